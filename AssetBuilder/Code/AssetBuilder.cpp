@@ -0,0 +1,241 @@
+// AssetBuilder.cpp : Bakes the content directory into the runtime formats the engine loads fastest.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "AssetGraph.h"
+#include "ModelBaker.h"
+#include "Utils/AssetManifest.h"
+
+namespace
+{
+	using Engine::Tools::AssetGraph;
+	using Engine::Tools::ModelBaker;
+	using Engine::Utils::AssetManifest;
+
+	// Bumped whenever copied .glb files change for the same input
+	constexpr uint32_t k_copyVersion = 1;
+
+	struct Task
+	{
+		size_t node = 0;
+		std::string output; // Relative to the output directory
+		uint64_t hash = 0;
+
+		bool success = false;
+		std::string error;
+		ModelBaker::Stats stats;
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const char* getTypeName(AssetGraph::Type type)
+	{
+		return type == AssetGraph::Type::Model ? "Model" : "Gltf";
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	uint32_t getBakerVersion(AssetGraph::Type type)
+	{
+		return type == AssetGraph::Type::Model ? ModelBaker::k_version : k_copyVersion;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool copyAsset(const std::filesystem::path& source, const std::filesystem::path& output, std::string& error)
+	{
+		std::error_code copyError;
+		std::filesystem::create_directories(output.parent_path(), copyError);
+		std::filesystem::copy_file(source, output, std::filesystem::copy_options::overwrite_existing, copyError);
+		if (copyError)
+		{
+			error = copyError.message();
+			return false;
+		}
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int printUsage()
+	{
+		std::cerr << "Usage: AssetBuilder <contentDirectory> <outputDirectory> [--force] [--workers N]" << std::endl;
+		return 1;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		return printUsage();
+	}
+
+	std::filesystem::path contentDirectory = std::filesystem::absolute(argv[1]).lexically_normal();
+	std::filesystem::path outputDirectory = std::filesystem::absolute(argv[2]).lexically_normal();
+	bool force = false;
+	size_t workersCount = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+	for (int i = 3; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument == "--force")
+		{
+			force = true;
+		}
+		else if (argument == "--workers" && i + 1 < argc)
+		{
+			workersCount = std::stoul(argv[++i]);
+		}
+		else
+		{
+			return printUsage();
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	Engine::JobsManager jobsManager;
+	jobsManager.init(workersCount);
+
+	AssetGraph graph;
+	if (!graph.scan(contentDirectory, jobsManager))
+	{
+		std::cerr << "Failed to read the content directory " << contentDirectory << std::endl;
+		return 1;
+	}
+
+	std::filesystem::path manifestPath = outputDirectory / "manifest.json";
+	AssetManifest previousManifest;
+	if (!force)
+	{
+		previousManifest.load(manifestPath.string());
+	}
+
+	AssetManifest manifest;
+	manifest.setContentDirectory(std::filesystem::relative(contentDirectory, outputDirectory).generic_string());
+
+	// Up to date assets keep their previous entry, the others are baked below
+	const std::vector<AssetGraph::Node>& nodes = graph.getNodes();
+	std::vector<Task> tasks;
+	std::unordered_map<std::string, size_t> outputNodes;
+	size_t upToDateCount = 0;
+	bool success = true;
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		const AssetGraph::Node& node = nodes[i];
+		if (!AssetGraph::isAsset(node.type))
+		{
+			continue;
+		}
+
+		for (const std::string& missing : node.missingDependencies)
+		{
+			std::cerr << "Warning: " << node.source << " references missing " << missing << std::endl;
+		}
+
+		Task task;
+		task.node = i;
+		task.output = std::filesystem::path(node.source).replace_extension(".glb").generic_string();
+		task.hash = graph.getBuildHash(i, getBakerVersion(node.type));
+
+		auto [outputNode, added] = outputNodes.try_emplace(task.output, i);
+		if (!added)
+		{
+			std::cerr << "Error: " << node.source << " and " << nodes[outputNode->second].source << " are both baked to " << task.output << std::endl;
+			success = false;
+			continue;
+		}
+
+		const AssetManifest::Asset* previous = previousManifest.findAsset(node.source);
+		if (previous && previous->hash == task.hash && previous->output == task.output && std::filesystem::exists(outputDirectory / task.output))
+		{
+			manifest.addAsset(AssetManifest::Asset(*previous));
+			upToDateCount++;
+			continue;
+		}
+
+		tasks.push_back(std::move(task));
+	}
+
+	// Models take from milliseconds to seconds each, one job per model keeps the workers busy
+	jobsManager.parallelFor(tasks.size(), 1, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				Task& task = tasks[i];
+				const AssetGraph::Node& node = nodes[task.node];
+				std::filesystem::path source = contentDirectory / node.source;
+				std::filesystem::path output = outputDirectory / task.output;
+				if (node.type == AssetGraph::Type::Model)
+				{
+					task.success = ModelBaker::bake(source, output, task.stats, task.error);
+				}
+				else
+				{
+					task.success = copyAsset(source, output, task.error);
+				}
+			}
+		});
+
+	// Failed assets stay out of the manifest, the engine keeps loading their sources
+	ModelBaker::Stats totalStats;
+	size_t bakedCount = 0;
+	for (Task& task : tasks)
+	{
+		const AssetGraph::Node& node = nodes[task.node];
+		if (!task.success)
+		{
+			std::cerr << "Error: " << node.source << ": " << task.error << std::endl;
+			success = false;
+			continue;
+		}
+
+		if (node.type == AssetGraph::Type::Model)
+		{
+			std::cout << node.source << ": " << task.stats.sourceVertices << " -> " << task.stats.bakedVertices << " vertices, "
+				<< task.stats.primitives << " primitives, " << task.stats.textures << " textures" << std::endl;
+			totalStats.sourceVertices += task.stats.sourceVertices;
+			totalStats.bakedVertices += task.stats.bakedVertices;
+		}
+		else
+		{
+			std::cout << node.source << ": copied" << std::endl;
+		}
+
+		manifest.addAsset({ node.source, getTypeName(node.type), task.output, task.hash, graph.getDependencySources(task.node) });
+		bakedCount++;
+	}
+
+	// Outputs of sources removed since the last build
+	for (const AssetManifest::Asset& previous : previousManifest.getAssets())
+	{
+		if (!manifest.findAsset(previous.source) && outputNodes.find(previous.output) == outputNodes.end())
+		{
+			std::error_code removeError;
+			std::filesystem::remove(outputDirectory / previous.output, removeError);
+		}
+	}
+
+	std::filesystem::create_directories(outputDirectory);
+	if (!manifest.save(manifestPath.string()))
+	{
+		std::cerr << "Failed to write " << manifestPath << std::endl;
+		return 1;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << bakedCount << " assets baked, " << upToDateCount << " up to date, " << totalStats.sourceVertices << " -> "
+		<< totalStats.bakedVertices << " vertices, " << seconds << " s with " << jobsManager.getWorkersCount() + 1 << " threads" << std::endl;
+
+	jobsManager.stop();
+	return success ? 0 : 1;
+}
@@ -0,0 +1,297 @@
+#include "AssetGraph.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace Engine::Tools
+{
+	namespace
+	{
+		constexpr uint64_t k_fnvOffset = 0xcbf29ce484222325ull;
+		constexpr uint64_t k_fnvPrime = 0x100000001b3ull;
+
+		//////////////////////////////////////////////////////////////////////////
+
+		uint64_t hashBytes(const void* data, size_t size, uint64_t hash = k_fnvOffset)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			for (size_t i = 0; i < size; i++)
+			{
+				hash = (hash ^ bytes[i]) * k_fnvPrime;
+			}
+			return hash;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		template <typename T>
+		uint64_t hashValue(const T& value, uint64_t hash)
+		{
+			return hashBytes(&value, sizeof(value), hash);
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Windows paths are case insensitive, references often don't match the case of the files
+		std::string getKey(const std::filesystem::path& relativePath)
+		{
+			std::string key = relativePath.lexically_normal().generic_string();
+			std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+			return key;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		std::string getLowerExtension(const std::filesystem::path& path)
+		{
+			std::string extension = path.extension().string();
+			std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+			return extension;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool AssetGraph::scan(const std::filesystem::path& contentDirectory, JobsManager& jobsManager)
+	{
+		m_contentDirectory = contentDirectory;
+		m_nodes.clear();
+		m_nodeIndices.clear();
+
+		std::error_code error;
+		if (!std::filesystem::is_directory(contentDirectory, error))
+		{
+			return false;
+		}
+
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(contentDirectory, error))
+		{
+			Type type;
+			if (!entry.is_regular_file() || !getType(entry.path(), type))
+			{
+				continue;
+			}
+
+			Node node;
+			node.source = std::filesystem::relative(entry.path(), contentDirectory).lexically_normal().generic_string();
+			node.type = type;
+			m_nodeIndices[getKey(node.source)] = m_nodes.size();
+			m_nodes.push_back(std::move(node));
+		}
+
+		// Reading dominates, files are hashed and parsed one per job
+		std::vector<std::vector<std::filesystem::path>> references(m_nodes.size());
+		m_readFailed.assign(m_nodes.size(), 0);
+		jobsManager.parallelFor(m_nodes.size(), 1, [this, &references](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					readNode(i, references[i]);
+				}
+			});
+
+		bool success = true;
+		for (size_t i = 0; i < m_nodes.size(); i++)
+		{
+			success &= m_readFailed[i] == 0;
+
+			Node& node = m_nodes[i];
+			for (const std::filesystem::path& reference : references[i])
+			{
+				auto index = m_nodeIndices.find(getKey(reference));
+				if (index != m_nodeIndices.end())
+				{
+					node.dependencies.push_back(index->second);
+				}
+				else
+				{
+					node.missingDependencies.push_back(reference.generic_string());
+				}
+			}
+		}
+		return success;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::vector<AssetGraph::Node>& AssetGraph::getNodes() const
+	{
+		return m_nodes;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::filesystem::path& AssetGraph::getContentDirectory() const
+	{
+		return m_contentDirectory;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	uint64_t AssetGraph::getBuildHash(size_t node, uint32_t bakerVersion) const
+	{
+		uint64_t hash = hashValue(bakerVersion, k_fnvOffset);
+		hash = hashValue(m_nodes[node].contentHash, hash);
+
+		// Sorted by source so the hash doesn't depend on the scan order, names count too since outputs embed them
+		std::vector<size_t> visited;
+		collectDependencies(node, visited);
+		std::sort(visited.begin(), visited.end(), [this](size_t first, size_t second) { return m_nodes[first].source < m_nodes[second].source; });
+		for (size_t dependency : visited)
+		{
+			const Node& dependencyNode = m_nodes[dependency];
+			hash = hashBytes(dependencyNode.source.data(), dependencyNode.source.size(), hash);
+			hash = hashValue(dependencyNode.contentHash, hash);
+		}
+
+		// A missing file showing up later has to trigger a rebuild
+		std::vector<std::string> missing;
+		for (size_t dependency : visited)
+		{
+			missing.insert(missing.end(), m_nodes[dependency].missingDependencies.begin(), m_nodes[dependency].missingDependencies.end());
+		}
+		missing.insert(missing.end(), m_nodes[node].missingDependencies.begin(), m_nodes[node].missingDependencies.end());
+		std::sort(missing.begin(), missing.end());
+		for (const std::string& source : missing)
+		{
+			hash = hashBytes(source.data(), source.size(), hash);
+		}
+
+		return hash;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::vector<std::string> AssetGraph::getDependencySources(size_t node) const
+	{
+		std::vector<size_t> visited;
+		collectDependencies(node, visited);
+
+		std::vector<std::string> sources;
+		for (size_t dependency : visited)
+		{
+			sources.push_back(m_nodes[dependency].source);
+		}
+		std::sort(sources.begin(), sources.end());
+		return sources;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool AssetGraph::isAsset(Type type)
+	{
+		return type == Type::Model || type == Type::Gltf;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool AssetGraph::getType(const std::filesystem::path& path, Type& type)
+	{
+		std::string extension = getLowerExtension(path);
+		if (extension == ".obj")
+		{
+			type = Type::Model;
+			return true;
+		}
+		if (extension == ".mtl")
+		{
+			type = Type::Material;
+			return true;
+		}
+		if (extension == ".glb")
+		{
+			type = Type::Gltf;
+			return true;
+		}
+		if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp")
+		{
+			type = Type::Texture;
+			return true;
+		}
+		return false;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::vector<std::filesystem::path> AssetGraph::parseReferences(const std::string& text, Type type)
+	{
+		// Same statements the OBJ loader follows: every file of mtllib, the last token of map_Kd after its options
+		const char* keyword = type == Type::Model ? "mtllib" : "map_Kd";
+
+		std::vector<std::filesystem::path> references;
+		std::istringstream lines(text);
+		std::string line;
+		while (std::getline(lines, line))
+		{
+			std::istringstream tokens(line);
+			std::string token;
+			if (!(tokens >> token) || token != keyword)
+			{
+				continue;
+			}
+
+			std::vector<std::string> arguments;
+			while (tokens >> token)
+			{
+				arguments.push_back(token);
+			}
+
+			if (type == Type::Model)
+			{
+				references.insert(references.end(), arguments.begin(), arguments.end());
+			}
+			else if (!arguments.empty())
+			{
+				references.push_back(arguments.back());
+			}
+		}
+		return references;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void AssetGraph::readNode(size_t node, std::vector<std::filesystem::path>& references)
+	{
+		Node& nodeData = m_nodes[node];
+		std::ifstream file(m_contentDirectory / nodeData.source, std::ios::binary);
+		if (!file.is_open())
+		{
+			m_readFailed[node] = 1;
+			return;
+		}
+
+		std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		nodeData.contentHash = hashBytes(content.data(), content.size());
+
+		if (nodeData.type != Type::Model && nodeData.type != Type::Material)
+		{
+			return;
+		}
+
+		// References are relative to the referencing file
+		std::filesystem::path directory = std::filesystem::path(nodeData.source).parent_path();
+		for (const std::filesystem::path& reference : parseReferences(content, nodeData.type))
+		{
+			references.push_back((directory / reference).lexically_normal());
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void AssetGraph::collectDependencies(size_t node, std::vector<size_t>& visited) const
+	{
+		for (size_t dependency : m_nodes[node].dependencies)
+		{
+			if (std::find(visited.begin(), visited.end(), dependency) != visited.end())
+			{
+				continue;
+			}
+
+			visited.push_back(dependency);
+			collectDependencies(dependency, visited);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
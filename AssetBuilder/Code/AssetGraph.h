@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Managers/JobsManager.h"
+
+namespace Engine::Tools
+{
+	/**
+	 * @brief      Source files of a content directory and the references between them.
+	 *
+	 *             Models reference materials through mtllib, materials reference
+	 *             textures through map_Kd. Every file is read once, in parallel,
+	 *             to hash its content and parse its references. The build hash of
+	 *             a file combines its own hash with the hashes of everything it
+	 *             depends on, so a changed texture rebuilds the models using it.
+	 */
+	class AssetGraph
+	{
+	public:
+		enum class Type
+		{
+			Model, // .obj, baked to .glb
+			Material, // .mtl
+			Texture,
+			Gltf // .glb, already in the runtime format
+		};
+
+		struct Node
+		{
+			std::string source; // Relative to the content directory, forward slashes
+			Type type = Type::Texture;
+			uint64_t contentHash = 0;
+			std::vector<size_t> dependencies;
+			std::vector<std::string> missingDependencies; // Referenced but not in the content directory
+		};
+
+	public:
+		bool scan(const std::filesystem::path& contentDirectory, JobsManager& jobsManager);
+
+		const std::vector<Node>& getNodes() const;
+		const std::filesystem::path& getContentDirectory() const;
+
+		// Hash of the node, its dependencies and the version of the tool baking it
+		uint64_t getBuildHash(size_t node, uint32_t bakerVersion) const;
+
+		// Sources of every direct and indirect dependency, sorted
+		std::vector<std::string> getDependencySources(size_t node) const;
+
+		static bool isAsset(Type type); // Types getting their own baked output
+
+	private:
+		static bool getType(const std::filesystem::path& path, Type& type);
+		static std::vector<std::filesystem::path> parseReferences(const std::string& text, Type type);
+
+		void readNode(size_t node, std::vector<std::filesystem::path>& references);
+		void collectDependencies(size_t node, std::vector<size_t>& visited) const;
+
+	private:
+		std::filesystem::path m_contentDirectory;
+		std::vector<Node> m_nodes;
+		std::unordered_map<std::string, size_t> m_nodeIndices;
+		std::vector<uint8_t> m_readFailed; // Not vector<bool>, the jobs write neighbouring entries
+	};
+}
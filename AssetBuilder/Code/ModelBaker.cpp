@@ -0,0 +1,377 @@
+#include "ModelBaker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <tiny_obj_loader.h>
+
+#include "Visual/GltfModel.h"
+
+namespace Engine::Tools
+{
+	namespace
+	{
+		using Vertex = Visual::GltfModel::Vertex;
+		static_assert(sizeof(Vertex) == 32, "The zero-copy path expects the 32 byte stride of the renderers");
+
+		// Faces sharing a material, drawn with one call
+		struct Primitive
+		{
+			int materialId = -1;
+			size_t firstVertex = 0;
+			std::vector<uint32_t> indices;
+			size_t indicesOffset = 0; // In the binary chunk
+			size_t indexSize = sizeof(uint32_t);
+		};
+
+		// OBJ faces index positions, normals and texture coordinates separately, a vertex is one combination
+		struct Corner
+		{
+			int position;
+			int normal;
+			int texCoord;
+
+			bool operator==(const Corner& other) const = default;
+		};
+
+		struct CornerHash
+		{
+			size_t operator()(const Corner& corner) const
+			{
+				return ((size_t)corner.position * 73856093) ^ ((size_t)corner.normal * 19349663) ^ ((size_t)corner.texCoord * 83492791);
+			}
+		};
+
+		//////////////////////////////////////////////////////////////////////////
+
+		size_t alignTo4(size_t size)
+		{
+			return (size + 3) & ~size_t(3);
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Returns the offset of the data, the binary chunk stays 4 byte aligned for the next accessor
+		size_t appendBytes(std::vector<uint8_t>& binary, const void* data, size_t size)
+		{
+			size_t offset = binary.size();
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			binary.insert(binary.end(), bytes, bytes + size);
+			binary.resize(alignTo4(binary.size()), 0);
+			return offset;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		void writeUint32(std::ofstream& file, uint32_t value)
+		{
+			file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		std::string getMimeType(const std::filesystem::path& path)
+		{
+			std::string extension = path.extension().string();
+			std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+			if (extension == ".png")
+			{
+				return "image/png";
+			}
+			if (extension == ".jpg" || extension == ".jpeg")
+			{
+				return "image/jpeg";
+			}
+
+			// Not allowed by glTF, the engine decodes every image with stb_image anyway
+			return "application/octet-stream";
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		bool readFile(const std::filesystem::path& path, std::vector<uint8_t>& data)
+		{
+			std::ifstream file(path, std::ios::binary);
+			if (!file.is_open())
+			{
+				return false;
+			}
+
+			data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			return true;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool ModelBaker::bake(const std::filesystem::path& source, const std::filesystem::path& output, Stats& stats, std::string& error)
+	{
+		// Same loading as the renderers, so the baked model looks like the OBJ did
+		std::filesystem::path directory = source.parent_path();
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warning;
+		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, source.string().c_str(), directory.string().c_str()))
+		{
+			return false;
+		}
+
+		// Faces of every shape are gathered by material, the order of first use is kept
+		std::vector<Primitive> primitives;
+		std::unordered_map<int, size_t> materialPrimitives;
+		std::vector<std::vector<Corner>> primitiveCorners;
+		for (const tinyobj::shape_t& shape : shapes)
+		{
+			size_t facesCount = shape.mesh.indices.size() / 3;
+			for (size_t face = 0; face < facesCount; face++)
+			{
+				int materialId = face < shape.mesh.material_ids.size() ? shape.mesh.material_ids[face] : -1;
+				if (materialId < 0 || materialId >= (int)materials.size())
+				{
+					materialId = -1;
+				}
+
+				auto [primitive, added] = materialPrimitives.try_emplace(materialId, primitives.size());
+				if (added)
+				{
+					primitives.push_back(Primitive{ materialId });
+					primitiveCorners.emplace_back();
+				}
+
+				for (size_t corner = 0; corner < 3; corner++)
+				{
+					const tinyobj::index_t& index = shape.mesh.indices[face * 3 + corner];
+					primitiveCorners[primitive->second].push_back(Corner{ index.vertex_index, index.normal_index, index.texcoord_index });
+				}
+			}
+		}
+
+		if (primitives.empty())
+		{
+			error = "No faces";
+			return false;
+		}
+
+		// Indices are local to each primitive, they index the vertices from its firstVertex
+		std::vector<Vertex> vertices;
+		for (size_t i = 0; i < primitives.size(); i++)
+		{
+			Primitive& primitive = primitives[i];
+			primitive.firstVertex = vertices.size();
+
+			std::unordered_map<Corner, uint32_t, CornerHash> cornerVertices;
+			primitive.indices.reserve(primitiveCorners[i].size());
+			for (const Corner& corner : primitiveCorners[i])
+			{
+				auto [vertexIndex, added] = cornerVertices.try_emplace(corner, (uint32_t)(vertices.size() - primitive.firstVertex));
+				primitive.indices.push_back(vertexIndex->second);
+				if (!added)
+				{
+					continue;
+				}
+
+				Vertex vertex = {};
+				for (int axis = 0; axis < 3; axis++)
+				{
+					vertex.position[axis] = attrib.vertices[3 * corner.position + axis];
+					vertex.normal[axis] = corner.normal >= 0 ? attrib.normals[3 * corner.normal + axis] : 0.0f;
+				}
+
+				// Kept as the OBJ has them, both loaders hand texture coordinates to the renderers unchanged
+				for (int axis = 0; axis < 2; axis++)
+				{
+					vertex.texCoord[axis] = corner.texCoord >= 0 ? attrib.texcoords[2 * corner.texCoord + axis] : 0.0f;
+				}
+				vertices.push_back(vertex);
+			}
+
+			stats.sourceVertices += primitiveCorners[i].size();
+			stats.indices += primitive.indices.size();
+		}
+		stats.bakedVertices = vertices.size();
+		stats.primitives = primitives.size();
+
+		std::vector<uint8_t> binary;
+		size_t verticesSize = vertices.size() * sizeof(Vertex);
+		appendBytes(binary, vertices.data(), verticesSize);
+
+		size_t indicesOffset = binary.size();
+		for (Primitive& primitive : primitives)
+		{
+			size_t vertexCount = primitive.indices.empty() ? 0 : *std::max_element(primitive.indices.begin(), primitive.indices.end()) + 1;
+			if (vertexCount <= 0x10000)
+			{
+				std::vector<uint16_t> shortIndices(primitive.indices.begin(), primitive.indices.end());
+				primitive.indexSize = sizeof(uint16_t);
+				primitive.indicesOffset = appendBytes(binary, shortIndices.data(), shortIndices.size() * sizeof(uint16_t));
+			}
+			else
+			{
+				primitive.indicesOffset = appendBytes(binary, primitive.indices.data(), primitive.indices.size() * sizeof(uint32_t));
+			}
+		}
+		size_t indicesSize = binary.size() - indicesOffset;
+
+		nlohmann::json bufferViews = {
+			{ { "buffer", 0 }, { "byteOffset", 0 }, { "byteLength", verticesSize }, { "byteStride", sizeof(Vertex) }, { "target", 34962 } },
+			{ { "buffer", 0 }, { "byteOffset", indicesOffset }, { "byteLength", indicesSize }, { "target", 34963 } } };
+		nlohmann::json accessors = nlohmann::json::array();
+		nlohmann::json primitivesJson = nlohmann::json::array();
+		for (const Primitive& primitive : primitives)
+		{
+			size_t vertexCount = (&primitive == &primitives.back() ? vertices.size() : (&primitive + 1)->firstVertex) - primitive.firstVertex;
+			size_t vertexOffset = primitive.firstVertex * sizeof(Vertex);
+
+			float minPosition[3] = { 0.0f, 0.0f, 0.0f };
+			float maxPosition[3] = { 0.0f, 0.0f, 0.0f };
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				for (int axis = 0; axis < 3; axis++)
+				{
+					float value = vertices[primitive.firstVertex + i].position[axis];
+					minPosition[axis] = i == 0 ? value : std::min(minPosition[axis], value);
+					maxPosition[axis] = i == 0 ? value : std::max(maxPosition[axis], value);
+				}
+			}
+
+			size_t firstAccessor = accessors.size();
+			accessors.push_back({ { "bufferView", 0 }, { "byteOffset", vertexOffset + offsetof(Vertex, position) }, { "componentType", 5126 }, { "count", vertexCount }, { "type", "VEC3" },
+				{ "min", minPosition }, { "max", maxPosition } });
+			accessors.push_back({ { "bufferView", 0 }, { "byteOffset", vertexOffset + offsetof(Vertex, normal) }, { "componentType", 5126 }, { "count", vertexCount }, { "type", "VEC3" } });
+			accessors.push_back({ { "bufferView", 0 }, { "byteOffset", vertexOffset + offsetof(Vertex, texCoord) }, { "componentType", 5126 }, { "count", vertexCount }, { "type", "VEC2" } });
+			accessors.push_back({ { "bufferView", 1 }, { "byteOffset", primitive.indicesOffset - indicesOffset },
+				{ "componentType", primitive.indexSize == sizeof(uint16_t) ? 5123 : 5125 }, { "count", primitive.indices.size() }, { "type", "SCALAR" } });
+
+			nlohmann::json primitiveJson = {
+				{ "attributes", { { "POSITION", firstAccessor }, { "NORMAL", firstAccessor + 1 }, { "TEXCOORD_0", firstAccessor + 2 } } },
+				{ "indices", firstAccessor + 3 } };
+			if (primitive.materialId >= 0)
+			{
+				primitiveJson["material"] = primitive.materialId;
+			}
+			primitivesJson.push_back(primitiveJson);
+		}
+
+		// Diffuse textures are embedded once however many materials use them
+		nlohmann::json images = nlohmann::json::array();
+		nlohmann::json materialsJson = nlohmann::json::array();
+		std::unordered_map<std::string, size_t> textureImages;
+		for (const tinyobj::material_t& material : materials)
+		{
+			// Inverse of GltfModel::Material::getPhongParameters for a dielectric, the ambient and specular colors are lost
+			float shininess = std::clamp((float)material.shininess, 0.0f, k_maxShininess);
+			float alpha = std::sqrt(2.0f / (shininess + 2.0f));
+			nlohmann::json pbr = {
+				{ "baseColorFactor", { material.diffuse[0], material.diffuse[1], material.diffuse[2], material.dissolve } },
+				{ "metallicFactor", 0.0f },
+				{ "roughnessFactor", std::sqrt(alpha) } };
+
+			if (!material.diffuse_texname.empty())
+			{
+				// The renderers look textures up next to the OBJ, not the MTL
+				std::filesystem::path texturePath = directory / material.diffuse_texname;
+				auto [image, added] = textureImages.try_emplace(texturePath.string(), images.size());
+				if (added)
+				{
+					std::vector<uint8_t> data;
+					if (readFile(texturePath, data))
+					{
+						bufferViews.push_back({ { "buffer", 0 }, { "byteOffset", appendBytes(binary, data.data(), data.size()) }, { "byteLength", data.size() } });
+						images.push_back({ { "bufferView", bufferViews.size() - 1 }, { "mimeType", getMimeType(texturePath) } });
+					}
+					else
+					{
+						// Missing textures fall back to the default one, like when loading the OBJ
+						textureImages[texturePath.string()] = SIZE_MAX;
+					}
+				}
+
+				if (textureImages[texturePath.string()] != SIZE_MAX)
+				{
+					pbr["baseColorTexture"] = { { "index", textureImages[texturePath.string()] } };
+				}
+			}
+
+			nlohmann::json materialJson = { { "name", material.name }, { "pbrMetallicRoughness", pbr } };
+			if (material.emission[0] > 0.0f || material.emission[1] > 0.0f || material.emission[2] > 0.0f)
+			{
+				materialJson["emissiveFactor"] = { material.emission[0], material.emission[1], material.emission[2] };
+			}
+			materialsJson.push_back(materialJson);
+		}
+		stats.textures = images.size();
+
+		nlohmann::json json = {
+			{ "asset", { { "version", "2.0" }, { "generator", "GameEngine AssetBuilder" } } },
+			{ "buffers", { { { "byteLength", binary.size() } } } },
+			{ "bufferViews", bufferViews },
+			{ "accessors", accessors },
+			{ "meshes", { { { "primitives", primitivesJson } } } },
+			{ "nodes", { { { "mesh", 0 } } } },
+			{ "scenes", { { { "nodes", { 0 } } } } },
+			{ "scene", 0 } };
+		if (!materialsJson.empty())
+		{
+			json["materials"] = materialsJson;
+		}
+		if (!images.empty())
+		{
+			json["images"] = images;
+			json["textures"] = nlohmann::json::array();
+			for (size_t i = 0; i < images.size(); i++)
+			{
+				json["textures"].push_back({ { "source", i } });
+			}
+		}
+
+		// The json chunk is padded with spaces, the binary one is already aligned
+		std::string jsonText = json.dump();
+		jsonText.resize(alignTo4(jsonText.size()), ' ');
+
+		// Written next to the output and renamed, an interrupted build never leaves a truncated model behind
+		std::filesystem::create_directories(output.parent_path());
+		std::filesystem::path temporary = output;
+		temporary += ".tmp";
+		{
+			std::ofstream file(temporary, std::ios::binary);
+			if (!file.is_open())
+			{
+				error = "Can't create " + temporary.string();
+				return false;
+			}
+
+			writeUint32(file, k_glbMagic);
+			writeUint32(file, 2);
+			writeUint32(file, static_cast<uint32_t>(12 + 8 + jsonText.size() + 8 + binary.size()));
+
+			writeUint32(file, static_cast<uint32_t>(jsonText.size()));
+			writeUint32(file, k_glbJsonChunk);
+			file.write(jsonText.data(), jsonText.size());
+
+			writeUint32(file, static_cast<uint32_t>(binary.size()));
+			writeUint32(file, k_glbBinaryChunk);
+			file.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+
+			if (!file.good())
+			{
+				error = "Can't write " + temporary.string();
+				return false;
+			}
+		}
+
+		std::error_code renameError;
+		std::filesystem::rename(temporary, output, renameError);
+		if (renameError)
+		{
+			error = "Can't replace " + output.string() + ": " + renameError.message();
+			return false;
+		}
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace Engine::Tools
+{
+	/**
+	 * @brief      Bakes OBJ models, with their MTL materials and diffuse textures, into .glb files.
+	 *
+	 *             The output hits the zero-copy path of GltfModel: one interleaved
+	 *             vertex buffer in the renderers layout, 16 bit indices whenever
+	 *             the vertices of a primitive fit. Vertices shared by several faces
+	 *             are stored once, faces are split into one primitive per material
+	 *             and textures are embedded, so nothing but the .glb is read at runtime.
+	 */
+	class ModelBaker
+	{
+	public:
+		struct Stats
+		{
+			size_t sourceVertices = 0; // Face corners of the OBJ, what loading it at runtime creates
+			size_t bakedVertices = 0;
+			size_t indices = 0;
+			size_t primitives = 0;
+			size_t textures = 0;
+		};
+
+		// Bumped whenever the output changes for the same input, so every model is baked again
+		static constexpr uint32_t k_version = 1;
+
+		static bool bake(const std::filesystem::path& source, const std::filesystem::path& output, Stats& stats, std::string& error);
+
+	private:
+		static constexpr uint32_t k_glbMagic = 0x46546C67; // "glTF"
+		static constexpr uint32_t k_glbJsonChunk = 0x4E4F534A; // "JSON"
+		static constexpr uint32_t k_glbBinaryChunk = 0x004E4942; // "BIN"
+		static constexpr float k_maxShininess = 1024.0f;
+	};
+}
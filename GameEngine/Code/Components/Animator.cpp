@@ -0,0 +1,4 @@
+#include "Animator.h"
+#include "Managers/GameController.h"
+
+REGISTER_SERIALIZABLE_COMPONENT(Engine::Components::Animator)
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Utils/Parser.h"
+#include "Utils/Matrix.h"
+#include "Visual/GltfModel.h"
+
+namespace Engine::Components
+{
+
+	// Plays the clips of the skinned model of the Model component on the same entity
+	class Animator
+	{
+	public:
+		std::string clip; // Empty plays the first clip of the model
+		std::string blendClip; // Optional second clip mixed in with blendWeight
+		float blendWeight = 0.0f;
+		float speed = 1.0f;
+		float time = 0.0f;
+		bool loop = true;
+
+		// Filled by AnimationSystem every frame
+		std::vector<Utils::Matrix4> palette; // Skinning matrix per joint
+		std::vector<Visual::GltfModel::Vertex> vertices; // Skinned vertices, empty when skinning is left to the GPU
+
+		SERIALIZABLE(
+			PROPERTY(Animator, clip),
+			PROPERTY(Animator, blendClip),
+			PROPERTY(Animator, blendWeight),
+			PROPERTY(Animator, speed),
+			PROPERTY(Animator, time),
+			PROPERTY(Animator, loop)
+		)
+	};
+
+
+
+}
@@ -0,0 +1,4 @@
+#include "Camera.h"
+#include "Managers/GameController.h"
+
+REGISTER_SERIALIZABLE_COMPONENT(Engine::Components::Camera)
\ No newline at end of file
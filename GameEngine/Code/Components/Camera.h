@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Utils/Parser.h"
+#include "Utils/Vector.h"
+#include "Utils/Matrix.h"
+#include "Utils/Geometry.h"
+
+namespace Engine::Components
+{
+
+	// Part of the window a camera covers, normalized, (0, 0) is the top left corner
+	class Viewport
+	{
+	public:
+		float x = 0.0f;
+		float y = 0.0f;
+		float width = 1.0f;
+		float height = 1.0f;
+
+		SERIALIZABLE(
+			PROPERTY(Viewport, x),
+			PROPERTY(Viewport, y),
+			PROPERTY(Viewport, width),
+			PROPERTY(Viewport, height)
+		)
+	};
+
+	// Perspective camera placed by the Transform of its entity, looking along +z rotated by the Transform rotation.
+	// Matrices are left-handed with depth in [0, 1], CameraSystem recomputes them when the camera moves or is marked dirty.
+	class Camera
+	{
+	public:
+		float fieldOfView = 45.0f; // Vertical, degrees
+		float nearPlane = 0.1f;
+		float farPlane = 1000.0f;
+		float aspectRatio = 0.0f; // Width over height, 0 follows the window and the viewport
+		Viewport viewport;
+		int priority = 0; // RenderingSystem draws with the active camera of highest priority
+		bool active = true;
+
+		// Filled by CameraSystem
+		bool dirty = true; // Set it after changing the settings above
+		uint32_t version = 0; // Incremented whenever the matrices change
+		Utils::Vector3 position;
+		Utils::Vector3 forward;
+		Utils::Vector3 up;
+		Utils::Vector3 right;
+		Utils::Matrix4 view;
+		Utils::Matrix4 projection;
+		Utils::Matrix4 viewProjection;
+		Utils::Frustum frustum; // World space, normals pointing inside
+		Utils::Vector3 cachedRotation; // Transform rotation the matrices were built from
+		float cachedAspectRatio = 0.0f;
+
+		SERIALIZABLE(
+			PROPERTY(Camera, fieldOfView),
+			PROPERTY(Camera, nearPlane),
+			PROPERTY(Camera, farPlane),
+			PROPERTY(Camera, aspectRatio),
+			PROPERTY(Camera, viewport),
+			PROPERTY(Camera, priority),
+			PROPERTY(Camera, active)
+		)
+	};
+
+
+
+}
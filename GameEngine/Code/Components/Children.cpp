@@ -0,0 +1,4 @@
+#include "Children.h"
+#include "Managers/GameController.h"
+
+REGISTER_COMPONENT(Engine::Components::Children)
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+
+#include "Managers/EntitiesManager.h"
+
+namespace Engine::Components
+{
+
+	// Filled by HierarchySystem from the Parent components, not meant to be edited directly
+	class Children
+	{
+	public:
+		std::vector<EntityID> ids;
+	};
+
+
+
+}
+
@@ -0,0 +1,4 @@
+#include "Collider.h"
+#include "Managers/GameController.h"
+
+REGISTER_SERIALIZABLE_COMPONENT(Engine::Components::Collider)
\ No newline at end of file
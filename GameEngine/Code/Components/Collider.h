@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+#include "Utils/Parser.h"
+#include "Utils/Vector.h"
+
+namespace Engine::Components
+{
+
+	// Collision shape in the local space of the Transform, its world bounds are tested by BroadphaseSystem.
+	// Without a RigidBody the collider is static
+	class Collider
+	{
+	public:
+		std::string shape = "Sphere"; // "Sphere" or "Box"
+		float radius = 0.5f; // Sphere only, scaled by the largest axis of the scale
+		Utils::Vector3 halfExtents = Utils::Vector3(0.5f, 0.5f, 0.5f); // Box only
+		Utils::Vector3 offset; // Center of the shape
+		float friction = 0.5f; // Combined with the other collider as sqrt(a * b)
+		float restitution = 0.0f; // The bouncier of the two colliders is used
+
+		SERIALIZABLE(
+			PROPERTY(Collider, shape),
+			PROPERTY(Collider, radius),
+			PROPERTY(Collider, halfExtents),
+			PROPERTY(Collider, offset),
+			PROPERTY(Collider, friction),
+			PROPERTY(Collider, restitution)
+		)
+	};
+
+
+
+}
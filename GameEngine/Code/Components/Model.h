@@ -13,12 +13,14 @@ namespace Engine::Components
 	public:
 
 		std::string path;
+		float boundingRadius = 0.0f; // Model space, around the origin of the model, 0 is never frustum culled
 
 		bool markedForDestroy = false;
 		std::unique_ptr<Visual::IModelInstance> instance = nullptr;
 
 		SERIALIZABLE(
-			PROPERTY(Model, path)
+			PROPERTY(Model, path),
+			PROPERTY(Model, boundingRadius)
 			)
 	};
 
@@ -0,0 +1,4 @@
+#include "Parent.h"
+#include "Managers/GameController.h"
+
+REGISTER_SERIALIZABLE_COMPONENT(Engine::Components::Parent)
\ No newline at end of file
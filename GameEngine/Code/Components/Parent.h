@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Utils/Parser.h"
+#include "Managers/EntitiesManager.h"
+
+namespace Engine::Components
+{
+
+	class Parent
+	{
+	public:
+		EntityID id = -1;
+
+		SERIALIZABLE(PROPERTY(Parent, id))
+
+	};
+
+
+
+}
+
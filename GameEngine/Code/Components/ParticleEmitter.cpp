@@ -0,0 +1,4 @@
+#include "ParticleEmitter.h"
+#include "Managers/GameController.h"
+
+REGISTER_SERIALIZABLE_COMPONENT(Engine::Components::ParticleEmitter)
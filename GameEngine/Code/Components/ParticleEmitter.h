@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Utils/Parser.h"
+#include "Utils/Vector.h"
+#include "Visual/ParticlePool.h"
+
+namespace Engine::Components
+{
+
+	// Spawns particles at the world position of its Transform, simulated and drawn by ParticleSystem.
+	// Particles live in the pool of the emitter, not as entities.
+	class ParticleEmitter
+	{
+	public:
+		int capacity = 10000; // Emission stops while the pool is full
+		float emissionRate = 1000.0f; // Particles per second
+		float lifetime = 2.0f;
+		float lifetimeVariance = 0.5f;
+		Utils::Vector3 velocity = Utils::Vector3(0.0f, 2.0f, 0.0f);
+		float velocitySpread = 1.0f; // Added to every axis of the velocity, uniform in [-spread, spread]
+		Utils::Vector3 gravity = Utils::Vector3(0.0f, -9.81f, 0.0f);
+		float drag = 0.5f; // Fraction of the velocity lost per second
+		float size = 0.05f;
+		Utils::Vector3 color = Utils::Vector3(1.0f, 0.6f, 0.2f);
+		float alpha = 1.0f;
+
+		// Filled by ParticleSystem
+		std::unique_ptr<Visual::ParticlePool> pool;
+		float emissionAccumulator = 0.0f; // Fraction of a particle carried to the next frame
+		std::vector<Visual::ParticleInstance> instances;
+
+		SERIALIZABLE(
+			PROPERTY(ParticleEmitter, capacity),
+			PROPERTY(ParticleEmitter, emissionRate),
+			PROPERTY(ParticleEmitter, lifetime),
+			PROPERTY(ParticleEmitter, lifetimeVariance),
+			PROPERTY(ParticleEmitter, velocity),
+			PROPERTY(ParticleEmitter, velocitySpread),
+			PROPERTY(ParticleEmitter, gravity),
+			PROPERTY(ParticleEmitter, drag),
+			PROPERTY(ParticleEmitter, size),
+			PROPERTY(ParticleEmitter, color),
+			PROPERTY(ParticleEmitter, alpha)
+		)
+	};
+
+
+
+}
@@ -0,0 +1,4 @@
+#include "RigidBody.h"
+#include "Managers/GameController.h"
+
+REGISTER_SERIALIZABLE_COMPONENT(Engine::Components::RigidBody)
\ No newline at end of file
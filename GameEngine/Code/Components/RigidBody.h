@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Utils/Parser.h"
+#include "Utils/SparseSet.h"
+#include "Utils/Vector.h"
+
+namespace Engine::Components
+{
+
+	// Moves the entity with the forces and contacts applied by RigidBodySystem, needs a Collider.
+	// Only root entities are simulated, a RigidBody under a Parent acts as a static collider.
+	// Stored in columns, the system reads and writes the fields it needs through getColumn.
+	class RigidBody
+	{
+	public:
+		float mass = 1.0f; // 0 or less makes the body static
+		Utils::Vector3 velocity;
+		Utils::Vector3 angularVelocity; // Radians per second around each world axis
+		float linearDamping = 0.05f; // Fraction of the velocity lost per second
+		float angularDamping = 0.05f;
+		bool useGravity = true;
+
+		SERIALIZABLE(
+			PROPERTY(RigidBody, mass),
+			PROPERTY(RigidBody, velocity),
+			PROPERTY(RigidBody, angularVelocity),
+			PROPERTY(RigidBody, linearDamping),
+			PROPERTY(RigidBody, angularDamping),
+			PROPERTY(RigidBody, useGravity)
+		)
+	};
+
+
+
+}
+
+SOA_STORAGE(Engine::Components::RigidBody)
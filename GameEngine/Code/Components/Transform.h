@@ -12,6 +12,11 @@ namespace Engine::Components
 		Utils::Vector3 rotation;
 		Utils::Vector3 scale = Utils::Vector3(1.0f, 1.0f, 1.0f);
 
+		// World space values, kept up to date by HierarchySystem
+		Utils::Vector3 worldPosition;
+		Utils::Vector3 worldRotation;
+		Utils::Vector3 worldScale = Utils::Vector3(1.0f, 1.0f, 1.0f);
+
 		SERIALIZABLE(
 			PROPERTY(Transform, position),
 			PROPERTY(Transform, rotation),
@@ -1,5 +1,7 @@
 #include "ComponentsManager.h"
 
+#include <unordered_set>
+
 #include "Utils/DebugMacros.h"
 
 namespace Engine
@@ -26,6 +28,56 @@ namespace Engine
 
 	//////////////////////////////////////////////////////////////////////////
 
+	void ComponentsManager::createComponentsFromJson(EntityRange& range, const nlohmann::json& components, JobsManager& jobsManager)
+	{
+		std::vector<std::unique_ptr<BulkInsertion>> insertions;
+		std::unordered_set<std::string> types;
+		for (const nlohmann::json& value : components)
+		{
+			ASSERT(value.contains(k_typenameField), "Component must have a {} field", k_typenameField);
+			if (!value.contains(k_typenameField))
+			{
+				continue;
+			}
+
+			// A second insertion would reserve slots in the same set while the first one is filled
+			std::string type = value[k_typenameField].get<std::string>();
+			auto creator = m_bulkComponentCreators.find(type);
+			ASSERT(creator != m_bulkComponentCreators.end(), "No bulk creator for component {}", type);
+			bool added = types.insert(type).second;
+			ASSERT(added, "Component {} listed twice", type);
+			if (creator == m_bulkComponentCreators.end() || !added)
+			{
+				continue;
+			}
+
+			insertions.push_back(creator->second(range, value, jobsManager));
+		}
+
+		// Every component of an entity is created by the job that claimed its id
+		size_t count = range.getEnd() - range.getFirst();
+		jobsManager.parallelFor(count, k_bulkCreationBatchSize, [&range, &insertions](size_t begin, size_t end)
+			{
+				EntityID first = range.claim(end - begin);
+				ASSERT(first >= 0, "Entity range claimed past its end");
+				if (first < 0)
+				{
+					return;
+				}
+
+				for (EntityID id = first; id < first + static_cast<EntityID>(end - begin); id++)
+				{
+					size_t index = static_cast<size_t>(id - range.getFirst());
+					for (const std::unique_ptr<BulkInsertion>& insertion : insertions)
+					{
+						insertion->insert(index, id);
+					}
+				}
+			});
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
 	void ComponentsManager::destroyEntity(EntityID id)
 	{
 		for (auto& [name, componentsSet] : m_sparseSets)
@@ -36,6 +88,29 @@ namespace Engine
 
 	//////////////////////////////////////////////////////////////////////////
 
+	const std::vector<EntityID>* ComponentsManager::getComponentIds(const std::string& typeName) const
+	{
+		auto componentSet = m_sparseSets.find(typeName);
+		return componentSet != m_sparseSets.end() ? &componentSet->second->getIds() : nullptr;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool ComponentsManager::reorderComponentSet(const std::string& typeName, const std::vector<EntityID>& ids, const std::vector<EntityID>& order)
+	{
+		auto componentSet = m_sparseSets.find(typeName);
+		ASSERT(componentSet != m_sparseSets.end(), "Component {} is not registered", typeName);
+		if (componentSet == m_sparseSets.end() || componentSet->second->getIds() != ids)
+		{
+			return false;
+		}
+
+		componentSet->second->reorder(order);
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
 	void ComponentsManager::clear()
 	{
 		for (auto& [name, componentsSet] : m_sparseSets)
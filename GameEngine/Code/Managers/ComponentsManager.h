@@ -11,6 +11,7 @@
 #include "Utils/Parser.h"
 
 #include "EntitiesManager.h"
+#include "JobsManager.h"
 
 namespace Engine
 {
@@ -19,6 +20,9 @@ namespace Engine
 	public:
 
 		void createComponentFromJson(EntityID id, const nlohmann::json& value);
+		// Components of every entity of a freshly reserved range, each json is parsed once.
+		// Batches of entities are filled by the jobs at once, each job claims the ids of its batch from the range
+		void createComponentsFromJson(EntityRange& range, const nlohmann::json& components, JobsManager& jobsManager);
 
 		void destroyEntity(EntityID id);
 
@@ -37,13 +41,33 @@ namespace Engine
 		template <typename... Components>
 		std::vector<EntityID> entitiesWithComponents();
 
+		// Ids of a component set in dense order, nullptr when the component is not registered
+		const std::vector<EntityID>* getComponentIds(const std::string& typeName) const;
+
+		// Moves the dense arrays of a component into order, a permutation of ids computed away from the set, e.g. on a job.
+		// Returns false without touching the set when it no longer holds ids in that order
+		bool reorderComponentSet(const std::string& typeName, const std::vector<EntityID>& ids, const std::vector<EntityID>& order);
+
 		void clear();
 
+	private:
+		// Components of one type for the entities of a range, made on the calling thread and filled by the jobs at once.
+		// The jobs also write the new storage before it is constructed, so its pages are local to them.
+		// Entities keep the slot matching their place in the range, so pools created for the same entities share their order
+		class BulkInsertion
+		{
+		public:
+			virtual ~BulkInsertion() = default; // Publishes the inserted components
+			virtual void insert(size_t index, EntityID id) = 0;
+		};
+
 	private:
 		static constexpr const char* k_typenameField = "typename";
+		static constexpr size_t k_bulkCreationBatchSize = 1024;
 
 		std::unordered_map<std::string, std::unique_ptr<Utils::SparseSetBase<EntityID>>> m_sparseSets;
 		std::unordered_map<std::string, std::function<void(EntityID, const nlohmann::json&)>> m_componentCreators;
+		std::unordered_map<std::string, std::function<std::unique_ptr<BulkInsertion>(const EntityRange&, const nlohmann::json&, JobsManager&)>> m_bulkComponentCreators;
 	};
 }
 
@@ -53,6 +53,63 @@ namespace Engine
 			};
 
 		m_componentCreators[Utils::getTypeName<Component>()] = creatorMethod;
+
+		// Parses the json once, the jobs then create the components of their entities from it
+		class TypedBulkInsertion: public BulkInsertion
+		{
+		public:
+			TypedBulkInsertion(Utils::SparseSet<Component, EntityID>& compSet, const EntityRange& range, const nlohmann::json& val, JobsManager& jobsManager)
+				: m_value(val)
+				, m_inserter(compSet.beginConcurrentInsertion(range.getEnd() - range.getFirst(), range.getEnd(),
+					[&jobsManager](size_t count, const JobsManager::RangeJob& job) { jobsManager.parallelFor(count, k_bulkCreationBatchSize, job); }))
+			{
+				Utils::Parser::fillFromJson(m_serializer, val);
+				m_firstSlot = m_inserter.claim(range.getEnd() - range.getFirst());
+			}
+
+			void insert(size_t index, EntityID id) override
+			{
+				size_t slot = m_firstSlot + index;
+				if constexpr (std::is_same<Component, Serializer>::value && std::is_copy_constructible<Component>::value)
+				{
+					m_inserter.insert(slot, id, static_cast<const Component&>(m_serializer));
+				}
+				else if constexpr (std::is_same<Component, Serializer>::value)
+				{
+					// Components owning resources can't be copied, each one is parsed on its own
+					Component comp{};
+					Utils::Parser::fillFromJson(comp, m_value);
+					m_inserter.insert(slot, id, std::move(comp));
+				}
+				else
+				{
+					Component comp{};
+					m_serializer.fill(comp);
+
+					if constexpr (std::is_move_constructible<Component>::value)
+					{
+						m_inserter.insert(slot, id, std::move(comp));
+					}
+					else
+					{
+						m_inserter.insert(slot, id, static_cast<const Component&>(comp));
+					}
+				}
+			}
+
+		private:
+			Serializer m_serializer{};
+			const nlohmann::json& m_value;
+			Utils::ConcurrentInserter<Component, EntityID> m_inserter;
+			size_t m_firstSlot = 0;
+		};
+
+		auto bulkCreatorMethod = [this](const EntityRange& range, const nlohmann::json& val, JobsManager& jobsManager) -> std::unique_ptr<BulkInsertion>
+			{
+				return std::make_unique<TypedBulkInsertion>(getComponentSet<Component>(), range, val, jobsManager);
+			};
+
+		m_bulkComponentCreators[Utils::getTypeName<Component>()] = bulkCreatorMethod;
 	}
 
 	//////////////////////////////////////////////////////////////////////////
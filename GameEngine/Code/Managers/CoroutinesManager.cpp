@@ -0,0 +1,234 @@
+#include "CoroutinesManager.h"
+
+#include <algorithm>
+
+#include "GameController.h"
+#include "Utils/DebugMacros.h"
+
+namespace Engine
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	void CoroutinesManager::start(Utils::Task&& task)
+	{
+		if (task.isDone())
+		{
+			return;
+		}
+
+		m_tasks.emplace_back(std::move(task));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void CoroutinesManager::update(float dt)
+	{
+		m_time += dt;
+
+		// Handles are moved out first, so coroutines that suspend again wait for the next update
+		std::vector<std::coroutine_handle<>> nextFrameHandles;
+		nextFrameHandles.swap(m_nextFrameHandles);
+		for (std::coroutine_handle<> handle : nextFrameHandles)
+		{
+			handle.resume();
+		}
+
+		resumeTimed();
+		resumeLoadedModels();
+
+		std::erase_if(m_tasks, [](const Utils::Task& task) { return task.isDone(); });
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void CoroutinesManager::clear()
+	{
+		m_nextFrameHandles.clear();
+		m_timedHandles.clear();
+		m_modelRequests.clear();
+		m_tasks.clear();
+		m_modelLoader = nullptr;
+		m_time = 0.0f;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void CoroutinesManager::setModelLoader(ModelLoader&& loader)
+	{
+		m_modelLoader = std::move(loader);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void CoroutinesManager::resumeNextFrame(std::coroutine_handle<> handle)
+	{
+		m_nextFrameHandles.push_back(handle);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void CoroutinesManager::resumeAfter(std::coroutine_handle<> handle, float seconds)
+	{
+		m_timedHandles.push_back(TimedResume{ handle, m_time + seconds });
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void CoroutinesManager::resumeAfterModelLoad(std::coroutine_handle<> handle, const std::string& path, bool& result)
+	{
+		ASSERT(m_modelLoader, "No model loader set, can't load: {}", path);
+		if (!m_modelLoader)
+		{
+			result = false;
+			resumeNextFrame(handle);
+			return;
+		}
+
+		auto request = std::make_shared<ModelRequest>();
+		request->handle = handle;
+		request->path = path;
+		request->result = &result;
+		m_modelRequests.push_back(request);
+
+		// The loader is copied so clear() can reset it while the job still runs
+		GameController::get().getJobsManager().submit([request, loader = m_modelLoader]()
+			{
+				request->upload = loader(request->path);
+				request->parsed = true;
+			});
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void CoroutinesManager::resumeTimed()
+	{
+		std::vector<TimedResume> dueHandles;
+		for (size_t i = 0; i < m_timedHandles.size();)
+		{
+			if (m_timedHandles[i].time > m_time)
+			{
+				i++;
+				continue;
+			}
+
+			dueHandles.push_back(m_timedHandles[i]);
+			m_timedHandles[i] = m_timedHandles.back();
+			m_timedHandles.pop_back();
+		}
+
+		std::sort(dueHandles.begin(), dueHandles.end(), [](const TimedResume& left, const TimedResume& right) { return left.time < right.time; });
+		for (const TimedResume& timed : dueHandles)
+		{
+			timed.handle.resume();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void CoroutinesManager::resumeLoadedModels()
+	{
+		std::vector<std::shared_ptr<ModelRequest>> loadedRequests;
+		for (size_t i = 0; i < m_modelRequests.size();)
+		{
+			if (!m_modelRequests[i]->parsed)
+			{
+				i++;
+				continue;
+			}
+
+			loadedRequests.push_back(std::move(m_modelRequests[i]));
+			m_modelRequests[i] = std::move(m_modelRequests.back());
+			m_modelRequests.pop_back();
+		}
+
+		for (const std::shared_ptr<ModelRequest>& request : loadedRequests)
+		{
+			*request->result = request->upload();
+			request->handle.resume();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool NextFrameAwaiter::await_ready() const
+	{
+		return false;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void NextFrameAwaiter::await_suspend(std::coroutine_handle<> handle) const
+	{
+		GameController::get().getCoroutinesManager().resumeNextFrame(handle);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void NextFrameAwaiter::await_resume() const
+	{
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool SecondsAwaiter::await_ready() const
+	{
+		return seconds <= 0.0f;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SecondsAwaiter::await_suspend(std::coroutine_handle<> handle) const
+	{
+		GameController::get().getCoroutinesManager().resumeAfter(handle, seconds);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SecondsAwaiter::await_resume() const
+	{
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool ModelLoadAwaiter::await_ready() const
+	{
+		return false;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void ModelLoadAwaiter::await_suspend(std::coroutine_handle<> handle)
+	{
+		GameController::get().getCoroutinesManager().resumeAfterModelLoad(handle, path, result);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool ModelLoadAwaiter::await_resume() const
+	{
+		return result;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	NextFrameAwaiter nextFrame()
+	{
+		return NextFrameAwaiter{};
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	SecondsAwaiter seconds(float seconds)
+	{
+		return SecondsAwaiter{ seconds };
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	ModelLoadAwaiter loadModel(const std::string& path)
+	{
+		return ModelLoadAwaiter{ path };
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
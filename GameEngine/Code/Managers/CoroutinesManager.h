@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <coroutine>
+
+#include "Utils/Task.h"
+
+namespace Engine
+{
+	class CoroutinesManager
+	{
+	public:
+		// Parses a model on a worker thread and returns its upload, which runs on the frame loop thread
+		using ModelUpload = std::function<bool()>;
+		using ModelLoader = std::function<ModelUpload(const std::string&)>;
+
+		void start(Utils::Task&& task);
+		void update(float dt);
+		void clear();
+
+		// Set by whoever owns the renderer, the loader must not touch the device
+		void setModelLoader(ModelLoader&& loader);
+
+		void resumeNextFrame(std::coroutine_handle<> handle);
+		void resumeAfter(std::coroutine_handle<> handle, float seconds);
+		void resumeAfterModelLoad(std::coroutine_handle<> handle, const std::string& path, bool& result);
+
+	private:
+		struct TimedResume
+		{
+			std::coroutine_handle<> handle;
+			float time;
+		};
+
+		struct ModelRequest
+		{
+			std::coroutine_handle<> handle;
+			std::string path;
+			bool* result;
+			ModelUpload upload; // Written by the job before parsed is set
+			std::atomic<bool> parsed = false;
+		};
+
+		void resumeTimed();
+		void resumeLoadedModels();
+
+	private:
+		std::vector<Utils::Task> m_tasks;
+		std::vector<std::coroutine_handle<>> m_nextFrameHandles;
+		std::vector<TimedResume> m_timedHandles;
+		std::vector<std::shared_ptr<ModelRequest>> m_modelRequests;
+		ModelLoader m_modelLoader;
+		float m_time = 0.0f;
+	};
+
+	struct NextFrameAwaiter
+	{
+		bool await_ready() const;
+		void await_suspend(std::coroutine_handle<> handle) const;
+		void await_resume() const;
+	};
+
+	struct SecondsAwaiter
+	{
+		float seconds;
+
+		bool await_ready() const;
+		void await_suspend(std::coroutine_handle<> handle) const;
+		void await_resume() const;
+	};
+
+	struct ModelLoadAwaiter
+	{
+		std::string path;
+		bool result = false;
+
+		bool await_ready() const;
+		void await_suspend(std::coroutine_handle<> handle);
+		bool await_resume() const;
+	};
+
+	// co_await nextFrame() resumes at the start of the next frame
+	NextFrameAwaiter nextFrame();
+
+	// co_await seconds(n) resumes on the first frame at least n seconds of frame time later
+	SecondsAwaiter seconds(float seconds);
+
+	// co_await loadModel(path) parses the file on a worker thread and then uploads it with the renderer, returns the load result
+	ModelLoadAwaiter loadModel(const std::string& path);
+}
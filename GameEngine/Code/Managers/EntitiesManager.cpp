@@ -35,4 +35,68 @@ namespace Engine
 	}
 
 	//////////////////////////////////////////////////////////////////////////
+
+	EntityRange EntitiesManager::reserveEntities(size_t count)
+	{
+		// Past the highest taken id, so the range is contiguous and goes in at the end of the set
+		EntityID first = m_takenIds.empty() ? 0 : *m_takenIds.rbegin() + 1;
+		for (EntityID id = first; id < first + static_cast<EntityID>(count); id++)
+		{
+			m_takenIds.insert(m_takenIds.end(), id);
+		}
+		return EntityRange(first, count);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void EntitiesManager::releaseEntities(const EntityRange& range)
+	{
+		EntityID unclaimed = range.getFirst() + static_cast<EntityID>(range.getClaimedCount());
+		m_takenIds.erase(m_takenIds.lower_bound(unclaimed), m_takenIds.lower_bound(range.getEnd()));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	EntityRange::EntityRange(EntityID first, size_t count): m_first(first), m_count(count)
+	{
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	EntityID EntityRange::claim(size_t count)
+	{
+		size_t claimed = m_claimed.load(std::memory_order_relaxed);
+		do
+		{
+			if (claimed + count > m_count)
+			{
+				return -1;
+			}
+		} while (!m_claimed.compare_exchange_weak(claimed, claimed + count, std::memory_order_relaxed));
+
+		return m_first + static_cast<EntityID>(claimed);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	EntityID EntityRange::getFirst() const
+	{
+		return m_first;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	EntityID EntityRange::getEnd() const
+	{
+		return m_first + static_cast<EntityID>(m_count);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t EntityRange::getClaimedCount() const
+	{
+		return m_claimed.load(std::memory_order_relaxed);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <set>
 #include <memory>
 
@@ -7,6 +8,23 @@ namespace Engine
 {
 	using EntityID = int;
 
+	// Consecutive ids reserved for jobs spawning entities at once, each job claims the ids it needs
+	class EntityRange
+	{
+	public:
+		EntityRange(EntityID first, size_t count);
+
+		EntityID claim(size_t count); // First of count consecutive ids, -1 when not enough are left. Lock free
+		EntityID getFirst() const;
+		EntityID getEnd() const; // Past the last id of the range, as idsEnd of the concurrent insertions
+		size_t getClaimedCount() const;
+
+	private:
+		EntityID m_first = 0;
+		size_t m_count = 0;
+		std::atomic<size_t> m_claimed = 0;
+	};
+
 	class EntitiesManager
 	{
 	public:
@@ -14,6 +32,10 @@ namespace Engine
 		void destroyEntity(EntityID id);
 		void clear();
 
+		// The manager stays single threaded, ranges are taken and released on the main thread and only claimed by the jobs
+		EntityRange reserveEntities(size_t count); // Ids past every taken one, taken until released
+		void releaseEntities(const EntityRange& range); // Ids the jobs didn't claim are free again
+
 	private:
 		std::set<EntityID> m_takenIds;
 	};
@@ -1,5 +1,7 @@
 #include "GameController.h"
 
+#include <numeric>
+
 #include "Utils/DebugMacros.h"
 #include "Events/NativeInputEvents.h"
 
@@ -54,8 +56,21 @@ namespace Engine
 
 	//////////////////////////////////////////////////////////////////////////
 
+	std::string GameController::getAssetPath(const std::string& path) const
+	{
+		return m_assetManifest.resolve(getConfigRelativePath(path));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
 	void GameController::init()
 	{
+		initMemory();
+		initJobs();
+		initAssets();
+		initFramePacing();
+		initBenchmark();
+		initProfiler();
 		initPrefabs();
 		initEntities();
 		initSystems();
@@ -74,7 +89,13 @@ namespace Engine
 			}
 		);
 
+		if (m_profilerEnabled)
+		{
+			m_profiler.start(m_profilerSettings);
+		}
+
 		float dt = 0;
+		bool benchmark = m_benchmark.isEnabled();
 		auto start = std::chrono::high_resolution_clock::now();
 		while (!nativeExitRequested)
 		{
@@ -92,22 +113,52 @@ namespace Engine
 			// calculating frame time
 			auto end = std::chrono::high_resolution_clock::now();
 			std::chrono::duration<float> elapsed = end - start;
-			dt = elapsed.count();
+			dt = benchmark ? m_benchmark.getTimeStep() : elapsed.count();
 
 			start = std::chrono::high_resolution_clock::now();
-			m_systemsManager.update(dt);
+			if (benchmark)
+			{
+				m_benchmark.beginFrame();
+				m_benchmark.beginSection();
+				m_coroutinesManager.update(dt);
+				m_benchmark.endSection("Coroutines");
+				m_systemsManager.update(dt, m_benchmark);
+				if (m_benchmark.endFrame())
+				{
+					break;
+				}
+			}
+			else
+			{
+				m_coroutinesManager.update(dt);
+				m_systemsManager.update(dt);
+			}
+			m_frameLimiter.wait();
 		}
 
 		m_systemsManager.stop();
+
+		if (benchmark)
+		{
+			m_benchmark.writeResults(getConfigRelativePath(m_benchmark.getOutputFile()));
+		}
+
+		if (m_profilerEnabled)
+		{
+			m_profiler.stop();
+			m_profiler.writeResults(getConfigRelativePath(m_profilerSettings.outputFile));
+		}
 	}
 
 	//////////////////////////////////////////////////////////////////////////
 
 	void GameController::clear()
 	{
+		m_coroutinesManager.clear();
 		m_systemsManager.clear();
 		m_componentsManager.clear();
 		m_entitiesManager.clear();
+		m_jobsManager.stop();
 	}
 
 	//////////////////////////////////////////////////////////////////////////
@@ -140,6 +191,20 @@ namespace Engine
 
 	//////////////////////////////////////////////////////////////////////////
 
+	JobsManager& GameController::getJobsManager()
+	{
+		return m_jobsManager;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	CoroutinesManager& GameController::getCoroutinesManager()
+	{
+		return m_coroutinesManager;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
 	const EventsManager& GameController::getEventsManager() const
 	{
 		return m_eventsManager;
@@ -166,6 +231,27 @@ namespace Engine
 
 	//////////////////////////////////////////////////////////////////////////
 
+	const JobsManager& GameController::getJobsManager() const
+	{
+		return m_jobsManager;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const CoroutinesManager& GameController::getCoroutinesManager() const
+	{
+		return m_coroutinesManager;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const Visual::FramePacing& GameController::getFramePacing() const
+	{
+		return m_framePacing;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
 	EntityID GameController::createPrefab(const std::string& prefabName)
 	{
 		Engine::EntityID id = m_entitiesManager.createEntity();
@@ -194,6 +280,35 @@ namespace Engine
 
 	//////////////////////////////////////////////////////////////////////////
 
+	std::vector<EntityID> GameController::createPrefabs(const std::string& prefabName, size_t count)
+	{
+		const auto& prefabItr = m_prefabs.find(prefabName);
+
+		ASSERT(prefabItr != m_prefabs.end(), "Prefab not found");
+		if (prefabItr == m_prefabs.end())
+		{
+			return {};
+		}
+
+		const nlohmann::json& prefabJson = prefabItr->second;
+		ASSERT(prefabJson.contains(k_componentsField), "Prefab must have {} field", k_componentsField);
+		if (!prefabJson.contains(k_componentsField))
+		{
+			return {};
+		}
+
+		// The jobs claim the ids of their batches, whatever they left is free again
+		EntityRange range = m_entitiesManager.reserveEntities(count);
+		m_componentsManager.createComponentsFromJson(range, prefabJson[k_componentsField], m_jobsManager);
+		m_entitiesManager.releaseEntities(range);
+
+		std::vector<EntityID> ids(range.getClaimedCount());
+		std::iota(ids.begin(), ids.end(), range.getFirst());
+		return ids;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
 	void GameController::createEntity(const nlohmann::json& entityJson)
 	{
 		Engine::EntityID id = m_entitiesManager.createEntity();
@@ -269,4 +384,94 @@ namespace Engine
 
 	//////////////////////////////////////////////////////////////////////////
 
+	void GameController::initJobs()
+	{
+		// One thread is left for the main loop, which also takes part in parallel jobs
+		size_t hardwareThreads = std::thread::hardware_concurrency();
+		size_t workersCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+		if (m_config.contains(k_workersCountField))
+		{
+			workersCount = m_config[k_workersCountField].get<size_t>();
+		}
+
+		m_jobsManager.init(workersCount);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void GameController::initFramePacing()
+	{
+		m_framePacing = Visual::FramePacing{};
+		if (m_config.contains(k_framePacingField))
+		{
+			Utils::Parser::fillFromJson(m_framePacing, m_config[k_framePacingField]);
+		}
+
+		ASSERT(m_framePacing.framesInFlight > 0, "framesInFlight must be positive");
+		m_framePacing.framesInFlight = std::max(m_framePacing.framesInFlight, 1);
+		m_frameLimiter.setMaxFps(m_framePacing.maxFps);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void GameController::initBenchmark()
+	{
+		Utils::BenchmarkSettings settings;
+		if (m_config.contains(k_benchmarkField))
+		{
+			Utils::Parser::fillFromJson(settings, m_config[k_benchmarkField]);
+		}
+
+		ASSERT(settings.frames <= 0 || !settings.outputFile.empty(), "Benchmark needs an outputFile");
+		m_benchmark.init(settings);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void GameController::initProfiler()
+	{
+		m_profilerEnabled = m_config.contains(k_profilerField);
+		if (!m_profilerEnabled)
+		{
+			return;
+		}
+
+		Utils::Parser::fillFromJson(m_profilerSettings, m_config[k_profilerField]);
+		ASSERT(!m_profilerSettings.outputFile.empty(), "Profiler needs an outputFile");
+		m_profilerEnabled = !m_profilerSettings.outputFile.empty();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void GameController::initMemory()
+	{
+		// Page allocation is opt-in, without a Memory section every buffer stays on the heap
+		if (!m_config.contains(k_memoryField))
+		{
+			return;
+		}
+
+		// Before anything is created, so every large buffer follows the configured policy
+		Utils::MemorySettings settings;
+		Utils::Parser::fillFromJson(settings, m_config[k_memoryField]);
+		Utils::PageMemory::init(settings);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void GameController::initAssets()
+	{
+		m_assetManifest.clear();
+		if (!m_config.contains(k_assetManifestField))
+		{
+			return;
+		}
+
+		std::string manifestPath = getConfigRelativePath(m_config[k_assetManifestField].get<std::string>());
+		bool loaded = m_assetManifest.load(manifestPath);
+		ASSERT(loaded, "Can't load asset manifest: {}", manifestPath);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
 }
\ No newline at end of file
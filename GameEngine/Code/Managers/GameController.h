@@ -6,8 +6,16 @@
 #include "ComponentsManager.h"
 #include "SystemsManager.h"
 #include "EntitiesManager.h"
+#include "JobsManager.h"
+#include "CoroutinesManager.h"
 
 #include "Visual/Window.h"
+#include "Visual/FramePacing.h"
+#include "Utils/FrameLimiter.h"
+#include "Utils/Benchmark.h"
+#include "Utils/SamplingProfiler.h"
+#include "Utils/PageMemory.h"
+#include "Utils/AssetManifest.h"
 
 namespace Engine
 {
@@ -21,6 +29,7 @@ namespace Engine
 		const Visual::Window& getWindow() const;
 		void setConfig(const std::string& configPath);
 		std::string getConfigRelativePath(const std::string& path) const;
+		std::string getAssetPath(const std::string& path) const; // Config relative, baked version when the manifest has one
 
 		void init();
 		void run();
@@ -30,13 +39,20 @@ namespace Engine
 		ComponentsManager& getComponentsManager();
 		SystemsManager& getSystemsManager();
 		EntitiesManager& getEntitiesManager();
+		JobsManager& getJobsManager();
+		CoroutinesManager& getCoroutinesManager();
 
 		const EventsManager& getEventsManager() const;
 		const ComponentsManager& getComponentsManager() const;
 		const SystemsManager& getSystemsManager() const;
 		const EntitiesManager& getEntitiesManager() const;
+		const JobsManager& getJobsManager() const;
+		const CoroutinesManager& getCoroutinesManager() const;
+
+		const Visual::FramePacing& getFramePacing() const;
 
 		EntityID createPrefab(const std::string& prefabName);
+		std::vector<EntityID> createPrefabs(const std::string& prefabName, size_t count);
 
 
 	private:
@@ -46,6 +62,12 @@ namespace Engine
 		void initPrefabs();
 		void initEntities();
 		void initSystems();
+		void initJobs();
+		void initFramePacing();
+		void initBenchmark();
+		void initProfiler();
+		void initMemory();
+		void initAssets();
 
 	private:
 		static constexpr const char* k_prefabsField = "Prefabs";
@@ -54,6 +76,12 @@ namespace Engine
 		static constexpr const char* k_nameField = "Name";
 		static constexpr const char* k_prefabField = "Prefab";
 		static constexpr const char* k_componentsField = "Components";
+		static constexpr const char* k_workersCountField = "WorkersCount";
+		static constexpr const char* k_framePacingField = "FramePacing";
+		static constexpr const char* k_benchmarkField = "Benchmark";
+		static constexpr const char* k_profilerField = "Profiler";
+		static constexpr const char* k_memoryField = "Memory";
+		static constexpr const char* k_assetManifestField = "AssetManifest";
 
 		static std::unique_ptr<GameController> m_instance;
 
@@ -61,11 +89,20 @@ namespace Engine
 		nlohmann::json m_config;
 		std::string m_configPath;
 		std::unordered_map<std::string, nlohmann::json> m_prefabs;
+		Visual::FramePacing m_framePacing;
+		Utils::FrameLimiter m_frameLimiter;
+		Utils::Benchmark m_benchmark;
+		Utils::SamplingProfiler m_profiler;
+		Utils::ProfilerSettings m_profilerSettings;
+		bool m_profilerEnabled = false;
+		Utils::AssetManifest m_assetManifest;
 
 		EventsManager m_eventsManager;
 		ComponentsManager m_componentsManager;
 		SystemsManager m_systemsManager;
 		EntitiesManager m_entitiesManager;
+		JobsManager m_jobsManager;
+		CoroutinesManager m_coroutinesManager;
 
 	};
 
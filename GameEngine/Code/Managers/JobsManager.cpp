@@ -0,0 +1,162 @@
+#include "JobsManager.h"
+
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+namespace Engine
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	void JobsManager::init(size_t workersCount)
+	{
+		stop();
+
+		m_stopRequested = false;
+		m_workers.reserve(workersCount);
+		for (size_t i = 0; i < workersCount; i++)
+		{
+			m_workers.emplace_back(&JobsManager::workerLoop, this);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void JobsManager::stop()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_stopRequested = true;
+		}
+		m_jobAvailable.notify_all();
+
+		for (std::thread& worker : m_workers)
+		{
+			worker.join();
+		}
+		m_workers.clear();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void JobsManager::submit(Job&& job)
+	{
+		if (m_workers.empty())
+		{
+			job();
+			return;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobs.emplace(std::move(job));
+			m_unfinishedJobs++;
+		}
+		m_jobAvailable.notify_one();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void JobsManager::parallelFor(size_t count, size_t batchSize, const RangeJob& job)
+	{
+		batchSize = std::max<size_t>(batchSize, 1);
+		size_t batchesCount = (count + batchSize - 1) / batchSize;
+		if (m_workers.empty() || batchesCount <= 1)
+		{
+			if (count > 0)
+			{
+				job(0, count);
+			}
+			return;
+		}
+
+		// Batches are pulled dynamically, so a slow batch doesn't stall a whole worker share.
+		// Helpers may only start once the loop is over, they then find no batch left and never touch the job
+		struct Batches
+		{
+			std::atomic<size_t> next = 0;
+			std::atomic<size_t> finished = 0;
+		};
+		auto batches = std::make_shared<Batches>();
+		const RangeJob* rangeJob = &job;
+		auto runBatches = [batches, rangeJob, batchesCount, batchSize, count]()
+			{
+				for (size_t batch = batches->next++; batch < batchesCount; batch = batches->next++)
+				{
+					size_t begin = batch * batchSize;
+					size_t end = std::min(begin + batchSize, count);
+					(*rangeJob)(begin, end);
+					batches->finished++;
+				}
+			};
+
+		size_t helpersCount = std::min(m_workers.size(), batchesCount - 1);
+		for (size_t i = 0; i < helpersCount; i++)
+		{
+			submit(runBatches);
+		}
+
+		runBatches();
+
+		// Only batches already running on other threads are waited for. Running unrelated queued jobs here
+		// could hold the caller for as long as a texture decode, and nested calls can't deadlock since
+		// every batch waited for is in progress
+		while (batches->finished < batchesCount)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void JobsManager::wait()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_jobsFinished.wait(lock, [this]() { return m_unfinishedJobs == 0; });
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t JobsManager::getWorkersCount() const
+	{
+		return m_workers.size();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	JobsManager::~JobsManager()
+	{
+		stop();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void JobsManager::workerLoop()
+	{
+		while (true)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_jobAvailable.wait(lock, [this]() { return m_stopRequested || !m_jobs.empty(); });
+				if (m_jobs.empty())
+				{
+					return;
+				}
+
+				job = std::move(m_jobs.front());
+				m_jobs.pop();
+			}
+
+			job();
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_unfinishedJobs--;
+			}
+			m_jobsFinished.notify_all();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
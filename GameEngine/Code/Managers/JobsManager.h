@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace Engine
+{
+	class JobsManager
+	{
+	public:
+		using Job = std::function<void()>;
+		using RangeJob = std::function<void(size_t, size_t)>;
+
+		void init(size_t workersCount);
+		void stop();
+
+		void submit(Job&& job);
+		void parallelFor(size_t count, size_t batchSize, const RangeJob& job);
+		void wait();
+
+		size_t getWorkersCount() const;
+
+		~JobsManager();
+
+	private:
+		void workerLoop();
+
+	private:
+		std::vector<std::thread> m_workers;
+		std::queue<Job> m_jobs;
+		std::mutex m_mutex;
+		std::condition_variable m_jobAvailable;
+		std::condition_variable m_jobsFinished;
+		size_t m_unfinishedJobs = 0;
+		bool m_stopRequested = false;
+	};
+}
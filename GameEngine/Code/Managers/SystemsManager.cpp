@@ -1,5 +1,7 @@
 #include "SystemsManager.h"
 
+#include <typeinfo>
+
 #include "Utils/DebugMacros.h"
 
 namespace Engine
@@ -77,6 +79,18 @@ namespace Engine
 
 	//////////////////////////////////////////////////////////////////////////
 
+	void SystemsManager::update(float dt, Utils::Benchmark& benchmark) const
+	{
+		for (const std::unique_ptr<Systems::ISystem>& system : m_systems)
+		{
+			benchmark.beginSection();
+			system->onUpdate(dt);
+			benchmark.endSection(typeid(*system).name());
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
 	void SystemsManager::stop() const
 	{
 		for (const std::unique_ptr<Systems::ISystem>& system : m_systems)
@@ -8,6 +8,7 @@
 
 #include "Utils/SparseSet.h"
 #include "Utils/BasicUtils.h"
+#include "Utils/Benchmark.h"
 #include "Systems/ISystem.h"
 
 namespace Engine
@@ -19,6 +20,7 @@ namespace Engine
 		void removeSystem(Systems::ISystem* system);
 		void loadSystemFromJson(const nlohmann::json& systemJson);
 		void update(float dt) const;
+		void update(float dt, Utils::Benchmark& benchmark) const; // Measures every system as a benchmark section
 		void stop() const;
 		void clear();
 		void processAddedSystems();
@@ -27,6 +29,10 @@ namespace Engine
 		template <class T>
 		void registerSystem();
 
+		// First running system of the type, nullptr when there is none
+		template <class T>
+		T* getSystem() const;
+
 	private:
 
 		struct LessPriority
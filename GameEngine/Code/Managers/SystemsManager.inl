@@ -20,5 +20,20 @@ namespace Engine
 	}
 
 	//////////////////////////////////////////////////////////////////////////
+
+	template<class T>
+	T* SystemsManager::getSystem() const
+	{
+		for (const std::unique_ptr<Systems::ISystem>& system : m_systems)
+		{
+			if (T* result = dynamic_cast<T*>(system.get()))
+			{
+				return result;
+			}
+		}
+		return nullptr;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
 }
 
@@ -0,0 +1,402 @@
+#include "Broadphase.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace Engine::Physics
+{
+	namespace
+	{
+		constexpr int64_t k_cellBits = 21;
+		constexpr int64_t k_cellOffset = int64_t(1) << (k_cellBits - 1);
+		constexpr int64_t k_cellMax = (int64_t(1) << k_cellBits) - 1;
+
+		//////////////////////////////////////////////////////////////////////////
+
+		const std::vector<float>& getMin(const Utils::AABBBatch& boxes, int axis)
+		{
+			return axis == 0 ? boxes.minX : axis == 1 ? boxes.minY : boxes.minZ;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		const std::vector<float>& getMax(const Utils::AABBBatch& boxes, int axis)
+		{
+			return axis == 0 ? boxes.maxX : axis == 1 ? boxes.maxY : boxes.maxZ;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		bool overlaps(const Utils::AABBBatch& boxes, size_t a, size_t b)
+		{
+			return boxes.minX[a] <= boxes.maxX[b] && boxes.minX[b] <= boxes.maxX[a]
+				&& boxes.minY[a] <= boxes.maxY[b] && boxes.minY[b] <= boxes.maxY[a]
+				&& boxes.minZ[a] <= boxes.maxZ[b] && boxes.minZ[b] <= boxes.maxZ[a];
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		OverlapPair makePair(uint32_t a, uint32_t b)
+		{
+			return a < b ? OverlapPair{ a, b } : OverlapPair{ b, a };
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Batches write to their own vector, joined in batch order so the result does not depend on scheduling
+		void gatherPairs(const std::vector<std::vector<OverlapPair>>& batchPairs, std::vector<OverlapPair>& pairs)
+		{
+			size_t count = 0;
+			for (const std::vector<OverlapPair>& batch : batchPairs)
+			{
+				count += batch.size();
+			}
+
+			pairs.reserve(count);
+			for (const std::vector<OverlapPair>& batch : batchPairs)
+			{
+				pairs.insert(pairs.end(), batch.begin(), batch.end());
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		void resetBatches(std::vector<std::vector<OverlapPair>>& batchPairs, size_t count, size_t batchSize)
+		{
+			batchPairs.resize((count + batchSize - 1) / batchSize);
+			for (std::vector<OverlapPair>& batch : batchPairs)
+			{
+				batch.clear();
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SweepAndPrune::findPairs(const Utils::AABBBatch& boxes, JobsManager& jobsManager, size_t batchSize, std::vector<OverlapPair>& pairs)
+	{
+		pairs.clear();
+		size_t count = boxes.size();
+		batchSize = std::max<size_t>(batchSize, 1);
+
+		int axis = chooseAxis(boxes);
+		const std::vector<float>& axisMin = getMin(boxes, axis);
+
+		m_fullySorted = axis != m_axis || m_order.size() != count;
+		m_axis = axis;
+		m_lastSwapsCount = 0;
+
+		if (!m_fullySorted)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				m_keys[i] = axisMin[m_order[i]];
+			}
+
+			// Too many swaps means the scene changed a lot, a regular sort is cheaper from there
+			m_fullySorted = !insertionSort(k_maxSwapsPerBox * count);
+		}
+
+		if (m_fullySorted)
+		{
+			m_order.resize(count);
+			std::iota(m_order.begin(), m_order.end(), 0);
+			std::sort(m_order.begin(), m_order.end(), [&axisMin](uint32_t a, uint32_t b) { return axisMin[a] < axisMin[b]; });
+
+			m_keys.resize(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				m_keys[i] = axisMin[m_order[i]];
+			}
+		}
+
+		if (count < 2)
+		{
+			return;
+		}
+
+		m_sorted.minX.resize(count);
+		m_sorted.minY.resize(count);
+		m_sorted.minZ.resize(count);
+		m_sorted.maxX.resize(count);
+		m_sorted.maxY.resize(count);
+		m_sorted.maxZ.resize(count);
+		jobsManager.parallelFor(count, batchSize, [this, &boxes](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					uint32_t box = m_order[i];
+					m_sorted.minX[i] = boxes.minX[box];
+					m_sorted.minY[i] = boxes.minY[box];
+					m_sorted.minZ[i] = boxes.minZ[box];
+					m_sorted.maxX[i] = boxes.maxX[box];
+					m_sorted.maxY[i] = boxes.maxY[box];
+					m_sorted.maxZ[i] = boxes.maxZ[box];
+				}
+			});
+
+		// Each box only looks forward, at the boxes starting before it ends along the axis
+		resetBatches(m_batchPairs, count, batchSize);
+		jobsManager.parallelFor(count, batchSize, [this, count, batchSize](size_t begin, size_t end)
+			{
+				const std::vector<float>& sortMin = getMin(m_sorted, m_axis);
+				const std::vector<float>& sortMax = getMax(m_sorted, m_axis);
+				const std::vector<float>& minU = getMin(m_sorted, (m_axis + 1) % 3);
+				const std::vector<float>& maxU = getMax(m_sorted, (m_axis + 1) % 3);
+				const std::vector<float>& minV = getMin(m_sorted, (m_axis + 2) % 3);
+				const std::vector<float>& maxV = getMax(m_sorted, (m_axis + 2) % 3);
+
+				std::vector<OverlapPair>& batchPairs = m_batchPairs[begin / batchSize];
+				for (size_t i = begin; i < end; i++)
+				{
+					float boxEnd = sortMax[i];
+					for (size_t j = i + 1; j < count && sortMin[j] <= boxEnd; j++)
+					{
+						if (minU[i] <= maxU[j] && minU[j] <= maxU[i] && minV[i] <= maxV[j] && minV[j] <= maxV[i])
+						{
+							batchPairs.push_back(makePair(m_order[i], m_order[j]));
+						}
+					}
+				}
+			});
+
+		gatherPairs(m_batchPairs, pairs);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int SweepAndPrune::getAxis() const
+	{
+		return m_axis;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t SweepAndPrune::getLastSwapsCount() const
+	{
+		return m_lastSwapsCount;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool SweepAndPrune::wasFullySorted() const
+	{
+		return m_fullySorted;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int SweepAndPrune::chooseAxis(const Utils::AABBBatch& boxes) const
+	{
+		size_t count = boxes.size();
+		if (count == 0)
+		{
+			return std::max(m_axis, 0);
+		}
+
+		double variance[3] = {};
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const std::vector<float>& axisMin = getMin(boxes, axis);
+			const std::vector<float>& axisMax = getMax(boxes, axis);
+
+			double sum = 0.0;
+			double squaresSum = 0.0;
+			for (size_t i = 0; i < count; i++)
+			{
+				double center = 0.5 * ((double)axisMin[i] + (double)axisMax[i]);
+				sum += center;
+				squaresSum += center * center;
+			}
+
+			double mean = sum / (double)count;
+			variance[axis] = squaresSum / (double)count - mean * mean;
+		}
+
+		int bestAxis = (int)(std::max_element(variance, variance + 3) - variance);
+
+		// Switching axis throws away the previous order, so it has to be clearly better
+		if (m_axis >= 0 && variance[bestAxis] < variance[m_axis] * k_axisSwitchRatio)
+		{
+			return m_axis;
+		}
+		return bestAxis;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool SweepAndPrune::insertionSort(size_t maxSwaps)
+	{
+		for (size_t i = 1; i < m_keys.size(); i++)
+		{
+			float key = m_keys[i];
+			uint32_t box = m_order[i];
+
+			size_t j = i;
+			while (j > 0 && m_keys[j - 1] > key)
+			{
+				m_keys[j] = m_keys[j - 1];
+				m_order[j] = m_order[j - 1];
+				j--;
+			}
+			m_keys[j] = key;
+			m_order[j] = box;
+
+			m_lastSwapsCount += i - j;
+			if (m_lastSwapsCount > maxSwaps)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SpatialHash::findPairs(const Utils::AABBBatch& boxes, float cellSize, JobsManager& jobsManager, size_t batchSize, std::vector<OverlapPair>& pairs)
+	{
+		pairs.clear();
+		size_t count = boxes.size();
+		batchSize = std::max<size_t>(batchSize, 1);
+
+		if (cellSize <= 0.0f && count > 0)
+		{
+			double sizesSum = 0.0;
+			for (size_t i = 0; i < count; i++)
+			{
+				sizesSum += std::max({ boxes.maxX[i] - boxes.minX[i], boxes.maxY[i] - boxes.minY[i], boxes.maxZ[i] - boxes.minZ[i] });
+			}
+			cellSize = (float)(sizesSum / (double)count);
+		}
+		m_cellSize = cellSize > 0.0f ? cellSize : 1.0f;
+
+		if (count < 2)
+		{
+			return;
+		}
+
+		// Counting first lets every box write its entries in place, without locks
+		m_entryOffsets.resize(count + 1);
+		m_entryOffsets[0] = 0;
+		jobsManager.parallelFor(count, batchSize, [this, &boxes](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					CellRange cells = getCells(boxes, i);
+					m_entryOffsets[i + 1] = (uint32_t)((cells.max[0] - cells.min[0] + 1) * (cells.max[1] - cells.min[1] + 1) * (cells.max[2] - cells.min[2] + 1));
+				}
+			});
+		std::partial_sum(m_entryOffsets.begin(), m_entryOffsets.end(), m_entryOffsets.begin());
+
+		m_entries.resize(m_entryOffsets[count]);
+		jobsManager.parallelFor(count, batchSize, [this, &boxes](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					CellRange cells = getCells(boxes, i);
+					CellEntry* entry = &m_entries[m_entryOffsets[i]];
+					for (int64_t z = cells.min[2]; z <= cells.max[2]; z++)
+					{
+						for (int64_t y = cells.min[1]; y <= cells.max[1]; y++)
+						{
+							for (int64_t x = cells.min[0]; x <= cells.max[0]; x++)
+							{
+								*entry++ = { getKey(x, y, z), (uint32_t)i };
+							}
+						}
+					}
+				}
+			});
+
+		std::sort(m_entries.begin(), m_entries.end(), [](const CellEntry& a, const CellEntry& b)
+			{
+				return a.key < b.key || (a.key == b.key && a.box < b.box);
+			});
+
+		m_cellStarts.clear();
+		for (size_t i = 0; i < m_entries.size(); i++)
+		{
+			if (i == 0 || m_entries[i].key != m_entries[i - 1].key)
+			{
+				m_cellStarts.push_back((uint32_t)i);
+			}
+		}
+		size_t cellsCount = m_cellStarts.size();
+		m_cellStarts.push_back((uint32_t)m_entries.size());
+
+		// Boxes sharing several cells would be found in each of them, only the cell holding
+		// the minimum corner of their intersection reports the pair
+		resetBatches(m_batchPairs, cellsCount, batchSize);
+		jobsManager.parallelFor(cellsCount, batchSize, [this, &boxes, batchSize](size_t begin, size_t end)
+			{
+				std::vector<OverlapPair>& batchPairs = m_batchPairs[begin / batchSize];
+				for (size_t cell = begin; cell < end; cell++)
+				{
+					uint32_t cellEnd = m_cellStarts[cell + 1];
+					for (uint32_t a = m_cellStarts[cell]; a < cellEnd; a++)
+					{
+						uint32_t boxA = m_entries[a].box;
+						for (uint32_t b = a + 1; b < cellEnd; b++)
+						{
+							uint32_t boxB = m_entries[b].box;
+							if (!overlaps(boxes, boxA, boxB))
+							{
+								continue;
+							}
+
+							uint64_t ownerKey = getKey(
+								getCell(std::max(boxes.minX[boxA], boxes.minX[boxB])),
+								getCell(std::max(boxes.minY[boxA], boxes.minY[boxB])),
+								getCell(std::max(boxes.minZ[boxA], boxes.minZ[boxB])));
+							if (ownerKey == m_entries[a].key)
+							{
+								batchPairs.push_back(makePair(boxA, boxB));
+							}
+						}
+					}
+				}
+			});
+
+		gatherPairs(m_batchPairs, pairs);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	float SpatialHash::getCellSize() const
+	{
+		return m_cellSize;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	SpatialHash::CellRange SpatialHash::getCells(const Utils::AABBBatch& boxes, size_t box) const
+	{
+		CellRange cells;
+		cells.min[0] = getCell(boxes.minX[box]);
+		cells.min[1] = getCell(boxes.minY[box]);
+		cells.min[2] = getCell(boxes.minZ[box]);
+		cells.max[0] = getCell(boxes.maxX[box]);
+		cells.max[1] = getCell(boxes.maxY[box]);
+		cells.max[2] = getCell(boxes.maxZ[box]);
+		return cells;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	// Cells out of the 21 bit range are clamped to the border, which only costs extra tests there
+	int64_t SpatialHash::getCell(float value) const
+	{
+		double cell = std::floor((double)value / (double)m_cellSize) + (double)k_cellOffset;
+		return static_cast<int64_t>(std::clamp(cell, 0.0, (double)k_cellMax));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	uint64_t SpatialHash::getKey(int64_t x, int64_t y, int64_t z)
+	{
+		return (uint64_t)x | (uint64_t)y << k_cellBits | (uint64_t)z << (2 * k_cellBits);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Managers/JobsManager.h"
+#include "Utils/Geometry.h"
+
+namespace Engine::Physics
+{
+	// Indices of two overlapping boxes of the batch given to findPairs, first is always the smaller one
+	struct OverlapPair
+	{
+		uint32_t first;
+		uint32_t second;
+	};
+
+	/**
+	 * @brief      Sweep and prune along the axis where the boxes are spread the most.
+	 *
+	 *             The order of the previous frame is kept and fixed with an insertion
+	 *             sort, which is close to linear while objects move little between frames.
+	 *             Boxes must keep their index from one call to the next for that to pay off.
+	 */
+	class SweepAndPrune
+	{
+	public:
+		/**
+		 * @brief      Finds every pair of overlapping boxes.
+		 *
+		 * @param[in]  boxes        The boxes.
+		 * @param      jobsManager  Runs the sweep, batchSize sorted boxes per job.
+		 * @param[in]  batchSize    The batch size.
+		 * @param[out] pairs        The overlapping pairs, grouped by batch in sorted order.
+		 */
+		void findPairs(const Utils::AABBBatch& boxes, JobsManager& jobsManager, size_t batchSize, std::vector<OverlapPair>& pairs);
+
+		int getAxis() const;
+		size_t getLastSwapsCount() const; // Insertion sort swaps of the last call
+		bool wasFullySorted() const; // True when the last call sorted from scratch instead of fixing the previous order
+
+	private:
+		int chooseAxis(const Utils::AABBBatch& boxes) const;
+		bool insertionSort(size_t maxSwaps);
+
+	private:
+		static constexpr float k_axisSwitchRatio = 1.5f; // Keeps the axis until another one is spread this much more
+		static constexpr size_t k_maxSwapsPerBox = 16;
+
+		int m_axis = -1;
+		std::vector<uint32_t> m_order; // Box indices sorted by their minimum along the axis
+		std::vector<float> m_keys; // Minimum of m_order[i] along the axis
+		Utils::AABBBatch m_sorted; // Boxes in sorted order, read linearly by the sweep
+		std::vector<std::vector<OverlapPair>> m_batchPairs;
+
+		size_t m_lastSwapsCount = 0;
+		bool m_fullySorted = false;
+	};
+
+	/**
+	 * @brief      Uniform grid stored as a sorted array of (cell, box) entries.
+	 *
+	 *             Each box goes into every cell it touches and the boxes sharing a
+	 *             cell are tested together. Works for any motion but boxes much larger
+	 *             than a cell are inserted in many cells.
+	 */
+	class SpatialHash
+	{
+	public:
+		/**
+		 * @brief      Finds every pair of overlapping boxes.
+		 *
+		 * @param[in]  boxes        The boxes.
+		 * @param[in]  cellSize     The cell size, the average box size is used when not positive.
+		 * @param      jobsManager  Runs the insertion and the tests, batchSize boxes or cells per job.
+		 * @param[in]  batchSize    The batch size.
+		 * @param[out] pairs        The overlapping pairs, each reported once.
+		 */
+		void findPairs(const Utils::AABBBatch& boxes, float cellSize, JobsManager& jobsManager, size_t batchSize, std::vector<OverlapPair>& pairs);
+
+		float getCellSize() const; // Cell size of the last call
+
+	private:
+		struct CellEntry
+		{
+			uint64_t key;
+			uint32_t box;
+		};
+
+		struct CellRange
+		{
+			int64_t min[3];
+			int64_t max[3];
+		};
+
+	private:
+		CellRange getCells(const Utils::AABBBatch& boxes, size_t box) const;
+		int64_t getCell(float value) const;
+		static uint64_t getKey(int64_t x, int64_t y, int64_t z);
+
+	private:
+		float m_cellSize = 1.0f;
+		std::vector<uint32_t> m_entryOffsets; // First entry of each box, prefix sum of the cells they touch
+		std::vector<CellEntry> m_entries;
+		std::vector<uint32_t> m_cellStarts; // First entry of each occupied cell, plus the entries count
+		std::vector<std::vector<OverlapPair>> m_batchPairs;
+	};
+}
@@ -0,0 +1,540 @@
+#include "ContactSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+#include <limits>
+#include <numeric>
+
+#include "Utils/Geometry.h"
+
+namespace Engine::Physics
+{
+	namespace
+	{
+		using Utils::Vector3;
+
+		constexpr size_t k_lanes = 4;
+		constexpr size_t k_groupSearchWindow = 8; // Open groups tried before starting a new one
+		constexpr int32_t k_staticBody = -1;
+
+		enum RowId
+		{
+			TangentRow1 = 0,
+			TangentRow2,
+			NormalRow,
+			RowsCount
+		};
+
+		// One velocity constraint for 4 contacts, lane by lane
+		struct alignas(16) ConstraintRow
+		{
+			float direction[3][k_lanes];
+			float angularA[3][k_lanes]; // rA x direction
+			float angularB[3][k_lanes]; // rB x direction
+			float inverseAngularA[3][k_lanes]; // World inverse inertia of A times angularA
+			float inverseAngularB[3][k_lanes];
+			float mass[k_lanes]; // Effective mass, 0 in unused lanes so they never apply anything
+			float impulse[k_lanes]; // Accumulated over the iterations
+		};
+
+		// Contacts solved together, none of them share a dynamic body so their results can be written back at once
+		struct alignas(16) ConstraintGroup
+		{
+			int32_t bodyA[k_lanes];
+			int32_t bodyB[k_lanes];
+			float inverseMassA[k_lanes];
+			float inverseMassB[k_lanes];
+			float bias[k_lanes]; // Target separating velocity of the normal row
+			float friction[k_lanes];
+			ConstraintRow rows[RowsCount];
+			size_t lanesCount;
+		};
+
+		//////////////////////////////////////////////////////////////////////////
+
+		Vector3 multiply(const Vector3 matrix[3], const Vector3& vector)
+		{
+			return Vector3(
+				Vector3::dotProduct(matrix[0], vector),
+				Vector3::dotProduct(matrix[1], vector),
+				Vector3::dotProduct(matrix[2], vector));
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		void setLane(float values[3][k_lanes], size_t lane, const Vector3& vector)
+		{
+			values[0][lane] = vector.x;
+			values[1][lane] = vector.y;
+			values[2][lane] = vector.z;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		Vector3 getLane(const float values[3][k_lanes], size_t lane)
+		{
+			return Vector3(values[0][lane], values[1][lane], values[2][lane]);
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Any unit vector perpendicular to the normal
+		Vector3 getTangent(const Vector3& normal)
+		{
+			Vector3 tangent = std::abs(normal.x) >= 0.57735f ? Vector3(normal.y, -normal.x, 0.0f) : Vector3(0.0f, normal.z, -normal.y);
+			return tangent.normalized();
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		Vector3 getPointVelocity(const SolverBody& body, const Vector3& offset)
+		{
+			return body.velocity + Vector3::crossProduct(body.angularVelocity, offset);
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		void prepareRow(ConstraintRow& row, size_t lane, const Vector3& direction, const Vector3& offsetA, const Vector3& offsetB, const SolverBody& bodyA, const SolverBody& bodyB)
+		{
+			Vector3 angularA = Vector3::crossProduct(offsetA, direction);
+			Vector3 angularB = Vector3::crossProduct(offsetB, direction);
+			Vector3 inverseAngularA = multiply(bodyA.inverseInertia, angularA);
+			Vector3 inverseAngularB = multiply(bodyB.inverseInertia, angularB);
+
+			float inverseMass = bodyA.inverseMass + bodyB.inverseMass
+				+ Vector3::dotProduct(angularA, inverseAngularA)
+				+ Vector3::dotProduct(angularB, inverseAngularB);
+
+			setLane(row.direction, lane, direction);
+			setLane(row.angularA, lane, angularA);
+			setLane(row.angularB, lane, angularB);
+			setLane(row.inverseAngularA, lane, inverseAngularA);
+			setLane(row.inverseAngularB, lane, inverseAngularB);
+			row.mass[lane] = inverseMass > 0.0f ? 1.0f / inverseMass : 0.0f;
+			row.impulse[lane] = 0.0f;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		void prepareLane(ConstraintGroup& group, size_t lane, const Contact& contact, const std::vector<SolverBody>& bodies, const SolverSettings& settings, float dt)
+		{
+			const SolverBody& bodyA = bodies[contact.first];
+			const SolverBody& bodyB = bodies[contact.second];
+			Vector3 offsetA = contact.point - bodyA.position;
+			Vector3 offsetB = contact.point - bodyB.position;
+
+			group.bodyA[lane] = bodyA.inverseMass > 0.0f ? (int32_t)contact.first : k_staticBody;
+			group.bodyB[lane] = bodyB.inverseMass > 0.0f ? (int32_t)contact.second : k_staticBody;
+			group.inverseMassA[lane] = bodyA.inverseMass;
+			group.inverseMassB[lane] = bodyB.inverseMass;
+			group.friction[lane] = std::sqrt(bodyA.friction * bodyB.friction);
+
+			Vector3 tangent1 = getTangent(contact.normal);
+			Vector3 tangent2 = Vector3::crossProduct(contact.normal, tangent1);
+			prepareRow(group.rows[TangentRow1], lane, tangent1, offsetA, offsetB, bodyA, bodyB);
+			prepareRow(group.rows[TangentRow2], lane, tangent2, offsetA, offsetB, bodyA, bodyB);
+			prepareRow(group.rows[NormalRow], lane, contact.normal, offsetA, offsetB, bodyA, bodyB);
+
+			// Baumgarte stabilization pushes penetrating bodies apart, restitution keeps part of the approach speed
+			float bias = settings.baumgarte / dt * std::max(contact.depth - settings.slop, 0.0f);
+			float approachSpeed = Vector3::dotProduct(contact.normal, getPointVelocity(bodyB, offsetB) - getPointVelocity(bodyA, offsetA));
+			if (approachSpeed < -settings.restitutionThreshold)
+			{
+				bias = std::max(bias, -std::max(bodyA.restitution, bodyB.restitution) * approachSpeed);
+			}
+			group.bias[lane] = bias;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		bool usesBody(const ConstraintGroup& group, int32_t body)
+		{
+			if (body == k_staticBody)
+			{
+				return false;
+			}
+
+			for (size_t lane = 0; lane < group.lanesCount; lane++)
+			{
+				if (group.bodyA[lane] == body || group.bodyB[lane] == body)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		ConstraintGroup& findGroup(std::vector<ConstraintGroup>& groups, int32_t bodyA, int32_t bodyB)
+		{
+			size_t first = groups.size() > k_groupSearchWindow ? groups.size() - k_groupSearchWindow : 0;
+			for (size_t i = first; i < groups.size(); i++)
+			{
+				ConstraintGroup& group = groups[i];
+				if (group.lanesCount < k_lanes && !usesBody(group, bodyA) && !usesBody(group, bodyB))
+				{
+					return group;
+				}
+			}
+
+			ConstraintGroup& group = groups.emplace_back();
+			std::fill(group.bodyA, group.bodyA + k_lanes, k_staticBody);
+			std::fill(group.bodyB, group.bodyB + k_lanes, k_staticBody);
+			return group;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		void solveRowScalar(ConstraintRow& row, size_t lane, float bias, float minImpulse, float maxImpulse, float inverseMassA, float inverseMassB,
+			Vector3& velocityA, Vector3& angularVelocityA, Vector3& velocityB, Vector3& angularVelocityB)
+		{
+			Vector3 direction = getLane(row.direction, lane);
+			float relativeVelocity = Vector3::dotProduct(direction, velocityB - velocityA)
+				+ Vector3::dotProduct(getLane(row.angularB, lane), angularVelocityB)
+				- Vector3::dotProduct(getLane(row.angularA, lane), angularVelocityA);
+
+			float oldImpulse = row.impulse[lane];
+			float newImpulse = std::clamp(oldImpulse + row.mass[lane] * (bias - relativeVelocity), minImpulse, maxImpulse);
+			float lambda = newImpulse - oldImpulse;
+			row.impulse[lane] = newImpulse;
+
+			velocityA -= direction * (inverseMassA * lambda);
+			angularVelocityA -= getLane(row.inverseAngularA, lane) * lambda;
+			velocityB += direction * (inverseMassB * lambda);
+			angularVelocityB += getLane(row.inverseAngularB, lane) * lambda;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		void solveLaneScalar(ConstraintGroup& group, size_t lane, std::vector<SolverBody>& bodies)
+		{
+			int32_t idA = group.bodyA[lane];
+			int32_t idB = group.bodyB[lane];
+			Vector3 velocityA = idA != k_staticBody ? bodies[idA].velocity : Vector3();
+			Vector3 angularVelocityA = idA != k_staticBody ? bodies[idA].angularVelocity : Vector3();
+			Vector3 velocityB = idB != k_staticBody ? bodies[idB].velocity : Vector3();
+			Vector3 angularVelocityB = idB != k_staticBody ? bodies[idB].angularVelocity : Vector3();
+
+			// Friction first, bounded by the normal impulse of the previous iteration
+			float maxFriction = group.friction[lane] * group.rows[NormalRow].impulse[lane];
+			for (int rowId = TangentRow1; rowId <= TangentRow2; rowId++)
+			{
+				solveRowScalar(group.rows[rowId], lane, 0.0f, -maxFriction, maxFriction, group.inverseMassA[lane], group.inverseMassB[lane],
+					velocityA, angularVelocityA, velocityB, angularVelocityB);
+			}
+			solveRowScalar(group.rows[NormalRow], lane, group.bias[lane], 0.0f, std::numeric_limits<float>::max(), group.inverseMassA[lane], group.inverseMassB[lane],
+				velocityA, angularVelocityA, velocityB, angularVelocityB);
+
+			if (idA != k_staticBody)
+			{
+				bodies[idA].velocity = velocityA;
+				bodies[idA].angularVelocity = angularVelocityA;
+			}
+			if (idB != k_staticBody)
+			{
+				bodies[idB].velocity = velocityB;
+				bodies[idB].angularVelocity = angularVelocityB;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// SSE, the 4 contacts of a group at once
+		//////////////////////////////////////////////////////////////////////////
+
+		struct Vector3x4
+		{
+			__m128 x;
+			__m128 y;
+			__m128 z;
+		};
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Static bodies read as not moving
+		void gatherVelocities(const std::vector<SolverBody>& bodies, const int32_t ids[k_lanes], Vector3x4& velocity, Vector3x4& angularVelocity)
+		{
+			alignas(16) float values[6][k_lanes];
+			for (size_t lane = 0; lane < k_lanes; lane++)
+			{
+				Vector3 linear = ids[lane] != k_staticBody ? bodies[ids[lane]].velocity : Vector3();
+				Vector3 angular = ids[lane] != k_staticBody ? bodies[ids[lane]].angularVelocity : Vector3();
+				values[0][lane] = linear.x;
+				values[1][lane] = linear.y;
+				values[2][lane] = linear.z;
+				values[3][lane] = angular.x;
+				values[4][lane] = angular.y;
+				values[5][lane] = angular.z;
+			}
+
+			velocity = { _mm_load_ps(values[0]), _mm_load_ps(values[1]), _mm_load_ps(values[2]) };
+			angularVelocity = { _mm_load_ps(values[3]), _mm_load_ps(values[4]), _mm_load_ps(values[5]) };
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		void scatterVelocities(std::vector<SolverBody>& bodies, const int32_t ids[k_lanes], const Vector3x4& velocity, const Vector3x4& angularVelocity)
+		{
+			alignas(16) float values[6][k_lanes];
+			_mm_store_ps(values[0], velocity.x);
+			_mm_store_ps(values[1], velocity.y);
+			_mm_store_ps(values[2], velocity.z);
+			_mm_store_ps(values[3], angularVelocity.x);
+			_mm_store_ps(values[4], angularVelocity.y);
+			_mm_store_ps(values[5], angularVelocity.z);
+
+			for (size_t lane = 0; lane < k_lanes; lane++)
+			{
+				if (ids[lane] != k_staticBody)
+				{
+					bodies[ids[lane]].velocity = Vector3(values[0][lane], values[1][lane], values[2][lane]);
+					bodies[ids[lane]].angularVelocity = Vector3(values[3][lane], values[4][lane], values[5][lane]);
+				}
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		__m128 dotSSE(const float values[3][k_lanes], const Vector3x4& vector)
+		{
+			return _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_load_ps(values[0]), vector.x),
+				_mm_mul_ps(_mm_load_ps(values[1]), vector.y)),
+				_mm_mul_ps(_mm_load_ps(values[2]), vector.z));
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		void addScaledSSE(Vector3x4& vector, const float values[3][k_lanes], __m128 scale)
+		{
+			vector.x = _mm_add_ps(vector.x, _mm_mul_ps(_mm_load_ps(values[0]), scale));
+			vector.y = _mm_add_ps(vector.y, _mm_mul_ps(_mm_load_ps(values[1]), scale));
+			vector.z = _mm_add_ps(vector.z, _mm_mul_ps(_mm_load_ps(values[2]), scale));
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		void solveRowSSE(ConstraintRow& row, __m128 bias, __m128 minImpulse, __m128 maxImpulse, __m128 inverseMassA, __m128 inverseMassB,
+			Vector3x4& velocityA, Vector3x4& angularVelocityA, Vector3x4& velocityB, Vector3x4& angularVelocityB)
+		{
+			Vector3x4 velocityDelta = {
+				_mm_sub_ps(velocityB.x, velocityA.x),
+				_mm_sub_ps(velocityB.y, velocityA.y),
+				_mm_sub_ps(velocityB.z, velocityA.z)
+			};
+			__m128 relativeVelocity = _mm_sub_ps(
+				_mm_add_ps(dotSSE(row.direction, velocityDelta), dotSSE(row.angularB, angularVelocityB)),
+				dotSSE(row.angularA, angularVelocityA));
+
+			__m128 oldImpulse = _mm_load_ps(row.impulse);
+			__m128 newImpulse = _mm_add_ps(oldImpulse, _mm_mul_ps(_mm_load_ps(row.mass), _mm_sub_ps(bias, relativeVelocity)));
+			newImpulse = _mm_min_ps(_mm_max_ps(newImpulse, minImpulse), maxImpulse);
+			__m128 lambda = _mm_sub_ps(newImpulse, oldImpulse);
+			_mm_store_ps(row.impulse, newImpulse);
+
+			__m128 negativeLambda = _mm_sub_ps(_mm_setzero_ps(), lambda);
+			addScaledSSE(velocityA, row.direction, _mm_mul_ps(inverseMassA, negativeLambda));
+			addScaledSSE(angularVelocityA, row.inverseAngularA, negativeLambda);
+			addScaledSSE(velocityB, row.direction, _mm_mul_ps(inverseMassB, lambda));
+			addScaledSSE(angularVelocityB, row.inverseAngularB, lambda);
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		void solveGroupSSE(ConstraintGroup& group, std::vector<SolverBody>& bodies)
+		{
+			Vector3x4 velocityA, angularVelocityA, velocityB, angularVelocityB;
+			gatherVelocities(bodies, group.bodyA, velocityA, angularVelocityA);
+			gatherVelocities(bodies, group.bodyB, velocityB, angularVelocityB);
+
+			__m128 inverseMassA = _mm_load_ps(group.inverseMassA);
+			__m128 inverseMassB = _mm_load_ps(group.inverseMassB);
+
+			__m128 maxFriction = _mm_mul_ps(_mm_load_ps(group.friction), _mm_load_ps(group.rows[NormalRow].impulse));
+			__m128 minFriction = _mm_sub_ps(_mm_setzero_ps(), maxFriction);
+			for (int rowId = TangentRow1; rowId <= TangentRow2; rowId++)
+			{
+				solveRowSSE(group.rows[rowId], _mm_setzero_ps(), minFriction, maxFriction, inverseMassA, inverseMassB,
+					velocityA, angularVelocityA, velocityB, angularVelocityB);
+			}
+			solveRowSSE(group.rows[NormalRow], _mm_load_ps(group.bias), _mm_setzero_ps(), _mm_set1_ps(std::numeric_limits<float>::max()), inverseMassA, inverseMassB,
+				velocityA, angularVelocityA, velocityB, angularVelocityB);
+
+			scatterVelocities(bodies, group.bodyA, velocityA, angularVelocityA);
+			scatterVelocities(bodies, group.bodyB, velocityB, angularVelocityB);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void ContactSolver::solve(std::vector<SolverBody>& bodies, const std::vector<Contact>& contacts, const SolverSettings& settings, float dt, JobsManager& jobsManager, size_t batchSize)
+	{
+		buildIslands(bodies, contacts);
+
+		size_t islandsCount = getIslandsCount();
+		m_islandGroups.assign(islandsCount, 0);
+		if (islandsCount == 0 || dt <= 0.0f)
+		{
+			m_laneOccupancy = 0.0f;
+			return;
+		}
+
+		jobsManager.parallelFor(islandsCount, batchSize, [this, &bodies, &contacts, &settings, dt](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					uint32_t island = m_islandOrder[i];
+					m_islandGroups[island] = solveIsland(island, bodies, contacts, settings, dt);
+				}
+			});
+
+		size_t groupsCount = std::accumulate(m_islandGroups.begin(), m_islandGroups.end(), size_t(0));
+		m_laneOccupancy = groupsCount > 0 ? (float)m_contactOrder.size() / (float)(groupsCount * k_lanes) : 0.0f;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t ContactSolver::getIslandsCount() const
+	{
+		return m_islandStarts.empty() ? 0 : m_islandStarts.size() - 1;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t ContactSolver::getLargestIslandContacts() const
+	{
+		return m_largestIsland;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	float ContactSolver::getLaneOccupancy() const
+	{
+		return m_laneOccupancy;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void ContactSolver::buildIslands(const std::vector<SolverBody>& bodies, const std::vector<Contact>& contacts)
+	{
+		m_parents.resize(bodies.size());
+		std::iota(m_parents.begin(), m_parents.end(), 0);
+
+		// Static bodies do not join islands, a floor would merge everything lying on it
+		for (const Contact& contact : contacts)
+		{
+			if (bodies[contact.first].inverseMass > 0.0f && bodies[contact.second].inverseMass > 0.0f)
+			{
+				uint32_t rootA = findRoot(contact.first);
+				uint32_t rootB = findRoot(contact.second);
+				if (rootA != rootB)
+				{
+					m_parents[std::max(rootA, rootB)] = std::min(rootA, rootB);
+				}
+			}
+		}
+
+		m_rootIslands.assign(bodies.size(), k_noIsland);
+		m_islandStarts.clear();
+		m_contactIslands.resize(contacts.size());
+		for (size_t i = 0; i < contacts.size(); i++)
+		{
+			const Contact& contact = contacts[i];
+			uint32_t body = bodies[contact.first].inverseMass > 0.0f ? contact.first : contact.second;
+			if (bodies[body].inverseMass <= 0.0f)
+			{
+				m_contactIslands[i] = k_noIsland;
+				continue;
+			}
+
+			uint32_t root = findRoot(body);
+			if (m_rootIslands[root] == k_noIsland)
+			{
+				m_rootIslands[root] = (uint32_t)m_islandStarts.size();
+				m_islandStarts.push_back(0);
+			}
+			m_contactIslands[i] = m_rootIslands[root];
+			m_islandStarts[m_contactIslands[i]]++;
+		}
+
+		size_t islandsCount = m_islandStarts.size();
+		m_largestIsland = islandsCount > 0 ? *std::max_element(m_islandStarts.begin(), m_islandStarts.end()) : 0;
+
+		m_islandOrder.resize(islandsCount);
+		std::iota(m_islandOrder.begin(), m_islandOrder.end(), 0);
+		std::stable_sort(m_islandOrder.begin(), m_islandOrder.end(), [this](uint32_t a, uint32_t b) { return m_islandStarts[a] > m_islandStarts[b]; });
+
+		// Counting sort of the contacts by island, the counts become the write positions
+		m_islandStarts.push_back(0);
+		std::exclusive_scan(m_islandStarts.begin(), m_islandStarts.end(), m_islandStarts.begin(), 0u);
+
+		m_contactOrder.resize(m_islandStarts.back());
+		for (size_t i = 0; i < contacts.size(); i++)
+		{
+			if (m_contactIslands[i] != k_noIsland)
+			{
+				m_contactOrder[m_islandStarts[m_contactIslands[i]]++] = (uint32_t)i;
+			}
+		}
+
+		// Every start moved to the next island start, shift them back
+		for (size_t island = islandsCount; island > 0; island--)
+		{
+			m_islandStarts[island] = m_islandStarts[island - 1];
+		}
+		m_islandStarts[0] = 0;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	uint32_t ContactSolver::findRoot(uint32_t body)
+	{
+		while (m_parents[body] != body)
+		{
+			m_parents[body] = m_parents[m_parents[body]];
+			body = m_parents[body];
+		}
+		return body;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t ContactSolver::solveIsland(size_t island, std::vector<SolverBody>& bodies, const std::vector<Contact>& contacts, const SolverSettings& settings, float dt) const
+	{
+		// Reused by every island solved on the same thread
+		thread_local std::vector<ConstraintGroup> groups;
+		groups.clear();
+
+		for (uint32_t i = m_islandStarts[island]; i < m_islandStarts[island + 1]; i++)
+		{
+			const Contact& contact = contacts[m_contactOrder[i]];
+			int32_t bodyA = bodies[contact.first].inverseMass > 0.0f ? (int32_t)contact.first : k_staticBody;
+			int32_t bodyB = bodies[contact.second].inverseMass > 0.0f ? (int32_t)contact.second : k_staticBody;
+
+			ConstraintGroup& group = findGroup(groups, bodyA, bodyB);
+			prepareLane(group, group.lanesCount++, contact, bodies, settings, dt);
+		}
+
+		bool useSimd = Utils::getActiveSimdLevel() != Utils::SimdLevel::Scalar;
+		for (int iteration = 0; iteration < settings.iterations; iteration++)
+		{
+			for (ConstraintGroup& group : groups)
+			{
+				if (useSimd)
+				{
+					solveGroupSSE(group, bodies);
+					continue;
+				}
+
+				for (size_t lane = 0; lane < group.lanesCount; lane++)
+				{
+					solveLaneScalar(group, lane, bodies);
+				}
+			}
+		}
+		return groups.size();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Contacts.h"
+#include "Managers/JobsManager.h"
+
+namespace Engine::Physics
+{
+	// Body state seen by the solver, static bodies have zero inverse mass and inertia
+	struct SolverBody
+	{
+		Utils::Vector3 position; // Center of mass
+		Utils::Vector3 velocity;
+		Utils::Vector3 angularVelocity;
+		Utils::Vector3 inverseInertia[3]; // World space, row by row
+		float inverseMass = 0.0f;
+		float friction = 0.5f;
+		float restitution = 0.0f;
+	};
+
+	struct SolverSettings
+	{
+		int iterations = 10;
+		float baumgarte = 0.2f; // Fraction of the penetration removed per step
+		float slop = 0.005f; // Penetration left alone, keeps resting contacts from jittering
+		float restitutionThreshold = 1.0f; // Slower impacts do not bounce
+	};
+
+	/**
+	 * @brief      Sequential impulse contact solver.
+	 *
+	 *             Bodies touching each other, directly or through other bodies,
+	 *             form an island. Islands do not share dynamic bodies, so they
+	 *             are solved in parallel. Inside an island, contacts are packed
+	 *             4 at a time with no dynamic body in common and each group is
+	 *             solved with SSE.
+	 */
+	class ContactSolver
+	{
+	public:
+		/**
+		 * @brief      Changes the body velocities so the contacts stop closing.
+		 *
+		 * @param      bodies       The bodies, contacts refer to them by index.
+		 * @param[in]  contacts     The contacts of this step.
+		 * @param[in]  settings     The settings.
+		 * @param[in]  dt           The step duration.
+		 * @param      jobsManager  Solves batchSize islands per job, largest islands first.
+		 * @param[in]  batchSize    The batch size.
+		 */
+		void solve(std::vector<SolverBody>& bodies, const std::vector<Contact>& contacts, const SolverSettings& settings, float dt, JobsManager& jobsManager, size_t batchSize);
+
+		size_t getIslandsCount() const;
+		size_t getLargestIslandContacts() const;
+		float getLaneOccupancy() const; // Fraction of the SIMD lanes holding a contact in the last solve
+
+	private:
+		void buildIslands(const std::vector<SolverBody>& bodies, const std::vector<Contact>& contacts);
+		uint32_t findRoot(uint32_t body);
+		size_t solveIsland(size_t island, std::vector<SolverBody>& bodies, const std::vector<Contact>& contacts, const SolverSettings& settings, float dt) const;
+
+	private:
+		static constexpr uint32_t k_noIsland = UINT32_MAX;
+
+		std::vector<uint32_t> m_parents; // Union-find over the bodies
+		std::vector<uint32_t> m_rootIslands; // Island of each root body
+		std::vector<uint32_t> m_contactIslands; // Island of each contact, k_noIsland between static bodies
+		std::vector<uint32_t> m_islandStarts; // First contact of each island in m_contactOrder, plus the contacts count
+		std::vector<uint32_t> m_contactOrder; // Contact indices grouped by island
+		std::vector<uint32_t> m_islandOrder; // Largest islands first
+		std::vector<size_t> m_islandGroups; // SIMD groups used by each island
+
+		size_t m_largestIsland = 0;
+		float m_laneOccupancy = 0.0f;
+	};
+}
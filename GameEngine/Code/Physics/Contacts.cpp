@@ -0,0 +1,370 @@
+#include "Contacts.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Engine::Physics
+{
+	namespace
+	{
+		using Utils::Vector3;
+
+		constexpr float k_parallelEpsilon = 1e-6f; // Cross products of nearly parallel edges are skipped
+		constexpr float k_edgeAxisBias = 0.95f; // Edge axes must separate clearly better than face axes to be picked
+
+		struct ContactPoint
+		{
+			Vector3 point;
+			float depth;
+		};
+
+		//////////////////////////////////////////////////////////////////////////
+
+		float dot(const Vector3& left, const Vector3& right)
+		{
+			return Vector3::dotProduct(left, right);
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		void addContact(uint32_t firstId, uint32_t secondId, const Vector3& normal, const Vector3& point, float depth, std::vector<Contact>& contacts)
+		{
+			contacts.push_back({ firstId, secondId, normal, point, depth });
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Half length of the box projected on a unit axis
+		float projectBox(const CollisionShape& box, const Vector3& axis)
+		{
+			return box.halfExtents.x * std::abs(dot(box.axes[0], axis))
+				+ box.halfExtents.y * std::abs(dot(box.axes[1], axis))
+				+ box.halfExtents.z * std::abs(dot(box.axes[2], axis));
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		Vector3 toLocal(const CollisionShape& box, const Vector3& point)
+		{
+			Vector3 offset = point - box.center;
+			return Vector3(dot(offset, box.axes[0]), dot(offset, box.axes[1]), dot(offset, box.axes[2]));
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		Vector3 toWorld(const CollisionShape& box, const Vector3& local)
+		{
+			return box.center + box.axes[0] * local.x + box.axes[1] * local.y + box.axes[2] * local.z;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		float getComponent(const Vector3& vector, int axis)
+		{
+			return axis == 0 ? vector.x : axis == 1 ? vector.y : vector.z;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Axis of the box most aligned with direction, sign tells which of its two faces looks that way
+		int getFaceAxis(const CollisionShape& box, const Vector3& direction, float& sign)
+		{
+			int bestAxis = 0;
+			float bestDot = 0.0f;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float alignment = dot(box.axes[axis], direction);
+				if (std::abs(alignment) > std::abs(bestDot))
+				{
+					bestAxis = axis;
+					bestDot = alignment;
+				}
+			}
+			sign = bestDot >= 0.0f ? 1.0f : -1.0f;
+			return bestAxis;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Keeps the part of the polygon where dot(point, planeNormal) <= planeOffset, one clip adds at most one vertex
+		size_t clipPolygon(const Vector3* input, size_t inputCount, const Vector3& planeNormal, float planeOffset, Vector3* output)
+		{
+			size_t outputCount = 0;
+			for (size_t i = 0; i < inputCount; i++)
+			{
+				const Vector3& from = input[i];
+				const Vector3& to = input[(i + 1) % inputCount];
+				float fromDistance = dot(from, planeNormal) - planeOffset;
+				float toDistance = dot(to, planeNormal) - planeOffset;
+
+				if (fromDistance <= 0.0f)
+				{
+					output[outputCount++] = from;
+				}
+				if ((fromDistance < 0.0f && toDistance > 0.0f) || (fromDistance > 0.0f && toDistance < 0.0f))
+				{
+					output[outputCount++] = from + (to - from) * (fromDistance / (fromDistance - toDistance));
+				}
+			}
+			return outputCount;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Clips the incident face, the face of the incident box looking the most against the reference normal,
+		// by the side planes of the reference face. The points below the reference face are the contacts.
+		size_t clipFaces(const CollisionShape& reference, const CollisionShape& incident, const Vector3& referenceNormal, ContactPoint* points)
+		{
+			float referenceSign = 1.0f;
+			int referenceAxis = getFaceAxis(reference, referenceNormal, referenceSign);
+			Vector3 referenceCenter = reference.center + reference.axes[referenceAxis] * (referenceSign * getComponent(reference.halfExtents, referenceAxis));
+
+			float incidentSign = 1.0f;
+			int incidentAxis = getFaceAxis(incident, -referenceNormal, incidentSign);
+			int incidentU = (incidentAxis + 1) % 3;
+			int incidentV = (incidentAxis + 2) % 3;
+			Vector3 incidentCenter = incident.center + incident.axes[incidentAxis] * (incidentSign * getComponent(incident.halfExtents, incidentAxis));
+			Vector3 edgeU = incident.axes[incidentU] * getComponent(incident.halfExtents, incidentU);
+			Vector3 edgeV = incident.axes[incidentV] * getComponent(incident.halfExtents, incidentV);
+
+			Vector3 polygon[8] = { incidentCenter + edgeU + edgeV, incidentCenter - edgeU + edgeV, incidentCenter - edgeU - edgeV, incidentCenter + edgeU - edgeV };
+			Vector3 clipped[8];
+			size_t count = 4;
+			for (int side = 1; side <= 2 && count > 0; side++)
+			{
+				int axis = (referenceAxis + side) % 3;
+				const Vector3& sideNormal = reference.axes[axis];
+				float center = dot(reference.center, sideNormal);
+				float extent = getComponent(reference.halfExtents, axis);
+
+				count = clipPolygon(polygon, count, sideNormal, center + extent, clipped);
+				count = clipPolygon(clipped, count, -sideNormal, -(center - extent), polygon);
+			}
+
+			size_t pointsCount = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				float separation = dot(polygon[i] - referenceCenter, referenceNormal);
+				if (separation <= 0.0f)
+				{
+					// Halfway between the incident point and the reference face
+					points[pointsCount++] = { polygon[i] - referenceNormal * (separation * 0.5f), -separation };
+				}
+			}
+			return pointsCount;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Keeps the deepest point and the ones spreading the most around it, so the manifold still covers the face
+		size_t reducePoints(ContactPoint* points, size_t count)
+		{
+			if (count <= k_maxContactsPerPair)
+			{
+				return count;
+			}
+
+			std::swap(points[0], *std::max_element(points, points + count, [](const ContactPoint& a, const ContactPoint& b) { return a.depth < b.depth; }));
+			for (size_t kept = 1; kept < k_maxContactsPerPair; kept++)
+			{
+				size_t best = kept;
+				float bestDistance = -1.0f;
+				for (size_t i = kept; i < count; i++)
+				{
+					float distance = std::numeric_limits<float>::max();
+					for (size_t j = 0; j < kept; j++)
+					{
+						distance = std::min(distance, (points[i].point - points[j].point).lengthSqr());
+					}
+					if (distance > bestDistance)
+					{
+						best = i;
+						bestDistance = distance;
+					}
+				}
+				std::swap(points[kept], points[best]);
+			}
+			return k_maxContactsPerPair;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Corner of the box furthest along direction
+		Vector3 getSupport(const CollisionShape& box, const Vector3& direction)
+		{
+			Vector3 local(
+				dot(box.axes[0], direction) >= 0.0f ? box.halfExtents.x : -box.halfExtents.x,
+				dot(box.axes[1], direction) >= 0.0f ? box.halfExtents.y : -box.halfExtents.y,
+				dot(box.axes[2], direction) >= 0.0f ? box.halfExtents.z : -box.halfExtents.z);
+			return toWorld(box, local);
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		size_t sphereSphere(const CollisionShape& first, const CollisionShape& second, uint32_t firstId, uint32_t secondId, std::vector<Contact>& contacts)
+		{
+			Vector3 offset = second.center - first.center;
+			float radiusSum = first.radius + second.radius;
+			float distanceSqr = offset.lengthSqr();
+			if (distanceSqr > radiusSum * radiusSum)
+			{
+				return 0;
+			}
+
+			float distance = std::sqrt(distanceSqr);
+			Vector3 normal = distance > 0.0f ? offset / distance : Vector3(0.0f, 1.0f, 0.0f);
+			float depth = radiusSum - distance;
+			addContact(firstId, secondId, normal, first.center + normal * (first.radius - depth * 0.5f), depth, contacts);
+			return 1;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// The normal points from the box to the sphere, flipped by the caller when the sphere comes first
+		bool sphereBox(const CollisionShape& sphere, const CollisionShape& box, Vector3& normal, Vector3& point, float& depth)
+		{
+			Vector3 local = toLocal(box, sphere.center);
+			Vector3 closest(
+				std::clamp(local.x, -box.halfExtents.x, box.halfExtents.x),
+				std::clamp(local.y, -box.halfExtents.y, box.halfExtents.y),
+				std::clamp(local.z, -box.halfExtents.z, box.halfExtents.z));
+
+			Vector3 offset = local - closest;
+			float distanceSqr = offset.lengthSqr();
+			if (distanceSqr > sphere.radius * sphere.radius)
+			{
+				return false;
+			}
+
+			if (distanceSqr > 0.0f)
+			{
+				float distance = std::sqrt(distanceSqr);
+				point = toWorld(box, closest);
+				normal = (sphere.center - point) / distance;
+				depth = sphere.radius - distance;
+				return true;
+			}
+
+			// Center inside the box, push it out through the nearest face
+			float faceDistances[3] = {
+				box.halfExtents.x - std::abs(local.x),
+				box.halfExtents.y - std::abs(local.y),
+				box.halfExtents.z - std::abs(local.z)
+			};
+			int axis = (int)(std::min_element(faceDistances, faceDistances + 3) - faceDistances);
+			float side = (axis == 0 ? local.x : axis == 1 ? local.y : local.z) >= 0.0f ? 1.0f : -1.0f;
+
+			normal = box.axes[axis] * side;
+			depth = sphere.radius + faceDistances[axis];
+			point = sphere.center - normal * sphere.radius;
+			return true;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		size_t boxBox(const CollisionShape& first, const CollisionShape& second, uint32_t firstId, uint32_t secondId, std::vector<Contact>& contacts)
+		{
+			Vector3 offset = second.center - first.center;
+
+			Vector3 axes[15];
+			size_t axesCount = 0;
+			for (int i = 0; i < 3; i++)
+			{
+				axes[axesCount++] = first.axes[i];
+			}
+			for (int i = 0; i < 3; i++)
+			{
+				axes[axesCount++] = second.axes[i];
+			}
+			size_t faceAxesCount = axesCount;
+			for (int i = 0; i < 3; i++)
+			{
+				for (int j = 0; j < 3; j++)
+				{
+					Vector3 axis = Vector3::crossProduct(first.axes[i], second.axes[j]);
+					float lengthSqr = axis.lengthSqr();
+					if (lengthSqr > k_parallelEpsilon)
+					{
+						axes[axesCount++] = axis / std::sqrt(lengthSqr);
+					}
+				}
+			}
+
+			float bestOverlap = std::numeric_limits<float>::max();
+			size_t bestAxis = 0;
+			Vector3 normal;
+			for (size_t i = 0; i < axesCount; i++)
+			{
+				float distance = dot(offset, axes[i]);
+				float overlap = projectBox(first, axes[i]) + projectBox(second, axes[i]) - std::abs(distance);
+				if (overlap < 0.0f)
+				{
+					return 0;
+				}
+
+				float biasedOverlap = i < faceAxesCount ? overlap : overlap / k_edgeAxisBias;
+				if (biasedOverlap < bestOverlap)
+				{
+					bestOverlap = biasedOverlap;
+					bestAxis = i;
+					normal = distance >= 0.0f ? axes[i] : -axes[i];
+				}
+			}
+
+			if (bestAxis >= faceAxesCount)
+			{
+				// Edge against edge, halfway between the deepest corners is close enough for the solver
+				float depth = dot(first.center, normal) + projectBox(first, normal) - dot(second.center, normal) + projectBox(second, normal);
+				Vector3 point = (getSupport(first, normal) + getSupport(second, -normal)) * 0.5f;
+				addContact(firstId, secondId, normal, point, depth, contacts);
+				return 1;
+			}
+
+			// The box whose face separates the best is the reference, the normal has to point out of it
+			bool firstIsReference = bestAxis < 3;
+			ContactPoint points[8];
+			size_t pointsCount = firstIsReference
+				? clipFaces(first, second, normal, points)
+				: clipFaces(second, first, -normal, points);
+			pointsCount = reducePoints(points, pointsCount);
+
+			for (size_t i = 0; i < pointsCount; i++)
+			{
+				addContact(firstId, secondId, normal, points[i].point, points[i].depth, contacts);
+			}
+			return pointsCount;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t generateContacts(const CollisionShape& first, const CollisionShape& second, uint32_t firstId, uint32_t secondId, std::vector<Contact>& contacts)
+	{
+		using Type = CollisionShape::Type;
+
+		if (first.type == Type::Sphere && second.type == Type::Sphere)
+		{
+			return sphereSphere(first, second, firstId, secondId, contacts);
+		}
+
+		if (first.type == Type::Box && second.type == Type::Box)
+		{
+			return boxBox(first, second, firstId, secondId, contacts);
+		}
+
+		bool sphereFirst = first.type == Type::Sphere;
+		Vector3 normal;
+		Vector3 point;
+		float depth = 0.0f;
+		if (!sphereBox(sphereFirst ? first : second, sphereFirst ? second : first, normal, point, depth))
+		{
+			return 0;
+		}
+
+		addContact(firstId, secondId, sphereFirst ? -normal : normal, point, depth, contacts);
+		return 1;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Utils/Vector.h"
+
+namespace Engine::Physics
+{
+	// World space collision shape, rebuilt from a Collider and its Transform every frame
+	struct CollisionShape
+	{
+		enum class Type
+		{
+			Sphere,
+			Box
+		};
+
+		Type type = Type::Sphere;
+		Utils::Vector3 center;
+		Utils::Vector3 axes[3] = { Utils::Vector3(1.0f, 0.0f, 0.0f), Utils::Vector3(0.0f, 1.0f, 0.0f), Utils::Vector3(0.0f, 0.0f, 1.0f) }; // Box only
+		Utils::Vector3 halfExtents; // Box only, along axes
+		float radius = 0.0f; // Sphere only
+	};
+
+	// Contact point between two shapes, the normal points from first to second
+	struct Contact
+	{
+		uint32_t first;
+		uint32_t second;
+		Utils::Vector3 normal;
+		Utils::Vector3 point;
+		float depth;
+	};
+
+	constexpr size_t k_maxContactsPerPair = 4;
+
+	/**
+	 * @brief      Computes the contact points of two overlapping shapes.
+	 *
+	 *             Spheres give one point. Boxes are separated with the 15 axes
+	 *             test. Face contacts clip one box face against the other and
+	 *             keep up to k_maxContactsPerPair points, edge contacts give one.
+	 *
+	 * @param[in]  first     The first shape.
+	 * @param[in]  second    The second shape.
+	 * @param[in]  firstId   Stored in the contacts as first.
+	 * @param[in]  secondId  Stored in the contacts as second.
+	 * @param[out] contacts  The contacts are appended to it.
+	 *
+	 * @return     The number of contacts added, 0 when the shapes do not touch.
+	 */
+	size_t generateContacts(const CollisionShape& first, const CollisionShape& second, uint32_t firstId, uint32_t secondId, std::vector<Contact>& contacts);
+}
@@ -0,0 +1,156 @@
+#include "AnimationSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Managers/GameController.h"
+#include "Components/Model.h"
+#include "Utils/DebugMacros.h"
+
+REGISTER_SYSTEM(Engine::Systems::AnimationSystem);
+
+namespace Engine::Systems
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	void AnimationSystem::onStart()
+	{
+		if (m_config.contains("batchSize"))
+		{
+			m_batchSize = m_config["batchSize"].get<size_t>();
+		}
+
+		if (m_config.contains("cpuSkinning"))
+		{
+			m_cpuSkinning = m_config["cpuSkinning"].get<bool>();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void AnimationSystem::onUpdate(float dt)
+	{
+		GameController& gameController = GameController::get();
+		ComponentsManager& compManager = gameController.getComponentsManager();
+		auto& animatorSet = compManager.getComponentSet<Components::Animator>();
+		const auto& modelSet = compManager.getComponentSet<Components::Model>();
+
+		// Files are loaded here on the main thread, the workers only read them
+		m_jobs.clear();
+		for (EntityID id : compManager.entitiesWithComponents<Components::Animator, Components::Model>())
+		{
+			const Visual::SkinnedModel* skinnedModel = getSkinnedModel(modelSet.getElement(id).path);
+			if (skinnedModel)
+			{
+				m_jobs.push_back({ skinnedModel, &animatorSet.getElement(id) });
+			}
+		}
+
+		// Characters are independent, each one is sampled, blended and skinned by a single worker
+		gameController.getJobsManager().parallelFor(m_jobs.size(), m_batchSize, [this, dt](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					updateAnimator(*m_jobs[i].skinnedModel, *m_jobs[i].animator, dt);
+				}
+			});
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void AnimationSystem::onStop()
+	{
+		m_jobs.clear();
+		m_skinnedModels.clear();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int AnimationSystem::getPriority() const
+	{
+		return 7;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const Visual::SkinnedModel* AnimationSystem::getSkinnedModel(const std::string& path)
+	{
+		const auto& skinnedModelItr = m_skinnedModels.find(path);
+		if (skinnedModelItr != m_skinnedModels.end())
+		{
+			return skinnedModelItr->second.get();
+		}
+
+		auto skinnedModel = std::make_unique<Visual::SkinnedModel>();
+		bool loadResult = skinnedModel->load(GameController::get().getAssetPath(path));
+		ASSERT(loadResult, "Failed to load skinned model: {}", path);
+		if (!loadResult)
+		{
+			skinnedModel = nullptr;
+		}
+
+		return m_skinnedModels.emplace(path, std::move(skinnedModel)).first->second.get();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void AnimationSystem::updateAnimator(const Visual::SkinnedModel& skinnedModel, Components::Animator& animator, float dt) const
+	{
+		// Scratch space per worker, reused between characters
+		thread_local Visual::Pose pose;
+		thread_local Visual::Pose blendPose;
+		thread_local std::vector<Utils::Matrix4> globals;
+
+		const Visual::Skeleton& skeleton = skinnedModel.getSkeleton();
+		pose = skeleton.bindPose;
+
+		const Visual::AnimationClip* clip = skinnedModel.findClip(animator.clip);
+		if (clip)
+		{
+			animator.time = wrapTime(animator.time + dt * animator.speed, clip->duration, animator.loop);
+			clip->sample(animator.time, pose);
+
+			const Visual::AnimationClip* blendClip = animator.blendWeight > 0.0f && !animator.blendClip.empty() ? skinnedModel.findClip(animator.blendClip) : nullptr;
+			if (blendClip)
+			{
+				// Both clips play at the same phase, so cycles of different lengths stay in step
+				float phase = clip->duration > 0.0f ? animator.time / clip->duration : 0.0f;
+				blendPose = skeleton.bindPose;
+				blendClip->sample(phase * blendClip->duration, blendPose);
+				Visual::blendPoses(pose, blendPose, std::min(animator.blendWeight, 1.0f), pose);
+			}
+		}
+
+		skeleton.computeSkinningMatrices(pose, globals, animator.palette);
+
+		if (m_cpuSkinning)
+		{
+			animator.vertices.resize(skinnedModel.getVertexCount());
+			skinnedModel.skin(animator.palette, animator.vertices.data());
+		}
+		else
+		{
+			animator.vertices.clear();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	float AnimationSystem::wrapTime(float time, float duration, bool loop)
+	{
+		if (duration <= 0.0f)
+		{
+			return 0.0f;
+		}
+
+		if (!loop)
+		{
+			return std::clamp(time, 0.0f, duration);
+		}
+
+		time = std::fmod(time, duration);
+		return time < 0.0f ? time + duration : time;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
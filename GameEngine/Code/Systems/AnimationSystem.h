@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ISystem.h"
+#include "Components/Animator.h"
+#include "Visual/SkinnedModel.h"
+
+namespace Engine::Systems
+{
+	class AnimationSystem: public ISystem
+	{
+	public:
+		void onStart() override;
+		void onUpdate(float dt) override;
+		void onStop() override;
+		int getPriority() const override;
+
+	private:
+		struct AnimatorJob
+		{
+			const Visual::SkinnedModel* skinnedModel;
+			Components::Animator* animator;
+		};
+
+	private:
+		const Visual::SkinnedModel* getSkinnedModel(const std::string& path);
+		void updateAnimator(const Visual::SkinnedModel& skinnedModel, Components::Animator& animator, float dt) const;
+
+		static float wrapTime(float time, float duration, bool loop);
+
+	private:
+		static constexpr size_t k_defaultBatchSize = 8;
+
+		size_t m_batchSize = k_defaultBatchSize;
+		bool m_cpuSkinning = true; // Without it only the palettes are computed
+
+		// Shared by every character using the same file, nullptr for files that failed to load
+		std::unordered_map<std::string, std::unique_ptr<Visual::SkinnedModel>> m_skinnedModels;
+		std::vector<AnimatorJob> m_jobs;
+	};
+}
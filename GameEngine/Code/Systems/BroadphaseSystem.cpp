@@ -0,0 +1,206 @@
+#include "BroadphaseSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+
+#include "Managers/GameController.h"
+#include "Components/Collider.h"
+#include "Components/Transform.h"
+#include "Components/Parent.h"
+#include "Utils/DebugMacros.h"
+
+REGISTER_SYSTEM(Engine::Systems::BroadphaseSystem);
+
+namespace Engine::Systems
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	void BroadphaseSystem::onStart()
+	{
+		if (m_config.contains("method"))
+		{
+			std::string method = m_config["method"].get<std::string>();
+			ASSERT(method == "SweepAndPrune" || method == "SpatialHash", "Unknown broadphase method: {}", method);
+			m_method = method == "SpatialHash" ? Method::SpatialHash : Method::SweepAndPrune;
+		}
+
+		if (m_config.contains("cellSize"))
+		{
+			m_cellSize = m_config["cellSize"].get<float>();
+		}
+
+		if (m_config.contains("batchSize"))
+		{
+			m_batchSize = m_config["batchSize"].get<size_t>();
+		}
+
+		if (m_config.contains("outputFile"))
+		{
+			m_outputFile = m_config["outputFile"].get<std::string>();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void BroadphaseSystem::onUpdate(float dt)
+	{
+		auto boundsStart = std::chrono::high_resolution_clock::now();
+		computeBounds();
+		auto boundsEnd = std::chrono::high_resolution_clock::now();
+
+		JobsManager& jobsManager = GameController::get().getJobsManager();
+		if (m_method == Method::SweepAndPrune)
+		{
+			m_sweepAndPrune.findPairs(m_bounds, jobsManager, m_batchSize, m_pairs);
+			m_fullSortsCount += m_sweepAndPrune.wasFullySorted() ? 1 : 0;
+			m_swapsSum += (double)m_sweepAndPrune.getLastSwapsCount();
+		}
+		else
+		{
+			m_spatialHash.findPairs(m_bounds, m_cellSize, jobsManager, m_batchSize, m_pairs);
+		}
+		auto pairsEnd = std::chrono::high_resolution_clock::now();
+
+		m_framesCount++;
+		m_collidersSum += (double)m_entities.size();
+		m_pairsSum += (double)m_pairs.size();
+		m_maxPairs = std::max(m_maxPairs, m_pairs.size());
+		m_boundsTime += std::chrono::duration<double>(boundsEnd - boundsStart).count();
+		m_pairsTime += std::chrono::duration<double>(pairsEnd - boundsEnd).count();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void BroadphaseSystem::onStop()
+	{
+		writeResults();
+		m_entities.clear();
+		m_bounds.clear();
+		m_pairs.clear();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int BroadphaseSystem::getPriority() const
+	{
+		return 6;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::vector<Physics::OverlapPair>& BroadphaseSystem::getPairs() const
+	{
+		return m_pairs;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::vector<EntityID>& BroadphaseSystem::getEntities() const
+	{
+		return m_entities;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void BroadphaseSystem::computeBounds()
+	{
+		GameController& gameController = GameController::get();
+		ComponentsManager& compManager = gameController.getComponentsManager();
+		const auto& colliderSet = compManager.getComponentSet<Components::Collider>();
+		const auto& transformSet = compManager.getComponentSet<Components::Transform>();
+		const auto& parentSet = compManager.getComponentSet<Components::Parent>();
+
+		// Dense order changes when SpatialSortSystem sorts the sets, ids do not
+		m_entities = compManager.entitiesWithComponents<Components::Collider, Components::Transform>();
+		std::sort(m_entities.begin(), m_entities.end());
+
+		size_t count = m_entities.size();
+		m_bounds.minX.resize(count);
+		m_bounds.minY.resize(count);
+		m_bounds.minZ.resize(count);
+		m_bounds.maxX.resize(count);
+		m_bounds.maxY.resize(count);
+		m_bounds.maxZ.resize(count);
+
+		gameController.getJobsManager().parallelFor(count, m_batchSize, [this, &colliderSet, &transformSet, &parentSet](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					EntityID id = m_entities[i];
+					const Components::Collider& collider = colliderSet.getElement(id);
+					const Components::Transform& transform = transformSet.getElement(id);
+
+					bool hasParent = parentSet.isPresent(id);
+					const Utils::Vector3& position = hasParent ? transform.worldPosition : transform.position;
+					const Utils::Vector3& rotation = hasParent ? transform.worldRotation : transform.rotation;
+					const Utils::Vector3& scale = hasParent ? transform.worldScale : transform.scale;
+					Utils::Matrix4 world = Utils::Matrix4::fromTransform(position, rotation, scale);
+
+					Utils::AABB box;
+					if (collider.shape == "Box")
+					{
+						box = Utils::AABB(collider.offset - collider.halfExtents, collider.offset + collider.halfExtents).transformed(world);
+					}
+					else
+					{
+						float radius = collider.radius * std::max({ std::abs(scale.x), std::abs(scale.y), std::abs(scale.z) });
+						Utils::Vector3 center = world.transformPoint(collider.offset);
+						box = Utils::AABB(center - Utils::Vector3(radius), center + Utils::Vector3(radius));
+					}
+
+					m_bounds.minX[i] = box.min.x;
+					m_bounds.minY[i] = box.min.y;
+					m_bounds.minZ[i] = box.min.z;
+					m_bounds.maxX[i] = box.max.x;
+					m_bounds.maxY[i] = box.max.y;
+					m_bounds.maxZ[i] = box.max.z;
+				}
+			});
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void BroadphaseSystem::writeResults() const
+	{
+		if (m_outputFile.empty() || m_framesCount == 0)
+		{
+			return;
+		}
+
+		std::ofstream outFile(GameController::get().getConfigRelativePath(m_outputFile));
+		if (!outFile.is_open())
+		{
+			return;
+		}
+
+		double frames = (double)m_framesCount;
+		double totalTime = m_boundsTime + m_pairsTime;
+
+		outFile << "Method: " << (m_method == Method::SweepAndPrune ? "SweepAndPrune" : "SpatialHash") << std::endl;
+		outFile << "Workers: " << GameController::get().getJobsManager().getWorkersCount() << std::endl;
+		outFile << "Batch size: " << m_batchSize << std::endl;
+		outFile << "Frames: " << m_framesCount << std::endl;
+		outFile << "Average colliders: " << m_collidersSum / frames << std::endl;
+		outFile << "Average pairs: " << m_pairsSum / frames << std::endl;
+		outFile << "Max pairs: " << m_maxPairs << std::endl;
+		outFile << "Average bounds time (ms): " << m_boundsTime * 1000.0 / frames << std::endl;
+		outFile << "Average pairs time (ms): " << m_pairsTime * 1000.0 / frames << std::endl;
+		outFile << "Colliders per second: " << (totalTime > 0.0 ? m_collidersSum / totalTime : 0.0) << std::endl;
+		outFile << "Pairs per second: " << (totalTime > 0.0 ? m_pairsSum / totalTime : 0.0) << std::endl;
+
+		if (m_method == Method::SweepAndPrune)
+		{
+			outFile << "Sweep axis: " << m_sweepAndPrune.getAxis() << std::endl;
+			outFile << "Full sorts: " << m_fullSortsCount << std::endl;
+			outFile << "Average insertion sort swaps: " << m_swapsSum / frames << std::endl;
+		}
+		else
+		{
+			outFile << "Cell size: " << m_spatialHash.getCellSize() << std::endl;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ISystem.h"
+#include "Managers/EntitiesManager.h"
+#include "Physics/Broadphase.h"
+
+namespace Engine::Systems
+{
+	// Finds the entities whose Collider bounds overlap, every frame after the hierarchy is updated.
+	// Pairs are kept in one contiguous buffer for the systems reacting to them.
+	class BroadphaseSystem: public ISystem
+	{
+	public:
+		void onStart() override;
+		void onUpdate(float dt) override;
+		void onStop() override;
+		int getPriority() const override;
+
+		// Pair indices refer to getEntities()
+		const std::vector<Physics::OverlapPair>& getPairs() const;
+		const std::vector<EntityID>& getEntities() const;
+
+	private:
+		enum class Method
+		{
+			SweepAndPrune,
+			SpatialHash
+		};
+
+	private:
+		void computeBounds();
+		void writeResults() const;
+
+	private:
+		static constexpr size_t k_defaultBatchSize = 256;
+
+		Method m_method = Method::SweepAndPrune;
+		float m_cellSize = 0.0f; // Spatial hash only, derived from the boxes when not positive
+		size_t m_batchSize = k_defaultBatchSize;
+		std::string m_outputFile;
+
+		Physics::SweepAndPrune m_sweepAndPrune;
+		Physics::SpatialHash m_spatialHash;
+
+		std::vector<EntityID> m_entities; // Sorted, so an entity keeps its index while the colliders do not change
+		Utils::AABBBatch m_bounds;
+		std::vector<Physics::OverlapPair> m_pairs;
+
+		size_t m_framesCount = 0;
+		double m_collidersSum = 0.0;
+		double m_pairsSum = 0.0;
+		size_t m_maxPairs = 0;
+		double m_boundsTime = 0.0; // Seconds
+		double m_pairsTime = 0.0;
+		size_t m_fullSortsCount = 0;
+		double m_swapsSum = 0.0;
+	};
+}
@@ -0,0 +1,138 @@
+#include "CameraSystem.h"
+
+#include <cmath>
+#include <numbers>
+
+#include "Managers/GameController.h"
+#include "Components/Transform.h"
+#include "Components/Parent.h"
+#include "Components/Tag.h"
+
+REGISTER_SYSTEM(Engine::Systems::CameraSystem);
+
+namespace Engine::Systems
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	void CameraSystem::onStart()
+	{
+		// Scenes written before the Camera component mark their camera with a tag only
+		ComponentsManager& compManager = GameController::get().getComponentsManager();
+		Utils::SparseSet<Components::Camera, EntityID>& cameraSet = compManager.getComponentSet<Components::Camera>();
+		const Utils::SparseSet<Components::Tag, EntityID>& tagSet = compManager.getComponentSet<Components::Tag>();
+
+		for (EntityID id : compManager.entitiesWithComponents<Components::Tag, Components::Transform>())
+		{
+			if (tagSet.getElement(id).tag == k_mainCameraTag && !cameraSet.isPresent(id))
+			{
+				cameraSet.addElement(id, Components::Camera{});
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void CameraSystem::onUpdate(float dt)
+	{
+		GameController& gameController = GameController::get();
+		ComponentsManager& compManager = gameController.getComponentsManager();
+		Utils::SparseSet<Components::Camera, EntityID>& cameraSet = compManager.getComponentSet<Components::Camera>();
+		const Utils::SparseSet<Components::Transform, EntityID>& transformSet = compManager.getComponentSet<Components::Transform>();
+		const Utils::SparseSet<Components::Parent, EntityID>& parentSet = compManager.getComponentSet<Components::Parent>();
+
+		float windowAspectRatio = gameController.getWindow().getAspectRatio();
+		m_mainCamera = -1;
+		int mainPriority = 0;
+
+		for (EntityID id : compManager.entitiesWithComponents<Components::Camera, Components::Transform>())
+		{
+			Components::Camera& camera = cameraSet.getElement(id);
+			const Components::Transform& transform = transformSet.getElement(id);
+			bool hasParent = parentSet.isPresent(id);
+			const Utils::Vector3& position = hasParent ? transform.worldPosition : transform.position;
+			const Utils::Vector3& rotation = hasParent ? transform.worldRotation : transform.rotation;
+
+			float aspectRatio = camera.aspectRatio;
+			if (aspectRatio <= 0.0f)
+			{
+				aspectRatio = camera.viewport.height > 0.0f ? windowAspectRatio * camera.viewport.width / camera.viewport.height : windowAspectRatio;
+			}
+
+			if (camera.dirty
+				|| camera.cachedAspectRatio != aspectRatio
+				|| !isSame(camera.position, position)
+				|| !isSame(camera.cachedRotation, rotation))
+			{
+				updateCamera(camera, position, rotation, aspectRatio);
+			}
+
+			if (camera.active && (m_mainCamera < 0 || camera.priority > mainPriority))
+			{
+				m_mainCamera = id;
+				mainPriority = camera.priority;
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void CameraSystem::onStop()
+	{
+
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int CameraSystem::getPriority() const
+	{
+		return 9;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	EntityID CameraSystem::getMainCamera() const
+	{
+		return m_mainCamera;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void CameraSystem::updateCamera(Components::Camera& camera, const Utils::Vector3& position, const Utils::Vector3& rotation, float aspectRatio)
+	{
+		// Roll around z, then pitch around x, then yaw around y, the order the backends always used for the camera
+		float sinPitch = std::sin(rotation.x);
+		float cosPitch = std::cos(rotation.x);
+		float sinYaw = std::sin(rotation.y);
+		float cosYaw = std::cos(rotation.y);
+		float sinRoll = std::sin(rotation.z);
+		float cosRoll = std::cos(rotation.z);
+
+		camera.position = position;
+		camera.forward = Utils::Vector3(cosPitch * sinYaw, -sinPitch, cosPitch * cosYaw);
+		camera.up = Utils::Vector3(
+			cosRoll * sinPitch * sinYaw - sinRoll * cosYaw,
+			cosRoll * cosPitch,
+			cosRoll * sinPitch * cosYaw + sinRoll * sinYaw);
+		camera.right = Utils::Vector3::crossProduct(camera.up, camera.forward);
+
+		float fieldOfView = camera.fieldOfView * std::numbers::pi_v<float> / 180.0f;
+		camera.view = Utils::Matrix4::lookAtLH(position, position + camera.forward, camera.up);
+		camera.projection = Utils::Matrix4::perspectiveLH(fieldOfView, aspectRatio, camera.nearPlane, camera.farPlane);
+		camera.viewProjection = camera.projection * camera.view;
+		camera.frustum = Utils::Frustum::fromMatrix(camera.viewProjection);
+
+		camera.cachedRotation = rotation;
+		camera.cachedAspectRatio = aspectRatio;
+		camera.dirty = false;
+		camera.version++;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool CameraSystem::isSame(const Utils::Vector3& left, const Utils::Vector3& right)
+	{
+		return left.x == right.x && left.y == right.y && left.z == right.z;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
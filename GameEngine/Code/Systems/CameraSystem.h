@@ -0,0 +1,31 @@
+#pragma once
+
+#include "ISystem.h"
+#include "Components/Camera.h"
+#include "Managers/EntitiesManager.h"
+#include "Utils/Vector.h"
+
+namespace Engine::Systems
+{
+	// Keeps the matrices and frustum of every Camera up to date, once per frame and only for cameras that changed.
+	// Runs after everything that moves entities and before RenderingSystem, which adds it when the config does not.
+	class CameraSystem: public ISystem
+	{
+	public:
+		void onStart() override;
+		void onUpdate(float dt) override;
+		void onStop() override;
+		int getPriority() const override;
+
+		EntityID getMainCamera() const; // Active camera of highest priority, -1 when there is none
+
+	private:
+		static void updateCamera(Components::Camera& camera, const Utils::Vector3& position, const Utils::Vector3& rotation, float aspectRatio);
+		static bool isSame(const Utils::Vector3& left, const Utils::Vector3& right);
+
+	private:
+		static constexpr const char* k_mainCameraTag = "MainCamera";
+
+		EntityID m_mainCamera = -1;
+	};
+}
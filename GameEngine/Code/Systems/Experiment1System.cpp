@@ -6,6 +6,7 @@
 #include "Managers/GameController.h"
 #include "Components/Transform.h"
 #include "Components/Tag.h"
+#include "Components/Parent.h"
 #include "Utils/DebugMacros.h"
 #include "Utils/Quaternion.h"
 
@@ -43,10 +44,16 @@ namespace Engine::Systems
 			m_cameraMaxDistance = m_config["cameraMaxDistance"].get<float>();
 		}
 
+		if (m_config.contains("groupRings"))
+		{
+			m_groupRings = m_config["groupRings"].get<bool>();
+		}
+
 		GameController& gameController = GameController::get();
 		ComponentsManager& compManager = gameController.getComponentsManager();
 		Utils::SparseSet<Components::Transform, EntityID>& transformSet = compManager.getComponentSet<Components::Transform>();
 		Utils::SparseSet<Components::Tag, EntityID>& tagSet = compManager.getComponentSet<Components::Tag>();
+		Utils::SparseSet<Components::Parent, EntityID>& parentSet = compManager.getComponentSet<Components::Parent>();
 		
 		float pi = std::numbers::pi_v<float>;
 		float angleStep = 2 * pi / m_prefabsCount;
@@ -56,6 +63,16 @@ namespace Engine::Systems
 		for (float radius : m_radiuses)
 		{
 			std::vector<EntityID>& objects = moveClockwise ? m_clockwiseObjects : m_counterClockwiseObjects;
+
+			EntityID pivotId = -1;
+			if (m_groupRings)
+			{
+				pivotId = gameController.getEntitiesManager().createEntity();
+				transformSet.addElement(pivotId, Components::Transform{});
+				std::vector<EntityID>& pivots = moveClockwise ? m_clockwisePivots : m_counterClockwisePivots;
+				pivots.push_back(pivotId);
+			}
+
 			for (size_t i = 0; i < m_prefabsCount; i++)
 			{
 				EntityID id = gameController.createPrefab(m_prefabName);
@@ -66,6 +83,11 @@ namespace Engine::Systems
 
 				tagSet.addElement(id, Components::Tag{ k_experimentObjectTag });
 				objects.push_back(id);
+
+				if (m_groupRings)
+				{
+					parentSet.addElement(id, Components::Parent{ pivotId });
+				}
 			}
 			moveClockwise = !moveClockwise;
 		}
@@ -113,6 +135,20 @@ namespace Engine::Systems
 		ComponentsManager& compManager = GameController::get().getComponentsManager();
 		Utils::SparseSet<Components::Transform, EntityID>& transform = compManager.getComponentSet<Components::Transform>();
 
+		if (m_groupRings)
+		{
+			for (EntityID id : m_clockwisePivots)
+			{
+				transform.getElement(id).rotation.z += m_rotationSpeed * dt;
+			}
+
+			for (EntityID id : m_counterClockwisePivots)
+			{
+				transform.getElement(id).rotation.z -= m_rotationSpeed * dt;
+			}
+			return;
+		}
+
 		for (EntityID id : m_clockwiseObjects)
 		{
 			transform.getElement(id).position.rotateArroundVector(Utils::Vector3(0, 0, 1), m_rotationSpeed * dt);
@@ -24,6 +24,10 @@ namespace Engine::Systems
 		std::vector<float> m_radiuses = { 5 };
 		std::vector<EntityID> m_clockwiseObjects;
 		std::vector<EntityID> m_counterClockwiseObjects;
+		// With groupRings every ring is parented to a pivot and only the pivots are rotated
+		bool m_groupRings = false;
+		std::vector<EntityID> m_clockwisePivots;
+		std::vector<EntityID> m_counterClockwisePivots;
 		EntityID m_cameraId;
 		bool m_cameraMoveForwards = true;
 		float m_originalCameraPosition = 0.0f;
@@ -0,0 +1,120 @@
+#include "Experiment3System.h"
+
+#include <cmath>
+
+#include "Managers/GameController.h"
+#include "Components/Transform.h"
+#include "Components/Tag.h"
+#include "Components/Animator.h"
+#include "Utils/DebugMacros.h"
+
+REGISTER_SYSTEM(Engine::Systems::Experiment3System);
+
+namespace Engine::Systems
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	void Experiment3System::onStart()
+	{
+		ExperimentSystemBase::onStart();
+
+		ASSERT(m_config.contains("distanceDelta"), "distanceDelta not found in config");
+		if (m_config.contains("distanceDelta"))
+		{
+			m_distanceDelta = m_config["distanceDelta"].get<float>();
+		}
+
+		ASSERT(m_config.contains("elementsPerRow"), "elementsPerRow not found in config");
+		if (m_config.contains("elementsPerRow"))
+		{
+			m_elementsPerRow = m_config["elementsPerRow"].get<size_t>();
+		}
+
+		if (m_config.contains("timeOffset"))
+		{
+			m_timeOffset = m_config["timeOffset"].get<float>();
+		}
+
+		if (m_config.contains("speedVariation"))
+		{
+			m_speedVariation = m_config["speedVariation"].get<float>();
+		}
+
+		if (m_config.contains("clip"))
+		{
+			m_clip = m_config["clip"].get<std::string>();
+		}
+
+		if (m_config.contains("blendClip"))
+		{
+			m_blendClip = m_config["blendClip"].get<std::string>();
+		}
+
+		if (m_config.contains("blendWeight"))
+		{
+			m_blendWeight = m_config["blendWeight"].get<float>();
+		}
+
+		GameController& gameController = GameController::get();
+		ComponentsManager& compManager = gameController.getComponentsManager();
+		Utils::SparseSet<Components::Transform, EntityID>& transformSet = compManager.getComponentSet<Components::Transform>();
+		Utils::SparseSet<Components::Tag, EntityID>& tagSet = compManager.getComponentSet<Components::Tag>();
+		Utils::SparseSet<Components::Animator, EntityID>& animatorSet = compManager.getComponentSet<Components::Animator>();
+
+		// Characters stand on a grid in the XZ plane, in front of the camera
+		float initialX = -(float)(m_elementsPerRow - 1) / 2.0f * m_distanceDelta;
+		for (size_t i = 0; i < m_prefabsCount; i++)
+		{
+			EntityID id = gameController.createPrefab(m_prefabName);
+			Components::Transform& transform = transformSet.getElement(id);
+			transform.position.x = initialX + (float)(i % m_elementsPerRow) * m_distanceDelta;
+			transform.position.z = (float)(i / m_elementsPerRow) * m_distanceDelta;
+			tagSet.addElement(id, Components::Tag{ k_experimentObjectTag });
+
+			ASSERT(animatorSet.isPresent(id), "Prefab {} has no Animator component", m_prefabName);
+			if (!animatorSet.isPresent(id))
+			{
+				continue;
+			}
+
+			Components::Animator& animator = animatorSet.getElement(id);
+			if (!m_clip.empty())
+			{
+				animator.clip = m_clip;
+			}
+			if (!m_blendClip.empty())
+			{
+				animator.blendClip = m_blendClip;
+				animator.blendWeight = m_blendWeight;
+			}
+			animator.time += getSpread(i) * m_timeOffset;
+			animator.speed *= 1.0f + (getSpread(i + m_prefabsCount) * 2.0f - 1.0f) * m_speedVariation;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Experiment3System::onStop()
+	{
+
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int Experiment3System::getPriority() const
+	{
+		return 0;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	float Experiment3System::getSpread(size_t index)
+	{
+		// Golden ratio sequence, evenly spread in [0, 1) and the same on every run
+		constexpr double goldenRatioFraction = 0.6180339887498949;
+		double value = (double)index * goldenRatioFraction;
+		return (float)(value - std::floor(value));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "ExperimentSystemBase.h"
+#include "Managers/EntitiesManager.h"
+
+namespace Engine::Systems
+{
+	// Crowd of animated characters, the prefab needs Model, Transform and Animator components
+	class Experiment3System: public ExperimentSystemBase
+	{
+	public:
+		void onStart() override;
+		void onStop() override;
+		int getPriority() const override;
+
+	private:
+		static float getSpread(size_t index);
+
+	private:
+		float m_distanceDelta = 1.0f;
+		size_t m_elementsPerRow = 10;
+		float m_timeOffset = 0.0f; // Largest start time offset, so the characters don't move in lockstep
+		float m_speedVariation = 0.0f;
+		std::string m_clip;
+		std::string m_blendClip;
+		float m_blendWeight = 0.0f;
+	};
+}
@@ -0,0 +1,274 @@
+#include "Experiment4System.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+
+#include "Managers/GameController.h"
+#include "Events/NativeInputEvents.h"
+#include "Components/Transform.h"
+#include "Components/Model.h"
+#include "Utils/DebugMacros.h"
+
+REGISTER_SYSTEM(Engine::Systems::Experiment4System);
+
+namespace Engine::Systems
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	void Experiment4System::onStart()
+	{
+		if (m_config.contains("shape"))
+		{
+			bool validShape = Visual::MeshGenerator::parseShape(m_config["shape"].get<std::string>(), m_shape);
+			ASSERT(validShape, "Unknown shape: {}", m_config["shape"].get<std::string>());
+		}
+
+		ASSERT(m_config.contains("triangleCounts"), "triangleCounts not found in config");
+		if (m_config.contains("triangleCounts"))
+		{
+			m_triangleCounts = m_config["triangleCounts"].get<std::vector<size_t>>();
+		}
+
+		ASSERT(m_config.contains("objectCounts"), "objectCounts not found in config");
+		if (m_config.contains("objectCounts"))
+		{
+			m_objectCounts = m_config["objectCounts"].get<std::vector<size_t>>();
+		}
+
+		if (m_config.contains("warmupTime"))
+		{
+			m_warmupTime = m_config["warmupTime"].get<float>();
+		}
+
+		if (m_config.contains("stepTime"))
+		{
+			m_stepTime = m_config["stepTime"].get<float>();
+		}
+
+		if (m_config.contains("loadTimeout"))
+		{
+			m_loadTimeout = m_config["loadTimeout"].get<float>();
+		}
+
+		if (m_config.contains("gridSize"))
+		{
+			m_gridSize = m_config["gridSize"].get<float>();
+		}
+
+		if (m_config.contains("gridDistance"))
+		{
+			m_gridDistance = m_config["gridDistance"].get<float>();
+		}
+
+		if (m_config.contains("meshDirectory"))
+		{
+			m_meshDirectory = m_config["meshDirectory"].get<std::string>();
+		}
+
+		if (m_config.contains("outputFile"))
+		{
+			m_outputFile = m_config["outputFile"].get<std::string>();
+		}
+
+		// Meshes are written as files up front, the renderers then load them like any other model
+		GameController& gameController = GameController::get();
+		std::filesystem::create_directories(gameController.getConfigRelativePath(m_meshDirectory));
+		for (size_t triangleCount : m_triangleCounts)
+		{
+			Visual::MeshGenerator::Mesh mesh = Visual::MeshGenerator::generate(m_shape, triangleCount);
+			std::string modelPath = m_meshDirectory + "/" + Visual::MeshGenerator::getShapeName(m_shape) + "_" + std::to_string(triangleCount) + ".glb";
+
+			bool writeResult = Visual::MeshGenerator::writeGlb(mesh, gameController.getConfigRelativePath(modelPath));
+			ASSERT(writeResult, "Failed to write generated mesh: {}", modelPath);
+			if (!writeResult)
+			{
+				continue;
+			}
+
+			m_modelPaths.push_back(modelPath);
+			m_generatedTriangleCounts.push_back(mesh.getTriangleCount());
+		}
+
+		gameController.getCoroutinesManager().start(runSweep());
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Experiment4System::onUpdate(float dt)
+	{
+		if (m_measuring)
+		{
+			m_frameTimes.push_back(dt);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Experiment4System::onStop()
+	{
+		writeResults();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int Experiment4System::getPriority() const
+	{
+		return 0;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Utils::Task Experiment4System::runSweep()
+	{
+		for (size_t meshIndex = 0; meshIndex < m_modelPaths.size(); meshIndex++)
+		{
+			for (size_t objectsCount : m_objectCounts)
+			{
+				spawnObjects(m_modelPaths[meshIndex], objectsCount);
+
+				// Loading is not part of the measurement
+				float waitedTime = 0.0f;
+				while (!areObjectsLoaded() && waitedTime < m_loadTimeout)
+				{
+					co_await seconds(0.1f);
+					waitedTime += 0.1f;
+				}
+				ASSERT(areObjectsLoaded(), "Timed out loading model: {}", m_modelPaths[meshIndex]);
+
+				co_await seconds(m_warmupTime);
+				m_frameTimes.clear();
+				m_measuring = true;
+				co_await seconds(m_stepTime);
+				m_measuring = false;
+
+				m_results.push_back(collectStepResult(m_generatedTriangleCounts[meshIndex], objectsCount));
+
+				// Instances are destroyed by the rendering system during this frame, the rest of the entity on the next one
+				destroyObjects();
+				co_await nextFrame();
+				ComponentsManager& compManager = GameController::get().getComponentsManager();
+				EntitiesManager& entitiesManager = GameController::get().getEntitiesManager();
+				for (EntityID id : m_objects)
+				{
+					compManager.destroyEntity(id);
+					entitiesManager.destroyEntity(id);
+				}
+				m_objects.clear();
+			}
+		}
+
+		GameController::get().getEventsManager().emit(Engine::Events::NativeExitRequested{});
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Experiment4System::spawnObjects(const std::string& modelPath, size_t count)
+	{
+		GameController& gameController = GameController::get();
+		ComponentsManager& compManager = gameController.getComponentsManager();
+		Utils::SparseSet<Components::Transform, EntityID>& transformSet = compManager.getComponentSet<Components::Transform>();
+		Utils::SparseSet<Components::Model, EntityID>& modelSet = compManager.getComponentSet<Components::Model>();
+
+		// Square grid in front of the camera, objects shrink as their count grows
+		size_t elementsPerRow = std::max<size_t>(1, (size_t)std::ceil(std::sqrt((double)count)));
+		float distanceDelta = m_gridSize / elementsPerRow;
+		float initialPosition = -m_gridSize / 2.0f + distanceDelta / 2.0f;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			EntityID id = gameController.getEntitiesManager().createEntity();
+
+			Components::Transform transform;
+			transform.position.x = initialPosition + (float)(i % elementsPerRow) * distanceDelta;
+			transform.position.y = initialPosition + (float)(i / elementsPerRow) * distanceDelta;
+			transform.position.z = m_gridDistance;
+			transform.scale = Utils::Vector3(distanceDelta * 0.9f);
+			transformSet.addElement(id, transform);
+
+			Components::Model model;
+			model.path = modelPath;
+			modelSet.addElement(id, std::move(model));
+
+			m_objects.push_back(id);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool Experiment4System::areObjectsLoaded() const
+	{
+		const auto& modelSet = GameController::get().getComponentsManager().getComponentSet<Components::Model>();
+		return std::all_of(m_objects.begin(), m_objects.end(), [&modelSet](EntityID id)
+			{
+				return modelSet.isPresent(id) && modelSet.getElement(id).instance;
+			});
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Experiment4System::destroyObjects()
+	{
+		auto& modelSet = GameController::get().getComponentsManager().getComponentSet<Components::Model>();
+		for (EntityID id : m_objects)
+		{
+			if (modelSet.isPresent(id))
+			{
+				modelSet.getElement(id).markedForDestroy = true;
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Experiment4System::StepResult Experiment4System::collectStepResult(size_t trianglesPerObject, size_t objectsCount)
+	{
+		StepResult result{ trianglesPerObject, objectsCount, m_frameTimes.size(), 0.0f, 0.0f, 0.0f };
+		if (m_frameTimes.empty())
+		{
+			return result;
+		}
+
+		std::sort(m_frameTimes.begin(), m_frameTimes.end());
+		result.averageFrameTime = std::accumulate(m_frameTimes.begin(), m_frameTimes.end(), 0.0f) / m_frameTimes.size();
+		result.medianFrameTime = m_frameTimes[m_frameTimes.size() / 2];
+
+		size_t onePercent = m_frameTimes.size() / 100;
+		result.percentile99 = onePercent > 0 ? m_frameTimes[m_frameTimes.size() - onePercent] : m_frameTimes.back();
+		return result;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Experiment4System::writeResults() const
+	{
+		if (m_outputFile.empty())
+		{
+			return;
+		}
+
+		std::ofstream outFile(GameController::get().getConfigRelativePath(m_outputFile));
+		if (!outFile.is_open())
+		{
+			return;
+		}
+
+		outFile << "Shape: " << Visual::MeshGenerator::getShapeName(m_shape) << std::endl;
+		outFile << "Step time: " << m_stepTime << std::endl;
+		outFile << "Triangles per object, Objects count, Total triangles, Frames, Average frame time (ms), Median frame time (ms), 99th percentile frame time (ms)" << std::endl;
+		for (const StepResult& result : m_results)
+		{
+			outFile << result.trianglesPerObject << ", "
+				<< result.objectsCount << ", "
+				<< result.trianglesPerObject * result.objectsCount << ", "
+				<< result.framesCount << ", "
+				<< result.averageFrameTime * 1000.0f << ", "
+				<< result.medianFrameTime * 1000.0f << ", "
+				<< result.percentile99 * 1000.0f << std::endl;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ISystem.h"
+#include "Managers/EntitiesManager.h"
+#include "Utils/Task.h"
+#include "Visual/MeshGenerator.h"
+
+namespace Engine::Systems
+{
+	// Sweeps triangles per object against object count with generated meshes, every step is measured separately.
+	// The objects of a step always cover the same square, so only the per draw and per vertex work changes.
+	class Experiment4System: public ISystem
+	{
+	public:
+		void onStart() override;
+		void onUpdate(float dt) override;
+		void onStop() override;
+		int getPriority() const override;
+
+	private:
+		struct StepResult
+		{
+			size_t trianglesPerObject;
+			size_t objectsCount;
+			size_t framesCount;
+			float averageFrameTime;
+			float medianFrameTime;
+			float percentile99;
+		};
+
+	private:
+		Utils::Task runSweep();
+		void spawnObjects(const std::string& modelPath, size_t count);
+		bool areObjectsLoaded() const;
+		void destroyObjects();
+		StepResult collectStepResult(size_t trianglesPerObject, size_t objectsCount);
+		void writeResults() const;
+
+	private:
+		Visual::MeshGenerator::Shape m_shape = Visual::MeshGenerator::Shape::Sphere;
+		std::vector<size_t> m_triangleCounts = { 1000 };
+		std::vector<size_t> m_objectCounts = { 100 };
+		float m_warmupTime = 1.0f;
+		float m_stepTime = 5.0f;
+		float m_loadTimeout = 30.0f;
+		float m_gridSize = 10.0f;
+		float m_gridDistance = 10.0f;
+		std::string m_meshDirectory = "../Models/Generated";
+		std::string m_outputFile;
+
+		std::vector<std::string> m_modelPaths; // Per triangle count
+		std::vector<size_t> m_generatedTriangleCounts;
+		std::vector<EntityID> m_objects;
+		bool m_measuring = false;
+		std::vector<float> m_frameTimes;
+		std::vector<StepResult> m_results;
+	};
+}
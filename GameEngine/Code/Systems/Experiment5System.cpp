@@ -0,0 +1,428 @@
+#include "Experiment5System.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+
+#include "Managers/GameController.h"
+#include "Events/NativeInputEvents.h"
+#include "Components/Transform.h"
+#include "Components/Model.h"
+#include "Systems/RenderingSystem.h"
+#include "Visual/MeshGenerator.h"
+#include "Utils/DebugMacros.h"
+
+REGISTER_SYSTEM(Engine::Systems::Experiment5System);
+
+namespace Engine::Systems
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	void Experiment5System::onStart()
+	{
+		ASSERT(m_config.contains("textureCount"), "textureCount not found in config");
+		if (m_config.contains("textureCount"))
+		{
+			m_texturesCount = m_config["textureCount"].get<size_t>();
+		}
+
+		ASSERT(m_config.contains("textureResolution"), "textureResolution not found in config");
+		if (m_config.contains("textureResolution"))
+		{
+			m_textureResolution = m_config["textureResolution"].get<int>();
+		}
+
+		if (m_config.contains("textureFormat"))
+		{
+			bool validFormat = Visual::TextureGenerator::parseFormat(m_config["textureFormat"].get<std::string>(), m_textureFormat);
+			ASSERT(validFormat, "Unknown texture format: {}", m_config["textureFormat"].get<std::string>());
+		}
+
+		if (m_config.contains("warmupTime"))
+		{
+			m_warmupTime = m_config["warmupTime"].get<float>();
+		}
+
+		if (m_config.contains("stepTime"))
+		{
+			m_stepTime = m_config["stepTime"].get<float>();
+		}
+
+		if (m_config.contains("loadTimeout"))
+		{
+			m_loadTimeout = m_config["loadTimeout"].get<float>();
+		}
+
+		if (m_config.contains("gridSize"))
+		{
+			m_gridSize = m_config["gridSize"].get<float>();
+		}
+
+		if (m_config.contains("gridDistance"))
+		{
+			m_gridDistance = m_config["gridDistance"].get<float>();
+		}
+
+		if (m_config.contains("assetsDirectory"))
+		{
+			m_assetsDirectory = m_config["assetsDirectory"].get<std::string>();
+		}
+
+		if (m_config.contains("outputFile"))
+		{
+			m_outputFile = m_config["outputFile"].get<std::string>();
+		}
+
+		PDH_STATUS openResult = PdhOpenQuery(nullptr, 0, &m_gpuMemoryQuery);
+		ASSERT(openResult == ERROR_SUCCESS, "Failed to open GPU memory query");
+		if (openResult == ERROR_SUCCESS)
+		{
+			PDH_STATUS addResult = PdhAddCounter(m_gpuMemoryQuery, TEXT("\\GPU Process Memory(*)\\Dedicated Usage"), 0, &m_dedicatedMemoryCounter);
+			ASSERT(addResult == ERROR_SUCCESS, "Failed to add GPU dedicated memory counter");
+			addResult = PdhAddCounter(m_gpuMemoryQuery, TEXT("\\GPU Process Memory(*)\\Shared Usage"), 0, &m_sharedMemoryCounter);
+			ASSERT(addResult == ERROR_SUCCESS, "Failed to add GPU shared memory counter");
+			PdhCollectQueryData(m_gpuMemoryQuery);
+		}
+
+		if (!generateAssets())
+		{
+			return;
+		}
+
+		GameController::get().getCoroutinesManager().start(runExperiment());
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Experiment5System::onUpdate(float dt)
+	{
+		if (!m_measuring)
+		{
+			return;
+		}
+
+		m_frameTimes.push_back(dt);
+
+		m_timeSinceSample += dt;
+		if (m_timeSinceSample > k_timeBetweenSamples)
+		{
+			m_timeSinceSample = 0.0f;
+			sampleGpuMemory();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Experiment5System::onStop()
+	{
+		if (m_gpuMemoryQuery)
+		{
+			PdhCloseQuery(m_gpuMemoryQuery);
+			m_gpuMemoryQuery = nullptr;
+		}
+
+		writeResults();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int Experiment5System::getPriority() const
+	{
+		return 0;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool Experiment5System::generateAssets()
+	{
+		// Files are named after their contents, so they are only written by the first run of a configuration
+		GameController& gameController = GameController::get();
+		std::filesystem::create_directories(gameController.getConfigRelativePath(m_assetsDirectory));
+
+		Visual::MeshGenerator::Mesh quad = Visual::MeshGenerator::generate(Visual::MeshGenerator::Shape::Grid, 2);
+		for (size_t i = 0; i <= m_texturesCount; i++)
+		{
+			std::string name = i < m_texturesCount ? std::to_string(i) : k_sharedName;
+			std::string texturePath = gameController.getConfigRelativePath(getTexturePath(name));
+			std::string modelPath = gameController.getConfigRelativePath(getModelPath(name));
+
+			bool writeResult = true;
+			if (!std::filesystem::exists(texturePath))
+			{
+				writeResult = Visual::TextureGenerator::writeBmp(texturePath, m_textureResolution, m_textureFormat, static_cast<uint32_t>(i));
+			}
+			if (writeResult && !std::filesystem::exists(modelPath))
+			{
+				writeResult = Visual::MeshGenerator::writeGlb(quad, modelPath, std::filesystem::path(texturePath).filename().string());
+			}
+
+			ASSERT(writeResult, "Failed to write generated assets: {}", modelPath);
+			if (!writeResult)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Utils::Task Experiment5System::runExperiment()
+	{
+		// Baseline with the same draws, only the texture is shared
+		spawnObjects(false);
+		co_await waitForObjects();
+		co_await seconds(m_warmupTime);
+		startMeasuring();
+		co_await seconds(m_stepTime);
+		m_sharedResult = stopMeasuring();
+		co_await destroyObjects();
+
+		const Visual::TextureStats* textureStats = getTextureStats();
+		Visual::TextureStats statsBefore = textureStats ? *textureStats : Visual::TextureStats();
+
+		auto loadStart = std::chrono::high_resolution_clock::now();
+		spawnObjects(true);
+		co_await waitForObjects();
+		std::chrono::duration<double> loadTime = std::chrono::high_resolution_clock::now() - loadStart;
+
+		m_uploadResult.loadTime = loadTime.count();
+		if (textureStats)
+		{
+			m_uploadResult.uploadedTextures = textureStats->uploadedTextures - statsBefore.uploadedTextures;
+			m_uploadResult.uploadedBytes = textureStats->uploadedBytes - statsBefore.uploadedBytes;
+			m_uploadResult.uploadTime = textureStats->uploadTime - statsBefore.uploadTime;
+			m_uploadResult.residentBytes = textureStats->residentBytes;
+		}
+
+		co_await seconds(m_warmupTime);
+		startMeasuring();
+		co_await seconds(m_stepTime);
+		m_uniqueResult = stopMeasuring();
+		co_await destroyObjects();
+
+		m_finished = true;
+		GameController::get().getEventsManager().emit(Engine::Events::NativeExitRequested{});
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Utils::Task Experiment5System::waitForObjects()
+	{
+		const auto& modelSet = GameController::get().getComponentsManager().getComponentSet<Components::Model>();
+		auto isLoaded = [&modelSet](EntityID id)
+			{
+				return modelSet.isPresent(id) && modelSet.getElement(id).instance;
+			};
+
+		// Polled every frame, the load time is part of the results
+		auto waitStart = std::chrono::high_resolution_clock::now();
+		std::chrono::duration<float> waitedTime(0.0f);
+		while (!std::all_of(m_objects.begin(), m_objects.end(), isLoaded) && waitedTime.count() < m_loadTimeout)
+		{
+			co_await nextFrame();
+			waitedTime = std::chrono::high_resolution_clock::now() - waitStart;
+		}
+		ASSERT(std::all_of(m_objects.begin(), m_objects.end(), isLoaded), "Timed out loading the texture stress objects");
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Utils::Task Experiment5System::destroyObjects()
+	{
+		ComponentsManager& compManager = GameController::get().getComponentsManager();
+		EntitiesManager& entitiesManager = GameController::get().getEntitiesManager();
+		auto& modelSet = compManager.getComponentSet<Components::Model>();
+		for (EntityID id : m_objects)
+		{
+			if (modelSet.isPresent(id))
+			{
+				modelSet.getElement(id).markedForDestroy = true;
+			}
+		}
+
+		// Instances are destroyed by the rendering system during this frame, the rest of the entity on the next one
+		co_await nextFrame();
+		for (EntityID id : m_objects)
+		{
+			compManager.destroyEntity(id);
+			entitiesManager.destroyEntity(id);
+		}
+		m_objects.clear();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Experiment5System::spawnObjects(bool uniqueTextures)
+	{
+		GameController& gameController = GameController::get();
+		ComponentsManager& compManager = gameController.getComponentsManager();
+		Utils::SparseSet<Components::Transform, EntityID>& transformSet = compManager.getComponentSet<Components::Transform>();
+		Utils::SparseSet<Components::Model, EntityID>& modelSet = compManager.getComponentSet<Components::Model>();
+
+		size_t elementsPerRow = std::max<size_t>(1, (size_t)std::ceil(std::sqrt((double)m_texturesCount)));
+		float distanceDelta = m_gridSize / elementsPerRow;
+		float initialPosition = -m_gridSize / 2.0f + distanceDelta / 2.0f;
+
+		for (size_t i = 0; i < m_texturesCount; i++)
+		{
+			EntityID id = gameController.getEntitiesManager().createEntity();
+
+			Components::Transform transform;
+			transform.position.x = initialPosition + (float)(i % elementsPerRow) * distanceDelta;
+			transform.position.y = initialPosition + (float)(i / elementsPerRow) * distanceDelta;
+			transform.position.z = m_gridDistance;
+			transform.scale = Utils::Vector3(distanceDelta);
+			transformSet.addElement(id, transform);
+
+			Components::Model model;
+			model.path = getModelPath(uniqueTextures ? std::to_string(i) : k_sharedName);
+			modelSet.addElement(id, std::move(model));
+
+			m_objects.push_back(id);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Experiment5System::startMeasuring()
+	{
+		m_frameTimes.clear();
+		m_maxDedicatedMemory = 0.0;
+		m_maxSharedMemory = 0.0;
+		m_timeSinceSample = 0.0f;
+		m_measuring = true;
+		sampleGpuMemory();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Experiment5System::PhaseResult Experiment5System::stopMeasuring()
+	{
+		m_measuring = false;
+
+		PhaseResult result;
+		result.framesCount = m_frameTimes.size();
+		result.maxDedicatedMemory = m_maxDedicatedMemory;
+		result.maxSharedMemory = m_maxSharedMemory;
+		if (m_frameTimes.empty())
+		{
+			return result;
+		}
+
+		std::sort(m_frameTimes.begin(), m_frameTimes.end());
+		result.averageFrameTime = std::accumulate(m_frameTimes.begin(), m_frameTimes.end(), 0.0f) / m_frameTimes.size();
+		result.medianFrameTime = m_frameTimes[m_frameTimes.size() / 2];
+		result.maxFrameTime = m_frameTimes.back();
+
+		size_t onePercent = m_frameTimes.size() / 100;
+		result.percentile99 = onePercent > 0 ? m_frameTimes[m_frameTimes.size() - onePercent] : m_frameTimes.back();
+
+		float spikeThreshold = result.medianFrameTime * k_spikeFactor;
+		result.spikesCount = m_frameTimes.end() - std::upper_bound(m_frameTimes.begin(), m_frameTimes.end(), spikeThreshold);
+		return result;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Experiment5System::sampleGpuMemory()
+	{
+		if (!m_gpuMemoryQuery || PdhCollectQueryData(m_gpuMemoryQuery) != ERROR_SUCCESS)
+		{
+			return;
+		}
+
+		PDH_FMT_COUNTERVALUE counterValue;
+		if (PdhGetFormattedCounterValue(m_dedicatedMemoryCounter, PDH_FMT_DOUBLE, nullptr, &counterValue) == ERROR_SUCCESS)
+		{
+			m_maxDedicatedMemory = std::max(m_maxDedicatedMemory, counterValue.doubleValue / (1024.0 * 1024.0));
+		}
+		if (PdhGetFormattedCounterValue(m_sharedMemoryCounter, PDH_FMT_DOUBLE, nullptr, &counterValue) == ERROR_SUCCESS)
+		{
+			m_maxSharedMemory = std::max(m_maxSharedMemory, counterValue.doubleValue / (1024.0 * 1024.0));
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const Visual::TextureStats* Experiment5System::getTextureStats() const
+	{
+		const RenderingSystem* renderingSystem = GameController::get().getSystemsManager().getSystem<RenderingSystem>();
+		ASSERT(renderingSystem && renderingSystem->getRenderer(), "Texture stress needs a running RenderingSystem");
+		if (!renderingSystem || !renderingSystem->getRenderer())
+		{
+			return nullptr;
+		}
+		return &renderingSystem->getRenderer()->getTextureStats();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Experiment5System::writeResults() const
+	{
+		if (m_outputFile.empty() || !m_finished)
+		{
+			return;
+		}
+
+		std::ofstream outFile(GameController::get().getConfigRelativePath(m_outputFile));
+		if (!outFile.is_open())
+		{
+			return;
+		}
+
+		double megabyte = 1024.0 * 1024.0;
+		double uploadedTextures = (double)std::max<size_t>(m_uploadResult.uploadedTextures, 1);
+
+		outFile << "Textures count: " << m_texturesCount << std::endl;
+		outFile << "Texture resolution: " << m_textureResolution << std::endl;
+		outFile << "Texture format: " << Visual::TextureGenerator::getFormatName(m_textureFormat) << std::endl;
+		outFile << "Load time (s): " << m_uploadResult.loadTime << std::endl;
+		outFile << "Uploaded textures: " << m_uploadResult.uploadedTextures << std::endl;
+		outFile << "Uploaded texture memory (MB): " << m_uploadResult.uploadedBytes / megabyte << std::endl;
+		outFile << "Renderer upload time (s): " << m_uploadResult.uploadTime << std::endl;
+		outFile << "Upload time per texture (ms): " << m_uploadResult.uploadTime * 1000.0 / uploadedTextures << std::endl;
+		outFile << "Upload throughput (MB/s): " << (m_uploadResult.uploadTime > 0.0 ? m_uploadResult.uploadedBytes / megabyte / m_uploadResult.uploadTime : 0.0) << std::endl;
+		outFile << "Resident texture memory (MB): " << m_uploadResult.residentBytes / megabyte << std::endl;
+
+		auto writePhase = [&outFile](const std::string& name, const PhaseResult& result)
+			{
+				outFile << name << " frames: " << result.framesCount << std::endl;
+				outFile << name << " average frame time (ms): " << result.averageFrameTime * 1000.0f << std::endl;
+				outFile << name << " median frame time (ms): " << result.medianFrameTime * 1000.0f << std::endl;
+				outFile << name << " 99th percentile frame time (ms): " << result.percentile99 * 1000.0f << std::endl;
+				outFile << name << " max frame time (ms): " << result.maxFrameTime * 1000.0f << std::endl;
+				outFile << name << " frame time spikes: " << result.spikesCount << std::endl;
+				outFile << name << " max GPU dedicated memory (MB): " << result.maxDedicatedMemory << std::endl;
+				outFile << name << " max GPU shared memory (MB): " << result.maxSharedMemory << std::endl;
+			};
+		writePhase("Shared texture", m_sharedResult);
+		writePhase("Unique textures", m_uniqueResult);
+
+		// Same draws in both phases, what is left is binding and sampling distinct textures, and paging them when they don't fit
+		float samplingCost = m_uniqueResult.medianFrameTime - m_sharedResult.medianFrameTime;
+		outFile << "Texture cost per frame (ms): " << samplingCost * 1000.0f << std::endl;
+		outFile << "Texture cost per object (us): " << samplingCost * 1000000.0f / std::max<size_t>(m_texturesCount, 1) << std::endl;
+		outFile << "Shared GPU memory growth (MB): " << m_uniqueResult.maxSharedMemory - m_sharedResult.maxSharedMemory << std::endl;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::string Experiment5System::getTexturePath(const std::string& name) const
+	{
+		return m_assetsDirectory + "/texture_" + std::to_string(m_textureResolution) + "_" + Visual::TextureGenerator::getFormatName(m_textureFormat) + "_" + name + ".bmp";
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::string Experiment5System::getModelPath(const std::string& name) const
+	{
+		return m_assetsDirectory + "/quad_" + std::to_string(m_textureResolution) + "_" + Visual::TextureGenerator::getFormatName(m_textureFormat) + "_" + name + ".glb";
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <pdh.h>
+
+#include "ISystem.h"
+#include "Managers/EntitiesManager.h"
+#include "Utils/Task.h"
+#include "Visual/TextureGenerator.h"
+#include "Visual/TextureStats.h"
+
+namespace Engine::Systems
+{
+	// Texture stress: the same quads are drawn first all sharing one texture, then each with its own generated one.
+	// The difference between the two phases is the cost of uploading, keeping resident and sampling the textures.
+	class Experiment5System: public ISystem
+	{
+	public:
+		void onStart() override;
+		void onUpdate(float dt) override;
+		void onStop() override;
+		int getPriority() const override;
+
+	private:
+		struct PhaseResult
+		{
+			size_t framesCount = 0;
+			float averageFrameTime = 0.0f;
+			float medianFrameTime = 0.0f;
+			float percentile99 = 0.0f;
+			float maxFrameTime = 0.0f;
+			size_t spikesCount = 0; // Frames longer than k_spikeFactor times the median, e.g. when textures are paged in
+			double maxDedicatedMemory = 0.0; // MB, as reported by the GPU performance counters
+			double maxSharedMemory = 0.0;
+		};
+
+		struct UploadResult
+		{
+			double loadTime = 0.0; // Seconds from spawning the objects until all of them can be drawn
+			size_t uploadedTextures = 0;
+			size_t uploadedBytes = 0;
+			double uploadTime = 0.0; // Seconds the renderer spent decoding and submitting
+			size_t residentBytes = 0;
+		};
+
+	private:
+		bool generateAssets();
+		Utils::Task runExperiment();
+		Utils::Task waitForObjects();
+		Utils::Task destroyObjects();
+		void spawnObjects(bool uniqueTextures);
+		void startMeasuring();
+		PhaseResult stopMeasuring();
+		void sampleGpuMemory();
+		const Visual::TextureStats* getTextureStats() const;
+		void writeResults() const;
+
+		std::string getTexturePath(const std::string& name) const;
+		std::string getModelPath(const std::string& name) const;
+
+	private:
+		static constexpr float k_spikeFactor = 2.0f;
+		static constexpr float k_timeBetweenSamples = 1.0f;
+		static constexpr const char* k_sharedName = "shared";
+
+		size_t m_texturesCount = 64;
+		int m_textureResolution = 1024;
+		Visual::TextureGenerator::Format m_textureFormat = Visual::TextureGenerator::Format::RGBA;
+		float m_warmupTime = 1.0f;
+		float m_stepTime = 5.0f;
+		float m_loadTimeout = 60.0f;
+		float m_gridSize = 10.0f;
+		float m_gridDistance = 10.0f;
+		std::string m_assetsDirectory = "../Models/Generated";
+		std::string m_outputFile;
+
+		std::vector<EntityID> m_objects;
+		bool m_measuring = false;
+		float m_timeSinceSample = 0.0f;
+		std::vector<float> m_frameTimes;
+		double m_maxDedicatedMemory = 0.0;
+		double m_maxSharedMemory = 0.0;
+
+		PDH_HQUERY m_gpuMemoryQuery = nullptr;
+		PDH_HCOUNTER m_dedicatedMemoryCounter = nullptr;
+		PDH_HCOUNTER m_sharedMemoryCounter = nullptr;
+
+		PhaseResult m_sharedResult;
+		PhaseResult m_uniqueResult;
+		UploadResult m_uploadResult;
+		bool m_finished = false;
+	};
+}
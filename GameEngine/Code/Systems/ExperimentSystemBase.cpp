@@ -25,26 +25,24 @@ namespace Engine::Systems
 		ASSERT(m_config.contains("experimentTime"), "experientTime field not found in experiment config");
 		if (m_config.contains("experimentTime"))
 		{
-			m_timeLeft = m_config["experimentTime"].get<float>();
+			m_experimentTime = m_config["experimentTime"].get<float>();
 		}
+
+		GameController::get().getCoroutinesManager().start(waitForExperimentEnd());
 	}
 
 	//////////////////////////////////////////////////////////////////////////
 
 	void ExperimentSystemBase::onUpdate(float dt)
 	{
-		checkExperimentEnd(dt);
 	}
 
 	//////////////////////////////////////////////////////////////////////////
 
-	void ExperimentSystemBase::checkExperimentEnd(float dt)
+	Utils::Task ExperimentSystemBase::waitForExperimentEnd()
 	{
-		m_timeLeft -= dt;
-		if (m_timeLeft <= 0)
-		{
-			GameController::get().getEventsManager().emit(Engine::Events::NativeExitRequested{});
-		}
+		co_await seconds(m_experimentTime);
+		GameController::get().getEventsManager().emit(Engine::Events::NativeExitRequested{});
 	}
 
 	//////////////////////////////////////////////////////////////////////////
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ISystem.h"
+#include "Utils/Task.h"
 
 namespace Engine::Systems
 {
@@ -10,12 +11,12 @@ namespace Engine::Systems
 		void onStart() override;
 		void onUpdate(float dt) override;
 	private:
-		void checkExperimentEnd(float dt);
+		Utils::Task waitForExperimentEnd();
 	protected:
 		static constexpr const char* k_experimentObjectTag = "ExperimentObject";
 
 		std::string m_prefabName = "Cube";
 		size_t m_prefabsCount = 10;
-		float m_timeLeft = 10.0f;
+		float m_experimentTime = 10.0f;
 	};
 }
\ No newline at end of file
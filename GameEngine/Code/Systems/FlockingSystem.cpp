@@ -0,0 +1,438 @@
+#include "FlockingSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <random>
+
+#include "Managers/GameController.h"
+#include "Components/Transform.h"
+#include "Components/Tag.h"
+#include "Utils/DebugMacros.h"
+
+REGISTER_SYSTEM(Engine::Systems::FlockingSystem);
+
+namespace Engine::Systems
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	void FlockingSystem::Agents::resize(size_t count)
+	{
+		positionX.resize(count);
+		positionY.resize(count);
+		positionZ.resize(count);
+		velocityX.resize(count);
+		velocityY.resize(count);
+		velocityZ.resize(count);
+		entities.resize(count);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void FlockingSystem::onStart()
+	{
+		ExperimentSystemBase::onStart();
+
+		if (m_config.contains("seed"))
+		{
+			m_seed = m_config["seed"].get<uint32_t>();
+		}
+
+		if (m_config.contains("layout"))
+		{
+			Utils::Parser::fillFromJson(m_layout, m_config["layout"]);
+		}
+
+		if (m_config.contains("neighborRadius"))
+		{
+			m_neighborRadius = m_config["neighborRadius"].get<float>();
+		}
+
+		if (m_config.contains("separationRadius"))
+		{
+			m_separationRadius = m_config["separationRadius"].get<float>();
+		}
+
+		if (m_config.contains("separationWeight"))
+		{
+			m_separationWeight = m_config["separationWeight"].get<float>();
+		}
+
+		if (m_config.contains("alignmentWeight"))
+		{
+			m_alignmentWeight = m_config["alignmentWeight"].get<float>();
+		}
+
+		if (m_config.contains("cohesionWeight"))
+		{
+			m_cohesionWeight = m_config["cohesionWeight"].get<float>();
+		}
+
+		if (m_config.contains("boundsWeight"))
+		{
+			m_boundsWeight = m_config["boundsWeight"].get<float>();
+		}
+
+		if (m_config.contains("minSpeed"))
+		{
+			m_minSpeed = m_config["minSpeed"].get<float>();
+		}
+
+		if (m_config.contains("maxSpeed"))
+		{
+			m_maxSpeed = m_config["maxSpeed"].get<float>();
+		}
+
+		if (m_config.contains("maxAcceleration"))
+		{
+			m_maxAcceleration = m_config["maxAcceleration"].get<float>();
+		}
+
+		if (m_config.contains("batchSize"))
+		{
+			m_batchSize = m_config["batchSize"].get<size_t>();
+		}
+
+		if (m_config.contains("outputFile"))
+		{
+			m_outputFile = m_config["outputFile"].get<std::string>();
+		}
+
+		ASSERT(m_neighborRadius > 0.0f, "neighborRadius must be positive, got {}", m_neighborRadius);
+		m_neighborRadius = std::max(m_neighborRadius, 0.001f);
+		m_separationRadius = std::min(m_separationRadius, m_neighborRadius);
+		m_minSpeed = std::min(m_minSpeed, m_maxSpeed);
+
+		spawnAgents();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void FlockingSystem::onUpdate(float dt)
+	{
+		float step = std::min(dt, k_maxTimeStep);
+		if (m_agents.entities.empty() || step <= 0.0f)
+		{
+			return;
+		}
+
+		JobsManager& jobsManager = GameController::get().getJobsManager();
+		size_t count = m_agents.entities.size();
+
+		auto gridStart = std::chrono::high_resolution_clock::now();
+		buildGrid();
+		auto updateStart = std::chrono::high_resolution_clock::now();
+
+		std::atomic<size_t> neighborsCount = 0;
+		jobsManager.parallelFor(count, m_batchSize, [this, step, &neighborsCount](size_t begin, size_t end)
+			{
+				neighborsCount += updateAgents(begin, end, step);
+			});
+		std::swap(m_agents, m_nextAgents);
+
+		auto writeStart = std::chrono::high_resolution_clock::now();
+		jobsManager.parallelFor(count, m_batchSize, [this](size_t begin, size_t end)
+			{
+				writeTransforms(begin, end);
+			});
+		auto writeEnd = std::chrono::high_resolution_clock::now();
+
+		m_framesCount++;
+		m_neighborsSum += (double)neighborsCount / (double)count;
+		m_gridTime += std::chrono::duration<double>(updateStart - gridStart).count();
+		m_updateTime += std::chrono::duration<double>(writeStart - updateStart).count();
+		m_writeTime += std::chrono::duration<double>(writeEnd - writeStart).count();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void FlockingSystem::onStop()
+	{
+		writeResults();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int FlockingSystem::getPriority() const
+	{
+		return 0;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void FlockingSystem::spawnAgents()
+	{
+		GameController& gameController = GameController::get();
+		ComponentsManager& compManager = gameController.getComponentsManager();
+		Utils::SparseSet<Components::Transform, EntityID>& transformSet = compManager.getComponentSet<Components::Transform>();
+		Utils::SparseSet<Components::Tag, EntityID>& tagSet = compManager.getComponentSet<Components::Tag>();
+
+		std::mt19937 random(m_seed);
+		std::vector<Utils::Vector3> positions = m_layout.generate(Utils::PointDistribution::Type::Uniform, m_prefabsCount, random);
+		std::vector<EntityID> ids = gameController.createPrefabs(m_prefabName, positions.size());
+		ASSERT(ids.size() == positions.size(), "Created {} agents out of {}", ids.size(), positions.size());
+
+		size_t count = std::min(ids.size(), positions.size());
+		m_agents.resize(count);
+		m_nextAgents.resize(count);
+		m_cellHashes.resize(count);
+
+		uint32_t bucketsCount = 1;
+		while (bucketsCount < 2 * count)
+		{
+			bucketsCount *= 2;
+		}
+		m_cellMask = bucketsCount - 1;
+		m_cellStarts.resize(bucketsCount + 1);
+		m_cellCursors.resize(bucketsCount);
+
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> speed(m_minSpeed, m_maxSpeed);
+		transformSet.reserve(transformSet.size() + count);
+		tagSet.reserve(tagSet.size() + count);
+		for (size_t i = 0; i < count; i++)
+		{
+			Utils::Vector3 direction;
+			do
+			{
+				direction = Utils::Vector3(unit(random), unit(random), unit(random));
+			} while (direction.lengthSqr() > 1.0f || direction.lengthSqr() < 0.0001f);
+			direction = direction.normalized() * speed(random);
+
+			m_agents.positionX[i] = positions[i].x;
+			m_agents.positionY[i] = positions[i].y;
+			m_agents.positionZ[i] = positions[i].z;
+			m_agents.velocityX[i] = direction.x;
+			m_agents.velocityY[i] = direction.y;
+			m_agents.velocityZ[i] = direction.z;
+			m_agents.entities[i] = ids[i];
+
+			if (!transformSet.isPresent(ids[i]))
+			{
+				transformSet.addElement(ids[i], Components::Transform{});
+			}
+			transformSet.getElement(ids[i]).position = positions[i];
+
+			tagSet.addElement(ids[i], Components::Tag{ k_experimentObjectTag });
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void FlockingSystem::buildGrid()
+	{
+		size_t count = m_agents.entities.size();
+		GameController::get().getJobsManager().parallelFor(count, m_batchSize, [this](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					m_cellHashes[i] = getCellHash(getCell(m_agents.positionX[i]), getCell(m_agents.positionY[i]), getCell(m_agents.positionZ[i]));
+				}
+			});
+
+		// Counting sort by bucket, agents of a cell end up next to each other for the neighbor loops
+		std::fill(m_cellStarts.begin(), m_cellStarts.end(), 0);
+		for (size_t i = 0; i < count; i++)
+		{
+			m_cellStarts[m_cellHashes[i] + 1]++;
+		}
+
+		for (size_t bucket = 1; bucket < m_cellStarts.size(); bucket++)
+		{
+			m_cellStarts[bucket] += m_cellStarts[bucket - 1];
+		}
+
+		std::copy(m_cellStarts.begin(), m_cellStarts.end() - 1, m_cellCursors.begin());
+		for (size_t i = 0; i < count; i++)
+		{
+			uint32_t target = m_cellCursors[m_cellHashes[i]]++;
+			m_nextAgents.positionX[target] = m_agents.positionX[i];
+			m_nextAgents.positionY[target] = m_agents.positionY[i];
+			m_nextAgents.positionZ[target] = m_agents.positionZ[i];
+			m_nextAgents.velocityX[target] = m_agents.velocityX[i];
+			m_nextAgents.velocityY[target] = m_agents.velocityY[i];
+			m_nextAgents.velocityZ[target] = m_agents.velocityZ[i];
+			m_nextAgents.entities[target] = m_agents.entities[i];
+		}
+
+		std::swap(m_agents, m_nextAgents);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t FlockingSystem::updateAgents(size_t begin, size_t end, float dt)
+	{
+		float neighborRadiusSqr = m_neighborRadius * m_neighborRadius;
+		float separationRadiusSqr = m_separationRadius * m_separationRadius;
+		Utils::Vector3 boundsMin = m_layout.center - m_layout.size * 0.5f;
+		Utils::Vector3 boundsMax = m_layout.center + m_layout.size * 0.5f;
+		size_t neighborsCount = 0;
+
+		for (size_t i = begin; i < end; i++)
+		{
+			float x = m_agents.positionX[i];
+			float y = m_agents.positionY[i];
+			float z = m_agents.positionZ[i];
+			Utils::Vector3 velocity(m_agents.velocityX[i], m_agents.velocityY[i], m_agents.velocityZ[i]);
+
+			Utils::Vector3 separation;
+			Utils::Vector3 averageVelocity;
+			Utils::Vector3 averageOffset;
+			uint32_t neighbors = 0;
+
+			// Cells of the 27 around the agent may share a bucket, each bucket is scanned once
+			uint32_t visited[27];
+			size_t visitedCount = 0;
+			int64_t cellX = getCell(x);
+			int64_t cellY = getCell(y);
+			int64_t cellZ = getCell(z);
+			for (int64_t offsetX = -1; offsetX <= 1; offsetX++)
+			{
+				for (int64_t offsetY = -1; offsetY <= 1; offsetY++)
+				{
+					for (int64_t offsetZ = -1; offsetZ <= 1; offsetZ++)
+					{
+						uint32_t hash = getCellHash(cellX + offsetX, cellY + offsetY, cellZ + offsetZ);
+						if (std::find(visited, visited + visitedCount, hash) != visited + visitedCount)
+						{
+							continue;
+						}
+						visited[visitedCount++] = hash;
+
+						for (uint32_t j = m_cellStarts[hash]; j < m_cellStarts[hash + 1]; j++)
+						{
+							float dx = m_agents.positionX[j] - x;
+							float dy = m_agents.positionY[j] - y;
+							float dz = m_agents.positionZ[j] - z;
+							float distanceSqr = dx * dx + dy * dy + dz * dz;
+							if (j == i || distanceSqr >= neighborRadiusSqr)
+							{
+								continue;
+							}
+
+							neighbors++;
+							averageVelocity += Utils::Vector3(m_agents.velocityX[j], m_agents.velocityY[j], m_agents.velocityZ[j]);
+							averageOffset += Utils::Vector3(dx, dy, dz);
+
+							// Pushes harder the closer the neighbor is
+							if (distanceSqr < separationRadiusSqr && distanceSqr > 0.0f)
+							{
+								separation -= Utils::Vector3(dx, dy, dz) * (1.0f / distanceSqr);
+							}
+						}
+					}
+				}
+			}
+
+			Utils::Vector3 acceleration = separation * m_separationWeight;
+			if (neighbors > 0)
+			{
+				float inverseNeighbors = 1.0f / (float)neighbors;
+				acceleration += (averageVelocity * inverseNeighbors - velocity) * m_alignmentWeight;
+				acceleration += averageOffset * inverseNeighbors * m_cohesionWeight;
+			}
+
+			// Agents outside the layout box are steered back in proportion to how far out they are
+			Utils::Vector3 outside;
+			outside.x = x < boundsMin.x ? boundsMin.x - x : (x > boundsMax.x ? boundsMax.x - x : 0.0f);
+			outside.y = y < boundsMin.y ? boundsMin.y - y : (y > boundsMax.y ? boundsMax.y - y : 0.0f);
+			outside.z = z < boundsMin.z ? boundsMin.z - z : (z > boundsMax.z ? boundsMax.z - z : 0.0f);
+			acceleration += outside * m_boundsWeight;
+
+			float accelerationSqr = acceleration.lengthSqr();
+			if (accelerationSqr > m_maxAcceleration * m_maxAcceleration)
+			{
+				acceleration *= m_maxAcceleration / std::sqrt(accelerationSqr);
+			}
+
+			velocity += acceleration * dt;
+			float speed = velocity.length();
+			if (speed > m_maxSpeed)
+			{
+				velocity *= m_maxSpeed / speed;
+			}
+			else if (speed < m_minSpeed)
+			{
+				velocity = speed > 0.0f ? velocity * (m_minSpeed / speed) : Utils::Vector3(0.0f, 0.0f, m_minSpeed);
+			}
+
+			m_nextAgents.positionX[i] = x + velocity.x * dt;
+			m_nextAgents.positionY[i] = y + velocity.y * dt;
+			m_nextAgents.positionZ[i] = z + velocity.z * dt;
+			m_nextAgents.velocityX[i] = velocity.x;
+			m_nextAgents.velocityY[i] = velocity.y;
+			m_nextAgents.velocityZ[i] = velocity.z;
+			m_nextAgents.entities[i] = m_agents.entities[i];
+			neighborsCount += neighbors;
+		}
+
+		return neighborsCount;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void FlockingSystem::writeTransforms(size_t begin, size_t end) const
+	{
+		Utils::SparseSet<Components::Transform, EntityID>& transformSet = GameController::get().getComponentsManager().getComponentSet<Components::Transform>();
+
+		for (size_t i = begin; i < end; i++)
+		{
+			Components::Transform& transform = transformSet.getElement(m_agents.entities[i]);
+			transform.position = Utils::Vector3(m_agents.positionX[i], m_agents.positionY[i], m_agents.positionZ[i]);
+
+			// Faces along the velocity, z forward, no roll
+			Utils::Vector3 velocity(m_agents.velocityX[i], m_agents.velocityY[i], m_agents.velocityZ[i]);
+			float horizontal = std::sqrt(velocity.x * velocity.x + velocity.z * velocity.z);
+			transform.rotation = Utils::Vector3(std::atan2(-velocity.y, horizontal), std::atan2(velocity.x, velocity.z), 0.0f);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	uint32_t FlockingSystem::getCellHash(int64_t x, int64_t y, int64_t z) const
+	{
+		uint32_t hash = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)z * 83492791u;
+		return hash & m_cellMask;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int64_t FlockingSystem::getCell(float value) const
+	{
+		return (int64_t)std::floor(value / m_neighborRadius);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void FlockingSystem::writeResults() const
+	{
+		if (m_outputFile.empty() || m_framesCount == 0)
+		{
+			return;
+		}
+
+		std::ofstream outFile(GameController::get().getConfigRelativePath(m_outputFile));
+		if (!outFile.is_open())
+		{
+			return;
+		}
+
+		double frames = (double)m_framesCount;
+		double agents = (double)m_agents.entities.size();
+
+		outFile << "Agents: " << m_agents.entities.size() << std::endl;
+		outFile << "Workers: " << GameController::get().getJobsManager().getWorkersCount() << std::endl;
+		outFile << "Batch size: " << m_batchSize << std::endl;
+		outFile << "Frames: " << m_framesCount << std::endl;
+		outFile << "Average neighbors: " << m_neighborsSum / frames << std::endl;
+		outFile << "Average grid time (ms): " << m_gridTime * 1000.0 / frames << std::endl;
+		outFile << "Average update time (ms): " << m_updateTime * 1000.0 / frames << std::endl;
+		outFile << "Average transforms write time (ms): " << m_writeTime * 1000.0 / frames << std::endl;
+		outFile << "Update time per agent (ns): " << (agents > 0.0 ? m_updateTime * 1e9 / (frames * agents) : 0.0) << std::endl;
+		outFile << "Grid and update time per agent (ns): " << (agents > 0.0 ? (m_gridTime + m_updateTime) * 1e9 / (frames * agents) : 0.0) << std::endl;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ExperimentSystemBase.h"
+#include "Managers/EntitiesManager.h"
+#include "Utils/PointDistribution.h"
+
+namespace Engine::Systems
+{
+	// Boids: every agent steers away from close neighbors, towards their average heading and their center.
+	// Agents live in structure of arrays storage, re-sorted by grid cell every frame so neighbors are close in memory.
+	class FlockingSystem: public ExperimentSystemBase
+	{
+	public:
+		void onStart() override;
+		void onUpdate(float dt) override;
+		void onStop() override;
+		int getPriority() const override;
+
+	private:
+		struct Agents
+		{
+			std::vector<float> positionX;
+			std::vector<float> positionY;
+			std::vector<float> positionZ;
+			std::vector<float> velocityX;
+			std::vector<float> velocityY;
+			std::vector<float> velocityZ;
+			std::vector<EntityID> entities;
+
+			void resize(size_t count);
+		};
+
+	private:
+		void spawnAgents();
+		void buildGrid();
+		size_t updateAgents(size_t begin, size_t end, float dt); // Returns the neighbors seen by the agents
+		void writeTransforms(size_t begin, size_t end) const;
+		uint32_t getCellHash(int64_t x, int64_t y, int64_t z) const;
+		int64_t getCell(float value) const;
+		void writeResults() const;
+
+	private:
+		static constexpr size_t k_defaultBatchSize = 512;
+		static constexpr float k_maxTimeStep = 1.0f / 30.0f; // Long frames would make agents jump across the grid
+
+		uint32_t m_seed = 0;
+		Utils::PointDistribution m_layout; // Agents spawn in it and are steered back when they leave it
+		float m_neighborRadius = 1.5f; // Also the grid cell size
+		float m_separationRadius = 0.5f;
+		float m_separationWeight = 1.5f;
+		float m_alignmentWeight = 1.0f;
+		float m_cohesionWeight = 1.0f;
+		float m_boundsWeight = 2.0f;
+		float m_minSpeed = 1.0f;
+		float m_maxSpeed = 4.0f;
+		float m_maxAcceleration = 8.0f;
+		size_t m_batchSize = k_defaultBatchSize;
+		std::string m_outputFile;
+
+		Agents m_agents; // Sorted by cell at the start of the frame
+		Agents m_nextAgents; // Counting sort target, then the updated state
+		std::vector<uint32_t> m_cellHashes; // Of each agent before sorting
+		std::vector<uint32_t> m_cellStarts; // First sorted agent of each hash bucket, plus the agents count
+		std::vector<uint32_t> m_cellCursors; // Next free slot of each bucket while scattering
+		uint32_t m_cellMask = 0; // Buckets count minus one, the count is a power of two
+
+		size_t m_framesCount = 0;
+		double m_gridTime = 0.0; // Seconds
+		double m_updateTime = 0.0;
+		double m_writeTime = 0.0;
+		double m_neighborsSum = 0.0;
+	};
+}
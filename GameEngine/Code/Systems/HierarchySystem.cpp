@@ -0,0 +1,280 @@
+#include "HierarchySystem.h"
+
+#include "Managers/GameController.h"
+#include "Components/Parent.h"
+#include "Components/Children.h"
+#include "Utils/DebugMacros.h"
+
+REGISTER_SYSTEM(Engine::Systems::HierarchySystem);
+
+namespace Engine::Systems
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	void HierarchySystem::onStart()
+	{
+		if (m_config.contains("batchSize"))
+		{
+			m_batchSize = m_config["batchSize"].get<size_t>();
+		}
+
+		rebuildStructure();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void HierarchySystem::onUpdate(float dt)
+	{
+		if (isStructureChanged())
+		{
+			rebuildStructure();
+		}
+
+		GameController& gameController = GameController::get();
+		Utils::DenseArray<Components::Transform>& transforms = gameController.getComponentsManager().getComponentSet<Components::Transform>().getElements();
+		JobsManager& jobsManager = gameController.getJobsManager();
+
+		// Nodes of one level only depend on the previous levels, so every level is split between workers
+		for (size_t level = 0; level + 1 < m_levelOffsets.size(); level++)
+		{
+			size_t levelBegin = m_levelOffsets[level];
+			size_t levelEnd = m_levelOffsets[level + 1];
+			jobsManager.parallelFor(levelEnd - levelBegin, m_batchSize, [this, &transforms, levelBegin](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; i++)
+					{
+						updateNode(transforms, levelBegin + i);
+					}
+				});
+		}
+
+		m_forceUpdate = false;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void HierarchySystem::onStop()
+	{
+
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int HierarchySystem::getPriority() const
+	{
+		return 5;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool HierarchySystem::isStructureChanged() const
+	{
+		ComponentsManager& compManager = GameController::get().getComponentsManager();
+		const Utils::SparseSet<Components::Transform, EntityID>& transformSet = compManager.getComponentSet<Components::Transform>();
+		const Utils::SparseSet<Components::Parent, EntityID>& parentSet = compManager.getComponentSet<Components::Parent>();
+
+		// Swap-and-pop removals and new transforms both break the breadth-first order
+		if (transformSet.getIds() != m_orderedIds)
+		{
+			return true;
+		}
+
+		if (parentSet.size() != m_parentLinks.size())
+		{
+			return true;
+		}
+
+		const std::vector<EntityID>& childIds = parentSet.getIds();
+		const Utils::DenseArray<Components::Parent>& parents = parentSet.getElements();
+		for (size_t i = 0; i < childIds.size(); i++)
+		{
+			if (m_parentLinks[i].first != childIds[i] || m_parentLinks[i].second != parents[i].id)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void HierarchySystem::rebuildStructure()
+	{
+		ComponentsManager& compManager = GameController::get().getComponentsManager();
+		Utils::SparseSet<Components::Transform, EntityID>& transformSet = compManager.getComponentSet<Components::Transform>();
+		const Utils::SparseSet<Components::Parent, EntityID>& parentSet = compManager.getComponentSet<Components::Parent>();
+		Utils::SparseSet<Components::Children, EntityID>& childrenSet = compManager.getComponentSet<Components::Children>();
+
+		auto getValidParent = [&](EntityID id) -> EntityID
+			{
+				if (!parentSet.isPresent(id))
+				{
+					return -1;
+				}
+
+				EntityID parent = parentSet.getElement(id).id;
+				if (parent == id || !transformSet.isPresent(parent))
+				{
+					return -1;
+				}
+
+				return parent;
+			};
+
+		m_parentLinks.clear();
+		childrenSet.clear();
+
+		const std::vector<EntityID>& childIds = parentSet.getIds();
+		const Utils::DenseArray<Components::Parent>& parents = parentSet.getElements();
+		for (size_t i = 0; i < childIds.size(); i++)
+		{
+			m_parentLinks.emplace_back(childIds[i], parents[i].id);
+
+			EntityID parent = getValidParent(childIds[i]);
+			if (parent == -1 || !transformSet.isPresent(childIds[i]))
+			{
+				continue;
+			}
+
+			if (!childrenSet.isPresent(parent))
+			{
+				childrenSet.addElement(parent, Components::Children{});
+			}
+			childrenSet.getElement(parent).ids.push_back(childIds[i]);
+		}
+
+		const std::vector<EntityID>& transformIds = transformSet.getIds();
+		EntityID maxId = transformIds.empty() ? 0 : *std::max_element(transformIds.begin(), transformIds.end());
+		std::vector<int> orderIndices(maxId + 1, -1);
+
+		std::vector<EntityID> order;
+		order.reserve(transformIds.size());
+		auto addToOrder = [&order, &orderIndices](EntityID id)
+			{
+				orderIndices[id] = static_cast<int>(order.size());
+				order.push_back(id);
+			};
+
+		for (EntityID id : transformIds)
+		{
+			if (getValidParent(id) == -1)
+			{
+				addToOrder(id);
+			}
+		}
+
+		m_levelOffsets.clear();
+		m_levelOffsets.push_back(0);
+
+		size_t levelBegin = 0;
+		while (levelBegin < order.size())
+		{
+			size_t levelEnd = order.size();
+			m_levelOffsets.push_back(levelEnd);
+
+			for (size_t i = levelBegin; i < levelEnd; i++)
+			{
+				if (!childrenSet.isPresent(order[i]))
+				{
+					continue;
+				}
+
+				for (EntityID child : childrenSet.getElement(order[i]).ids)
+				{
+					if (orderIndices[child] == -1)
+					{
+						addToOrder(child);
+					}
+				}
+			}
+
+			levelBegin = levelEnd;
+		}
+
+		// Entities that are left are part of a parent cycle, they are updated as roots
+		size_t reachableCount = order.size();
+		ASSERT(reachableCount == transformIds.size(), "Cycle found in transforms hierarchy");
+		if (reachableCount < transformIds.size())
+		{
+			for (EntityID id : transformIds)
+			{
+				if (orderIndices[id] == -1)
+				{
+					addToOrder(id);
+				}
+			}
+			m_levelOffsets.push_back(order.size());
+		}
+
+		m_parentIndices.assign(order.size(), -1);
+		for (size_t i = 0; i < reachableCount; i++)
+		{
+			EntityID parent = getValidParent(order[i]);
+			if (parent != -1)
+			{
+				m_parentIndices[i] = orderIndices[parent];
+			}
+		}
+
+		transformSet.reorder(order);
+		m_orderedIds = std::move(order);
+
+		m_localStates.resize(m_orderedIds.size());
+		m_worldRotations.resize(m_orderedIds.size());
+		m_dirty.assign(m_orderedIds.size(), 1);
+		m_forceUpdate = true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void HierarchySystem::updateNode(Utils::DenseArray<Components::Transform>& transforms, size_t index)
+	{
+		Components::Transform& transform = transforms[index];
+		LocalState& state = m_localStates[index];
+		int parentIndex = m_parentIndices[index];
+
+		bool localChanged = m_forceUpdate
+			|| !isSame(state.position, transform.position)
+			|| !isSame(state.rotation, transform.rotation)
+			|| !isSame(state.scale, transform.scale);
+		bool parentChanged = parentIndex >= 0 && m_dirty[parentIndex];
+
+		m_dirty[index] = localChanged || parentChanged;
+		if (!m_dirty[index])
+		{
+			return;
+		}
+
+		state.position = transform.position;
+		state.rotation = transform.rotation;
+		state.scale = transform.scale;
+
+		Utils::Quaternion localRotation = Utils::Quaternion::fromEulerAngles(transform.rotation);
+		if (parentIndex < 0)
+		{
+			transform.worldPosition = transform.position;
+			transform.worldRotation = transform.rotation;
+			transform.worldScale = transform.scale;
+			m_worldRotations[index] = localRotation;
+			return;
+		}
+
+		const Components::Transform& parent = transforms[parentIndex];
+		const Utils::Quaternion& parentRotation = m_worldRotations[parentIndex];
+
+		m_worldRotations[index] = parentRotation * localRotation;
+		transform.worldScale = parent.worldScale * transform.scale;
+		transform.worldPosition = parent.worldPosition + parentRotation.rotate(parent.worldScale * transform.position);
+		transform.worldRotation = m_worldRotations[index].toEulerAngles();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool HierarchySystem::isSame(const Utils::Vector3& left, const Utils::Vector3& right)
+	{
+		return left.x == right.x && left.y == right.y && left.z == right.z;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
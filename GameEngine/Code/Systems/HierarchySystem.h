@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+#include "ISystem.h"
+#include "Managers/EntitiesManager.h"
+#include "Components/Transform.h"
+#include "Utils/Vector.h"
+#include "Utils/Quaternion.h"
+#include "Utils/SparseSet.h"
+
+namespace Engine::Systems
+{
+	class HierarchySystem: public ISystem
+	{
+	public:
+		void onStart() override;
+		void onUpdate(float dt) override;
+		void onStop() override;
+		int getPriority() const override;
+
+	private:
+		struct LocalState
+		{
+			Utils::Vector3 position;
+			Utils::Vector3 rotation;
+			Utils::Vector3 scale;
+		};
+
+	private:
+		bool isStructureChanged() const;
+		void rebuildStructure();
+		void updateNode(Utils::DenseArray<Components::Transform>& transforms, size_t index);
+
+		static bool isSame(const Utils::Vector3& left, const Utils::Vector3& right);
+
+	private:
+		static constexpr size_t k_defaultBatchSize = 256;
+
+		size_t m_batchSize = k_defaultBatchSize;
+		bool m_forceUpdate = true;
+
+		// Transform ids in the breadth-first order they were sorted to during the last rebuild
+		std::vector<EntityID> m_orderedIds;
+		std::vector<std::pair<EntityID, EntityID>> m_parentLinks;
+
+		// Per dense index data, valid until the next rebuild
+		std::vector<int> m_parentIndices;
+		std::vector<size_t> m_levelOffsets;
+		std::vector<LocalState> m_localStates;
+		std::vector<Utils::Quaternion> m_worldRotations;
+		std::vector<uint8_t> m_dirty;
+	};
+}
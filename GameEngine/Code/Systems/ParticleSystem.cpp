@@ -0,0 +1,190 @@
+#include "ParticleSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+
+#include "Managers/GameController.h"
+#include "Components/Transform.h"
+#include "Components/Parent.h"
+#include "Systems/RenderingSystem.h"
+#include "Utils/DebugMacros.h"
+
+REGISTER_SYSTEM(Engine::Systems::ParticleSystem);
+
+namespace Engine::Systems
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	void ParticleSystem::onStart()
+	{
+		if (m_config.contains("batchSize"))
+		{
+			m_batchSize = m_config["batchSize"].get<size_t>();
+		}
+
+		if (m_config.contains("renderParticles"))
+		{
+			m_renderParticles = m_config["renderParticles"].get<bool>();
+		}
+
+		if (m_config.contains("seed"))
+		{
+			m_seed = m_config["seed"].get<uint32_t>();
+		}
+
+		if (m_config.contains("outputFile"))
+		{
+			m_outputFile = m_config["outputFile"].get<std::string>();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void ParticleSystem::onUpdate(float dt)
+	{
+		GameController& gameController = GameController::get();
+		ComponentsManager& compManager = gameController.getComponentsManager();
+		auto& emitterSet = compManager.getComponentSet<Components::ParticleEmitter>();
+		const auto& transformSet = compManager.getComponentSet<Components::Transform>();
+		const auto& parentSet = compManager.getComponentSet<Components::Parent>();
+
+		// Pools are allocated here on the main thread, the workers only fill them
+		m_jobs.clear();
+		for (EntityID id : compManager.entitiesWithComponents<Components::ParticleEmitter, Components::Transform>())
+		{
+			Components::ParticleEmitter& emitter = emitterSet.getElement(id);
+			if (!emitter.pool)
+			{
+				ASSERT(emitter.capacity > 0, "Particle emitter {} has no capacity", id);
+				emitter.pool = std::make_unique<Visual::ParticlePool>(std::max(emitter.capacity, 0), m_seed + (uint32_t)id);
+			}
+
+			const Components::Transform& transform = transformSet.getElement(id);
+			m_jobs.push_back({ &emitter, parentSet.isPresent(id) ? transform.worldPosition : transform.position });
+		}
+
+		JobsManager& jobsManager = gameController.getJobsManager();
+
+		auto updateStart = std::chrono::high_resolution_clock::now();
+		jobsManager.parallelFor(m_jobs.size(), m_batchSize, [this, dt](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					updateEmitter(m_jobs[i], dt);
+				}
+			});
+		auto updateEnd = std::chrono::high_resolution_clock::now();
+
+		if (m_renderParticles)
+		{
+			jobsManager.parallelFor(m_jobs.size(), m_batchSize, [this](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; i++)
+					{
+						Components::ParticleEmitter& emitter = *m_jobs[i].emitter;
+						emitter.instances.resize(emitter.pool->size());
+						emitter.pool->writeInstances(emitter.instances.data(), emitter.size, emitter.color, emitter.alpha);
+					}
+				});
+		}
+		auto packEnd = std::chrono::high_resolution_clock::now();
+
+		size_t particlesCount = 0;
+		for (const EmitterJob& job : m_jobs)
+		{
+			particlesCount += job.emitter->pool->size();
+		}
+
+		m_framesCount++;
+		m_particlesSum += (double)particlesCount;
+		m_maxParticles = std::max(m_maxParticles, particlesCount);
+		m_updateTime += std::chrono::duration<double>(updateEnd - updateStart).count();
+		m_packTime += std::chrono::duration<double>(packEnd - updateEnd).count();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void ParticleSystem::onStop()
+	{
+		writeResults();
+
+		auto& compManager = GameController::get().getComponentsManager();
+		auto& emitterSet = compManager.getComponentSet<Components::ParticleEmitter>();
+		for (EntityID id : compManager.entitiesWithComponents<Components::ParticleEmitter>())
+		{
+			Components::ParticleEmitter& emitter = emitterSet.getElement(id);
+			emitter.pool = nullptr;
+			emitter.instances.clear();
+		}
+		m_jobs.clear();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int ParticleSystem::getPriority() const
+	{
+		return 8;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void ParticleSystem::updateEmitter(const EmitterJob& job, float dt) const
+	{
+		Components::ParticleEmitter& emitter = *job.emitter;
+
+		// Dead particles are removed before emitting, so a full pool frees its slots in the same frame
+		emitter.pool->update(dt, emitter.gravity, emitter.drag);
+
+		emitter.emissionAccumulator += emitter.emissionRate * dt;
+		float emitCount = std::floor(emitter.emissionAccumulator);
+		emitter.emissionAccumulator -= emitCount;
+		emitter.pool->emit((size_t)emitCount, job.origin, emitter.velocity, emitter.velocitySpread, emitter.lifetime, emitter.lifetimeVariance);
+
+		if (!m_renderParticles)
+		{
+			emitter.instances.clear();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void ParticleSystem::writeResults() const
+	{
+		if (m_outputFile.empty() || m_framesCount == 0)
+		{
+			return;
+		}
+
+		std::ofstream outFile(GameController::get().getConfigRelativePath(m_outputFile));
+		if (!outFile.is_open())
+		{
+			return;
+		}
+
+		double frames = (double)m_framesCount;
+		double averageParticles = m_particlesSum / frames;
+
+		outFile << "Emitters count: " << m_jobs.size() << std::endl;
+		outFile << "Render particles: " << m_renderParticles << std::endl;
+		outFile << "Frames: " << m_framesCount << std::endl;
+		outFile << "Average particles: " << averageParticles << std::endl;
+		outFile << "Max particles: " << m_maxParticles << std::endl;
+		outFile << "Average update time (ms): " << m_updateTime * 1000.0 / frames << std::endl;
+		outFile << "Update time per particle (ns): " << (averageParticles > 0.0 ? m_updateTime * 1e9 / m_particlesSum : 0.0) << std::endl;
+		outFile << "Average pack time (ms): " << m_packTime * 1000.0 / frames << std::endl;
+
+		// Upload and draw submission, measured by the renderer around its particle pass
+		const RenderingSystem* renderingSystem = GameController::get().getSystemsManager().getSystem<RenderingSystem>();
+		if (renderingSystem && renderingSystem->getRenderer())
+		{
+			const Visual::ParticleStats& particleStats = renderingSystem->getRenderer()->getParticleStats();
+			double renderedFrames = (double)std::max<size_t>(particleStats.renderedFrames, 1);
+			outFile << "Average render time (ms): " << particleStats.renderTime * 1000.0 / renderedFrames << std::endl;
+			outFile << "Render time per particle (ns): " << (particleStats.renderedParticles > 0 ? particleStats.renderTime * 1e9 / (double)particleStats.renderedParticles : 0.0) << std::endl;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
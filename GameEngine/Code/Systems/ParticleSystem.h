@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ISystem.h"
+#include "Components/ParticleEmitter.h"
+
+namespace Engine::Systems
+{
+	// Emits, simulates and packs the particles of every ParticleEmitter, one emitter per job.
+	// Simulation and packing are timed separately, drawing is measured by the renderer.
+	class ParticleSystem: public ISystem
+	{
+	public:
+		void onStart() override;
+		void onUpdate(float dt) override;
+		void onStop() override;
+		int getPriority() const override;
+
+	private:
+		struct EmitterJob
+		{
+			Components::ParticleEmitter* emitter;
+			Utils::Vector3 origin;
+		};
+
+	private:
+		void updateEmitter(const EmitterJob& job, float dt) const;
+		void writeResults() const;
+
+	private:
+		static constexpr size_t k_defaultBatchSize = 1;
+
+		size_t m_batchSize = k_defaultBatchSize;
+		bool m_renderParticles = true; // Without it only the simulation runs
+		uint32_t m_seed = 0;
+		std::string m_outputFile;
+
+		std::vector<EmitterJob> m_jobs;
+
+		size_t m_framesCount = 0;
+		double m_particlesSum = 0.0;
+		size_t m_maxParticles = 0;
+		double m_updateTime = 0.0; // Seconds
+		double m_packTime = 0.0;
+	};
+}
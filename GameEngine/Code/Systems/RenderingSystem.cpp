@@ -1,8 +1,16 @@
 #include "RenderingSystem.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "Components/Transform.h"
 #include "Components/Tag.h"
 #include "Components/Model.h"
+#include "Components/Parent.h"
+#include "Components/Animator.h"
+#include "Components/ParticleEmitter.h"
+#include "Components/Camera.h"
+#include "Systems/CameraSystem.h"
 #include "Utils/BasicUtils.h"
 #include "Utils/DebugMacros.h"
 #include "Managers/GameController.h"
@@ -11,6 +19,56 @@ REGISTER_SYSTEM(Engine::Systems::RenderingSystem);
 
 namespace Engine::Systems
 {
+	namespace
+	{
+		bool isSameMatrix(const Utils::Matrix4& left, const Utils::Matrix4& right)
+		{
+			for (int row = 0; row < 4; row++)
+			{
+				for (int column = 0; column < 4; column++)
+				{
+					if (left.m[row][column] != right.m[row][column])
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		bool isSameSphere(const Utils::Sphere& left, const Utils::Sphere& right)
+		{
+			return left.center.x == right.center.x && left.center.y == right.center.y && left.center.z == right.center.z && left.radius == right.radius;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Centered on the box of the centers, padded so rounding can't leave a sphere of the run sticking out
+		Utils::Sphere getBounds(const Utils::SphereBatch& spheres, size_t first, size_t last)
+		{
+			constexpr float k_padding = 1e-4f;
+
+			Utils::Vector3 min(spheres.centerX[first], spheres.centerY[first], spheres.centerZ[first]);
+			Utils::Vector3 max = min;
+			for (size_t i = first + 1; i < last; i++)
+			{
+				min = Utils::Vector3(std::min(min.x, spheres.centerX[i]), std::min(min.y, spheres.centerY[i]), std::min(min.z, spheres.centerZ[i]));
+				max = Utils::Vector3(std::max(max.x, spheres.centerX[i]), std::max(max.y, spheres.centerY[i]), std::max(max.z, spheres.centerZ[i]));
+			}
+
+			Utils::Vector3 center = (min + max) * 0.5f;
+			float radius = 0.0f;
+			for (size_t i = first; i < last; i++)
+			{
+				Utils::Vector3 offset(spheres.centerX[i] - center.x, spheres.centerY[i] - center.y, spheres.centerZ[i] - center.z);
+				radius = std::max(radius, offset.length() + spheres.radius[i]);
+			}
+			return Utils::Sphere(center, radius * (1.0f + k_padding) + k_padding);
+		}
+	}
+
 	//////////////////////////////////////////////////////////////////////////
 
 	RenderingSystem::RenderingSystem(): m_window(GameController::get().getWindow())
@@ -36,6 +94,21 @@ namespace Engine::Systems
 			{
 				m_renderer = std::make_unique<Visual::OpenGLRenderer>();
 			}
+			else if (renderer == "Software")
+			{
+				auto softwareRenderer = std::make_unique<Visual::SoftwareRenderer>();
+				if (m_config.contains("overdrawAnalysis"))
+				{
+					Visual::OverdrawAnalysis analysis;
+					Utils::Parser::fillFromJson(analysis, m_config["overdrawAnalysis"]);
+					if (!analysis.outputDirectory.empty())
+					{
+						analysis.outputDirectory = GameController::get().getConfigRelativePath(analysis.outputDirectory);
+					}
+					softwareRenderer->setOverdrawAnalysis(analysis);
+				}
+				m_renderer = std::move(softwareRenderer);
+			}
 		}
 
 		if (!m_renderer)
@@ -43,37 +116,70 @@ namespace Engine::Systems
 			m_renderer = std::make_unique<Visual::DirectXRenderer>();
 		}
 
-		m_renderer->init(m_window);
+		if (m_config.contains("sortFrontToBack"))
+		{
+			m_sortFrontToBack = m_config["sortFrontToBack"];
+		}
+
+		if (m_config.contains("frustumCulling"))
+		{
+			m_frustumCulling = m_config["frustumCulling"];
+		}
+
+		if (m_config.contains("visibilityCache"))
+		{
+			m_visibilityCache = m_config["visibilityCache"];
+		}
+
+		if (m_config.contains("cullRunSize"))
+		{
+			m_cullRunSize = m_config["cullRunSize"].get<size_t>();
+		}
 
 		auto& gameController = GameController::get();
+		m_renderer->setFramePacing(gameController.getFramePacing());
+		m_renderer->setDepthPrePass(m_config.contains("depthPrePass") && m_config["depthPrePass"]);
+		Visual::TextureStreaming textureStreaming;
+		if (m_config.contains("textureStreaming"))
+		{
+			Utils::Parser::fillFromJson(textureStreaming, m_config["textureStreaming"]);
+		}
+		m_renderer->setTextureStreaming(textureStreaming, gameController.getJobsManager());
+		m_renderer->init(m_window);
+
+		// Only the options are captured for the parse, the renderer is touched by the upload on the frame loop thread
+		gameController.getCoroutinesManager().setModelLoader([this, options = m_renderer->getModelSourceOptions()](const std::string& path)
+			{
+				auto source = std::make_shared<Visual::ModelSource>();
+				bool parsed = source->load(path, options);
+				return CoroutinesManager::ModelUpload([this, source, parsed, path]()
+					{
+						return parsed && m_renderer->loadModel(path, *source);
+					});
+			});
+
+		// Older configs do not list CameraSystem, the frame cannot be drawn without it
+		if (!gameController.getSystemsManager().getSystem<CameraSystem>())
+		{
+			gameController.getSystemsManager().addSystem(std::make_unique<CameraSystem>());
+		}
+
 		auto& compManager = gameController.getComponentsManager();
 		auto& modelSet = compManager.getComponentSet<Components::Model>();
-		auto& tagSet = compManager.getComponentSet<Components::Tag>();
-		auto& transformSet = compManager.getComponentSet<Components::Transform>();
 
 		for (EntityID id : compManager.entitiesWithComponents<Components::Model, Components::Transform>())
 		{
 			Components::Model& model = modelSet.getElement(id);
 
-			bool loadResult = m_renderer->loadModel(gameController.getConfigRelativePath(model.path));
-			ASSERT(loadResult, "Failed to load model: {}", gameController.getConfigRelativePath(model.path));
+			bool loadResult = m_renderer->loadModel(gameController.getAssetPath(model.path));
+			ASSERT(loadResult, "Failed to load model: {}", gameController.getAssetPath(model.path));
 			if (!loadResult)
 			{
 				continue;
 			}
 
-			model.instance = m_renderer->createModelInstance(gameController.getConfigRelativePath(model.path));
-		}
-
-
-		for (EntityID id : compManager.entitiesWithComponents<Components::Tag>())
-		{
-			if (tagSet.getElement(id).tag == "MainCamera")
-			{
-				m_cameraId = id;
-			}
+			model.instance = m_renderer->createModelInstance(gameController.getAssetPath(model.path));
 		}
-
 	}
 
 	//////////////////////////////////////////////////////////////////////////
@@ -82,11 +188,25 @@ namespace Engine::Systems
 	{
 		auto& gameController = GameController::get();
 		auto& compManager = gameController.getComponentsManager();
-		const auto& cameraTransform = compManager.getComponentSet<Components::Transform>().getElement(m_cameraId);
-		m_renderer->setCameraProperties(cameraTransform.position, cameraTransform.rotation);
+		const CameraSystem* cameraSystem = gameController.getSystemsManager().getSystem<CameraSystem>();
+		EntityID cameraId = cameraSystem ? cameraSystem->getMainCamera() : -1;
+		ASSERT(cameraId >= 0, "No active camera to render with");
+		if (cameraId < 0)
+		{
+			return;
+		}
+
+		const Components::Camera& camera = compManager.getComponentSet<Components::Camera>().getElement(cameraId);
+		m_renderer->setCamera(camera.view, camera.projection);
+		if (m_frustumCulling && m_visibilityCache)
+		{
+			updateVisibilityCamera(cameraId, camera);
+		}
 
 		auto& modelSet = compManager.getComponentSet<Components::Model>();
 		const auto& transformSet = compManager.getComponentSet<Components::Transform>();
+		const auto& parentSet = compManager.getComponentSet<Components::Parent>();
+		const auto& animatorSet = compManager.getComponentSet<Components::Animator>();
 
 		m_renderer->clearBackground(0.0f, 0.2f, 0.4f, 1.0f);
 		for (EntityID id : compManager.entitiesWithComponents<Components::Model, Components::Transform>())
@@ -95,26 +215,95 @@ namespace Engine::Systems
 			Components::Model& model = modelSet.getElement(id);
 			if (model.markedForDestroy)
 			{
-				m_renderer->destroyModelInstance(*model.instance);
+				if (model.instance)
+				{
+					m_renderer->destroyModelInstance(*model.instance);
+				}
 				modelSet.removeElement(id);
+				m_cachedVisibility.removeElement(id);
 				continue;
 			}
 			
 			if (!model.instance)
 			{
-				bool loadResult = m_renderer->loadModel(gameController.getConfigRelativePath(model.path));
-				ASSERT(loadResult, "Failed to load model: {}", gameController.getConfigRelativePath(model.path));
-				if (!loadResult)
+				// Models added at runtime are loaded in the background and drawn once ready
+				if (!m_pendingModels.contains(id))
 				{
-					continue;
+					gameController.getCoroutinesManager().start(createModelInstance(id, model.path));
+				}
+				continue;
+			}
+
+			if (animatorSet.isPresent(id))
+			{
+				const Components::Animator& animator = animatorSet.getElement(id);
+				if (!animator.vertices.empty())
+				{
+					m_renderer->updateInstanceVertices(*model.instance, animator.vertices.data(), animator.vertices.size());
 				}
-				model.instance = m_renderer->createModelInstance(gameController.getConfigRelativePath(model.path));
 			}
 
 			const Components::Transform& transform = transformSet.getElement(id);
-			m_renderer->draw(*model.instance, transform.position, transform.rotation, transform.scale);
+			if (parentSet.isPresent(id))
+			{
+				m_drawItems.push_back({ model.instance.get(), transform.worldPosition, transform.worldRotation, transform.worldScale, 0.0f });
+			}
+			else
+			{
+				m_drawItems.push_back({ model.instance.get(), transform.position, transform.rotation, transform.scale, 0.0f });
+			}
+
+			if (m_frustumCulling && model.boundingRadius > 0.0f)
+			{
+				const DrawItem& item = m_drawItems.back();
+				float maxScale = std::max({ std::abs(item.scale.x), std::abs(item.scale.y), std::abs(item.scale.z) });
+				Utils::Sphere sphere(item.position, model.boundingRadius * maxScale);
+
+				bool visible;
+				if (m_visibilityCache && getCachedVisibility(id, sphere, visible))
+				{
+					m_cullingStats.cached++;
+					m_cullingStats.visible += visible;
+					if (!visible)
+					{
+						m_drawItems.pop_back();
+					}
+				}
+				else
+				{
+					m_culledItems.push_back(m_drawItems.size() - 1);
+					m_cullSpheres.add(sphere);
+					if (m_visibilityCache)
+					{
+						m_culledIds.push_back(id);
+					}
+				}
+			}
+		}
+
+		if (m_frustumCulling)
+		{
+			m_cullingStats.frames++;
+			cullItems(camera.frustum);
+		}
+		drawItems(camera.position);
+
+		const auto& emitterSet = compManager.getComponentSet<Components::ParticleEmitter>();
+		for (EntityID id : compManager.entitiesWithComponents<Components::ParticleEmitter>())
+		{
+			const Components::ParticleEmitter& emitter = emitterSet.getElement(id);
+			if (!emitter.instances.empty())
+			{
+				m_renderer->drawParticles(emitter.instances.data(), emitter.instances.size());
+			}
 		}
 		m_renderer->render();
+
+		// Blocking here instead of at the next present keeps input to display latency at one frame
+		if (gameController.getFramePacing().waitableSwapchain)
+		{
+			m_renderer->waitForNextFrame();
+		}
 	}
 
 	//////////////////////////////////////////////////////////////////////////
@@ -128,10 +317,14 @@ namespace Engine::Systems
 		for (EntityID id : compManager.entitiesWithComponents<Components::Model, Components::Transform>())
 		{
 			Components::Model& model = modelSet.getElement(id);
-			m_renderer->destroyModelInstance(*model.instance);
-			model.instance = nullptr;
+			if (model.instance)
+			{
+				m_renderer->destroyModelInstance(*model.instance);
+				model.instance = nullptr;
+			}
 		}
 
+		GameController::get().getCoroutinesManager().setModelLoader(nullptr);
 		m_renderer->cleanUp();
 	}
 
@@ -143,5 +336,250 @@ namespace Engine::Systems
 	}
 
 	//////////////////////////////////////////////////////////////////////////
+
+	const Visual::IRenderer* RenderingSystem::getRenderer() const
+	{
+		return m_renderer.get();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const RenderingSystem::CullingStats& RenderingSystem::getCullingStats() const
+	{
+		return m_cullingStats;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void RenderingSystem::cullItems(const Utils::Frustum& frustum)
+	{
+		if (m_culledItems.empty())
+		{
+			return;
+		}
+
+		if (m_cullRunSize > 1)
+		{
+			cullRuns(frustum);
+		}
+		else
+		{
+			m_cullingStats.visible += Utils::frustumCullSpheres(frustum, m_cullSpheres, m_visible);
+			m_cullingStats.tested += m_cullSpheres.size();
+		}
+
+		if (m_visibilityCache)
+		{
+			cacheVisibility(frustum);
+		}
+
+		// Items without bounds stay, the hidden ones are removed keeping the order of the others
+		size_t culled = 0;
+		size_t kept = 0;
+		for (size_t i = 0; i < m_drawItems.size(); i++)
+		{
+			if (culled < m_culledItems.size() && m_culledItems[culled] == i)
+			{
+				if (!m_visible[culled++])
+				{
+					continue;
+				}
+			}
+			m_drawItems[kept++] = m_drawItems[i];
+		}
+		m_drawItems.resize(kept);
+
+		m_culledItems.clear();
+		m_cullSpheres.clear();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void RenderingSystem::cullRuns(const Utils::Frustum& frustum)
+	{
+		size_t count = m_cullSpheres.size();
+		m_visible.resize(count);
+		m_partialSpheres.clear();
+		m_partialItems.clear();
+		for (size_t first = 0; first < count; first += m_cullRunSize)
+		{
+			size_t last = std::min(first + m_cullRunSize, count);
+			Utils::Sphere bounds = getBounds(m_cullSpheres, first, last);
+			m_cullingStats.runs++;
+
+			bool outside = !frustum.intersects(bounds);
+			if (outside || frustum.contains(bounds))
+			{
+				std::fill(m_visible.begin() + first, m_visible.begin() + last, outside ? 0 : 1);
+				m_cullingStats.skipped += last - first;
+				m_cullingStats.visible += outside ? 0 : last - first;
+				continue;
+			}
+
+			for (size_t i = first; i < last; i++)
+			{
+				m_partialSpheres.add(Utils::Sphere(Utils::Vector3(m_cullSpheres.centerX[i], m_cullSpheres.centerY[i], m_cullSpheres.centerZ[i]), m_cullSpheres.radius[i]));
+				m_partialItems.push_back(i);
+			}
+		}
+
+		m_cullingStats.visible += Utils::frustumCullSpheres(frustum, m_partialSpheres, m_partialVisible);
+		m_cullingStats.tested += m_partialSpheres.size();
+		for (size_t i = 0; i < m_partialItems.size(); i++)
+		{
+			m_visible[m_partialItems[i]] = m_partialVisible[i];
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void RenderingSystem::updateVisibilityCamera(EntityID cameraId, const Components::Camera& camera)
+	{
+		if (cameraId == m_cacheCameraId && camera.version == m_cacheCameraVersion)
+		{
+			return;
+		}
+
+		Utils::Vector3 axes[3] = { camera.right, camera.up, camera.forward };
+		if (cameraId != m_cacheCameraId || !isSameMatrix(camera.projection, m_cacheProjection))
+		{
+			// The frustum changed shape, the margins don't hold anymore
+			m_cachedVisibility.clear();
+			m_cacheCameraId = cameraId;
+			m_cacheProjection = camera.projection;
+			m_cameraTranslation = 0.0;
+			m_cameraRotation = 0.0;
+		}
+		else
+		{
+			// Frobenius norm of the rotation change, bounds how far it moves a point at unit distance
+			float rotationSqr = 0.0f;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				rotationSqr += (axes[axis] - m_cameraAxes[axis]).lengthSqr();
+			}
+			m_cameraTranslation += (camera.position - m_cameraPosition).length();
+			m_cameraRotation += std::sqrt(rotationSqr);
+		}
+
+		m_cacheCameraVersion = camera.version;
+		m_cameraPosition = camera.position;
+		std::copy(std::begin(axes), std::end(axes), std::begin(m_cameraAxes));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool RenderingSystem::getCachedVisibility(EntityID id, const Utils::Sphere& sphere, bool& visible) const
+	{
+		if (!m_cachedVisibility.isPresent(id))
+		{
+			return false;
+		}
+
+		const CachedVisibility& cached = m_cachedVisibility.getElement(id);
+		if (!isSameSphere(cached.sphere, sphere))
+		{
+			return false;
+		}
+
+		// The planes are fixed in view space, so relative to the sphere they moved at most by the camera translation,
+		// plus the rotation times the distance to the camera, which itself grew at most by the translation
+		double translation = m_cameraTranslation - cached.cameraTranslation;
+		double rotation = m_cameraRotation - cached.cameraRotation;
+		double distance = cached.distance + translation;
+		double motion = (rotation + k_visibilityTolerance) * distance + translation;
+		if (motion >= std::abs(cached.margin))
+		{
+			return false;
+		}
+
+		visible = cached.margin >= 0.0f;
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void RenderingSystem::cacheVisibility(const Utils::Frustum& frustum)
+	{
+		for (size_t i = 0; i < m_culledIds.size(); i++)
+		{
+			CachedVisibility cached;
+			cached.sphere = Utils::Sphere(Utils::Vector3(m_cullSpheres.centerX[i], m_cullSpheres.centerY[i], m_cullSpheres.centerZ[i]), m_cullSpheres.radius[i]);
+			cached.margin = frustum.getMargin(cached.sphere);
+			cached.distance = (cached.sphere.center - m_cameraPosition).length();
+			cached.cameraTranslation = m_cameraTranslation;
+			cached.cameraRotation = m_cameraRotation;
+
+			// Spheres on a plane can round differently in the SIMD test, they are tested again every frame
+			if ((cached.margin >= 0.0f) != (m_visible[i] != 0))
+			{
+				cached.margin = 0.0f;
+			}
+
+			EntityID id = m_culledIds[i];
+			if (m_cachedVisibility.isPresent(id))
+			{
+				m_cachedVisibility.getElement(id) = cached;
+			}
+			else
+			{
+				m_cachedVisibility.addElement(id, std::move(cached));
+			}
+		}
+		m_culledIds.clear();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void RenderingSystem::drawItems(const Utils::Vector3& cameraPosition)
+	{
+		// Nearer opaque objects go first so the depth test rejects the hidden fragments behind them
+		if (m_sortFrontToBack)
+		{
+			for (DrawItem& item : m_drawItems)
+			{
+				item.distanceSqr = (item.position - cameraPosition).lengthSqr();
+			}
+			std::sort(m_drawItems.begin(), m_drawItems.end(), [](const DrawItem& left, const DrawItem& right)
+				{
+					return left.distanceSqr < right.distanceSqr;
+				});
+		}
+
+		for (const DrawItem& item : m_drawItems)
+		{
+			m_renderer->draw(*item.instance, item.position, item.rotation, item.scale);
+		}
+		m_drawItems.clear();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Utils::Task RenderingSystem::createModelInstance(EntityID id, std::string path)
+	{
+		GameController& gameController = GameController::get();
+		std::string fullPath = gameController.getAssetPath(path);
+
+		m_pendingModels.insert(id);
+		bool loadResult = co_await loadModel(fullPath);
+		m_pendingModels.erase(id);
+
+		ASSERT(loadResult, "Failed to load model: {}", fullPath);
+		if (!loadResult)
+		{
+			co_return;
+		}
+
+		// The entity could have been destroyed or changed its model while loading
+		auto& modelSet = gameController.getComponentsManager().getComponentSet<Components::Model>();
+		if (!modelSet.isPresent(id) || modelSet.getElement(id).path != path || modelSet.getElement(id).instance)
+		{
+			co_return;
+		}
+
+		modelSet.getElement(id).instance = m_renderer->createModelInstance(fullPath);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
 	
 }
\ No newline at end of file
@@ -1,13 +1,20 @@
 #pragma once
 
+#include <unordered_set>
+
 #include "ISystem.h"
 #include "Visual/DirectXRenderer.h"
 #include "Visual/OpenGLRenderer.h"
 #include "Visual/VulkanRenderer.h"
+#include "Visual/SoftwareRenderer.h"
 
 #include "Visual/Window.h"
 #include "Components/Transform.h"
+#include "Components/Camera.h"
 #include "Managers/EntitiesManager.h"
+#include "Utils/Task.h"
+#include "Utils/Geometry.h"
+#include "Utils/SparseSet.h"
 
 namespace Engine::Systems
 {
@@ -19,10 +26,81 @@ namespace Engine::Systems
 		void onUpdate(float dt) override;
 		void onStop() override;
 		int getPriority() const override;
+
+		// Totals since start, tested went through the frustum test and cached reused the result of an earlier frame.
+		// With cullRunSize, skipped items were decided by the test of their run alone
+		struct CullingStats
+		{
+			size_t frames = 0;
+			size_t tested = 0;
+			size_t cached = 0;
+			size_t visible = 0;
+			size_t runs = 0;
+			size_t skipped = 0;
+		};
+
+		const Visual::IRenderer* getRenderer() const;
+		const CullingStats& getCullingStats() const;
+	private:
+		struct DrawItem
+		{
+			const Visual::IModelInstance* instance;
+			Utils::Vector3 position;
+			Utils::Vector3 rotation;
+			Utils::Vector3 scale;
+			float distanceSqr;
+		};
+
+		// Culling result of an entity, kept while its bounds don't change and the camera moves less than margin relative to them
+		struct CachedVisibility
+		{
+			Utils::Sphere sphere;
+			float margin = 0.0f; // Frustum::getMargin when tested
+			float distance = 0.0f; // From the camera when tested
+			double cameraTranslation = 0.0; // Camera motion accumulated when tested
+			double cameraRotation = 0.0;
+		};
+
+		Utils::Task createModelInstance(EntityID id, std::string path);
+		void cullItems(const Utils::Frustum& frustum);
+		void cullRuns(const Utils::Frustum& frustum);
+		void updateVisibilityCamera(EntityID cameraId, const Components::Camera& camera);
+		bool getCachedVisibility(EntityID id, const Utils::Sphere& sphere, bool& visible) const;
+		void cacheVisibility(const Utils::Frustum& frustum);
+		void drawItems(const Utils::Vector3& cameraPosition);
+
 	private:
 		const Visual::Window& m_window;
 		std::unique_ptr<Visual::IRenderer> m_renderer;
+		std::unordered_set<EntityID> m_pendingModels;
+		std::vector<DrawItem> m_drawItems;
+		bool m_sortFrontToBack = false;
+
+		// Bounds of the culled draw items, in the same order
+		bool m_frustumCulling = false;
+		std::vector<size_t> m_culledItems; // Index in m_drawItems of the items with bounds
+		Utils::SphereBatch m_cullSpheres;
+		std::vector<uint8_t> m_visible;
+		CullingStats m_cullingStats;
+
+		// Items come in the order of the pools, SpatialSortSystem puts neighbours next to each other so a run
+		// of them is often entirely in or out of the frustum and decided by a single test
+		size_t m_cullRunSize = 0; // 0 tests every item on its own
+		Utils::SphereBatch m_partialSpheres; // Items of the runs crossing a plane
+		std::vector<size_t> m_partialItems; // Index in m_cullSpheres of each partial sphere
+		std::vector<uint8_t> m_partialVisible;
 
-		EntityID m_cameraId = -1;
+		// Visibility cache, the items left to cull are those whose result could have changed
+		static constexpr double k_visibilityTolerance = 1e-4; // Per unit of distance to the camera, covers the rounding of the planes
+		bool m_visibilityCache = false;
+		Utils::SparseSet<CachedVisibility, EntityID> m_cachedVisibility;
+		std::vector<EntityID> m_culledIds; // Entity of each culled item
+		EntityID m_cacheCameraId = -1;
+		uint32_t m_cacheCameraVersion = 0;
+		Utils::Matrix4 m_cacheProjection;
+		Utils::Vector3 m_cameraPosition;
+		Utils::Vector3 m_cameraAxes[3]; // Right, up and forward, the rows of the view rotation
+		double m_cameraTranslation = 0.0; // Path length of the camera since the cache was cleared
+		double m_cameraRotation = 0.0; // Sum of the norms of the view rotation changes since the cache was cleared
 	};
 }
\ No newline at end of file
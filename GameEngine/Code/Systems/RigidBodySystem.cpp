@@ -0,0 +1,390 @@
+#include "RigidBodySystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+
+#include "Managers/GameController.h"
+#include "Components/Collider.h"
+#include "Components/RigidBody.h"
+#include "Components/Transform.h"
+#include "Components/Parent.h"
+#include "Systems/BroadphaseSystem.h"
+#include "Utils/DebugMacros.h"
+
+REGISTER_SYSTEM(Engine::Systems::RigidBodySystem);
+
+namespace Engine::Systems
+{
+	namespace
+	{
+		//////////////////////////////////////////////////////////////////////////
+
+		// Diagonal of the inverse inertia tensor in the local space of the shape
+		Utils::Vector3 getLocalInverseInertia(const Physics::CollisionShape& shape, float mass)
+		{
+			if (shape.type == Physics::CollisionShape::Type::Sphere)
+			{
+				float inertia = 0.4f * mass * shape.radius * shape.radius;
+				return Utils::Vector3(inertia > 0.0f ? 1.0f / inertia : 0.0f);
+			}
+
+			Utils::Vector3 size = shape.halfExtents * shape.halfExtents;
+			Utils::Vector3 inertia = Utils::Vector3(size.y + size.z, size.x + size.z, size.x + size.y) * (mass / 3.0f);
+			return Utils::Vector3(
+				inertia.x > 0.0f ? 1.0f / inertia.x : 0.0f,
+				inertia.y > 0.0f ? 1.0f / inertia.y : 0.0f,
+				inertia.z > 0.0f ? 1.0f / inertia.z : 0.0f);
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// R * diag(local) * R^T, the columns of R are the axes of the shape
+		void setWorldInverseInertia(Physics::SolverBody& body, const Physics::CollisionShape& shape, const Utils::Vector3& local)
+		{
+			const Utils::Vector3* axes = shape.axes;
+			Utils::Vector3 scaled[3] = { axes[0] * local.x, axes[1] * local.y, axes[2] * local.z };
+			body.inverseInertia[0] = scaled[0] * axes[0].x + scaled[1] * axes[1].x + scaled[2] * axes[2].x;
+			body.inverseInertia[1] = scaled[0] * axes[0].y + scaled[1] * axes[1].y + scaled[2] * axes[2].y;
+			body.inverseInertia[2] = scaled[0] * axes[0].z + scaled[1] * axes[1].z + scaled[2] * axes[2].z;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void RigidBodySystem::onStart()
+	{
+		if (m_config.contains("gravity"))
+		{
+			Utils::Parser::fillFromJson(m_gravity, m_config["gravity"]);
+		}
+
+		if (m_config.contains("maxTimeStep"))
+		{
+			m_maxTimeStep = m_config["maxTimeStep"].get<float>();
+		}
+
+		if (m_config.contains("iterations"))
+		{
+			m_settings.iterations = m_config["iterations"].get<int>();
+		}
+
+		if (m_config.contains("baumgarte"))
+		{
+			m_settings.baumgarte = m_config["baumgarte"].get<float>();
+		}
+
+		if (m_config.contains("slop"))
+		{
+			m_settings.slop = m_config["slop"].get<float>();
+		}
+
+		if (m_config.contains("restitutionThreshold"))
+		{
+			m_settings.restitutionThreshold = m_config["restitutionThreshold"].get<float>();
+		}
+
+		if (m_config.contains("batchSize"))
+		{
+			m_batchSize = m_config["batchSize"].get<size_t>();
+		}
+
+		if (m_config.contains("pairsBatchSize"))
+		{
+			m_pairsBatchSize = m_config["pairsBatchSize"].get<size_t>();
+		}
+
+		if (m_config.contains("outputFile"))
+		{
+			m_outputFile = m_config["outputFile"].get<std::string>();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void RigidBodySystem::onUpdate(float dt)
+	{
+		float step = std::min(dt, m_maxTimeStep);
+		if (step <= 0.0f)
+		{
+			return;
+		}
+
+		auto bodiesStart = std::chrono::high_resolution_clock::now();
+		buildBodies(step);
+		auto contactsStart = std::chrono::high_resolution_clock::now();
+		generateContacts();
+		auto solveStart = std::chrono::high_resolution_clock::now();
+		m_solver.solve(m_bodies, m_contacts, m_settings, step, GameController::get().getJobsManager(), m_batchSize);
+		auto integrateStart = std::chrono::high_resolution_clock::now();
+		integrate(step);
+		auto integrateEnd = std::chrono::high_resolution_clock::now();
+
+		size_t dynamicCount = (size_t)std::count(m_dynamic.begin(), m_dynamic.end(), uint8_t(1));
+
+		m_framesCount++;
+		m_bodiesSum += (double)dynamicCount;
+		m_contactsSum += (double)m_contacts.size();
+		m_islandsSum += (double)m_solver.getIslandsCount();
+		m_largestIsland = std::max(m_largestIsland, m_solver.getLargestIslandContacts());
+		m_laneOccupancySum += m_solver.getLaneOccupancy();
+		m_bodiesTime += std::chrono::duration<double>(contactsStart - bodiesStart).count();
+		m_contactsTime += std::chrono::duration<double>(solveStart - contactsStart).count();
+		m_solveTime += std::chrono::duration<double>(integrateStart - solveStart).count();
+		m_integrateTime += std::chrono::duration<double>(integrateEnd - integrateStart).count();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void RigidBodySystem::onStop()
+	{
+		writeResults();
+		m_shapes.clear();
+		m_bodies.clear();
+		m_orientations.clear();
+		m_dynamic.clear();
+		m_contacts.clear();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int RigidBodySystem::getPriority() const
+	{
+		return 7;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void RigidBodySystem::buildBodies(float dt)
+	{
+		GameController& gameController = GameController::get();
+		ComponentsManager& compManager = gameController.getComponentsManager();
+		const auto& colliderSet = compManager.getComponentSet<Components::Collider>();
+		const auto& rigidBodySet = compManager.getComponentSet<Components::RigidBody>();
+		const auto& transformSet = compManager.getComponentSet<Components::Transform>();
+		const auto& parentSet = compManager.getComponentSet<Components::Parent>();
+
+		auto masses = rigidBodySet.getColumn<&Components::RigidBody::mass>();
+		auto velocitiesX = rigidBodySet.getColumn<&Components::RigidBody::velocity, &Utils::Vector3::x>();
+		auto velocitiesY = rigidBodySet.getColumn<&Components::RigidBody::velocity, &Utils::Vector3::y>();
+		auto velocitiesZ = rigidBodySet.getColumn<&Components::RigidBody::velocity, &Utils::Vector3::z>();
+		auto angularVelocitiesX = rigidBodySet.getColumn<&Components::RigidBody::angularVelocity, &Utils::Vector3::x>();
+		auto angularVelocitiesY = rigidBodySet.getColumn<&Components::RigidBody::angularVelocity, &Utils::Vector3::y>();
+		auto angularVelocitiesZ = rigidBodySet.getColumn<&Components::RigidBody::angularVelocity, &Utils::Vector3::z>();
+		auto linearDampings = rigidBodySet.getColumn<&Components::RigidBody::linearDamping>();
+		auto angularDampings = rigidBodySet.getColumn<&Components::RigidBody::angularDamping>();
+		auto useGravities = rigidBodySet.getColumn<&Components::RigidBody::useGravity>();
+
+		const BroadphaseSystem* broadphase = gameController.getSystemsManager().getSystem<BroadphaseSystem>();
+		ASSERT(broadphase, "RigidBodySystem needs a BroadphaseSystem");
+		static const std::vector<EntityID> k_noEntities;
+		const std::vector<EntityID>& entities = broadphase ? broadphase->getEntities() : k_noEntities;
+
+		size_t count = entities.size();
+		m_shapes.resize(count);
+		m_bodies.resize(count);
+		m_orientations.resize(count);
+		m_dynamic.resize(count);
+
+		gameController.getJobsManager().parallelFor(count, m_pairsBatchSize, [&, this, dt](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					EntityID id = entities[i];
+					const Components::Collider& collider = colliderSet.getElement(id);
+					const Components::Transform& transform = transformSet.getElement(id);
+
+					bool hasParent = parentSet.isPresent(id);
+					const Utils::Vector3& position = hasParent ? transform.worldPosition : transform.position;
+					const Utils::Vector3& scale = hasParent ? transform.worldScale : transform.scale;
+					Utils::Quaternion orientation = Utils::Quaternion::fromEulerAngles(hasParent ? transform.worldRotation : transform.rotation);
+					m_orientations[i] = orientation;
+
+					Physics::CollisionShape& shape = m_shapes[i];
+					shape.center = position + orientation.rotate(collider.offset * scale);
+					if (collider.shape == "Box")
+					{
+						shape.type = Physics::CollisionShape::Type::Box;
+						shape.axes[0] = orientation.rotate(Utils::Vector3(1.0f, 0.0f, 0.0f));
+						shape.axes[1] = orientation.rotate(Utils::Vector3(0.0f, 1.0f, 0.0f));
+						shape.axes[2] = orientation.rotate(Utils::Vector3(0.0f, 0.0f, 1.0f));
+						shape.halfExtents = collider.halfExtents * Utils::Vector3(std::abs(scale.x), std::abs(scale.y), std::abs(scale.z));
+					}
+					else
+					{
+						shape.type = Physics::CollisionShape::Type::Sphere;
+						shape.radius = collider.radius * std::max({ std::abs(scale.x), std::abs(scale.y), std::abs(scale.z) });
+					}
+
+					Physics::SolverBody& body = m_bodies[i];
+					body = Physics::SolverBody{};
+					body.position = shape.center;
+					body.friction = collider.friction;
+					body.restitution = collider.restitution;
+
+					size_t index = rigidBodySet.isPresent(id) ? rigidBodySet.getIndex(id) : 0;
+					m_dynamic[i] = rigidBodySet.isPresent(id) && masses[index] > 0.0f && !hasParent;
+					if (!m_dynamic[i])
+					{
+						continue;
+					}
+
+					// Forces first, so the contacts see the velocity the bodies would move with
+					Utils::Vector3 velocity(velocitiesX[index], velocitiesY[index], velocitiesZ[index]);
+					if (useGravities[index])
+					{
+						velocity += m_gravity * dt;
+					}
+					Utils::Vector3 angularVelocity(angularVelocitiesX[index], angularVelocitiesY[index], angularVelocitiesZ[index]);
+					body.velocity = velocity * std::max(1.0f - linearDampings[index] * dt, 0.0f);
+					body.angularVelocity = angularVelocity * std::max(1.0f - angularDampings[index] * dt, 0.0f);
+					body.inverseMass = 1.0f / masses[index];
+					setWorldInverseInertia(body, shape, getLocalInverseInertia(shape, masses[index]));
+				}
+			});
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void RigidBodySystem::generateContacts()
+	{
+		m_contacts.clear();
+
+		const BroadphaseSystem* broadphase = GameController::get().getSystemsManager().getSystem<BroadphaseSystem>();
+		if (!broadphase)
+		{
+			return;
+		}
+
+		const std::vector<Physics::OverlapPair>& pairs = broadphase->getPairs();
+		size_t batchSize = std::max<size_t>(m_pairsBatchSize, 1);
+		m_batchContacts.resize((pairs.size() + batchSize - 1) / batchSize);
+		for (std::vector<Physics::Contact>& batch : m_batchContacts)
+		{
+			batch.clear();
+		}
+
+		GameController::get().getJobsManager().parallelFor(pairs.size(), batchSize, [this, &pairs, batchSize](size_t begin, size_t end)
+			{
+				std::vector<Physics::Contact>& contacts = m_batchContacts[begin / batchSize];
+				for (size_t i = begin; i < end; i++)
+				{
+					const Physics::OverlapPair& pair = pairs[i];
+					if (m_dynamic[pair.first] || m_dynamic[pair.second])
+					{
+						Physics::generateContacts(m_shapes[pair.first], m_shapes[pair.second], pair.first, pair.second, contacts);
+					}
+				}
+			});
+
+		// Joined in batch order, the solver result does not depend on scheduling
+		for (const std::vector<Physics::Contact>& batch : m_batchContacts)
+		{
+			m_contacts.insert(m_contacts.end(), batch.begin(), batch.end());
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void RigidBodySystem::integrate(float dt)
+	{
+		GameController& gameController = GameController::get();
+		ComponentsManager& compManager = gameController.getComponentsManager();
+		auto& rigidBodySet = compManager.getComponentSet<Components::RigidBody>();
+		auto& transformSet = compManager.getComponentSet<Components::Transform>();
+		const auto& colliderSet = compManager.getComponentSet<Components::Collider>();
+
+		auto velocitiesX = rigidBodySet.getColumn<&Components::RigidBody::velocity, &Utils::Vector3::x>();
+		auto velocitiesY = rigidBodySet.getColumn<&Components::RigidBody::velocity, &Utils::Vector3::y>();
+		auto velocitiesZ = rigidBodySet.getColumn<&Components::RigidBody::velocity, &Utils::Vector3::z>();
+		auto angularVelocitiesX = rigidBodySet.getColumn<&Components::RigidBody::angularVelocity, &Utils::Vector3::x>();
+		auto angularVelocitiesY = rigidBodySet.getColumn<&Components::RigidBody::angularVelocity, &Utils::Vector3::y>();
+		auto angularVelocitiesZ = rigidBodySet.getColumn<&Components::RigidBody::angularVelocity, &Utils::Vector3::z>();
+
+		const BroadphaseSystem* broadphase = gameController.getSystemsManager().getSystem<BroadphaseSystem>();
+		if (!broadphase)
+		{
+			return;
+		}
+		const std::vector<EntityID>& entities = broadphase->getEntities();
+
+		gameController.getJobsManager().parallelFor(entities.size(), m_pairsBatchSize, [&, this, dt](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					if (!m_dynamic[i])
+					{
+						continue;
+					}
+
+					EntityID id = entities[i];
+					const Physics::SolverBody& body = m_bodies[i];
+					size_t index = rigidBodySet.getIndex(id);
+					velocitiesX[index] = body.velocity.x;
+					velocitiesY[index] = body.velocity.y;
+					velocitiesZ[index] = body.velocity.z;
+					angularVelocitiesX[index] = body.angularVelocity.x;
+					angularVelocitiesY[index] = body.angularVelocity.y;
+					angularVelocitiesZ[index] = body.angularVelocity.z;
+
+					// q' = q + dt / 2 * w * q, renormalized
+					const Utils::Quaternion& orientation = m_orientations[i];
+					Utils::Quaternion spin = Utils::Quaternion(body.angularVelocity) * orientation;
+					float halfStep = 0.5f * dt;
+					Utils::Quaternion newOrientation(
+						orientation.real + spin.real * halfStep,
+						orientation.i + spin.i * halfStep,
+						orientation.j + spin.j * halfStep,
+						orientation.k + spin.k * halfStep);
+					float length = std::sqrt(newOrientation.real * newOrientation.real + newOrientation.i * newOrientation.i
+						+ newOrientation.j * newOrientation.j + newOrientation.k * newOrientation.k);
+					newOrientation = Utils::Quaternion(newOrientation.real / length, newOrientation.i / length, newOrientation.j / length, newOrientation.k / length);
+
+					// The body turns around its center of mass, the shape offset moves the entity origin with it
+					Components::Transform& transform = transformSet.getElement(id);
+					const Components::Collider& collider = colliderSet.getElement(id);
+					Utils::Vector3 center = body.position + body.velocity * dt;
+					transform.position = center - newOrientation.rotate(collider.offset * transform.scale);
+					transform.rotation = newOrientation.toEulerAngles();
+				}
+			});
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void RigidBodySystem::writeResults() const
+	{
+		if (m_outputFile.empty() || m_framesCount == 0)
+		{
+			return;
+		}
+
+		std::ofstream outFile(GameController::get().getConfigRelativePath(m_outputFile));
+		if (!outFile.is_open())
+		{
+			return;
+		}
+
+		double frames = (double)m_framesCount;
+		double totalTime = m_bodiesTime + m_contactsTime + m_solveTime + m_integrateTime;
+
+		outFile << "Workers: " << GameController::get().getJobsManager().getWorkersCount() << std::endl;
+		outFile << "SIMD: " << (Utils::getActiveSimdLevel() != Utils::SimdLevel::Scalar ? "SSE" : "Scalar") << std::endl;
+		outFile << "Iterations: " << m_settings.iterations << std::endl;
+		outFile << "Frames: " << m_framesCount << std::endl;
+		outFile << "Average dynamic bodies: " << m_bodiesSum / frames << std::endl;
+		outFile << "Average contacts: " << m_contactsSum / frames << std::endl;
+		outFile << "Average islands: " << m_islandsSum / frames << std::endl;
+		outFile << "Largest island (contacts): " << m_largestIsland << std::endl;
+		outFile << "Average SIMD lane occupancy: " << m_laneOccupancySum / frames << std::endl;
+		outFile << "Average bodies time (ms): " << m_bodiesTime * 1000.0 / frames << std::endl;
+		outFile << "Average contacts time (ms): " << m_contactsTime * 1000.0 / frames << std::endl;
+		outFile << "Average solve time (ms): " << m_solveTime * 1000.0 / frames << std::endl;
+		outFile << "Average integrate time (ms): " << m_integrateTime * 1000.0 / frames << std::endl;
+		outFile << "Average step time (ms): " << totalTime * 1000.0 / frames << std::endl;
+		outFile << "Contacts per second: " << (m_solveTime > 0.0 ? m_contactsSum / m_solveTime : 0.0) << std::endl;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
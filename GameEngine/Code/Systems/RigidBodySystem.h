@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ISystem.h"
+#include "Physics/Contacts.h"
+#include "Physics/ContactSolver.h"
+#include "Utils/Quaternion.h"
+
+namespace Engine::Systems
+{
+	// Simulates the RigidBody entities from the pairs found by BroadphaseSystem: contact generation,
+	// island solving on the workers and integration back into the Transforms.
+	class RigidBodySystem: public ISystem
+	{
+	public:
+		void onStart() override;
+		void onUpdate(float dt) override;
+		void onStop() override;
+		int getPriority() const override;
+
+	private:
+		void buildBodies(float dt);
+		void generateContacts();
+		void integrate(float dt);
+		void writeResults() const;
+
+	private:
+		static constexpr size_t k_defaultBatchSize = 4;
+		static constexpr size_t k_defaultPairsBatchSize = 256;
+
+		Utils::Vector3 m_gravity = Utils::Vector3(0.0f, -9.81f, 0.0f);
+		float m_maxTimeStep = 1.0f / 30.0f; // Longer frames are simulated slower instead of exploding
+		Physics::SolverSettings m_settings;
+		size_t m_batchSize = k_defaultBatchSize; // Islands per job
+		size_t m_pairsBatchSize = k_defaultPairsBatchSize; // Broadphase pairs and bodies per job
+		std::string m_outputFile;
+
+		Physics::ContactSolver m_solver;
+
+		// Indexed like the broadphase entities
+		std::vector<Physics::CollisionShape> m_shapes;
+		std::vector<Physics::SolverBody> m_bodies;
+		std::vector<Utils::Quaternion> m_orientations;
+		std::vector<uint8_t> m_dynamic;
+
+		std::vector<std::vector<Physics::Contact>> m_batchContacts;
+		std::vector<Physics::Contact> m_contacts;
+
+		size_t m_framesCount = 0;
+		double m_bodiesSum = 0.0;
+		double m_contactsSum = 0.0;
+		double m_islandsSum = 0.0;
+		size_t m_largestIsland = 0;
+		double m_laneOccupancySum = 0.0;
+		double m_bodiesTime = 0.0; // Seconds
+		double m_contactsTime = 0.0;
+		double m_solveTime = 0.0;
+		double m_integrateTime = 0.0;
+	};
+}
@@ -0,0 +1,140 @@
+#include "SceneGeneratorSystem.h"
+
+#include <random>
+
+#include "Managers/GameController.h"
+#include "Components/Transform.h"
+#include "Components/Tag.h"
+#include "Utils/DebugMacros.h"
+
+REGISTER_SYSTEM(Engine::Systems::SceneGeneratorSystem);
+
+namespace Engine::Systems
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	void SceneGeneratorSystem::onStart()
+	{
+		ExperimentSystemBase::onStart();
+
+		if (m_config.contains("seed"))
+		{
+			m_seed = m_config["seed"].get<uint32_t>();
+		}
+
+		ASSERT(m_config.contains("distribution"), "distribution not found in config");
+		if (m_config.contains("distribution"))
+		{
+			bool validType = Utils::PointDistribution::parseType(m_config["distribution"].get<std::string>(), m_distributionType);
+			ASSERT(validType, "Unknown distribution: {}", m_config["distribution"].get<std::string>());
+		}
+
+		if (m_config.contains("layout"))
+		{
+			Utils::Parser::fillFromJson(m_distribution, m_config["layout"]);
+		}
+
+		if (m_config.contains("prefabs"))
+		{
+			Utils::Parser::fillFromJson(m_prefabs, m_config["prefabs"]);
+		}
+
+		if (m_config.contains("scaleJitter"))
+		{
+			m_scaleJitter = m_config["scaleJitter"].get<float>();
+		}
+
+		if (m_config.contains("rotationJitter"))
+		{
+			Utils::Parser::fillFromJson(m_rotationJitter, m_config["rotationJitter"]);
+		}
+
+		if (m_prefabs.empty())
+		{
+			m_prefabs.push_back(PrefabWeight{ m_prefabName, 1.0f });
+		}
+
+		generateScene();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SceneGeneratorSystem::onStop()
+	{
+
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int SceneGeneratorSystem::getPriority() const
+	{
+		return 0;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SceneGeneratorSystem::generateScene()
+	{
+		GameController& gameController = GameController::get();
+		ComponentsManager& compManager = gameController.getComponentsManager();
+		Utils::SparseSet<Components::Transform, EntityID>& transformSet = compManager.getComponentSet<Components::Transform>();
+		Utils::SparseSet<Components::Tag, EntityID>& tagSet = compManager.getComponentSet<Components::Tag>();
+
+		std::mt19937 random(m_seed);
+		std::vector<Utils::Vector3> positions = m_distribution.generate(m_distributionType, m_prefabsCount, random);
+
+		std::vector<float> weights;
+		for (const PrefabWeight& prefab : m_prefabs)
+		{
+			weights.push_back(prefab.weight);
+		}
+		std::discrete_distribution<size_t> pickPrefab(weights.begin(), weights.end());
+
+		std::vector<size_t> prefabIndices(positions.size());
+		std::vector<size_t> prefabCounts(m_prefabs.size(), 0);
+		for (size_t& prefabIndex : prefabIndices)
+		{
+			prefabIndex = pickPrefab(random);
+			prefabCounts[prefabIndex]++;
+		}
+
+		// Each prefab is parsed once for all of its objects, creating them one by one dominates at 100k+ objects
+		std::vector<std::vector<EntityID>> prefabIds(m_prefabs.size());
+		for (size_t i = 0; i < m_prefabs.size(); i++)
+		{
+			if (prefabCounts[i] > 0)
+			{
+				prefabIds[i] = gameController.createPrefabs(m_prefabs[i].name, prefabCounts[i]);
+			}
+		}
+
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<size_t> usedIds(m_prefabs.size(), 0);
+		transformSet.reserve(transformSet.size() + positions.size());
+		tagSet.reserve(tagSet.size() + positions.size());
+		for (size_t i = 0; i < positions.size(); i++)
+		{
+			size_t prefabIndex = prefabIndices[i];
+			EntityID id = prefabIds[prefabIndex][usedIds[prefabIndex]++];
+			if (!transformSet.isPresent(id))
+			{
+				transformSet.addElement(id, Components::Transform{});
+			}
+
+			Components::Transform& transform = transformSet.getElement(id);
+			transform.position = positions[i];
+
+			float scaleFactor = 1.0f + unit(random) * m_scaleJitter;
+			transform.scale *= scaleFactor;
+
+			float rotationX = unit(random) * m_rotationJitter.x;
+			float rotationY = unit(random) * m_rotationJitter.y;
+			float rotationZ = unit(random) * m_rotationJitter.z;
+			transform.rotation += Utils::Vector3(rotationX, rotationY, rotationZ);
+
+			tagSet.addElement(id, Components::Tag{ k_experimentObjectTag });
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ExperimentSystemBase.h"
+#include "Managers/EntitiesManager.h"
+#include "Utils/Parser.h"
+#include "Utils/PointDistribution.h"
+#include "Utils/Vector.h"
+
+namespace Engine::Systems
+{
+	// Places prefabCount objects with a seeded distribution instead of listing them in the config.
+	// Prefabs are mixed by weight and each object gets a random scale and rotation offset.
+	class SceneGeneratorSystem: public ExperimentSystemBase
+	{
+	public:
+		void onStart() override;
+		void onStop() override;
+		int getPriority() const override;
+
+	private:
+		class PrefabWeight
+		{
+		public:
+			std::string name;
+			float weight = 1.0f;
+
+			SERIALIZABLE(
+				PROPERTY(PrefabWeight, name),
+				PROPERTY(PrefabWeight, weight)
+			)
+		};
+
+	private:
+		void generateScene();
+
+	private:
+		uint32_t m_seed = 0;
+		Utils::PointDistribution::Type m_distributionType = Utils::PointDistribution::Type::Uniform;
+		Utils::PointDistribution m_distribution;
+		std::vector<PrefabWeight> m_prefabs; // Empty uses the prefab of the experiment alone
+		float m_scaleJitter = 0.0f; // Relative, the scale is multiplied by a value in [1 - jitter, 1 + jitter]
+		Utils::Vector3 m_rotationJitter; // Radians added in [-jitter, jitter] on each axis
+	};
+}
@@ -0,0 +1,198 @@
+#include "SpatialSortSystem.h"
+
+#include <algorithm>
+
+#include "Managers/GameController.h"
+#include "Components/Transform.h"
+#include "Components/Parent.h"
+#include "Utils/Morton.h"
+#include "Utils/DebugMacros.h"
+
+REGISTER_SYSTEM(Engine::Systems::SpatialSortSystem);
+
+namespace Engine::Systems
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	void SpatialSortSystem::onStart()
+	{
+		ASSERT(m_config.contains("components"), "components not found in config");
+		if (m_config.contains("components"))
+		{
+			m_componentNames = m_config["components"].get<std::vector<std::string>>();
+		}
+
+		if (m_config.contains("framesBetweenSorts"))
+		{
+			m_framesBetweenSorts = m_config["framesBetweenSorts"].get<size_t>();
+		}
+
+		if (m_config.contains("poolsPerFrame"))
+		{
+			m_poolsPerFrame = m_config["poolsPerFrame"].get<size_t>();
+		}
+		ASSERT(m_poolsPerFrame > 0, "poolsPerFrame must be positive");
+		m_poolsPerFrame = std::max<size_t>(m_poolsPerFrame, 1);
+
+		if (m_config.contains("cellSize"))
+		{
+			m_cellSize = m_config["cellSize"].get<float>();
+		}
+		ASSERT(m_cellSize > 0.0f, "cellSize must be positive");
+
+		startSort();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SpatialSortSystem::onUpdate(float dt)
+	{
+		if (m_sortJob)
+		{
+			if (m_sortJob->sorted && applyOrders())
+			{
+				m_sortJob.reset();
+				m_framesSinceSort = 0;
+			}
+			return;
+		}
+
+		// Objects move slowly relative to the grid, so sorting every few frames is enough
+		m_framesSinceSort++;
+		if (m_framesSinceSort < m_framesBetweenSorts)
+		{
+			return;
+		}
+
+		startSort();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SpatialSortSystem::onStop()
+	{
+		// A running job keeps its own reference and finishes on its data
+		m_sortJob.reset();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int SpatialSortSystem::getPriority() const
+	{
+		return 6;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SpatialSortSystem::startSort()
+	{
+		GameController& gameController = GameController::get();
+		ComponentsManager& compManager = gameController.getComponentsManager();
+		const Utils::SparseSet<Components::Transform, EntityID>& transformSet = compManager.getComponentSet<Components::Transform>();
+		const Utils::SparseSet<Components::Parent, EntityID>& parentSet = compManager.getComponentSet<Components::Parent>();
+
+		auto job = std::make_shared<SortJob>();
+		EntityID idsEnd = 0;
+		for (const std::string& name : m_componentNames)
+		{
+			const std::vector<EntityID>* ids = compManager.getComponentIds(name);
+			ASSERT(ids, "Component {} is not registered", name);
+			if (!ids || !isSortable(name))
+			{
+				continue;
+			}
+
+			job->componentNames.push_back(name);
+			job->ids.push_back(*ids);
+			if (!ids->empty())
+			{
+				idsEnd = std::max(idsEnd, *std::max_element(ids->begin(), ids->end()) + 1);
+			}
+		}
+
+		// Entities without a Transform go last
+		job->keys.assign(idsEnd, UINT64_MAX);
+		const std::vector<EntityID>& transformIds = transformSet.getIds();
+		const Utils::DenseArray<Components::Transform>& transforms = transformSet.getElements();
+		gameController.getJobsManager().parallelFor(transformIds.size(), k_keysBatchSize, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					EntityID id = transformIds[i];
+					if (id >= idsEnd)
+					{
+						continue;
+					}
+
+					const Components::Transform& transform = transforms[i];
+					const Utils::Vector3& position = parentSet.isPresent(id) ? transform.worldPosition : transform.position;
+					job->keys[id] = Utils::mortonCode(position, m_cellSize);
+				}
+			});
+
+		m_sortJob = job;
+		m_nextPool = 0;
+		gameController.getJobsManager().submit([job]()
+			{
+				job->orders.resize(job->ids.size());
+				std::vector<std::pair<uint64_t, EntityID>> sortedEntities;
+				for (size_t pool = 0; pool < job->ids.size(); pool++)
+				{
+					sortedEntities.clear();
+					sortedEntities.reserve(job->ids[pool].size());
+					for (EntityID id : job->ids[pool])
+					{
+						sortedEntities.emplace_back(job->keys[id], id);
+					}
+
+					// Ties are broken by id, which keeps the permutation identical across pools
+					if (std::is_sorted(sortedEntities.begin(), sortedEntities.end()))
+					{
+						continue;
+					}
+					std::sort(sortedEntities.begin(), sortedEntities.end());
+
+					std::vector<EntityID>& order = job->orders[pool];
+					order.reserve(sortedEntities.size());
+					for (const auto& [key, id] : sortedEntities)
+					{
+						order.push_back(id);
+					}
+				}
+				job->sorted = true;
+			});
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool SpatialSortSystem::applyOrders()
+	{
+		ComponentsManager& compManager = GameController::get().getComponentsManager();
+		for (size_t moved = 0; m_nextPool < m_sortJob->componentNames.size() && moved < m_poolsPerFrame; m_nextPool++)
+		{
+			const std::string& name = m_sortJob->componentNames[m_nextPool];
+			const std::vector<EntityID>& order = m_sortJob->orders[m_nextPool];
+			if (order.empty() || !isSortable(name))
+			{
+				continue;
+			}
+
+			// A pool changed since the keys were taken keeps its order until the next sort
+			compManager.reorderComponentSet(name, m_sortJob->ids[m_nextPool], order);
+			moved++;
+		}
+
+		return m_nextPool == m_sortJob->componentNames.size();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool SpatialSortSystem::isSortable(const std::string& componentName) const
+	{
+		// Transform order is owned by HierarchySystem once parents exist, sorting it would force a rebuild
+		ComponentsManager& compManager = GameController::get().getComponentsManager();
+		return compManager.getComponentSet<Components::Parent>().size() == 0 || componentName != Utils::getTypeName<Components::Transform>();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
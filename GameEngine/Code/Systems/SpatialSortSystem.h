@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+
+#include "ISystem.h"
+#include "Managers/EntitiesManager.h"
+
+namespace Engine::Systems
+{
+	// Keeps the dense arrays of the configured components in Morton order of their entity positions.
+	// Keys are taken on the main thread, the orders are sorted on a job and a few pools are moved per frame.
+	class SpatialSortSystem: public ISystem
+	{
+	public:
+		void onStart() override;
+		void onUpdate(float dt) override;
+		void onStop() override;
+		int getPriority() const override;
+
+	private:
+		// Every pool is ordered by the same keys, so pools sharing entities get the same permutation
+		// even though they are moved on different frames
+		struct SortJob
+		{
+			std::vector<std::string> componentNames;
+			std::vector<std::vector<EntityID>> ids; // Of each pool when the keys were taken
+			std::vector<uint64_t> keys; // Indexed by entity
+			std::vector<std::vector<EntityID>> orders; // Written by the job, empty for pools already in order
+			std::atomic<bool> sorted = false;
+		};
+
+		void startSort();
+		bool applyOrders(); // True once every pool of the job is handled
+		bool isSortable(const std::string& componentName) const;
+
+	private:
+		static constexpr size_t k_keysBatchSize = 4096;
+
+		std::vector<std::string> m_componentNames;
+		size_t m_framesBetweenSorts = 30;
+		size_t m_framesSinceSort = 0;
+		size_t m_poolsPerFrame = 1;
+		float m_cellSize = 1.0f;
+
+		std::shared_ptr<SortJob> m_sortJob;
+		size_t m_nextPool = 0;
+	};
+}
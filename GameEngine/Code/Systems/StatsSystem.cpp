@@ -7,9 +7,11 @@
 #include "Managers/GameController.h"
 #include "Events/NativeInputEvents.h"
 #include "Utils/DebugMacros.h"
+#include "Utils/PageMemory.h"
 #include "Components/Transform.h"
 #include "Components/Tag.h"
 #include "Components/Model.h"
+#include "Systems/RenderingSystem.h"
 
 REGISTER_SYSTEM(Engine::Systems::StatsSystem);
 
@@ -114,6 +116,17 @@ namespace Engine::Systems
 			{
 				m_memoryUsage.push_back(memCounter.WorkingSetSize / (1024.0 * 1024.0)); // in MB
 			}
+
+			const RenderingSystem* renderingSystem = GameController::get().getSystemsManager().getSystem<RenderingSystem>();
+			if (renderingSystem && renderingSystem->getRenderer())
+			{
+				const Visual::TextureStats& textureStats = renderingSystem->getRenderer()->getTextureStats();
+				m_residentTextureMemory.push_back(textureStats.residentBytes / (1024.0f * 1024.0f));
+				if (textureStats.streamingBudget > 0)
+				{
+					m_requestedTextureMemory.push_back(textureStats.requestedBytes / (1024.0f * 1024.0f));
+				}
+			}
 		}
 
 	}
@@ -129,6 +142,10 @@ namespace Engine::Systems
 		std::string rendererName = m_config["renderer"];
 		std::string outputPath = m_config["outputFile"];
 
+		// Like the renderer name, these mirror the RenderingSystem config so results can be told apart
+		bool depthPrePass = m_config.contains("depthPrePass") && m_config["depthPrePass"];
+		bool sortFrontToBack = m_config.contains("sortFrontToBack") && m_config["sortFrontToBack"];
+
 		if (outputPath.empty())
 		{
 			return;
@@ -169,7 +186,15 @@ namespace Engine::Systems
 			return;
 		}
 
+		const Visual::FramePacing& framePacing = gameController.getFramePacing();
+
 		outFile << "Renderer: " << rendererName << std::endl;
+		outFile << "Frames in flight: " << framePacing.framesInFlight << std::endl;
+		outFile << "Present mode: " << framePacing.presentMode << std::endl;
+		outFile << "Waitable swapchain: " << framePacing.waitableSwapchain << std::endl;
+		outFile << "Max FPS: " << framePacing.maxFps << std::endl;
+		outFile << "Depth pre-pass: " << depthPrePass << std::endl;
+		outFile << "Front-to-back sorting: " << sortFrontToBack << std::endl;
 		outFile << "Objects count: " << objectsCount << std::endl;
 		outFile << "Total number of vertices: " << totalNumberOfVertices << std::endl;
 		outFile << "Creation time: " << m_creationTime << std::endl;
@@ -190,6 +215,67 @@ namespace Engine::Systems
 		outFile << "Median frame time: " << medianFrameTime << std::endl;
 		outFile << "99th percentile frame time: " << percentile99 << std::endl;
 		outFile << "1th percentile frame time: " << percentile1 << std::endl;
+
+		// Page allocations of the large buffers, residency shows whether large pages and NUMA placement took effect
+		if (Utils::PageMemory::isEnabled())
+		{
+			outFile << "NUMA nodes: " << Utils::PageMemory::getNodesCount() << std::endl;
+			for (size_t arena = 0; arena < (size_t)Utils::MemoryArena::Count; arena++)
+			{
+				Utils::MemoryArenaStats memoryStats = Utils::PageMemory::getStats((Utils::MemoryArena)arena);
+				std::string arenaName = Utils::PageMemory::getArenaName((Utils::MemoryArena)arena);
+				outFile << arenaName << " page allocations: " << memoryStats.allocations << std::endl;
+				outFile << arenaName << " page memory: " << memoryStats.bytes / (1024.0 * 1024.0) << std::endl;
+				outFile << arenaName << " large page memory: " << memoryStats.largePageBytes / (1024.0 * 1024.0) << std::endl;
+				outFile << arenaName << " large page failures: " << memoryStats.largePageFailures << std::endl;
+				outFile << arenaName << " resident pages: " << memoryStats.residentPages << std::endl;
+				outFile << arenaName << " resident large pages: " << memoryStats.residentLargePages << std::endl;
+				for (size_t node = 0; node < memoryStats.nodePages.size(); node++)
+				{
+					outFile << arenaName << " pages on node " << node << ": " << memoryStats.nodePages[node] << std::endl;
+				}
+
+				// Pages touched by jobs should be resident on the nodes of those jobs, far more pages than touched on
+				// the main thread's node means the storage was written before the jobs got to it
+				for (size_t node = 0; node < memoryStats.touchedNodePages.size(); node++)
+				{
+					outFile << arenaName << " pages touched by jobs on node " << node << ": " << memoryStats.touchedNodePages[node] << std::endl;
+				}
+			}
+		}
+
+		const RenderingSystem* renderingSystem = gameController.getSystemsManager().getSystem<RenderingSystem>();
+		if (renderingSystem && renderingSystem->getCullingStats().frames > 0)
+		{
+			// Cached results come from an earlier frame and skip the frustum test
+			const RenderingSystem::CullingStats& cullingStats = renderingSystem->getCullingStats();
+			double frames = (double)cullingStats.frames;
+			outFile << "Frustum tests per frame: " << cullingStats.tested / frames << std::endl;
+			outFile << "Cached visibility per frame: " << cullingStats.cached / frames << std::endl;
+			outFile << "Visible objects per frame: " << cullingStats.visible / frames << std::endl;
+			if (cullingStats.runs > 0)
+			{
+				outFile << "Culling runs per frame: " << cullingStats.runs / frames << std::endl;
+				outFile << "Objects decided by their run per frame: " << cullingStats.skipped / frames << std::endl;
+			}
+		}
+
+		// Requested is what the screen coverage asks for, resident stays under the budget when streaming
+		if (!m_residentTextureMemory.empty())
+		{
+			outFile << "Average resident texture memory: " << std::accumulate(m_residentTextureMemory.begin(), m_residentTextureMemory.end(), 0.0) / m_residentTextureMemory.size() << std::endl;
+			outFile << "Max resident texture memory: " << *std::max_element(m_residentTextureMemory.begin(), m_residentTextureMemory.end()) << std::endl;
+		}
+		if (!m_requestedTextureMemory.empty() && renderingSystem && renderingSystem->getRenderer())
+		{
+			const Visual::TextureStats& textureStats = renderingSystem->getRenderer()->getTextureStats();
+			outFile << "Texture streaming budget: " << textureStats.streamingBudget / (1024.0 * 1024.0) << std::endl;
+			outFile << "Average requested texture memory: " << std::accumulate(m_requestedTextureMemory.begin(), m_requestedTextureMemory.end(), 0.0) / m_requestedTextureMemory.size() << std::endl;
+			outFile << "Max requested texture memory: " << *std::max_element(m_requestedTextureMemory.begin(), m_requestedTextureMemory.end()) << std::endl;
+			outFile << "Streamed in texture memory: " << textureStats.streamedInBytes / (1024.0 * 1024.0) << std::endl;
+			outFile << "Dropped texture memory: " << textureStats.droppedBytes / (1024.0 * 1024.0) << std::endl;
+			outFile << "Streamed texture uploads: " << textureStats.streamedUploads << std::endl;
+		}
 	}
 
 	//////////////////////////////////////////////////////////////////////////
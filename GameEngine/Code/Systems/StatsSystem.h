@@ -34,6 +34,8 @@ namespace Engine::Systems
 		std::vector<float> m_cpuUsage;
 		std::vector<float> m_gpuUsage;
 		std::vector<float> m_gpuMemoryUsage;
+		std::vector<float> m_residentTextureMemory; // MB, as counted by the renderer
+		std::vector<float> m_requestedTextureMemory; // MB, only sampled while streaming
 
 		bool m_firstUpdate;
 		float m_timePassed;
@@ -0,0 +1,153 @@
+#include "AssetManifest.h"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+namespace Engine::Utils
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	bool AssetManifest::load(const std::string& filename)
+	{
+		clear();
+
+		std::ifstream file(filename);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		nlohmann::json json = nlohmann::json::parse(file, nullptr, false);
+		if (json.is_discarded() || json.value("version", 0) != k_version)
+		{
+			return false;
+		}
+
+		m_directory = std::filesystem::path(filename).parent_path();
+		m_contentDirectory = json.value("contentDirectory", "");
+		for (const nlohmann::json& assetJson : json.value("assets", nlohmann::json::array()))
+		{
+			Asset asset;
+			asset.source = assetJson.value("source", "");
+			asset.type = assetJson.value("type", "");
+			asset.output = assetJson.value("output", "");
+			asset.hash = std::stoull(assetJson.value("hash", "0"), nullptr, 16);
+			asset.dependencies = assetJson.value("dependencies", std::vector<std::string>());
+			addAsset(std::move(asset));
+		}
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool AssetManifest::save(const std::string& filename) const
+	{
+		nlohmann::json assets = nlohmann::json::array();
+		for (const Asset& asset : m_assets)
+		{
+			assets.push_back({
+				{ "source", asset.source },
+				{ "type", asset.type },
+				{ "output", asset.output },
+				{ "hash", std::format("{:016x}", asset.hash) },
+				{ "dependencies", asset.dependencies } });
+		}
+
+		nlohmann::json json = {
+			{ "version", k_version },
+			{ "contentDirectory", m_contentDirectory },
+			{ "assets", assets } };
+
+		std::ofstream file(filename);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		file << json.dump(4) << std::endl;
+		return file.good();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void AssetManifest::clear()
+	{
+		m_contentDirectory.clear();
+		m_directory.clear();
+		m_assets.clear();
+		m_sourceIndices.clear();
+		m_resolvedIndices.clear();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void AssetManifest::setContentDirectory(const std::string& directory)
+	{
+		m_contentDirectory = directory;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::string& AssetManifest::getContentDirectory() const
+	{
+		return m_contentDirectory;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void AssetManifest::addAsset(Asset&& asset)
+	{
+		m_sourceIndices[asset.source] = m_assets.size();
+		if (!m_directory.empty())
+		{
+			m_resolvedIndices[getKey(m_directory / m_contentDirectory / asset.source)] = m_assets.size();
+		}
+		m_assets.push_back(std::move(asset));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const AssetManifest::Asset* AssetManifest::findAsset(const std::string& source) const
+	{
+		auto index = m_sourceIndices.find(source);
+		return index != m_sourceIndices.end() ? &m_assets[index->second] : nullptr;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::vector<AssetManifest::Asset>& AssetManifest::getAssets() const
+	{
+		return m_assets;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::string AssetManifest::resolve(const std::string& path) const
+	{
+		if (m_resolvedIndices.empty())
+		{
+			return path;
+		}
+
+		auto index = m_resolvedIndices.find(getKey(path));
+		if (index == m_resolvedIndices.end())
+		{
+			return path;
+		}
+		return (m_directory / m_assets[index->second].output).string();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::string AssetManifest::getKey(const std::filesystem::path& path)
+	{
+		// Lexical only, the source files don't have to exist on the machine running the baked content
+		std::string key = std::filesystem::absolute(path).lexically_normal().generic_string();
+		std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return key;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
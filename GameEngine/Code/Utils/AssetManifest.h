@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Engine::Utils
+{
+	/**
+	 * @brief      Baked assets written by the AssetBuilder tool.
+	 *
+	 *             Sources are relative to the content directory and outputs to
+	 *             the directory of the manifest, the content directory itself is
+	 *             stored relative to the manifest too. The hash of an asset
+	 *             covers its source and every dependency, the builder only bakes
+	 *             again assets whose hash changed.
+	 */
+	class AssetManifest
+	{
+	public:
+		struct Asset
+		{
+			std::string source;
+			std::string type;
+			std::string output;
+			uint64_t hash = 0;
+			std::vector<std::string> dependencies; // Sources the output was built from, besides the asset itself
+		};
+
+	public:
+		bool load(const std::string& filename);
+		bool save(const std::string& filename) const;
+		void clear();
+
+		void setContentDirectory(const std::string& directory); // Relative to the manifest
+		const std::string& getContentDirectory() const;
+
+		void addAsset(Asset&& asset);
+		const Asset* findAsset(const std::string& source) const;
+		const std::vector<Asset>& getAssets() const;
+
+		// Path of the baked file for a source file path, the path itself when it wasn't baked
+		std::string resolve(const std::string& path) const;
+
+	private:
+		static std::string getKey(const std::filesystem::path& path);
+
+	private:
+		static constexpr int k_version = 1;
+
+		std::string m_contentDirectory;
+		std::filesystem::path m_directory; // Of the loaded manifest, resolve() works from it
+		std::vector<Asset> m_assets;
+		std::unordered_map<std::string, size_t> m_sourceIndices;
+		std::unordered_map<std::string, size_t> m_resolvedIndices; // Absolute source paths of a loaded manifest
+	};
+}
@@ -0,0 +1,284 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <Windows.h>
+
+namespace Engine::Utils
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	void Benchmark::init(const BenchmarkSettings& settings)
+	{
+		m_settings = settings;
+		m_settings.warmupFrames = std::max(m_settings.warmupFrames, 0);
+		m_frameIndex = 0;
+
+		m_frameThreadCycles.clear();
+		m_frameProcessCycles.clear();
+		m_frameNanoseconds.clear();
+		m_frameCounterSpans.clear();
+		m_sections.clear();
+		if (isEnabled())
+		{
+			m_frameThreadCycles.reserve(m_settings.frames);
+			m_frameProcessCycles.reserve(m_settings.frames);
+			m_frameNanoseconds.reserve(m_settings.frames);
+			m_frameCounterSpans.reserve(m_settings.frames);
+
+			// Counts the calling thread, init runs on the main thread
+			m_counters.start();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool Benchmark::isEnabled() const
+	{
+		return m_settings.frames > 0 && m_settings.timeStep > 0.0f;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	float Benchmark::getTimeStep() const
+	{
+		return m_settings.timeStep;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::string& Benchmark::getOutputFile() const
+	{
+		return m_settings.outputFile;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Benchmark::beginFrame()
+	{
+		// Outside of the cycles, an Etw sample costs a context switch
+		m_frameCountersStart = m_counters.sample();
+		m_frameStartTime = Clock::now();
+		m_frameStart = sampleCycles();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool Benchmark::endFrame()
+	{
+		CycleSample frameEnd = sampleCycles();
+		Clock::time_point frameEndTime = Clock::now();
+		HardwareCounters::Sample frameCountersEnd = m_counters.sample();
+
+		if (isRecording())
+		{
+			m_frameCounterSpans.push_back({ m_frameCountersStart, frameCountersEnd });
+			m_frameThreadCycles.push_back(frameEnd.thread - m_frameStart.thread);
+			m_frameProcessCycles.push_back(frameEnd.process - m_frameStart.process);
+			m_frameNanoseconds.push_back((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(frameEndTime - m_frameStartTime).count());
+		}
+
+		m_frameIndex++;
+		if (m_frameIndex < m_settings.warmupFrames + m_settings.frames)
+		{
+			return false;
+		}
+
+		m_counters.stop();
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Benchmark::beginSection()
+	{
+		m_sectionCountersStart = m_counters.sample();
+		m_sectionStart = sampleCycles();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Benchmark::endSection(const char* name)
+	{
+		CycleSample sectionEnd = sampleCycles();
+		HardwareCounters::Sample sectionCountersEnd = m_counters.sample();
+
+		auto [itr, inserted] = m_sections.try_emplace(name);
+		Section& section = itr->second;
+		if (inserted)
+		{
+			section.order = m_sections.size() - 1;
+		}
+
+		if (isRecording())
+		{
+			section.threadCycles += sectionEnd.thread - m_sectionStart.thread;
+			section.processCycles += sectionEnd.process - m_sectionStart.process;
+			section.counterSpans.push_back({ m_sectionCountersStart, sectionCountersEnd });
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Benchmark::writeResults(const std::string& path)
+	{
+		m_counters.stop();
+		if (m_frameThreadCycles.empty())
+		{
+			return;
+		}
+
+		std::ofstream outFile(path);
+		if (!outFile.is_open())
+		{
+			return;
+		}
+
+		double frames = (double)m_frameThreadCycles.size();
+		Summary threadCycles = summarize(m_frameThreadCycles);
+		Summary processCycles = summarize(m_frameProcessCycles);
+		Summary wallTime = summarize(m_frameNanoseconds);
+
+		outFile << "Frames: " << m_frameThreadCycles.size() << std::endl;
+		outFile << "Warmup frames: " << m_settings.warmupFrames << std::endl;
+		outFile << "Time step (s): " << m_settings.timeStep << std::endl;
+		if (m_counters.getMode() == HardwareCounters::Mode::Cycles)
+		{
+			outFile << "Counters: " << m_counters.getModeName() << ", instruction, branch and cache counters unavailable" << std::endl;
+		}
+		else
+		{
+			outFile << "Counters: " << m_counters.getModeName() << std::endl;
+		}
+		if (m_counters.getMode() == HardwareCounters::Mode::Etw)
+		{
+			outFile << "Counter events lost: " << m_counters.getEventsLost() << std::endl;
+		}
+
+		for (int i = 0; i < HardwareCounters::CountersCount; i++)
+		{
+			HardwareCounters::Counter counter = (HardwareCounters::Counter)i;
+			const char* counterName = HardwareCounters::getCounterName(counter);
+			if (!m_counters.isCounted(counter))
+			{
+				outFile << "Main thread " << counterName << ": not counted" << std::endl;
+				continue;
+			}
+
+			std::vector<uint64_t> counts;
+			counts.reserve(m_frameCounterSpans.size());
+			for (const CounterSpan& span : m_frameCounterSpans)
+			{
+				counts.push_back(m_counters.getDelta(span.start, span.end, counter));
+			}
+
+			Summary summary = summarize(std::move(counts));
+			outFile << "Median main thread " << counterName << " per frame: " << summary.median << std::endl;
+			outFile << "Mean main thread " << counterName << " per frame: " << summary.mean << std::endl;
+			outFile << "Min main thread " << counterName << " per frame: " << summary.min << std::endl;
+			outFile << "Main thread " << counterName << " deviation (%): " << summary.relativeDeviation << std::endl;
+		}
+
+		outFile << "Median main thread cycles per frame: " << threadCycles.median << std::endl;
+		outFile << "Mean main thread cycles per frame: " << threadCycles.mean << std::endl;
+		outFile << "Min main thread cycles per frame: " << threadCycles.min << std::endl;
+		outFile << "Main thread cycles deviation (%): " << threadCycles.relativeDeviation << std::endl;
+		outFile << "Median process cycles per frame: " << processCycles.median << std::endl;
+		outFile << "Mean process cycles per frame: " << processCycles.mean << std::endl;
+		outFile << "Process cycles deviation (%): " << processCycles.relativeDeviation << std::endl;
+		outFile << "Median frame time (ms): " << wallTime.median / 1e6 << std::endl;
+		outFile << "Frame time deviation (%): " << wallTime.relativeDeviation << std::endl;
+
+		std::vector<std::pair<const char*, const Section*>> sections;
+		for (const auto& [name, section] : m_sections)
+		{
+			sections.emplace_back(name, &section);
+		}
+		std::sort(sections.begin(), sections.end(), [](const auto& left, const auto& right)
+			{
+				return left.second->order < right.second->order;
+			});
+
+		for (const auto& [name, section] : sections)
+		{
+			outFile << name << " main thread cycles per frame: " << (double)section->threadCycles / frames << std::endl;
+			outFile << name << " process cycles per frame: " << (double)section->processCycles / frames << std::endl;
+
+			for (int i = 0; i < HardwareCounters::CountersCount; i++)
+			{
+				HardwareCounters::Counter counter = (HardwareCounters::Counter)i;
+				if (!m_counters.isCounted(counter))
+				{
+					continue;
+				}
+
+				uint64_t count = 0;
+				for (const CounterSpan& span : section->counterSpans)
+				{
+					count += m_counters.getDelta(span.start, span.end, counter);
+				}
+				outFile << name << " main thread " << HardwareCounters::getCounterName(counter) << " per frame: " << (double)count / frames << std::endl;
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Benchmark::CycleSample Benchmark::sampleCycles()
+	{
+		CycleSample sample;
+		ULONG64 cycles = 0;
+		if (QueryThreadCycleTime(GetCurrentThread(), &cycles))
+		{
+			sample.thread = cycles;
+		}
+		if (QueryProcessCycleTime(GetCurrentProcess(), &cycles))
+		{
+			sample.process = cycles;
+		}
+		return sample;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Benchmark::Summary Benchmark::summarize(std::vector<uint64_t> values)
+	{
+		Summary summary;
+		if (values.empty())
+		{
+			return summary;
+		}
+
+		double sum = 0.0;
+		for (uint64_t value : values)
+		{
+			sum += (double)value;
+		}
+		summary.mean = sum / (double)values.size();
+
+		double squaredSum = 0.0;
+		for (uint64_t value : values)
+		{
+			double difference = (double)value - summary.mean;
+			squaredSum += difference * difference;
+		}
+		double deviation = std::sqrt(squaredSum / (double)values.size());
+		summary.relativeDeviation = summary.mean > 0.0 ? deviation / summary.mean * 100.0 : 0.0;
+
+		std::sort(values.begin(), values.end());
+		summary.min = (double)values.front();
+		size_t middle = values.size() / 2;
+		summary.median = values.size() % 2 == 0 ? ((double)values[middle - 1] + (double)values[middle]) * 0.5 : (double)values[middle];
+		return summary;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool Benchmark::isRecording() const
+	{
+		return m_frameIndex >= m_settings.warmupFrames;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
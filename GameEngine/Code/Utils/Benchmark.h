@@ -0,0 +1,114 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Parser.h"
+#include "HardwareCounters.h"
+
+namespace Engine::Utils
+{
+	class BenchmarkSettings
+	{
+	public:
+		int frames = 0; // Recorded frames, 0 disables the benchmark mode
+		int warmupFrames = 60; // Run first and not recorded, caches and lazy loads settle in them
+		float timeStep = 1.0f / 60.0f; // dt of every frame, so the same frames run whatever the machine load
+		std::string outputFile;
+
+		SERIALIZABLE(
+			PROPERTY(BenchmarkSettings, frames),
+			PROPERTY(BenchmarkSettings, warmupFrames),
+			PROPERTY(BenchmarkSettings, timeStep),
+			PROPERTY(BenchmarkSettings, outputFile)
+		)
+	};
+
+	/**
+	 * @brief      Fixed frame count, fixed time step benchmark.
+	 *
+	 *             Retired instructions, branches and cache references of the main
+	 *             thread come from HardwareCounters, per frame and per system.
+	 *             Cycles come from QueryThreadCycleTime and QueryProcessCycleTime.
+	 *             They are CPU time, not work: frequency changes and cache misses
+	 *             move them. When no counter can be read the results are labelled
+	 *             as a cycles fallback. The process count also covers the job
+	 *             workers and the driver threads.
+	 */
+	class Benchmark
+	{
+	public:
+		void init(const BenchmarkSettings& settings);
+		bool isEnabled() const;
+		float getTimeStep() const;
+		const std::string& getOutputFile() const;
+
+		void beginFrame();
+		bool endFrame(); // Returns true once every frame is recorded
+
+		// Sections must not overlap, the name must outlive the benchmark, systems use their type name
+		void beginSection();
+		void endSection(const char* name);
+
+		void writeResults(const std::string& path); // Stops the counters when the run ended early
+
+	private:
+		struct CycleSample
+		{
+			uint64_t thread = 0;
+			uint64_t process = 0;
+		};
+
+		// Counts are resolved once the counters are stopped
+		struct CounterSpan
+		{
+			HardwareCounters::Sample start;
+			HardwareCounters::Sample end;
+		};
+
+		struct Section
+		{
+			uint64_t threadCycles = 0; // Summed over the recorded frames
+			uint64_t processCycles = 0;
+			std::vector<CounterSpan> counterSpans; // Of the recorded frames
+			size_t order = 0; // First time the section ended, sections are written in that order
+		};
+
+		struct Summary
+		{
+			double mean = 0.0;
+			double median = 0.0;
+			double min = 0.0;
+			double relativeDeviation = 0.0; // Standard deviation over the mean, in percent
+		};
+
+	private:
+		static CycleSample sampleCycles();
+		static Summary summarize(std::vector<uint64_t> values);
+
+		bool isRecording() const;
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		BenchmarkSettings m_settings;
+		int m_frameIndex = 0;
+
+		CycleSample m_frameStart;
+		CycleSample m_sectionStart;
+		HardwareCounters::Sample m_frameCountersStart;
+		HardwareCounters::Sample m_sectionCountersStart;
+		Clock::time_point m_frameStartTime;
+
+		HardwareCounters m_counters;
+		std::vector<CounterSpan> m_frameCounterSpans;
+
+		std::vector<uint64_t> m_frameThreadCycles;
+		std::vector<uint64_t> m_frameProcessCycles;
+		std::vector<uint64_t> m_frameNanoseconds;
+		std::unordered_map<const char*, Section> m_sections;
+	};
+}
@@ -0,0 +1,79 @@
+#include "FrameLimiter.h"
+
+#include <thread>
+
+namespace Engine::Utils
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	FrameLimiter::FrameLimiter()
+	{
+		m_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		if (!m_timer)
+		{
+			// High resolution timers need Windows 10 1803, the regular one is still better than Sleep
+			m_timer = CreateWaitableTimerW(nullptr, TRUE, nullptr);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	FrameLimiter::~FrameLimiter()
+	{
+		if (m_timer)
+		{
+			CloseHandle(m_timer);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void FrameLimiter::setMaxFps(float maxFps)
+	{
+		if (maxFps <= 0.0f)
+		{
+			m_framePeriod = Clock::duration::zero();
+			return;
+		}
+
+		m_framePeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / maxFps));
+		m_nextFrameTime = Clock::now() + m_framePeriod;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void FrameLimiter::wait()
+	{
+		if (m_framePeriod == Clock::duration::zero())
+		{
+			return;
+		}
+
+		Clock::duration remaining = m_nextFrameTime - Clock::now();
+		if (remaining > k_spinTime && m_timer)
+		{
+			// Relative due time in 100 ns units
+			LARGE_INTEGER dueTime;
+			dueTime.QuadPart = -static_cast<LONGLONG>(std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - k_spinTime).count() / 100);
+			if (SetWaitableTimerEx(m_timer, &dueTime, 0, nullptr, nullptr, nullptr, 0))
+			{
+				WaitForSingleObject(m_timer, INFINITE);
+			}
+		}
+
+		while (Clock::now() < m_nextFrameTime)
+		{
+			std::this_thread::yield();
+		}
+
+		// Frames are scheduled on a fixed grid, a frame that ran too long doesn't make the next ones shorter
+		m_nextFrameTime += m_framePeriod;
+		Clock::time_point now = Clock::now();
+		if (m_nextFrameTime < now)
+		{
+			m_nextFrameTime = now + m_framePeriod;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
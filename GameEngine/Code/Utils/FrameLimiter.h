@@ -0,0 +1,33 @@
+#pragma once
+
+#include <chrono>
+#include <Windows.h>
+
+namespace Engine::Utils
+{
+	/**
+	 * @brief      Caps the frame rate with a precise wait.
+	 *
+	 *             Most of the remaining frame time is slept on a high resolution
+	 *             waitable timer, the last couple of milliseconds are spun, since
+	 *             the scheduler can oversleep by more than that.
+	 */
+	class FrameLimiter
+	{
+	public:
+		FrameLimiter();
+		~FrameLimiter();
+
+		void setMaxFps(float maxFps);
+		void wait();
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		static constexpr std::chrono::microseconds k_spinTime{ 2000 };
+
+		HANDLE m_timer = nullptr;
+		Clock::duration m_framePeriod = Clock::duration::zero();
+		Clock::time_point m_nextFrameTime;
+	};
+}
@@ -0,0 +1,752 @@
+#include "Geometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define GEOMETRY_TARGET_AVX
+#else
+#define GEOMETRY_TARGET_AVX __attribute__((target("avx")))
+#endif
+
+namespace Engine::Utils
+{
+	namespace
+	{
+		SimdLevel s_maxSimdLevel = SimdLevel::AVX;
+
+		//////////////////////////////////////////////////////////////////////////
+
+		SimdLevel detectSimdLevel()
+		{
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 1);
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+			// The OS has to save the ymm registers on context switches
+			if (osxsave && avx && (_xgetbv(0) & 0x6) == 0x6)
+			{
+				return SimdLevel::AVX;
+			}
+#else
+			if (__builtin_cpu_supports("avx"))
+			{
+				return SimdLevel::AVX;
+			}
+#endif
+			// SSE2 is part of x64
+			return SimdLevel::SSE;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Same NaN behaviour as minps/maxps, so every kernel gives the same result
+		float minOf(float a, float b)
+		{
+			return a < b ? a : b;
+		}
+
+		float maxOf(float a, float b)
+		{
+			return a > b ? a : b;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		struct RaySetup
+		{
+			float origin[3];
+			float inverseDirection[3];
+		};
+
+		RaySetup getRaySetup(const Ray& ray)
+		{
+			// Division by zero gives infinity, which the slab test handles
+			return RaySetup{
+				{ ray.origin.x, ray.origin.y, ray.origin.z },
+				{ 1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z }
+			};
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		bool sphereVisible(const Frustum& frustum, float x, float y, float z, float radius)
+		{
+			bool visible = true;
+			for (const Plane& plane : frustum.planes)
+			{
+				float distance = plane.normal.x * x + plane.normal.y * y + plane.normal.z * z + plane.d;
+				visible &= distance >= -radius;
+			}
+			return visible;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Selects the corner furthest along the plane normal (p-vertex)
+		struct PlaneCorner
+		{
+			const float* x;
+			const float* y;
+			const float* z;
+		};
+
+		PlaneCorner getPlaneCorner(const Plane& plane, const AABBBatch& boxes)
+		{
+			return PlaneCorner{
+				plane.normal.x >= 0.0f ? boxes.maxX.data() : boxes.minX.data(),
+				plane.normal.y >= 0.0f ? boxes.maxY.data() : boxes.minY.data(),
+				plane.normal.z >= 0.0f ? boxes.maxZ.data() : boxes.minZ.data()
+			};
+		}
+
+		bool boxVisible(const Frustum& frustum, const PlaneCorner* corners, size_t index)
+		{
+			bool visible = true;
+			for (int i = 0; i < Frustum::PlanesCount; i++)
+			{
+				const Plane& plane = frustum.planes[i];
+				float distance =
+					plane.normal.x * corners[i].x[index] +
+					plane.normal.y * corners[i].y[index] +
+					plane.normal.z * corners[i].z[index] +
+					plane.d;
+				visible &= distance >= 0.0f;
+			}
+			return visible;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		float slabDistance(const RaySetup& ray, const float* boxMin, const float* boxMax)
+		{
+			float tNear = -std::numeric_limits<float>::infinity();
+			float tFar = std::numeric_limits<float>::infinity();
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float t1 = (boxMin[axis] - ray.origin[axis]) * ray.inverseDirection[axis];
+				float t2 = (boxMax[axis] - ray.origin[axis]) * ray.inverseDirection[axis];
+				tNear = maxOf(tNear, minOf(t1, t2));
+				tFar = minOf(tFar, maxOf(t1, t2));
+			}
+
+			float entry = maxOf(tNear, 0.0f);
+			return tFar >= entry ? entry : std::numeric_limits<float>::infinity();
+		}
+
+		float rayBoxDistance(const RaySetup& ray, const AABBBatch& boxes, size_t index)
+		{
+			float boxMin[3] = { boxes.minX[index], boxes.minY[index], boxes.minZ[index] };
+			float boxMax[3] = { boxes.maxX[index], boxes.maxY[index], boxes.maxZ[index] };
+			return slabDistance(ray, boxMin, boxMax);
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		size_t storeMask(int mask, int lanes, uint8_t* output)
+		{
+			size_t count = 0;
+			for (int lane = 0; lane < lanes; lane++)
+			{
+				uint8_t bit = static_cast<uint8_t>((mask >> lane) & 1);
+				output[lane] = bit;
+				count += bit;
+			}
+			return count;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// SSE kernels, 4 objects per iteration. Return the index of the first unprocessed object
+		//////////////////////////////////////////////////////////////////////////
+
+		size_t cullSpheresSSE(const Frustum& frustum, const SphereBatch& spheres, uint8_t* visible, size_t& count)
+		{
+			size_t size = spheres.size();
+			size_t i = 0;
+			for (; i + 4 <= size; i += 4)
+			{
+				__m128 x = _mm_loadu_ps(spheres.centerX.data() + i);
+				__m128 y = _mm_loadu_ps(spheres.centerY.data() + i);
+				__m128 z = _mm_loadu_ps(spheres.centerZ.data() + i);
+				__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres.radius.data() + i));
+
+				__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (const Plane& plane : frustum.planes)
+				{
+					__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+						_mm_mul_ps(_mm_set1_ps(plane.normal.x), x),
+						_mm_mul_ps(_mm_set1_ps(plane.normal.y), y)),
+						_mm_mul_ps(_mm_set1_ps(plane.normal.z), z)),
+						_mm_set1_ps(plane.d));
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+				}
+				count += storeMask(_mm_movemask_ps(inside), 4, visible + i);
+			}
+			return i;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		size_t cullAABBsSSE(const Frustum& frustum, const PlaneCorner* corners, size_t size, uint8_t* visible, size_t& count)
+		{
+			size_t i = 0;
+			for (; i + 4 <= size; i += 4)
+			{
+				__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (int p = 0; p < Frustum::PlanesCount; p++)
+				{
+					const Plane& plane = frustum.planes[p];
+					__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+						_mm_mul_ps(_mm_set1_ps(plane.normal.x), _mm_loadu_ps(corners[p].x + i)),
+						_mm_mul_ps(_mm_set1_ps(plane.normal.y), _mm_loadu_ps(corners[p].y + i))),
+						_mm_mul_ps(_mm_set1_ps(plane.normal.z), _mm_loadu_ps(corners[p].z + i))),
+						_mm_set1_ps(plane.d));
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+				}
+				count += storeMask(_mm_movemask_ps(inside), 4, visible + i);
+			}
+			return i;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		size_t intersectRaySSE(const RaySetup& ray, const AABBBatch& boxes, float* distances)
+		{
+			const float* mins[3] = { boxes.minX.data(), boxes.minY.data(), boxes.minZ.data() };
+			const float* maxs[3] = { boxes.maxX.data(), boxes.maxY.data(), boxes.maxZ.data() };
+
+			size_t size = boxes.size();
+			size_t i = 0;
+			for (; i + 4 <= size; i += 4)
+			{
+				__m128 tNear = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+				__m128 tFar = _mm_set1_ps(std::numeric_limits<float>::infinity());
+				for (int axis = 0; axis < 3; axis++)
+				{
+					__m128 origin = _mm_set1_ps(ray.origin[axis]);
+					__m128 inverseDirection = _mm_set1_ps(ray.inverseDirection[axis]);
+					__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(mins[axis] + i), origin), inverseDirection);
+					__m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(maxs[axis] + i), origin), inverseDirection);
+					tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+					tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+				}
+
+				__m128 entry = _mm_max_ps(tNear, _mm_setzero_ps());
+				__m128 hit = _mm_cmpge_ps(tFar, entry);
+				__m128 miss = _mm_set1_ps(std::numeric_limits<float>::infinity());
+				_mm_storeu_ps(distances + i, _mm_or_ps(_mm_and_ps(hit, entry), _mm_andnot_ps(hit, miss)));
+			}
+			return i;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// AVX kernels, 8 objects per iteration
+		//////////////////////////////////////////////////////////////////////////
+
+		GEOMETRY_TARGET_AVX
+		size_t cullSpheresAVX(const Frustum& frustum, const SphereBatch& spheres, uint8_t* visible, size_t& count)
+		{
+			size_t size = spheres.size();
+			size_t i = 0;
+			for (; i + 8 <= size; i += 8)
+			{
+				__m256 x = _mm256_loadu_ps(spheres.centerX.data() + i);
+				__m256 y = _mm256_loadu_ps(spheres.centerY.data() + i);
+				__m256 z = _mm256_loadu_ps(spheres.centerZ.data() + i);
+				__m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(spheres.radius.data() + i));
+
+				__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+				for (const Plane& plane : frustum.planes)
+				{
+					__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+						_mm256_mul_ps(_mm256_set1_ps(plane.normal.x), x),
+						_mm256_mul_ps(_mm256_set1_ps(plane.normal.y), y)),
+						_mm256_mul_ps(_mm256_set1_ps(plane.normal.z), z)),
+						_mm256_set1_ps(plane.d));
+					inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+				}
+				count += storeMask(_mm256_movemask_ps(inside), 8, visible + i);
+			}
+			return i;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		GEOMETRY_TARGET_AVX
+		size_t cullAABBsAVX(const Frustum& frustum, const PlaneCorner* corners, size_t size, uint8_t* visible, size_t& count)
+		{
+			size_t i = 0;
+			for (; i + 8 <= size; i += 8)
+			{
+				__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+				for (int p = 0; p < Frustum::PlanesCount; p++)
+				{
+					const Plane& plane = frustum.planes[p];
+					__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+						_mm256_mul_ps(_mm256_set1_ps(plane.normal.x), _mm256_loadu_ps(corners[p].x + i)),
+						_mm256_mul_ps(_mm256_set1_ps(plane.normal.y), _mm256_loadu_ps(corners[p].y + i))),
+						_mm256_mul_ps(_mm256_set1_ps(plane.normal.z), _mm256_loadu_ps(corners[p].z + i))),
+						_mm256_set1_ps(plane.d));
+					inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+				}
+				count += storeMask(_mm256_movemask_ps(inside), 8, visible + i);
+			}
+			return i;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		GEOMETRY_TARGET_AVX
+		size_t intersectRayAVX(const RaySetup& ray, const AABBBatch& boxes, float* distances)
+		{
+			const float* mins[3] = { boxes.minX.data(), boxes.minY.data(), boxes.minZ.data() };
+			const float* maxs[3] = { boxes.maxX.data(), boxes.maxY.data(), boxes.maxZ.data() };
+
+			size_t size = boxes.size();
+			size_t i = 0;
+			for (; i + 8 <= size; i += 8)
+			{
+				__m256 tNear = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+				__m256 tFar = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+				for (int axis = 0; axis < 3; axis++)
+				{
+					__m256 origin = _mm256_set1_ps(ray.origin[axis]);
+					__m256 inverseDirection = _mm256_set1_ps(ray.inverseDirection[axis]);
+					__m256 t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(mins[axis] + i), origin), inverseDirection);
+					__m256 t2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(maxs[axis] + i), origin), inverseDirection);
+					tNear = _mm256_max_ps(tNear, _mm256_min_ps(t1, t2));
+					tFar = _mm256_min_ps(tFar, _mm256_max_ps(t1, t2));
+				}
+
+				__m256 entry = _mm256_max_ps(tNear, _mm256_setzero_ps());
+				__m256 hit = _mm256_cmp_ps(tFar, entry, _CMP_GE_OQ);
+				__m256 miss = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+				_mm256_storeu_ps(distances + i, _mm256_blendv_ps(miss, entry, hit));
+			}
+			return i;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	AABB AABB::fromPoints(const std::vector<Vector3>& points)
+	{
+		AABB box;
+		for (const Vector3& point : points)
+		{
+			box.merge(point);
+		}
+		return box;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool AABB::isEmpty() const
+	{
+		return min.x > max.x || min.y > max.y || min.z > max.z;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Vector3 AABB::getCenter() const
+	{
+		return (min + max) * 0.5f;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Vector3 AABB::getExtents() const
+	{
+		return (max - min) * 0.5f;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void AABB::merge(const Vector3& point)
+	{
+		min = Vector3(std::min(min.x, point.x), std::min(min.y, point.y), std::min(min.z, point.z));
+		max = Vector3(std::max(max.x, point.x), std::max(max.y, point.y), std::max(max.z, point.z));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void AABB::merge(const AABB& box)
+	{
+		if (box.isEmpty())
+		{
+			return;
+		}
+		merge(box.min);
+		merge(box.max);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void AABB::expand(float amount)
+	{
+		min -= Vector3(amount);
+		max += Vector3(amount);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	AABB AABB::transformed(const Matrix4& matrix) const
+	{
+		if (isEmpty())
+		{
+			return *this;
+		}
+
+		float oldMin[3] = { min.x, min.y, min.z };
+		float oldMax[3] = { max.x, max.y, max.z };
+		float newMin[3] = { matrix.m[0][3], matrix.m[1][3], matrix.m[2][3] };
+		float newMax[3] = { matrix.m[0][3], matrix.m[1][3], matrix.m[2][3] };
+
+		for (int row = 0; row < 3; row++)
+		{
+			for (int column = 0; column < 3; column++)
+			{
+				float a = matrix.m[row][column] * oldMin[column];
+				float b = matrix.m[row][column] * oldMax[column];
+				newMin[row] += std::min(a, b);
+				newMax[row] += std::max(a, b);
+			}
+		}
+
+		return AABB(Vector3(newMin[0], newMin[1], newMin[2]), Vector3(newMax[0], newMax[1], newMax[2]));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Sphere Sphere::fromAABB(const AABB& box)
+	{
+		return Sphere(box.getCenter(), box.getExtents().length());
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Sphere::merge(const Sphere& sphere)
+	{
+		Vector3 offset = sphere.center - center;
+		float distance = offset.length();
+
+		if (distance + sphere.radius <= radius)
+		{
+			return;
+		}
+		if (distance + radius <= sphere.radius)
+		{
+			*this = sphere;
+			return;
+		}
+
+		float newRadius = (distance + radius + sphere.radius) * 0.5f;
+		center += offset * ((newRadius - radius) / distance);
+		radius = newRadius;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	float Plane::distance(const Vector3& point) const
+	{
+		return Vector3::dotProduct(normal, point) + d;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Plane::normalize()
+	{
+		float length = normal.length();
+		if (length > 0.0f)
+		{
+			normal /= length;
+			d /= length;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Frustum Frustum::fromMatrix(const Matrix4& viewProjection)
+	{
+		const auto& m = viewProjection.m;
+		auto combine = [&m](int row, float sign)
+			{
+				return Plane(
+					Vector3(m[3][0] + sign * m[row][0], m[3][1] + sign * m[row][1], m[3][2] + sign * m[row][2]),
+					m[3][3] + sign * m[row][3]
+				);
+			};
+
+		Frustum frustum;
+		frustum.planes[Left] = combine(0, 1.0f);
+		frustum.planes[Right] = combine(0, -1.0f);
+		frustum.planes[Bottom] = combine(1, 1.0f);
+		frustum.planes[Top] = combine(1, -1.0f);
+		frustum.planes[Near] = Plane(Vector3(m[2][0], m[2][1], m[2][2]), m[2][3]);
+		frustum.planes[Far] = combine(2, -1.0f);
+
+		for (Plane& plane : frustum.planes)
+		{
+			plane.normalize();
+		}
+		return frustum;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool Frustum::intersects(const Sphere& sphere) const
+	{
+		return sphereVisible(*this, sphere.center.x, sphere.center.y, sphere.center.z, sphere.radius);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool Frustum::contains(const Sphere& sphere) const
+	{
+		for (const Plane& plane : planes)
+		{
+			if (plane.distance(sphere.center) < sphere.radius)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	float Frustum::getMargin(const Sphere& sphere) const
+	{
+		// Inside by the nearest plane, outside by the plane the sphere is furthest behind
+		float inside = std::numeric_limits<float>::max();
+		float outside = 0.0f;
+		for (const Plane& plane : planes)
+		{
+			float distance = plane.distance(sphere.center) + sphere.radius;
+			inside = std::min(inside, distance);
+			outside = std::min(outside, distance);
+		}
+		return outside < 0.0f ? outside : inside;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool Frustum::intersects(const AABB& box) const
+	{
+		for (const Plane& plane : planes)
+		{
+			Vector3 corner(
+				plane.normal.x >= 0.0f ? box.max.x : box.min.x,
+				plane.normal.y >= 0.0f ? box.max.y : box.min.y,
+				plane.normal.z >= 0.0f ? box.max.z : box.min.z
+			);
+			if (plane.distance(corner) < 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool Ray::intersect(const AABB& box, float& distance) const
+	{
+		float boxMin[3] = { box.min.x, box.min.y, box.min.z };
+		float boxMax[3] = { box.max.x, box.max.y, box.max.z };
+		distance = slabDistance(getRaySetup(*this), boxMin, boxMax);
+		return distance != std::numeric_limits<float>::infinity();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SphereBatch::add(const Sphere& sphere)
+	{
+		centerX.push_back(sphere.center.x);
+		centerY.push_back(sphere.center.y);
+		centerZ.push_back(sphere.center.z);
+		radius.push_back(sphere.radius);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SphereBatch::reserve(size_t count)
+	{
+		centerX.reserve(count);
+		centerY.reserve(count);
+		centerZ.reserve(count);
+		radius.reserve(count);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SphereBatch::clear()
+	{
+		centerX.clear();
+		centerY.clear();
+		centerZ.clear();
+		radius.clear();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void AABBBatch::add(const AABB& box)
+	{
+		minX.push_back(box.min.x);
+		minY.push_back(box.min.y);
+		minZ.push_back(box.min.z);
+		maxX.push_back(box.max.x);
+		maxY.push_back(box.max.y);
+		maxZ.push_back(box.max.z);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void AABBBatch::reserve(size_t count)
+	{
+		minX.reserve(count);
+		minY.reserve(count);
+		minZ.reserve(count);
+		maxX.reserve(count);
+		maxY.reserve(count);
+		maxZ.reserve(count);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void AABBBatch::clear()
+	{
+		minX.clear();
+		minY.clear();
+		minZ.clear();
+		maxX.clear();
+		maxY.clear();
+		maxZ.clear();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	SimdLevel getSimdLevel()
+	{
+		static const SimdLevel level = detectSimdLevel();
+		return level;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void setMaxSimdLevel(SimdLevel level)
+	{
+		s_maxSimdLevel = level;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	SimdLevel getActiveSimdLevel()
+	{
+		return std::min(getSimdLevel(), s_maxSimdLevel);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t frustumCullSpheres(const Frustum& frustum, const SphereBatch& spheres, std::vector<uint8_t>& visible)
+	{
+		visible.resize(spheres.size());
+
+		size_t count = 0;
+		size_t i = 0;
+		switch (getActiveSimdLevel())
+		{
+		case SimdLevel::AVX:
+			i = cullSpheresAVX(frustum, spheres, visible.data(), count);
+			break;
+		case SimdLevel::SSE:
+			i = cullSpheresSSE(frustum, spheres, visible.data(), count);
+			break;
+		default:
+			break;
+		}
+
+		for (; i < spheres.size(); i++)
+		{
+			visible[i] = sphereVisible(frustum, spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i], spheres.radius[i]);
+			count += visible[i];
+		}
+		return count;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t frustumCullAABBs(const Frustum& frustum, const AABBBatch& boxes, std::vector<uint8_t>& visible)
+	{
+		visible.resize(boxes.size());
+
+		PlaneCorner corners[Frustum::PlanesCount];
+		for (int p = 0; p < Frustum::PlanesCount; p++)
+		{
+			corners[p] = getPlaneCorner(frustum.planes[p], boxes);
+		}
+
+		size_t count = 0;
+		size_t i = 0;
+		switch (getActiveSimdLevel())
+		{
+		case SimdLevel::AVX:
+			i = cullAABBsAVX(frustum, corners, boxes.size(), visible.data(), count);
+			break;
+		case SimdLevel::SSE:
+			i = cullAABBsSSE(frustum, corners, boxes.size(), visible.data(), count);
+			break;
+		default:
+			break;
+		}
+
+		for (; i < boxes.size(); i++)
+		{
+			visible[i] = boxVisible(frustum, corners, i);
+			count += visible[i];
+		}
+		return count;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int64_t intersectRayAABBs(const Ray& ray, const AABBBatch& boxes, std::vector<float>& distances)
+	{
+		distances.resize(boxes.size());
+		RaySetup setup = getRaySetup(ray);
+
+		size_t i = 0;
+		switch (getActiveSimdLevel())
+		{
+		case SimdLevel::AVX:
+			i = intersectRayAVX(setup, boxes, distances.data());
+			break;
+		case SimdLevel::SSE:
+			i = intersectRaySSE(setup, boxes, distances.data());
+			break;
+		default:
+			break;
+		}
+
+		for (; i < boxes.size(); i++)
+		{
+			distances[i] = rayBoxDistance(setup, boxes, i);
+		}
+
+		int64_t closest = -1;
+		for (size_t j = 0; j < distances.size(); j++)
+		{
+			if (distances[j] != std::numeric_limits<float>::infinity() &&
+				(closest < 0 || distances[j] < distances[closest]))
+			{
+				closest = static_cast<int64_t>(j);
+			}
+		}
+		return closest;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
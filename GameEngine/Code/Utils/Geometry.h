@@ -0,0 +1,218 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Vector.h"
+#include "Matrix.h"
+
+namespace Engine::Utils
+{
+	/**
+	 * @brief      Axis aligned bounding box. Default constructed box is empty,
+	 *             so merging points or boxes into it just works.
+	 */
+	class AABB
+	{
+	public:
+		Vector3 min = Vector3(std::numeric_limits<float>::max());
+		Vector3 max = Vector3(-std::numeric_limits<float>::max());
+
+		AABB() = default;
+		AABB(const Vector3& iMin, const Vector3& iMax) : min(iMin), max(iMax) {}
+
+		static AABB fromPoints(const std::vector<Vector3>& points);
+
+		bool isEmpty() const;
+		Vector3 getCenter() const;
+		Vector3 getExtents() const; // Half of the size
+
+		void merge(const Vector3& point);
+		void merge(const AABB& box);
+		void expand(float amount);
+
+		/**
+		 * @brief      Bounds of this box after an affine transformation.
+		 *
+		 *             Uses Arvo's method, so the result is exact for the
+		 *             transformed corners without transforming all eight of them.
+		 *
+		 * @param[in]  matrix  The affine transformation.
+		 *
+		 * @return     The transformed box.
+		 */
+		AABB transformed(const Matrix4& matrix) const;
+	};
+
+	class Sphere
+	{
+	public:
+		Vector3 center;
+		float radius = 0.0f;
+
+		Sphere() = default;
+		Sphere(const Vector3& iCenter, float iRadius) : center(iCenter), radius(iRadius) {}
+
+		static Sphere fromAABB(const AABB& box);
+
+		// Smallest sphere containing both spheres
+		void merge(const Sphere& sphere);
+	};
+
+	/**
+	 * @brief      Plane as normal and offset, points with dot(normal, p) + d >= 0
+	 *             are in front of it.
+	 */
+	class Plane
+	{
+	public:
+		Vector3 normal;
+		float d = 0.0f;
+
+		Plane() = default;
+		Plane(const Vector3& iNormal, float iD) : normal(iNormal), d(iD) {}
+
+		float distance(const Vector3& point) const;
+		void normalize();
+	};
+
+	class Frustum
+	{
+	public:
+		enum PlaneId
+		{
+			Left = 0,
+			Right,
+			Bottom,
+			Top,
+			Near,
+			Far,
+			PlanesCount
+		};
+
+		Plane planes[PlanesCount];
+
+		/**
+		 * @brief      Extracts the planes from a view projection matrix
+		 *             (Gribb-Hartmann), depth is expected in [0, 1].
+		 *
+		 * @param[in]  viewProjection  The view projection matrix.
+		 *
+		 * @return     The frustum with normals pointing inside.
+		 */
+		static Frustum fromMatrix(const Matrix4& viewProjection);
+
+		// Conservative tests, objects crossing a plane count as visible
+		bool intersects(const Sphere& sphere) const;
+		bool intersects(const AABB& box) const;
+
+		// True when the whole sphere is in front of every plane
+		bool contains(const Sphere& sphere) const;
+
+		// How far the sphere can move relative to the planes before intersects() may change,
+		// positive while it intersects, negative while it is outside
+		float getMargin(const Sphere& sphere) const;
+	};
+
+	class Ray
+	{
+	public:
+		Vector3 origin;
+		Vector3 direction;
+
+		Ray() = default;
+		Ray(const Vector3& iOrigin, const Vector3& iDirection) : origin(iOrigin), direction(iDirection) {}
+
+		/**
+		 * @brief      Slab test against a box.
+		 *
+		 * @param[in]  box       The box.
+		 * @param[out] distance  Distance along the ray to the entry point, 0 when the origin is inside.
+		 *
+		 * @return     True when the ray hits the box.
+		 */
+		bool intersect(const AABB& box, float& distance) const;
+	};
+
+	// Structure of arrays storage for the batched tests below
+
+	class SphereBatch
+	{
+	public:
+		std::vector<float> centerX;
+		std::vector<float> centerY;
+		std::vector<float> centerZ;
+		std::vector<float> radius;
+
+		void add(const Sphere& sphere);
+		void reserve(size_t count);
+		void clear();
+		size_t size() const { return radius.size(); }
+	};
+
+	class AABBBatch
+	{
+	public:
+		std::vector<float> minX;
+		std::vector<float> minY;
+		std::vector<float> minZ;
+		std::vector<float> maxX;
+		std::vector<float> maxY;
+		std::vector<float> maxZ;
+
+		void add(const AABB& box);
+		void reserve(size_t count);
+		void clear();
+		size_t size() const { return minX.size(); }
+	};
+
+	enum class SimdLevel
+	{
+		Scalar,
+		SSE,
+		AVX
+	};
+
+	// Widest instruction set usable on this CPU, detected once
+	SimdLevel getSimdLevel();
+
+	// Lowers the level used by the SIMD kernels, for comparing them
+	void setMaxSimdLevel(SimdLevel level);
+
+	// Level the SIMD kernels run with, getSimdLevel() capped by setMaxSimdLevel()
+	SimdLevel getActiveSimdLevel();
+
+	/**
+	 * @brief      Tests a batch of spheres against the frustum.
+	 *
+	 * @param[in]  frustum  The frustum.
+	 * @param[in]  spheres  The spheres.
+	 * @param[out] visible  1 for every sphere that intersects the frustum, 0 otherwise.
+	 *
+	 * @return     The number of visible spheres.
+	 */
+	size_t frustumCullSpheres(const Frustum& frustum, const SphereBatch& spheres, std::vector<uint8_t>& visible);
+
+	/**
+	 * @brief      Tests a batch of boxes against the frustum.
+	 *
+	 * @param[in]  frustum  The frustum.
+	 * @param[in]  boxes    The boxes.
+	 * @param[out] visible  1 for every box that intersects the frustum, 0 otherwise.
+	 *
+	 * @return     The number of visible boxes.
+	 */
+	size_t frustumCullAABBs(const Frustum& frustum, const AABBBatch& boxes, std::vector<uint8_t>& visible);
+
+	/**
+	 * @brief      Tests a ray against a batch of boxes.
+	 *
+	 * @param[in]  ray        The ray.
+	 * @param[in]  boxes      The boxes.
+	 * @param[out] distances  Entry distance for every box, infinity when it is missed.
+	 *
+	 * @return     Index of the closest hit box, or -1 when nothing is hit.
+	 */
+	int64_t intersectRayAABBs(const Ray& ray, const AABBBatch& boxes, std::vector<float>& distances);
+}
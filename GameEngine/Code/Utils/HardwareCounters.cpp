@@ -0,0 +1,465 @@
+#include "HardwareCounters.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <intrin.h>
+
+namespace Engine::Utils
+{
+	namespace
+	{
+		// Kernel thread events, CSwitch is type 36
+		constexpr GUID k_threadGuid = { 0x3d6fa8d1, 0xfe05, 0x11d0, { 0x9d, 0xda, 0x00, 0xc0, 0x4f, 0xd7, 0xba, 0x7c } };
+
+		// Names of the profile sources as listed by the kernel, the first one found is used
+		const wchar_t* const k_sourceNames[][2] = {
+			{ L"InstructionRetired", nullptr },
+			{ L"BranchInstructions", nullptr },
+			{ L"LLCReference", L"DcacheAccesses" },
+		};
+
+		bool isElevated()
+		{
+			HANDLE token = nullptr;
+			if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token))
+			{
+				return false;
+			}
+
+			TOKEN_ELEVATION elevation = {};
+			DWORD size = 0;
+			bool elevated = GetTokenInformation(token, TokenElevation, &elevation, sizeof(elevation), &size) && elevation.TokenIsElevated;
+			CloseHandle(token);
+			return elevated;
+		}
+
+		int64_t getTime()
+		{
+			LARGE_INTEGER counter;
+			QueryPerformanceCounter(&counter);
+			return counter.QuadPart;
+		}
+
+		bool readInstructions(ULONG counter, uint64_t& value)
+		{
+#if defined(_M_X64) || defined(_M_IX86)
+			// Faults unless the OS lets user mode read the counters
+			__try
+			{
+				value = __readpmc(counter);
+				return true;
+			}
+			__except (EXCEPTION_EXECUTE_HANDLER)
+			{
+				return false;
+			}
+#else
+			return false;
+#endif
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	HardwareCounters::~HardwareCounters()
+	{
+		stop();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void HardwareCounters::start()
+	{
+		stop();
+
+		m_threadId = GetCurrentThreadId();
+		m_mode = Mode::Cycles;
+		std::fill(std::begin(m_pmcIndices), std::end(m_pmcIndices), -1);
+		if (startEtw())
+		{
+			m_mode = Mode::Etw;
+			return;
+		}
+
+		std::fill(std::begin(m_pmcIndices), std::end(m_pmcIndices), -1);
+		if (startRdpmc())
+		{
+			m_mode = Mode::Rdpmc;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void HardwareCounters::stop()
+	{
+		// The mode stays, the deltas are read after stopping
+		if (m_session != 0)
+		{
+			stopEtw();
+		}
+		else if (m_previousAffinity != 0)
+		{
+			stopRdpmc();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	HardwareCounters::Mode HardwareCounters::getMode() const
+	{
+		return m_mode;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const char* HardwareCounters::getModeName() const
+	{
+		switch (m_mode)
+		{
+		case Mode::Etw:
+			return "ETW PMC";
+		case Mode::Rdpmc:
+			return "rdpmc";
+		default:
+			return "Cycles fallback";
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool HardwareCounters::isCounted(Counter counter) const
+	{
+		return m_mode != Mode::Cycles && m_pmcIndices[counter] >= 0;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const char* HardwareCounters::getCounterName(Counter counter)
+	{
+		switch (counter)
+		{
+		case Instructions:
+			return "instructions";
+		case Branches:
+			return "branches";
+		case CacheReferences:
+			return "cache references";
+		default:
+			return "unknown";
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	uint64_t HardwareCounters::getEventsLost() const
+	{
+		return m_eventsLost;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	HardwareCounters::Sample HardwareCounters::sample()
+	{
+		Sample sample;
+		if (m_mode == Mode::Etw && m_session != 0)
+		{
+			endQuantum();
+			sample.time = getTime();
+		}
+		else if (m_mode == Mode::Rdpmc)
+		{
+			readInstructions(k_fixedInstructionsCounter, sample.values[Instructions]);
+		}
+		return sample;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	uint64_t HardwareCounters::getDelta(const Sample& start, const Sample& end, Counter counter) const
+	{
+		if (!isCounted(counter))
+		{
+			return 0;
+		}
+
+		if (m_mode == Mode::Etw)
+		{
+			return resolve(end.time, counter) - resolve(start.time, counter);
+		}
+		return end.values[counter] - start.values[counter];
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool HardwareCounters::startEtw()
+	{
+		if (!isElevated())
+		{
+			return false;
+		}
+
+		// Every PMC source of the machine, each one a PROFILE_SOURCE_INFO with its name
+		std::vector<uint8_t> sources(64 * 1024);
+		ULONG sourcesSize = 0;
+		if (TraceQueryInformation(0, TraceProfileSourceListInfo, sources.data(), (ULONG)sources.size(), &sourcesSize) != ERROR_SUCCESS)
+		{
+			return false;
+		}
+
+		std::vector<ULONG> pmcSources;
+		for (int counter = 0; counter < CountersCount; counter++)
+		{
+			for (const wchar_t* name : k_sourceNames[counter])
+			{
+				for (size_t offset = 0; name && m_pmcIndices[counter] < 0 && offset < sourcesSize;)
+				{
+					const PROFILE_SOURCE_INFO* source = reinterpret_cast<const PROFILE_SOURCE_INFO*>(sources.data() + offset);
+					if (wcscmp(source->Description, name) == 0)
+					{
+						m_pmcIndices[counter] = (int)pmcSources.size();
+						pmcSources.push_back(source->Source);
+					}
+
+					if (source->NextEntryOffset == 0)
+					{
+						break;
+					}
+					offset += source->NextEntryOffset;
+				}
+			}
+		}
+
+		if (pmcSources.empty())
+		{
+			return false;
+		}
+
+		size_t nameSize = (wcslen(k_sessionName) + 1) * sizeof(wchar_t);
+		m_properties.assign(sizeof(EVENT_TRACE_PROPERTIES) + nameSize, 0);
+		EVENT_TRACE_PROPERTIES* properties = reinterpret_cast<EVENT_TRACE_PROPERTIES*>(m_properties.data());
+		auto resetProperties = [&]()
+			{
+				std::fill(m_properties.begin(), m_properties.end(), 0);
+				properties->Wnode.BufferSize = (ULONG)m_properties.size();
+				properties->Wnode.Flags = WNODE_FLAG_TRACED_GUID;
+				properties->Wnode.ClientContext = 1; // QPC timestamps, comparable with the samples
+				properties->LogFileMode = EVENT_TRACE_REAL_TIME_MODE | EVENT_TRACE_SYSTEM_LOGGER_MODE;
+				properties->EnableFlags = EVENT_TRACE_FLAG_CSWITCH;
+				properties->BufferSize = 1024; // KB, context switches of the whole machine go through the session
+				properties->MinimumBuffers = 64;
+				properties->FlushTimer = 1;
+				properties->LoggerNameOffset = sizeof(EVENT_TRACE_PROPERTIES);
+			};
+
+		resetProperties();
+		ULONG status = StartTraceW(&m_session, k_sessionName, properties);
+		if (status == ERROR_ALREADY_EXISTS)
+		{
+			// Left over by a run that didn't stop it
+			ControlTraceW(0, k_sessionName, properties, EVENT_TRACE_CONTROL_STOP);
+			resetProperties();
+			status = StartTraceW(&m_session, k_sessionName, properties);
+		}
+		if (status != ERROR_SUCCESS)
+		{
+			m_session = 0;
+			return false;
+		}
+
+		CLASSIC_EVENT_ID contextSwitch = {};
+		contextSwitch.EventGuid = k_threadGuid;
+		contextSwitch.Type = k_contextSwitchType;
+		if (TraceSetInformation(m_session, TracePmcCounterListInfo, pmcSources.data(), (ULONG)(pmcSources.size() * sizeof(ULONG))) != ERROR_SUCCESS ||
+			TraceSetInformation(m_session, TracePmcEventListInfo, &contextSwitch, sizeof(contextSwitch)) != ERROR_SUCCESS)
+		{
+			ControlTraceW(m_session, nullptr, properties, EVENT_TRACE_CONTROL_STOP);
+			m_session = 0;
+			return false;
+		}
+
+		EVENT_TRACE_LOGFILEW logFile = {};
+		logFile.LoggerName = const_cast<wchar_t*>(k_sessionName);
+		logFile.ProcessTraceMode = PROCESS_TRACE_MODE_REAL_TIME | PROCESS_TRACE_MODE_EVENT_RECORD | PROCESS_TRACE_MODE_RAW_TIMESTAMP;
+		logFile.EventRecordCallback = &HardwareCounters::onEvent;
+		logFile.Context = this;
+		m_consumer = OpenTraceW(&logFile);
+		if (m_consumer == INVALID_PROCESSTRACE_HANDLE)
+		{
+			ControlTraceW(m_session, nullptr, properties, EVENT_TRACE_CONTROL_STOP);
+			m_session = 0;
+			return false;
+		}
+
+		m_quanta.clear();
+		m_running = false;
+		m_eventsLost = 0;
+		m_consumerThread = std::thread([this]()
+			{
+				ProcessTrace(&m_consumer, 1, nullptr, nullptr);
+			});
+
+		// A quantum only ends when the thread stops running, the helper gives it something to wait for
+		m_stopRequested = false;
+		m_switchRequest = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+		m_switchDone = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+		m_switchThread = std::thread([this]()
+			{
+				while (WaitForSingleObject(m_switchRequest, INFINITE) == WAIT_OBJECT_0 && !m_stopRequested)
+				{
+					SetEvent(m_switchDone);
+				}
+			});
+
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void HardwareCounters::stopEtw()
+	{
+		m_stopRequested = true;
+		SetEvent(m_switchRequest);
+		m_switchThread.join();
+		CloseHandle(m_switchRequest);
+		CloseHandle(m_switchDone);
+		m_switchRequest = nullptr;
+		m_switchDone = nullptr;
+
+		// Stopping flushes the buffers, ProcessTrace returns once every event is delivered
+		EVENT_TRACE_PROPERTIES* properties = reinterpret_cast<EVENT_TRACE_PROPERTIES*>(m_properties.data());
+		ControlTraceW(m_session, nullptr, properties, EVENT_TRACE_CONTROL_STOP);
+		m_eventsLost = properties->EventsLost + properties->RealTimeBuffersLost;
+		m_consumerThread.join();
+		CloseTrace(m_consumer);
+
+		m_session = 0;
+		m_consumer = INVALID_PROCESSTRACE_HANDLE;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool HardwareCounters::startRdpmc()
+	{
+		// The fixed counter can exist but be stopped, it has to move over some work
+		uint64_t before = 0, after = 0;
+		if (!readInstructions(k_fixedInstructionsCounter, before))
+		{
+			return false;
+		}
+
+		volatile uint64_t work = 0;
+		for (int i = 0; i < 1000; i++)
+		{
+			work = work + i;
+		}
+
+		if (!readInstructions(k_fixedInstructionsCounter, after) || after == before)
+		{
+			return false;
+		}
+
+		// Counters belong to the core, a migration between two samples would mix two of them
+		m_previousAffinity = SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << GetCurrentProcessorNumber());
+		if (m_previousAffinity == 0)
+		{
+			return false;
+		}
+
+		m_pmcIndices[Instructions] = 0;
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void HardwareCounters::stopRdpmc()
+	{
+		if (GetCurrentThreadId() == m_threadId)
+		{
+			SetThreadAffinityMask(GetCurrentThread(), m_previousAffinity);
+		}
+		m_previousAffinity = 0;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void HardwareCounters::endQuantum()
+	{
+		// Blocks until the helper answers, the switch away from this thread reads the counters
+		SignalObjectAndWait(m_switchRequest, m_switchDone, INFINITE, FALSE);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void HardwareCounters::onContextSwitch(const EVENT_RECORD& record)
+	{
+		const uint64_t* values = nullptr;
+		size_t valuesCount = 0;
+		for (USHORT i = 0; i < record.ExtendedDataCount; i++)
+		{
+			const EVENT_HEADER_EXTENDED_DATA_ITEM& item = record.ExtendedData[i];
+			if (item.ExtType == EVENT_HEADER_EXT_TYPE_PMC_COUNTERS)
+			{
+				values = reinterpret_cast<const uint64_t*>(item.DataPtr);
+				valuesCount = item.DataSize / sizeof(uint64_t);
+			}
+		}
+
+		if (!values || record.UserDataLength < 2 * sizeof(ULONG))
+		{
+			return;
+		}
+
+		ULONG threadIds[2]; // New thread, then old thread
+		std::memcpy(threadIds, record.UserData, sizeof(threadIds));
+
+		// Both switches of a quantum happen on the same processor, so the difference is the count of the thread
+		if (threadIds[1] == m_threadId && m_running)
+		{
+			Quantum quantum;
+			quantum.end = record.EventHeader.TimeStamp.QuadPart;
+			for (int counter = 0; counter < CountersCount; counter++)
+			{
+				int index = m_pmcIndices[counter];
+				uint64_t previous = m_quanta.empty() ? 0 : m_quanta.back().values[counter];
+				quantum.values[counter] = previous + (index >= 0 && (size_t)index < valuesCount ? values[index] - m_quantumStart[counter] : 0);
+			}
+			m_quanta.push_back(quantum);
+			m_running = false;
+		}
+
+		if (threadIds[0] == m_threadId)
+		{
+			for (int counter = 0; counter < CountersCount; counter++)
+			{
+				int index = m_pmcIndices[counter];
+				m_quantumStart[counter] = index >= 0 && (size_t)index < valuesCount ? values[index] : 0;
+			}
+			m_running = true;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void WINAPI HardwareCounters::onEvent(PEVENT_RECORD record)
+	{
+		if (record->EventHeader.EventDescriptor.Opcode == k_contextSwitchType && IsEqualGUID(record->EventHeader.ProviderId, k_threadGuid))
+		{
+			static_cast<HardwareCounters*>(record->UserContext)->onContextSwitch(*record);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	uint64_t HardwareCounters::resolve(int64_t time, Counter counter) const
+	{
+		// Quanta that ended before the sample returned, the last one is the one it ended
+		auto next = std::lower_bound(m_quanta.begin(), m_quanta.end(), time, [](const Quantum& quantum, int64_t sampleTime)
+			{
+				return quantum.end < sampleTime;
+			});
+		return next == m_quanta.begin() ? 0 : std::prev(next)->values[counter];
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <Windows.h>
+#include <evntrace.h>
+#include <evntcons.h>
+
+namespace Engine::Utils
+{
+	/**
+	 * @brief      Retired instructions, branches and cache references of the thread that started it.
+	 *
+	 *             Etw: an elevated process starts a kernel trace session that reads the
+	 *             PMCs on every context switch (TracePmcCounterListInfo). The counts of
+	 *             the thread are summed over its quanta, so they don't include the other
+	 *             threads of the core. sample() ends the quantum of the thread with a round
+	 *             trip to a helper thread, and the counts of a sample are resolved from the
+	 *             events once the session is stopped.
+	 *             Rdpmc: otherwise the fixed instruction counter is read with __readpmc
+	 *             where user mode access to it is enabled. It counts the core, so the thread
+	 *             is pinned while counting and preemption adds the instructions of others.
+	 *             Branches and cache references need programmed counters, they are missing.
+	 *             Cycles: neither is available and nothing is counted.
+	 */
+	class HardwareCounters
+	{
+	public:
+		enum class Mode
+		{
+			Cycles,
+			Etw,
+			Rdpmc
+		};
+
+		enum Counter
+		{
+			Instructions,
+			Branches,
+			CacheReferences,
+			CountersCount
+		};
+
+		struct Sample
+		{
+			int64_t time = 0; // QPC right after the quantum ended, Etw only
+			uint64_t values[CountersCount] = {}; // Rdpmc only
+		};
+
+	public:
+		~HardwareCounters();
+
+		void start();
+		void stop();
+
+		Mode getMode() const;
+		const char* getModeName() const;
+		bool isCounted(Counter counter) const;
+		static const char* getCounterName(Counter counter);
+		uint64_t getEventsLost() const; // Etw only, the counts are too low when some were lost
+
+		Sample sample();
+		uint64_t getDelta(const Sample& start, const Sample& end, Counter counter) const; // Call after stop
+
+	private:
+		struct Quantum
+		{
+			int64_t end = 0; // QPC of the context switch ending it
+			uint64_t values[CountersCount] = {}; // Summed over this quantum and the previous ones
+		};
+
+	private:
+		bool startEtw();
+		void stopEtw();
+		bool startRdpmc();
+		void stopRdpmc();
+
+		void endQuantum();
+		void onContextSwitch(const EVENT_RECORD& record);
+		static void WINAPI onEvent(PEVENT_RECORD record);
+		uint64_t resolve(int64_t time, Counter counter) const;
+
+	private:
+		static constexpr const wchar_t* k_sessionName = L"GameEngineBenchmarkPmc";
+		static constexpr UCHAR k_contextSwitchType = 36;
+		static constexpr ULONG k_fixedInstructionsCounter = 1u << 30; // Fixed counter 0 on Intel
+
+		Mode m_mode = Mode::Cycles;
+		DWORD m_threadId = 0;
+		int m_pmcIndices[CountersCount] = { -1, -1, -1 }; // Position of each counter in the PMC values of an event
+
+		// Etw
+		TRACEHANDLE m_session = 0;
+		TRACEHANDLE m_consumer = INVALID_PROCESSTRACE_HANDLE;
+		std::vector<uint8_t> m_properties; // EVENT_TRACE_PROPERTIES followed by the session name
+		std::thread m_consumerThread;
+		std::thread m_switchThread;
+		HANDLE m_switchRequest = nullptr;
+		HANDLE m_switchDone = nullptr;
+		std::atomic<bool> m_stopRequested = false;
+		uint64_t m_eventsLost = 0;
+
+		// Written by the consumer thread only, read after it is joined
+		std::vector<Quantum> m_quanta;
+		uint64_t m_quantumStart[CountersCount] = {};
+		bool m_running = false;
+
+		// Rdpmc
+		DWORD_PTR m_previousAffinity = 0;
+	};
+}
@@ -0,0 +1,165 @@
+#include "Matrix.h"
+
+#include <cmath>
+
+namespace Engine::Utils
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	Matrix4 Matrix4::operator*(const Matrix4& right) const
+	{
+		Matrix4 result;
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				result.m[row][column] =
+					m[row][0] * right.m[0][column] +
+					m[row][1] * right.m[1][column] +
+					m[row][2] * right.m[2][column] +
+					m[row][3] * right.m[3][column];
+			}
+		}
+		return result;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Vector3 Matrix4::transformPoint(const Vector3& point) const
+	{
+		Vector3 result(
+			m[0][0] * point.x + m[0][1] * point.y + m[0][2] * point.z + m[0][3],
+			m[1][0] * point.x + m[1][1] * point.y + m[1][2] * point.z + m[1][3],
+			m[2][0] * point.x + m[2][1] * point.y + m[2][2] * point.z + m[2][3]
+		);
+
+		float w = m[3][0] * point.x + m[3][1] * point.y + m[3][2] * point.z + m[3][3];
+		if (w != 1.0f && w != 0.0f)
+		{
+			result /= w;
+		}
+		return result;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Vector3 Matrix4::transformDirection(const Vector3& direction) const
+	{
+		return Vector3(
+			m[0][0] * direction.x + m[0][1] * direction.y + m[0][2] * direction.z,
+			m[1][0] * direction.x + m[1][1] * direction.y + m[1][2] * direction.z,
+			m[2][0] * direction.x + m[2][1] * direction.y + m[2][2] * direction.z
+		);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Matrix4 Matrix4::identity()
+	{
+		return Matrix4();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Matrix4 Matrix4::translation(const Vector3& offset)
+	{
+		Matrix4 result;
+		result.m[0][3] = offset.x;
+		result.m[1][3] = offset.y;
+		result.m[2][3] = offset.z;
+		return result;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Matrix4 Matrix4::scaling(const Vector3& scale)
+	{
+		Matrix4 result;
+		result.m[0][0] = scale.x;
+		result.m[1][1] = scale.y;
+		result.m[2][2] = scale.z;
+		return result;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Matrix4 Matrix4::rotation(const Quaternion& rotation)
+	{
+		// Columns are the rotated basis vectors
+		Vector3 xAxis = rotation.rotate(Vector3(1.0f, 0.0f, 0.0f));
+		Vector3 yAxis = rotation.rotate(Vector3(0.0f, 1.0f, 0.0f));
+		Vector3 zAxis = rotation.rotate(Vector3(0.0f, 0.0f, 1.0f));
+
+		Matrix4 result;
+		result.m[0][0] = xAxis.x; result.m[0][1] = yAxis.x; result.m[0][2] = zAxis.x;
+		result.m[1][0] = xAxis.y; result.m[1][1] = yAxis.y; result.m[1][2] = zAxis.y;
+		result.m[2][0] = xAxis.z; result.m[2][1] = yAxis.z; result.m[2][2] = zAxis.z;
+		return result;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Matrix4 Matrix4::fromTransform(const Vector3& position, const Vector3& rotation, const Vector3& scale)
+	{
+		return translation(position) * Matrix4::rotation(Quaternion::fromEulerAngles(rotation)) * scaling(scale);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Matrix4 Matrix4::fromTRS(const Vector3& translation, const Quaternion& rotation, const Vector3& scale)
+	{
+		float x = rotation.i, y = rotation.j, z = rotation.k, w = rotation.real;
+
+		Matrix4 result;
+		result.m[0][0] = (1.0f - 2.0f * (y * y + z * z)) * scale.x;
+		result.m[0][1] = (2.0f * (x * y - w * z)) * scale.y;
+		result.m[0][2] = (2.0f * (x * z + w * y)) * scale.z;
+		result.m[0][3] = translation.x;
+		result.m[1][0] = (2.0f * (x * y + w * z)) * scale.x;
+		result.m[1][1] = (1.0f - 2.0f * (x * x + z * z)) * scale.y;
+		result.m[1][2] = (2.0f * (y * z - w * x)) * scale.z;
+		result.m[1][3] = translation.y;
+		result.m[2][0] = (2.0f * (x * z - w * y)) * scale.x;
+		result.m[2][1] = (2.0f * (y * z + w * x)) * scale.y;
+		result.m[2][2] = (1.0f - 2.0f * (x * x + y * y)) * scale.z;
+		result.m[2][3] = translation.z;
+		return result;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Matrix4 Matrix4::lookAtLH(const Vector3& eye, const Vector3& target, const Vector3& up)
+	{
+		Vector3 forward = (target - eye).normalized();
+		Vector3 right = Vector3::crossProduct(up, forward).normalized();
+		Vector3 trueUp = Vector3::crossProduct(forward, right);
+
+		Matrix4 result;
+		result.m[0][0] = right.x; result.m[0][1] = right.y; result.m[0][2] = right.z;
+		result.m[1][0] = trueUp.x; result.m[1][1] = trueUp.y; result.m[1][2] = trueUp.z;
+		result.m[2][0] = forward.x; result.m[2][1] = forward.y; result.m[2][2] = forward.z;
+		result.m[0][3] = -Vector3::dotProduct(right, eye);
+		result.m[1][3] = -Vector3::dotProduct(trueUp, eye);
+		result.m[2][3] = -Vector3::dotProduct(forward, eye);
+		return result;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Matrix4 Matrix4::perspectiveLH(float fovY, float aspectRatio, float nearPlane, float farPlane)
+	{
+		float yScale = 1.0f / std::tan(fovY * 0.5f);
+		float depthScale = farPlane / (farPlane - nearPlane);
+
+		Matrix4 result;
+		result.m[0][0] = yScale / aspectRatio;
+		result.m[1][1] = yScale;
+		result.m[2][2] = depthScale;
+		result.m[2][3] = -nearPlane * depthScale;
+		result.m[3][2] = 1.0f;
+		result.m[3][3] = 0.0f;
+		return result;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
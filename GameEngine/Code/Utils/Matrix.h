@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Vector.h"
+#include "Quaternion.h"
+
+namespace Engine::Utils
+{
+	/**
+	 * @brief      4x4 float matrix, stored row by row and applied to column vectors (p' = M * p).
+	 *
+	 *             Only covers what the engine side math needs, renderers keep their own matrix types.
+	 */
+	class Matrix4
+	{
+	public:
+		float m[4][4] = {
+			{ 1.0f, 0.0f, 0.0f, 0.0f },
+			{ 0.0f, 1.0f, 0.0f, 0.0f },
+			{ 0.0f, 0.0f, 1.0f, 0.0f },
+			{ 0.0f, 0.0f, 0.0f, 1.0f }
+		};
+
+		Matrix4 operator*(const Matrix4& right) const;
+
+		Vector3 transformPoint(const Vector3& point) const;
+		Vector3 transformDirection(const Vector3& direction) const;
+
+		static Matrix4 identity();
+		static Matrix4 translation(const Vector3& offset);
+		static Matrix4 scaling(const Vector3& scale);
+		static Matrix4 rotation(const Quaternion& rotation);
+
+		/**
+		 * @brief      Builds the world matrix of a Transform (translation * rotation * scale).
+		 *
+		 * @param[in]  position  The position.
+		 * @param[in]  rotation  The euler angles in radian, same convention as Transform.
+		 * @param[in]  scale     The scale.
+		 */
+		static Matrix4 fromTransform(const Vector3& position, const Vector3& rotation, const Vector3& scale);
+
+		/**
+		 * @brief      Builds translation * rotation * scale straight from a quaternion,
+		 *             without multiplying the intermediate matrices.
+		 *
+		 * @param[in]  translation  The translation.
+		 * @param[in]  rotation     The rotation, must be normalized.
+		 * @param[in]  scale        The scale.
+		 */
+		static Matrix4 fromTRS(const Vector3& translation, const Quaternion& rotation, const Vector3& scale);
+
+		// Left-handed view and projection with depth in [0, 1], matching the renderers
+		static Matrix4 lookAtLH(const Vector3& eye, const Vector3& target, const Vector3& up);
+		static Matrix4 perspectiveLH(float fovY, float aspectRatio, float nearPlane, float farPlane);
+	};
+}
@@ -0,0 +1,47 @@
+#include "Morton.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Engine::Utils
+{
+	namespace
+	{
+		constexpr int64_t k_axisBits = 21;
+		constexpr int64_t k_axisOffset = int64_t(1) << (k_axisBits - 1);
+		constexpr int64_t k_axisMax = (int64_t(1) << k_axisBits) - 1;
+
+		//////////////////////////////////////////////////////////////////////////
+
+		uint64_t quantize(float value, float cellSize)
+		{
+			int64_t cell = static_cast<int64_t>(std::floor(value / cellSize)) + k_axisOffset;
+			return static_cast<uint64_t>(std::clamp<int64_t>(cell, 0, k_axisMax));
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Spreads the lower 21 bits so there are two zero bits between each of them
+		uint64_t spreadBits(uint64_t value)
+		{
+			value &= 0x1fffff;
+			value = (value | value << 32) & 0x1f00000000ffff;
+			value = (value | value << 16) & 0x1f0000ff0000ff;
+			value = (value | value << 8) & 0x100f00f00f00f00f;
+			value = (value | value << 4) & 0x10c30c30c30c30c3;
+			value = (value | value << 2) & 0x1249249249249249;
+			return value;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	uint64_t mortonCode(const Vector3& position, float cellSize)
+	{
+		return spreadBits(quantize(position.x, cellSize))
+			| spreadBits(quantize(position.y, cellSize)) << 1
+			| spreadBits(quantize(position.z, cellSize)) << 2;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Vector.h"
+
+namespace Engine::Utils
+{
+	/**
+	 * @brief      Computes the Morton (Z-order) code of the grid cell containing a position.
+	 *
+	 *             Each axis is quantized to 21 bits around the origin and the bits are
+	 *             interleaved, so positions that are close in space get close codes.
+	 *
+	 * @param[in]  position  The position to encode.
+	 * @param[in]  cellSize  The size of one grid cell.
+	 *
+	 * @return     63 bit Morton code.
+	 */
+	uint64_t mortonCode(const Vector3& position, float cellSize);
+}
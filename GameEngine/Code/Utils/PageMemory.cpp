@@ -0,0 +1,401 @@
+#include "PageMemory.h"
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <Windows.h>
+#include <psapi.h>
+
+#include "DebugMacros.h"
+
+namespace Engine::Utils
+{
+	namespace
+	{
+		enum class PagePlacement
+		{
+			Local,
+			Interleaved
+		};
+
+		struct PageAllocation
+		{
+			size_t size = 0; // Reserved bytes, rounded up to whole pages
+			MemoryArena arena = MemoryArena::Components;
+			bool largePages = false;
+		};
+
+		struct PageMemoryState
+		{
+			std::mutex mutex;
+			std::unordered_map<void*, PageAllocation> allocations;
+			size_t largePageFailures[(size_t)MemoryArena::Count] = {};
+			std::vector<size_t> touchedPages[(size_t)MemoryArena::Count]; // Per node, written by touch
+
+			PagePlacement placements[(size_t)MemoryArena::Count] = { PagePlacement::Local, PagePlacement::Local };
+			size_t minimumSize = 1024 * 1024;
+			bool enabled = false; // Set by init, every allocation stays on the heap until then
+			bool largePages = false;
+
+			size_t pageSize = 4096;
+			size_t largePageSize = 0; // 0 when large pages can't be used
+			std::vector<USHORT> nodes; // NUMA nodes with memory
+			ULONG highestNode = 0;
+		};
+
+		// Never destroyed, static pools are freed after every function-local static is gone
+		PageMemoryState& getState()
+		{
+			static PageMemoryState& state = *new PageMemoryState;
+			return state;
+		}
+
+		bool parsePlacement(const std::string& name, PagePlacement& placement)
+		{
+			if (name == "Local")
+			{
+				placement = PagePlacement::Local;
+				return true;
+			}
+			if (name == "Interleaved")
+			{
+				placement = PagePlacement::Interleaved;
+				return true;
+			}
+			return false;
+		}
+
+		// Large pages are only handed out to processes holding SeLockMemoryPrivilege, it has to be enabled first
+		bool enableLockMemoryPrivilege()
+		{
+			HANDLE token = nullptr;
+			if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+			{
+				return false;
+			}
+
+			TOKEN_PRIVILEGES privileges{};
+			privileges.PrivilegeCount = 1;
+			privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+			bool enabled = LookupPrivilegeValue(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid)
+				&& AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr)
+				&& GetLastError() == ERROR_SUCCESS; // ERROR_NOT_ALL_ASSIGNED when the account lacks the privilege
+
+			CloseHandle(token);
+			return enabled;
+		}
+
+		size_t roundUp(size_t value, size_t multiple)
+		{
+			return (value + multiple - 1) / multiple * multiple;
+		}
+
+		USHORT getCurrentNode()
+		{
+			PROCESSOR_NUMBER processor;
+			GetCurrentProcessorNumberEx(&processor);
+
+			USHORT node = 0;
+			GetNumaProcessorNodeEx(&processor, &node);
+			return node;
+		}
+
+		// Large pages are committed when reserved, so the node is chosen now instead of on first touch.
+		// Interleaving would need a separate allocation per node, those get the first node with free large pages.
+		void* allocateLargePages(const PageMemoryState& state, size_t size, PagePlacement placement)
+		{
+			DWORD type = MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES;
+			if (placement == PagePlacement::Local && state.nodes.size() > 1)
+			{
+				return VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, type, PAGE_READWRITE, getCurrentNode());
+			}
+			return VirtualAlloc(nullptr, size, type, PAGE_READWRITE);
+		}
+
+		void* allocateInterleaved(const PageMemoryState& state, size_t size, size_t stride)
+		{
+			uint8_t* base = static_cast<uint8_t*>(VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_READWRITE));
+			if (!base)
+			{
+				return nullptr;
+			}
+
+			// The node given when committing is where the pages go once touched
+			size_t nodeIndex = 0;
+			for (size_t offset = 0; offset < size; offset += stride)
+			{
+				size_t chunk = std::min(stride, size - offset);
+				DWORD node = state.nodes[nodeIndex];
+				nodeIndex = (nodeIndex + 1) % state.nodes.size();
+				if (!VirtualAllocExNuma(GetCurrentProcess(), base + offset, chunk, MEM_COMMIT, PAGE_READWRITE, node))
+				{
+					VirtualFree(base, 0, MEM_RELEASE);
+					return nullptr;
+				}
+			}
+			return base;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void PageMemory::init(const MemorySettings& settings)
+	{
+		PageMemoryState& state = getState();
+		std::unique_lock<std::mutex> lock(state.mutex);
+
+		SYSTEM_INFO systemInfo;
+		GetSystemInfo(&systemInfo);
+		state.pageSize = systemInfo.dwPageSize;
+		state.minimumSize = std::max((size_t)std::max(settings.minimumSize, 0) * 1024, k_minimumSizeFloor);
+
+		bool validComponentsPlacement = parsePlacement(settings.componentsPlacement, state.placements[(size_t)MemoryArena::Components]);
+		ASSERT(validComponentsPlacement, "Unknown components placement {}", settings.componentsPlacement);
+		bool validGeometryPlacement = parsePlacement(settings.geometryPlacement, state.placements[(size_t)MemoryArena::Geometry]);
+		ASSERT(validGeometryPlacement, "Unknown geometry placement {}", settings.geometryPlacement);
+
+		state.nodes.clear();
+		state.highestNode = 0;
+		GetNumaHighestNodeNumber(&state.highestNode);
+		for (USHORT node = 0; node <= state.highestNode; node++)
+		{
+			ULONGLONG availableBytes = 0;
+			if (GetNumaAvailableMemoryNodeEx(node, &availableBytes) && availableBytes > 0)
+			{
+				state.nodes.push_back(node);
+			}
+		}
+		if (state.nodes.empty())
+		{
+			state.nodes.push_back(0);
+		}
+		for (std::vector<size_t>& touchedPages : state.touchedPages)
+		{
+			touchedPages.assign(state.highestNode + 1, 0);
+		}
+
+		state.enabled = true;
+		state.largePages = settings.largePages;
+		state.largePageSize = 0;
+		if (state.largePages)
+		{
+			bool privilegeEnabled = enableLockMemoryPrivilege();
+			ASSERT(privilegeEnabled, "Large pages need the Lock pages in memory privilege");
+			state.largePageSize = privilegeEnabled ? GetLargePageMinimum() : 0;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void* PageMemory::allocate(size_t bytes, size_t alignment, MemoryArena arena)
+	{
+		PageMemoryState& state = getState();
+		if (!state.enabled || bytes < state.minimumSize)
+		{
+			if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+			{
+				return ::operator new(bytes, std::align_val_t(alignment));
+			}
+			return ::operator new(bytes);
+		}
+
+		PagePlacement placement = state.placements[(size_t)arena];
+		PageAllocation allocation;
+		allocation.arena = arena;
+
+		void* pointer = nullptr;
+		bool largePageFailure = false;
+		if (state.largePageSize > 0)
+		{
+			allocation.size = roundUp(bytes, state.largePageSize);
+			pointer = allocateLargePages(state, allocation.size, placement);
+			allocation.largePages = pointer != nullptr;
+
+			// Large pages need physically contiguous memory, a fragmented machine often has none left
+			largePageFailure = pointer == nullptr;
+		}
+
+		if (!pointer)
+		{
+			allocation.size = roundUp(bytes, state.pageSize);
+			if (placement == PagePlacement::Interleaved && state.nodes.size() > 1)
+			{
+				pointer = allocateInterleaved(state, allocation.size, k_interleaveStride);
+			}
+			else
+			{
+				pointer = VirtualAlloc(nullptr, allocation.size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+			}
+		}
+
+		if (!pointer)
+		{
+			throw std::bad_alloc();
+		}
+
+		std::unique_lock<std::mutex> lock(state.mutex);
+		state.allocations[pointer] = allocation;
+		if (largePageFailure)
+		{
+			state.largePageFailures[(size_t)arena]++;
+		}
+		return pointer;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void PageMemory::deallocate(void* pointer, size_t bytes, size_t alignment)
+	{
+		if (!pointer)
+		{
+			return;
+		}
+
+		// minimumSize may have changed since the allocation, so the table tells where it came from
+		PageMemoryState& state = getState();
+		if (bytes >= k_minimumSizeFloor)
+		{
+			std::unique_lock<std::mutex> lock(state.mutex);
+			auto allocation = state.allocations.find(pointer);
+			if (allocation != state.allocations.end())
+			{
+				state.allocations.erase(allocation);
+				lock.unlock();
+
+				VirtualFree(pointer, 0, MEM_RELEASE);
+				return;
+			}
+		}
+
+		if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+		{
+			::operator delete(pointer, std::align_val_t(alignment));
+			return;
+		}
+		::operator delete(pointer);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void PageMemory::touch(void* pointer, size_t bytes, MemoryArena arena)
+	{
+		PageMemoryState& state = getState();
+		if (!state.enabled || bytes == 0)
+		{
+			return;
+		}
+
+		// One byte per page is enough, the value doesn't matter since the storage is constructed afterwards.
+		// Large pages already got their node when allocated, writing them changes nothing
+		volatile uint8_t* bytesPointer = static_cast<uint8_t*>(pointer);
+		uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+		bytesPointer[0] = 0;
+		size_t pages = 1;
+		for (size_t offset = roundUp(address + 1, state.pageSize) - address; offset < bytes; offset += state.pageSize)
+		{
+			bytesPointer[offset] = 0;
+			pages++;
+		}
+
+		USHORT node = getCurrentNode();
+		std::unique_lock<std::mutex> lock(state.mutex);
+		std::vector<size_t>& touchedPages = state.touchedPages[(size_t)arena];
+		if (node < touchedPages.size())
+		{
+			touchedPages[node] += pages;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool PageMemory::isEnabled()
+	{
+		return getState().enabled;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t PageMemory::getNodesCount()
+	{
+		return getState().nodes.size();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const char* PageMemory::getArenaName(MemoryArena arena)
+	{
+		switch (arena)
+		{
+		case MemoryArena::Components:
+			return "Components";
+		case MemoryArena::Geometry:
+			return "Geometry";
+		default:
+			return "Unknown";
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	MemoryArenaStats PageMemory::getStats(MemoryArena arena)
+	{
+		PageMemoryState& state = getState();
+		std::unique_lock<std::mutex> lock(state.mutex);
+
+		MemoryArenaStats stats;
+		stats.largePageFailures = state.largePageFailures[(size_t)arena];
+		stats.nodePages.resize(state.highestNode + 1, 0);
+		stats.touchedNodePages = state.touchedPages[(size_t)arena];
+
+		// One entry per system page, large pages report the attributes of the large page holding them
+		std::vector<PSAPI_WORKING_SET_EX_INFORMATION> pages;
+		for (const auto& [pointer, allocation] : state.allocations)
+		{
+			if (allocation.arena != arena)
+			{
+				continue;
+			}
+
+			stats.allocations++;
+			stats.bytes += allocation.size;
+			if (allocation.largePages)
+			{
+				stats.largePageBytes += allocation.size;
+			}
+
+			pages.resize(allocation.size / state.pageSize);
+			for (size_t i = 0; i < pages.size(); i++)
+			{
+				pages[i].VirtualAddress = static_cast<uint8_t*>(pointer) + i * state.pageSize;
+			}
+
+			if (!QueryWorkingSetEx(GetCurrentProcess(), pages.data(), (DWORD)(pages.size() * sizeof(PSAPI_WORKING_SET_EX_INFORMATION))))
+			{
+				continue;
+			}
+
+			for (const PSAPI_WORKING_SET_EX_INFORMATION& page : pages)
+			{
+				if (!page.VirtualAttributes.Valid)
+				{
+					continue;
+				}
+
+				stats.residentPages++;
+				if (page.VirtualAttributes.LargePage)
+				{
+					stats.residentLargePages++;
+				}
+				if (page.VirtualAttributes.Node < stats.nodePages.size())
+				{
+					stats.nodePages[page.VirtualAttributes.Node]++;
+				}
+			}
+		}
+
+		return stats;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Parser.h"
+
+namespace Engine::Utils
+{
+	// Large engine buffers grouped by access pattern, each group has its own page placement
+	enum class MemoryArena
+	{
+		Components, // Dense arrays of the component pools
+		Geometry, // Vertex data shared by every worker, read-mostly
+		Count
+	};
+
+	class MemorySettings
+	{
+	public:
+		bool largePages = false; // Needs the "Lock pages in memory" privilege, normal pages are used without it
+		int minimumSize = 1024; // Kilobytes, smaller allocations stay on the heap
+		std::string componentsPlacement = "Local"; // Local or Interleaved
+		std::string geometryPlacement = "Local";
+
+		SERIALIZABLE(
+			PROPERTY(MemorySettings, largePages),
+			PROPERTY(MemorySettings, minimumSize),
+			PROPERTY(MemorySettings, componentsPlacement),
+			PROPERTY(MemorySettings, geometryPlacement)
+		)
+	};
+
+	struct MemoryArenaStats
+	{
+		size_t allocations = 0; // Live page allocations
+		size_t bytes = 0;
+		size_t largePageBytes = 0;
+		size_t largePageFailures = 0; // Allocations that fell back to normal pages since the start
+		size_t residentPages = 0; // Pages in the working set, in system page units
+		size_t residentLargePages = 0; // Resident pages that are part of a large page
+		std::vector<size_t> nodePages; // Resident pages per NUMA node
+		std::vector<size_t> touchedNodePages; // Pages first written through touch, per NUMA node of the writing thread
+	};
+
+	/**
+	 * @brief      Page level allocations for the large engine buffers.
+	 *
+	 *             Allocations of at least minimumSize bypass the heap and get pages
+	 *             of their own. With largePages they are backed by large pages, so
+	 *             far fewer TLB entries cover them. On NUMA machines the placement
+	 *             of the arena decides where the pages live. Local pages get no
+	 *             physical memory until first written, Windows then takes it from
+	 *             the node of the writing thread. Constructing elements writes them,
+	 *             so storage filled by jobs has to be touched by those jobs before
+	 *             the main thread constructs it. Interleaved pages are committed
+	 *             k_interleaveStride at a time on each node in turn, so shared data
+	 *             doesn't make every worker read from one node.
+	 *             Until init is called every allocation stays on the heap.
+	 */
+	class PageMemory
+	{
+	public:
+		static void init(const MemorySettings& settings);
+
+		static void* allocate(size_t bytes, size_t alignment, MemoryArena arena);
+		static void deallocate(void* pointer, size_t bytes, size_t alignment);
+
+		// Writes every page of storage not constructed yet, so a Local page is backed from the node of the calling thread
+		static void touch(void* pointer, size_t bytes, MemoryArena arena);
+
+		static bool isEnabled();
+		static size_t getNodesCount();
+		static const char* getArenaName(MemoryArena arena);
+
+		// Counters of the arena, residency is read from the working set of every live allocation
+		static MemoryArenaStats getStats(MemoryArena arena);
+
+	private:
+		static constexpr size_t k_interleaveStride = 256 * 1024;
+		static constexpr size_t k_minimumSizeFloor = 64 * 1024; // Allocation granularity of VirtualAlloc
+	};
+
+	// Standard allocator handing the storage of a container to PageMemory
+	template <typename T, MemoryArena Arena>
+	class PageAllocator
+	{
+	public:
+		using value_type = T;
+
+		// Not derived by allocator_traits because of the non-type parameter
+		template <typename U>
+		struct rebind
+		{
+			using other = PageAllocator<U, Arena>;
+		};
+
+		PageAllocator() = default;
+
+		template <typename U>
+		PageAllocator(const PageAllocator<U, Arena>& other);
+
+		T* allocate(size_t count);
+		void deallocate(T* pointer, size_t count);
+
+		template <typename U>
+		bool operator==(const PageAllocator<U, Arena>& other) const;
+	};
+
+	template <typename T, MemoryArena Arena>
+	using PageVector = std::vector<T, PageAllocator<T, Arena>>;
+}
+
+#include "PageMemory.inl"
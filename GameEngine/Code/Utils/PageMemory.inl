@@ -0,0 +1,41 @@
+#pragma once
+
+#include "PageMemory.h"
+
+namespace Engine::Utils
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	template <typename T, MemoryArena Arena>
+	template <typename U>
+	PageAllocator<T, Arena>::PageAllocator(const PageAllocator<U, Arena>&)
+	{
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	template <typename T, MemoryArena Arena>
+	T* PageAllocator<T, Arena>::allocate(size_t count)
+	{
+		return static_cast<T*>(PageMemory::allocate(count * sizeof(T), alignof(T), Arena));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	template <typename T, MemoryArena Arena>
+	void PageAllocator<T, Arena>::deallocate(T* pointer, size_t count)
+	{
+		PageMemory::deallocate(pointer, count * sizeof(T), alignof(T));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	template <typename T, MemoryArena Arena>
+	template <typename U>
+	bool PageAllocator<T, Arena>::operator==(const PageAllocator<U, Arena>&) const
+	{
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
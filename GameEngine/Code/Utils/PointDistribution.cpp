@@ -0,0 +1,265 @@
+#include "PointDistribution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace Engine::Utils
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	bool PointDistribution::parseType(const std::string& name, Type& type)
+	{
+		for (Type candidate : { Type::Uniform, Type::PoissonDisk, Type::Clustered, Type::CityBlock })
+		{
+			if (name == getTypeName(candidate))
+			{
+				type = candidate;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::string PointDistribution::getTypeName(Type type)
+	{
+		switch (type)
+		{
+		case Type::Uniform:
+			return "Uniform";
+		case Type::PoissonDisk:
+			return "PoissonDisk";
+		case Type::Clustered:
+			return "Clustered";
+		case Type::CityBlock:
+			return "CityBlock";
+		}
+		return "";
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::vector<Vector3> PointDistribution::generate(Type type, size_t count, std::mt19937& random) const
+	{
+		switch (type)
+		{
+		case Type::Uniform:
+			return generateUniform(count, random);
+		case Type::PoissonDisk:
+			return generatePoissonDisk(count, random);
+		case Type::Clustered:
+			return generateClustered(count, random);
+		case Type::CityBlock:
+			return generateCityBlock(count, random);
+		}
+		return {};
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::vector<Vector3> PointDistribution::generateUniform(size_t count, std::mt19937& random) const
+	{
+		Vector3 min = getMin();
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		std::vector<Vector3> points;
+		points.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			float x = unit(random);
+			float y = unit(random);
+			float z = unit(random);
+			points.emplace_back(min.x + x * size.x, min.y + y * size.y, min.z + z * size.z);
+		}
+		return points;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::vector<Vector3> PointDistribution::generatePoissonDisk(size_t count, std::mt19937& random) const
+	{
+		// Bridson's algorithm on the ground plane, a background grid with at most one point per cell keeps it linear
+		Vector3 min = getMin();
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		if (count == 0)
+		{
+			return {};
+		}
+
+		float radius = minDistance > 0.0f ? minDistance : std::sqrt(k_poissonAreaPerPoint * size.x * size.z / count);
+		float cellSize = radius / std::numbers::sqrt2_v<float>;
+		int columns = std::max(1, (int)std::ceil(size.x / cellSize));
+		int rows = std::max(1, (int)std::ceil(size.z / cellSize));
+		std::vector<int> grid((size_t)columns * rows, -1);
+
+		std::vector<Vector3> points;
+		std::vector<size_t> active;
+		auto addPoint = [&](float x, float z)
+			{
+				int column = std::min((int)((x - min.x) / cellSize), columns - 1);
+				int row = std::min((int)((z - min.z) / cellSize), rows - 1);
+				grid[(size_t)row * columns + column] = (int)points.size();
+				active.push_back(points.size());
+				points.emplace_back(x, 0.0f, z);
+			};
+		auto isFree = [&](float x, float z)
+			{
+				if (x < min.x || x >= min.x + size.x || z < min.z || z >= min.z + size.z)
+				{
+					return false;
+				}
+
+				int column = std::min((int)((x - min.x) / cellSize), columns - 1);
+				int row = std::min((int)((z - min.z) / cellSize), rows - 1);
+				for (int neighbourRow = std::max(row - 2, 0); neighbourRow <= std::min(row + 2, rows - 1); neighbourRow++)
+				{
+					for (int neighbourColumn = std::max(column - 2, 0); neighbourColumn <= std::min(column + 2, columns - 1); neighbourColumn++)
+					{
+						int pointIndex = grid[(size_t)neighbourRow * columns + neighbourColumn];
+						if (pointIndex < 0)
+						{
+							continue;
+						}
+
+						float dx = points[pointIndex].x - x;
+						float dz = points[pointIndex].z - z;
+						if (dx * dx + dz * dz < radius * radius)
+						{
+							return false;
+						}
+					}
+				}
+				return true;
+			};
+
+		float firstX = min.x + unit(random) * size.x;
+		float firstZ = min.z + unit(random) * size.z;
+		addPoint(firstX, firstZ);
+		while (!active.empty())
+		{
+			size_t activeIndex = std::min((size_t)(unit(random) * active.size()), active.size() - 1);
+			const Vector3 origin = points[active[activeIndex]];
+
+			bool found = false;
+			for (int attempt = 0; attempt < k_poissonAttempts && !found; attempt++)
+			{
+				float angle = unit(random) * 2.0f * std::numbers::pi_v<float>;
+				float distance = radius * (1.0f + unit(random));
+				float x = origin.x + distance * std::cos(angle);
+				float z = origin.z + distance * std::sin(angle);
+				if (isFree(x, z))
+				{
+					addPoint(x, z);
+					found = true;
+				}
+			}
+
+			if (!found)
+			{
+				active[activeIndex] = active.back();
+				active.pop_back();
+			}
+		}
+
+		// The set grows outwards from the first point, a random subset keeps the whole area covered
+		std::shuffle(points.begin(), points.end(), random);
+		if (points.size() > count)
+		{
+			points.resize(count);
+		}
+
+		// An explicit minDistance may not fit the count, the rest is uniform and ignores it
+		while (points.size() < count)
+		{
+			float x = min.x + unit(random) * size.x;
+			float z = min.z + unit(random) * size.z;
+			points.emplace_back(x, 0.0f, z);
+		}
+
+		for (Vector3& point : points)
+		{
+			point.y = min.y + unit(random) * size.y;
+		}
+		return points;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::vector<Vector3> PointDistribution::generateClustered(size_t count, std::mt19937& random) const
+	{
+		Vector3 min = getMin();
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::normal_distribution<float> offset(0.0f, clusterRadius);
+
+		std::vector<Vector3> centers;
+		for (int i = 0; i < std::max(clusterCount, 1); i++)
+		{
+			float x = min.x + unit(random) * size.x;
+			float z = min.z + unit(random) * size.z;
+			centers.emplace_back(x, 0.0f, z);
+		}
+		std::uniform_int_distribution<size_t> pickCenter(0, centers.size() - 1);
+
+		std::vector<Vector3> points;
+		points.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const Vector3& clusterCenter = centers[pickCenter(random)];
+			float x = clusterCenter.x + offset(random);
+			float z = clusterCenter.z + offset(random);
+			float y = min.y + unit(random) * size.y;
+			points.emplace_back(x, y, z);
+		}
+		return points;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::vector<Vector3> PointDistribution::generateCityBlock(size_t count, std::mt19937& random) const
+	{
+		// Blocks are separated by streets, objects stand on lots and stack when a lot is picked again
+		Vector3 min = getMin();
+		float blockPitch = blockSize + streetWidth;
+		int blocksX = std::max(1, (int)(size.x / blockPitch));
+		int blocksZ = std::max(1, (int)(size.z / blockPitch));
+		int lotsPerSide = std::max(lotsPerBlock, 1);
+		float lotSize = blockSize / lotsPerSide;
+		int lotsX = blocksX * lotsPerSide;
+		int lotsZ = blocksZ * lotsPerSide;
+
+		// Heavier lots grow taller, exponential weights give few towers and many low buildings
+		std::exponential_distribution<float> heightWeight(1.0f);
+		std::vector<float> weights((size_t)lotsX * lotsZ);
+		for (float& weight : weights)
+		{
+			weight = heightWeight(random);
+		}
+		std::discrete_distribution<size_t> pickLot(weights.begin(), weights.end());
+		std::vector<int> lotLevels(weights.size(), 0);
+
+		std::vector<Vector3> points;
+		points.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t lot = pickLot(random);
+			int lotX = (int)(lot % lotsX);
+			int lotZ = (int)(lot / lotsX);
+			float x = min.x + (lotX / lotsPerSide) * blockPitch + streetWidth / 2.0f + ((lotX % lotsPerSide) + 0.5f) * lotSize;
+			float z = min.z + (lotZ / lotsPerSide) * blockPitch + streetWidth / 2.0f + ((lotZ % lotsPerSide) + 0.5f) * lotSize;
+			float y = min.y + lotLevels[lot]++ * lotSize;
+			points.emplace_back(x, y, z);
+		}
+		return points;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Vector3 PointDistribution::getMin() const
+	{
+		return center - size / 2.0f;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
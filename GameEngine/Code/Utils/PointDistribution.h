@@ -0,0 +1,63 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Parser.h"
+#include "Vector.h"
+
+namespace Engine::Utils
+{
+	// Seeded object placements inside an axis aligned box. The ground is the XZ plane, y is the height.
+	class PointDistribution
+	{
+	public:
+		enum class Type
+		{
+			Uniform, // Independent uniform points in the whole box
+			PoissonDisk, // Uniform on the ground, but no two points closer than minDistance
+			Clustered, // Gaussian blobs around clusterCount uniform centers
+			CityBlock // Stacks on lots of a block grid split by streets, stack heights vary like a skyline
+		};
+
+		static bool parseType(const std::string& name, Type& type);
+		static std::string getTypeName(Type type);
+
+		// Same seed, type, settings and count give the same points
+		std::vector<Vector3> generate(Type type, size_t count, std::mt19937& random) const;
+
+	public:
+		Vector3 center = Vector3(0.0f, 0.0f, 50.0f);
+		Vector3 size = Vector3(100.0f, 10.0f, 100.0f);
+		float minDistance = 0.0f; // PoissonDisk, 0 derives it from the ground area and the count
+		int clusterCount = 16;
+		float clusterRadius = 5.0f; // Standard deviation of the offsets from the cluster center
+		float blockSize = 20.0f;
+		float streetWidth = 6.0f;
+		int lotsPerBlock = 4; // Lots along each side of a block, the lot size is also the stack step
+
+		SERIALIZABLE(
+			PROPERTY(PointDistribution, center),
+			PROPERTY(PointDistribution, size),
+			PROPERTY(PointDistribution, minDistance),
+			PROPERTY(PointDistribution, clusterCount),
+			PROPERTY(PointDistribution, clusterRadius),
+			PROPERTY(PointDistribution, blockSize),
+			PROPERTY(PointDistribution, streetWidth),
+			PROPERTY(PointDistribution, lotsPerBlock)
+		)
+
+	private:
+		std::vector<Vector3> generateUniform(size_t count, std::mt19937& random) const;
+		std::vector<Vector3> generatePoissonDisk(size_t count, std::mt19937& random) const;
+		std::vector<Vector3> generateClustered(size_t count, std::mt19937& random) const;
+		std::vector<Vector3> generateCityBlock(size_t count, std::mt19937& random) const;
+
+		Vector3 getMin() const;
+
+	private:
+		static constexpr int k_poissonAttempts = 30;
+		static constexpr float k_poissonAreaPerPoint = 0.5f; // Derived minDistance leaves room for about 1.5 times the count
+	};
+}
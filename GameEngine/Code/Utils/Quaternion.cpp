@@ -98,6 +98,46 @@ namespace Engine::Utils
 
 	//////////////////////////////////////////////////////////////////////////
 
+	Vector3 Quaternion::rotate(const Vector3& v) const
+	{
+		return (*this * v * getConjugate()).toVector();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Vector3 Quaternion::toEulerAngles() const
+	{
+		// Elements of the rotation matrix R = Rx * Ry * Rz
+		float r02 = 2.0f * (i * k + real * j);
+		float r12 = 2.0f * (j * k - real * i);
+		float r22 = 1.0f - 2.0f * (i * i + j * j);
+		float r01 = 2.0f * (i * j - real * k);
+		float r00 = 1.0f - 2.0f * (j * j + k * k);
+
+		r02 = std::fmaxf(-1.0f, std::fminf(1.0f, r02));
+		if (std::fabs(r02) > 0.9999f)
+		{
+			// Gimbal lock, x and z rotate around the same axis
+			float r21 = 2.0f * (j * k + real * i);
+			float r11 = 1.0f - 2.0f * (i * i + k * k);
+			return Vector3(std::atan2(r21, r11), std::asin(r02), 0.0f);
+		}
+
+		return Vector3(std::atan2(-r12, r22), std::asin(r02), std::atan2(-r01, r00));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Quaternion Quaternion::fromEulerAngles(const Vector3& angles)
+	{
+		Quaternion rotationX(Vector3(1.0f, 0.0f, 0.0f), angles.x);
+		Quaternion rotationY(Vector3(0.0f, 1.0f, 0.0f), angles.y);
+		Quaternion rotationZ(Vector3(0.0f, 0.0f, 1.0f), angles.z);
+		return rotationX * rotationY * rotationZ;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
 	std::ostream& operator<<(std::ostream& os, const Quaternion& q)
 	{
 		os << '{' << q.real << ',' << q.i << ',' << q.j << ',' << q.k << '}';
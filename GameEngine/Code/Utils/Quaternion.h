@@ -113,6 +113,31 @@ namespace Engine::Utils
 		 * @return     The rotated z vector.
 		 */
 		Vector3 getRotatedZVector();
+		/**
+		 * @brief      Rotates a vector by this quaternion.
+		 *
+		 * @param[in]  v     The vector to rotate. Quaternion length must equal 1.
+		 *
+		 * @return     The rotated vector.
+		 */
+		Vector3 rotate(const Vector3& v) const;
+		/**
+		 * @brief      Gets the euler angles of this rotation.
+		 *
+		 *             Angles follow the Transform convention, where the
+		 *             rotation is applied as Rx * Ry * Rz.
+		 *
+		 * @return     The euler angles in radian.
+		 */
+		Vector3 toEulerAngles() const;
+		/**
+		 * @brief      Constructs a quaternion from euler angles.
+		 *
+		 * @param[in]  angles  The euler angles in radian (Rx * Ry * Rz order).
+		 *
+		 * @return     The resulting rotation.
+		 */
+		static Quaternion fromEulerAngles(const Vector3& angles);
 		float real = 1;
 		float i = 0;
 		float j = 0;
@@ -0,0 +1,390 @@
+#include "SamplingProfiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+#include <TlHelp32.h>
+#include <DbgHelp.h>
+
+namespace Engine::Utils
+{
+	namespace
+	{
+		// Runs while the thread is suspended, so it can't allocate or take any lock
+		size_t copyStack(const CONTEXT& context, uint8_t* copy, size_t copySize)
+		{
+#if defined(_M_X64)
+			// The committed part of a stack is a single region, copying stops at its end
+			MEMORY_BASIC_INFORMATION region = {};
+			if (VirtualQuery(reinterpret_cast<LPCVOID>(context.Rsp), &region, sizeof(region)) == 0 || region.State != MEM_COMMIT)
+			{
+				return 0;
+			}
+
+			DWORD64 regionEnd = reinterpret_cast<DWORD64>(region.BaseAddress) + region.RegionSize;
+			size_t size = (size_t)std::min<DWORD64>(regionEnd - context.Rsp, copySize);
+			__try
+			{
+				memcpy(copy, reinterpret_cast<const void*>(context.Rsp), size);
+			}
+			__except (EXCEPTION_EXECUTE_HANDLER)
+			{
+				return 0;
+			}
+			return size;
+#else
+			return 0;
+#endif
+		}
+
+#if defined(_M_X64)
+		// Registers pointing into the copied part of the stack are moved into the copy, which also
+		// catches frame pointers restored from it
+		void rebaseRegisters(CONTEXT& context, DWORD64 stackBegin, DWORD64 stackEnd, DWORD64 copyBegin)
+		{
+			DWORD64* registers[] = { &context.Rsp, &context.Rbp, &context.Rbx, &context.Rsi, &context.Rdi,
+				&context.R12, &context.R13, &context.R14, &context.R15 };
+			for (DWORD64* value : registers)
+			{
+				if (*value >= stackBegin && *value < stackEnd)
+				{
+					*value = *value - stackBegin + copyBegin;
+				}
+			}
+		}
+#endif
+
+		// Walks the copy made by copyStack after the thread is resumed, the context still holds its real registers
+		size_t unwindStack(CONTEXT& context, const uint8_t* stack, size_t stackSize, uint64_t* frames, size_t maxFrames)
+		{
+			size_t count = 0;
+#if defined(_M_X64)
+			DWORD64 stackBegin = context.Rsp;
+			DWORD64 stackEnd = stackBegin + stackSize;
+			DWORD64 copyBegin = reinterpret_cast<DWORD64>(stack);
+			DWORD64 copyEnd = copyBegin + stackSize;
+
+			// The copy can hold anything, a fault ends the walk with the frames found so far
+			__try
+			{
+				while (count < maxFrames && context.Rip != 0)
+				{
+					frames[count++] = context.Rip;
+
+					rebaseRegisters(context, stackBegin, stackEnd, copyBegin);
+					if (context.Rsp < copyBegin || context.Rsp + sizeof(DWORD64) > copyEnd)
+					{
+						break; // Outer frames were not copied
+					}
+					DWORD64 previousRsp = context.Rsp;
+
+					DWORD64 imageBase = 0;
+					PRUNTIME_FUNCTION function = RtlLookupFunctionEntry(context.Rip, &imageBase, nullptr);
+					if (function)
+					{
+						PVOID handlerData = nullptr;
+						DWORD64 establisherFrame = 0;
+						RtlVirtualUnwind(UNW_FLAG_NHANDLER, imageBase, context.Rip, function, &context, &handlerData, &establisherFrame, nullptr);
+					}
+					else
+					{
+						// Leaf functions have no unwind data, the return address is on top of the stack
+						context.Rip = *reinterpret_cast<const DWORD64*>(context.Rsp);
+						context.Rsp += sizeof(DWORD64);
+					}
+
+					if (context.Rsp <= previousRsp)
+					{
+						break;
+					}
+				}
+			}
+			__except (EXCEPTION_EXECUTE_HANDLER)
+			{
+			}
+#elif defined(_M_IX86)
+			// No table based unwinding on x86, only the sampled function is known
+			if (maxFrames > 0 && context.Eip != 0)
+			{
+				frames[count++] = context.Eip;
+			}
+#endif
+			return count;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	SamplingProfiler::~SamplingProfiler()
+	{
+		stop();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SamplingProfiler::start(const ProfilerSettings& settings)
+	{
+		stop();
+
+		m_settings = settings;
+		m_settings.sampleRate = std::max(m_settings.sampleRate, 1);
+		m_settings.maxDepth = std::max(m_settings.maxDepth, 1);
+		m_settings.bufferSize = std::max(m_settings.bufferSize, 1);
+		m_settings.stackCopySize = std::max(m_settings.stackCopySize, 1);
+
+		// Filled now so the pages are committed before any thread is suspended
+		m_buffer.assign((size_t)m_settings.bufferSize * 1024 * 1024 / sizeof(uint64_t), 0);
+		m_stackCopy.assign((size_t)m_settings.stackCopySize * 1024, 0);
+		m_bufferUsed = 0;
+		m_threads.clear();
+
+		m_mainThreadId = GetCurrentThreadId();
+		m_stopRequested = false;
+		m_sampler = std::thread(&SamplingProfiler::samplerLoop, this);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SamplingProfiler::stop()
+	{
+		if (!m_sampler.joinable())
+		{
+			return;
+		}
+
+		m_stopRequested = true;
+		m_sampler.join();
+
+		for (SampledThread& thread : m_threads)
+		{
+			CloseHandle(thread.handle);
+			thread.handle = nullptr;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SamplingProfiler::writeResults(const std::string& path) const
+	{
+		size_t used = m_bufferUsed.load(std::memory_order_acquire);
+		if (used == 0)
+		{
+			return;
+		}
+
+		std::ofstream outFile(path);
+		if (!outFile.is_open())
+		{
+			return;
+		}
+
+		HANDLE process = GetCurrentProcess();
+		SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS);
+		bool symbolsLoaded = SymInitialize(process, nullptr, TRUE);
+
+		std::vector<char> symbolStorage(sizeof(SYMBOL_INFO) + MAX_SYM_NAME);
+		SYMBOL_INFO* symbol = reinterpret_cast<SYMBOL_INFO*>(symbolStorage.data());
+
+		std::unordered_map<uint64_t, std::string> names;
+		auto getName = [&](uint64_t address) -> const std::string&
+			{
+				auto [itr, inserted] = names.try_emplace(address);
+				if (!inserted)
+				{
+					return itr->second;
+				}
+
+				std::string& name = itr->second;
+				symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+				symbol->MaxNameLen = MAX_SYM_NAME;
+				DWORD64 displacement = 0;
+				IMAGEHLP_MODULE64 module = {};
+				module.SizeOfStruct = sizeof(IMAGEHLP_MODULE64);
+				char hexAddress[32];
+				if (symbolsLoaded && SymFromAddr(process, address, &displacement, symbol))
+				{
+					name.assign(symbol->Name, symbol->NameLen);
+				}
+				else if (symbolsLoaded && SymGetModuleInfo64(process, address, &module))
+				{
+					snprintf(hexAddress, sizeof(hexAddress), "+0x%llx", (unsigned long long)(address - module.BaseOfImage));
+					name = std::string(module.ModuleName) + hexAddress;
+				}
+				else
+				{
+					snprintf(hexAddress, sizeof(hexAddress), "0x%llx", (unsigned long long)address);
+					name = hexAddress;
+				}
+
+				// Semicolons separate the frames of a collapsed stack
+				std::replace(name.begin(), name.end(), ';', ':');
+				return name;
+			};
+
+		std::map<std::string, size_t> stacks;
+		size_t position = 0;
+		while (position < used)
+		{
+			uint32_t threadIndex = (uint32_t)(m_buffer[position] >> 32);
+			size_t framesCount = (size_t)(m_buffer[position] & 0xFFFFFFFFull);
+			const uint64_t* frames = &m_buffer[position + 1];
+			position += 1 + framesCount;
+
+			std::string stack = getThreadName(threadIndex);
+			for (size_t i = framesCount; i-- > 0;)
+			{
+				// Outer frames are return addresses, one byte back is still inside the call
+				uint64_t address = i > 0 ? frames[i] - 1 : frames[i];
+				stack += ';';
+				stack += getName(address);
+			}
+			stacks[stack]++;
+		}
+
+		for (const auto& [stack, count] : stacks)
+		{
+			outFile << stack << ' ' << count << std::endl;
+		}
+
+		if (symbolsLoaded)
+		{
+			SymCleanup(process);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SamplingProfiler::samplerLoop()
+	{
+		m_samplerThreadId = GetCurrentThreadId();
+
+		HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		if (!timer)
+		{
+			timer = CreateWaitableTimerW(nullptr, TRUE, nullptr);
+		}
+
+		// Negative due times are relative, in 100 ns units
+		LARGE_INTEGER period;
+		period.QuadPart = -10'000'000LL / m_settings.sampleRate;
+		int ticksPerRefresh = std::max(m_settings.sampleRate / k_refreshesPerSecond, 1);
+
+		for (int tick = 0; !m_stopRequested; tick++)
+		{
+			if (tick % ticksPerRefresh == 0)
+			{
+				refreshThreads();
+			}
+
+			for (uint32_t i = 0; i < (uint32_t)m_threads.size(); i++)
+			{
+				sampleThread(i);
+			}
+
+			if (timer && SetWaitableTimer(timer, &period, 0, nullptr, nullptr, FALSE))
+			{
+				WaitForSingleObject(timer, INFINITE);
+			}
+			else
+			{
+				Sleep(1);
+			}
+		}
+
+		if (timer)
+		{
+			CloseHandle(timer);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SamplingProfiler::refreshThreads()
+	{
+		HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+		if (snapshot == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+
+		DWORD processId = GetCurrentProcessId();
+		THREADENTRY32 entry = {};
+		entry.dwSize = sizeof(THREADENTRY32);
+		for (BOOL found = Thread32First(snapshot, &entry); found; found = Thread32Next(snapshot, &entry))
+		{
+			if (entry.th32OwnerProcessID != processId || entry.th32ThreadID == m_samplerThreadId)
+			{
+				continue;
+			}
+
+			bool known = std::any_of(m_threads.begin(), m_threads.end(), [&entry](const SampledThread& thread)
+				{
+					return thread.id == entry.th32ThreadID;
+				});
+			if (known)
+			{
+				continue;
+			}
+
+			HANDLE handle = OpenThread(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION | SYNCHRONIZE, FALSE, entry.th32ThreadID);
+			if (handle)
+			{
+				m_threads.push_back(SampledThread{ entry.th32ThreadID, handle });
+			}
+		}
+
+		CloseHandle(snapshot);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SamplingProfiler::sampleThread(uint32_t threadIndex)
+	{
+		const SampledThread& thread = m_threads[threadIndex];
+		if (WaitForSingleObject(thread.handle, 0) == WAIT_OBJECT_0)
+		{
+			return; // Exited
+		}
+
+		size_t maxFrames = (size_t)m_settings.maxDepth;
+		size_t used = m_bufferUsed.load(std::memory_order_relaxed);
+		if (used + 1 + maxFrames > m_buffer.size())
+		{
+			return;
+		}
+
+		if (SuspendThread(thread.handle) == (DWORD)-1)
+		{
+			return;
+		}
+
+		// GetThreadContext also waits for the suspension to take effect
+		alignas(16) CONTEXT context = {};
+		context.ContextFlags = CONTEXT_FULL;
+		bool contextRead = GetThreadContext(thread.handle, &context) != 0;
+		size_t stackSize = contextRead ? copyStack(context, m_stackCopy.data(), m_stackCopy.size()) : 0;
+
+		ResumeThread(thread.handle);
+
+		size_t framesCount = contextRead ? unwindStack(context, m_stackCopy.data(), stackSize, &m_buffer[used + 1], maxFrames) : 0;
+		if (framesCount == 0)
+		{
+			return;
+		}
+
+		m_buffer[used] = ((uint64_t)threadIndex << 32) | (uint64_t)framesCount;
+		m_bufferUsed.store(used + 1 + framesCount, std::memory_order_release);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::string SamplingProfiler::getThreadName(uint32_t threadIndex) const
+	{
+		DWORD id = m_threads[threadIndex].id;
+		return id == m_mainThreadId ? "Main thread" : "Thread " + std::to_string(id);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Windows.h>
+
+#include "Parser.h"
+
+namespace Engine::Utils
+{
+	class ProfilerSettings
+	{
+	public:
+		int sampleRate = 1000; // Samples per second taken from every thread
+		int maxDepth = 64; // Deeper stacks keep their innermost frames
+		int bufferSize = 64; // Megabytes of stack frames, sampling stops when they are used up
+		int stackCopySize = 64; // Kilobytes copied from the top of each sampled stack, frames beyond them are cut
+		std::string outputFile;
+
+		SERIALIZABLE(
+			PROPERTY(ProfilerSettings, sampleRate),
+			PROPERTY(ProfilerSettings, maxDepth),
+			PROPERTY(ProfilerSettings, bufferSize),
+			PROPERTY(ProfilerSettings, stackCopySize),
+			PROPERTY(ProfilerSettings, outputFile)
+		)
+	};
+
+	/**
+	 * @brief      Statistical profiler, samples the call stacks of every thread of the process.
+	 *
+	 *             A sampler thread wakes sampleRate times per second and suspends
+	 *             each thread in turn only to read its context and copy the top of
+	 *             its stack into a buffer allocated at start. The stack is unwound
+	 *             from that copy once the thread is resumed: the unwinder can take
+	 *             the loader lock and the heap may be locked by the suspended thread,
+	 *             so neither is touched while it is suspended.
+	 *             Addresses are symbolized with DbgHelp when the results are
+	 *             written, in the collapsed stacks format flame graph tools read.
+	 */
+	class SamplingProfiler
+	{
+	public:
+		~SamplingProfiler();
+
+		void start(const ProfilerSettings& settings);
+		void stop();
+
+		// Call after stop, one "thread;outermost;...;innermost count" line per distinct stack
+		void writeResults(const std::string& path) const;
+
+	private:
+		struct SampledThread
+		{
+			DWORD id;
+			HANDLE handle;
+		};
+
+	private:
+		void samplerLoop();
+		void refreshThreads();
+		void sampleThread(uint32_t threadIndex);
+		std::string getThreadName(uint32_t threadIndex) const;
+
+	private:
+		static constexpr int k_refreshesPerSecond = 10; // New threads are found this often
+
+		ProfilerSettings m_settings;
+		DWORD m_mainThreadId = 0;
+		DWORD m_samplerThreadId = 0;
+		std::thread m_sampler;
+		std::atomic<bool> m_stopRequested = false;
+
+		std::vector<SampledThread> m_threads; // Only touched by the sampler thread while it runs
+
+		std::vector<uint8_t> m_stackCopy; // Top of the stack of the thread being sampled
+
+		// Records of [thread index << 32 | frames count, frames...], written by the sampler thread only
+		std::vector<uint64_t> m_buffer;
+		std::atomic<size_t> m_bufferUsed = 0;
+	};
+}
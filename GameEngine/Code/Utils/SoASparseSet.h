@@ -0,0 +1,145 @@
+#pragma once
+
+#include <tuple>
+#include <span>
+#include <type_traits>
+
+#include "SparseSet.h"
+#include "Parser.h"
+
+namespace Engine::Utils
+{
+    // Components opt into column storage with SOA_STORAGE, everything else stays an array of structs
+    template <typename ElemType>
+    struct UseSoAStorage: std::false_type {};
+
+    template <typename T>
+    concept SerializableType = requires { T::properties; };
+
+    // Chain of member pointers leading from a component to one of its leaf values
+    template <typename LeafType, typename... Members>
+    struct ColumnPath
+    {
+        using Type = LeafType;
+
+        std::tuple<Members...> members;
+
+        template <typename Object>
+        constexpr auto& resolve(Object& object) const;
+
+        template <typename Member>
+        constexpr auto prepend(Member member) const;
+    };
+
+    // Flattens SERIALIZABLE properties, nested serializable members are expanded down to their leaves
+    template <SerializableType Class>
+    constexpr auto getColumnPaths();
+
+    template <SerializableType ElemType>
+    struct SoALayout
+    {
+        static constexpr auto k_columnPaths = getColumnPaths<ElemType>();
+        static constexpr size_t k_columnsCount = std::tuple_size_v<decltype(k_columnPaths)>;
+
+        // Bools are stored as bytes, a packed vector<bool> has no contiguous storage to span and its
+        // neighbouring slots share words
+        template <typename LeafType>
+        using StorageType = std::conditional_t<std::is_same_v<LeafType, bool>, uint8_t, LeafType>;
+
+        template <size_t Column>
+        using ColumnType = StorageType<typename std::tuple_element_t<Column, std::remove_const_t<decltype(k_columnPaths)>>::Type>;
+
+        template <typename... Paths>
+        static auto makeColumns(const std::tuple<Paths...>&) -> std::tuple<DenseArray<StorageType<typename Paths::Type>>...>;
+
+        using Columns = decltype(makeColumns(k_columnPaths));
+    };
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    class SparseSet<ElemType, IDType>: public SparseSetBase<IDType>
+    {
+        using Layout = SoALayout<ElemType>;
+        static constexpr size_t k_columnsCount = Layout::k_columnsCount;
+
+        template <size_t Column>
+        using ColumnType = typename Layout::template ColumnType<Column>;
+
+    public:
+        // Stands in for ElemType& since there is no element object to refer to
+        class Reference
+        {
+        public:
+            Reference(SparseSet& set, size_t index);
+
+            operator ElemType() const;
+            Reference& operator=(const ElemType& element);
+
+            template <auto... Members>
+            auto& get() const;
+
+        private:
+            SparseSet& m_set;
+            size_t m_index;
+        };
+
+        bool addElement(IDType entity, const ElemType& component);
+        bool addElement(IDType entity, ElemType&& component);
+
+        Reference getElement(IDType entity);
+        ElemType getElement(IDType entity) const;
+
+        bool removeElement(IDType entity) override;
+        void clear() override;
+        void reorder(const std::vector<IDType>& order) override;
+
+        // Room for count elements of entities below idsEnd, filled by jobs through the inserter
+        ConcurrentInserter<ElemType, IDType> beginConcurrentInsertion(size_t count, IDType idsEnd,
+            const typename ConcurrentInserter<ElemType, IDType>::ParallelFor& parallelFor = {});
+
+        // Column addressed by its member path, e.g. getColumn<&RigidBody::velocity, &Vector3::x>(), bool leaves are uint8_t
+        template <auto... Members>
+        auto getColumn();
+
+        template <auto... Members>
+        auto getColumn() const;
+
+        template <size_t Column>
+        std::span<ColumnType<Column>> getColumnAt();
+
+        template <size_t Column>
+        std::span<const ColumnType<Column>> getColumnAt() const;
+
+        static constexpr size_t getColumnsCount();
+
+        using SparseSetBase<IDType>::isPresent;
+        using SparseSetBase<IDType>::getIndex;
+        using SparseSetBase<IDType>::getIds;
+        using SparseSetBase<IDType>::size;
+
+    private:
+        friend class ConcurrentInserter<ElemType, IDType>;
+
+        template <auto... Members>
+        static constexpr size_t findColumn();
+
+        ElemType gather(size_t index) const;
+        void scatter(size_t index, const ElemType& element);
+
+        size_t reserveSlots(size_t count, IDType idsEnd); // Capacity only, the new slots are not constructed
+        void touchSlots(size_t begin, size_t end);
+        void constructSlots(size_t end);
+        void storeElement(size_t index, IDType entity, const ElemType& element);
+        void publishSlots(size_t first);
+
+    private:
+        using SparseSetBase<IDType>::m_sparse;
+        using SparseSetBase<IDType>::m_denseEntities;
+
+        typename Layout::Columns m_columns; // One dense array per leaf property
+    };
+}
+
+#define SOA_STORAGE(CLASS) template <> struct Engine::Utils::UseSoAStorage<CLASS>: std::true_type {};
+
+#include "SoASparseSet.inl"
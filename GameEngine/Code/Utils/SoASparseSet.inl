@@ -0,0 +1,397 @@
+#pragma once
+
+#include "SoASparseSet.h"
+
+namespace Engine::Utils
+{
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename Object, typename Member, typename... Rest>
+    constexpr auto& resolveMember(Object& object, Member member, Rest... rest)
+    {
+        if constexpr (sizeof...(Rest) == 0)
+        {
+            return object.*member;
+        }
+        else
+        {
+            return resolveMember(object.*member, rest...);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename LeafType, typename... Members>
+    template <typename Object>
+    constexpr auto& ColumnPath<LeafType, Members...>::resolve(Object& object) const
+    {
+        return std::apply([&object](auto... member) -> auto& { return resolveMember(object, member...); }, members);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename LeafType, typename... Members>
+    template <typename Member>
+    constexpr auto ColumnPath<LeafType, Members...>::prepend(Member member) const
+    {
+        return ColumnPath<LeafType, Member, Members...>{ std::tuple_cat(std::make_tuple(member), members) };
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename Class, typename T>
+    constexpr auto getPropertyColumnPaths(PropertyImpl<Class, T> property)
+    {
+        if constexpr (SerializableType<T>)
+        {
+            return std::apply([&property](auto... path) { return std::make_tuple(path.prepend(property.member)...); }, getColumnPaths<T>());
+        }
+        else
+        {
+            return std::make_tuple(ColumnPath<T, T Class::*>{ std::make_tuple(property.member) });
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <SerializableType Class>
+    constexpr auto getColumnPaths()
+    {
+        return std::apply([](auto... property) { return std::tuple_cat(getPropertyColumnPaths(property)...); }, Class::properties);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    SparseSet<ElemType, IDType>::Reference::Reference(SparseSet& set, size_t index): m_set(set), m_index(index)
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    SparseSet<ElemType, IDType>::Reference::operator ElemType() const
+    {
+        return m_set.gather(m_index);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    typename SparseSet<ElemType, IDType>::Reference& SparseSet<ElemType, IDType>::Reference::operator=(const ElemType& element)
+    {
+        m_set.scatter(m_index, element);
+        return *this;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    template <auto... Members>
+    auto& SparseSet<ElemType, IDType>::Reference::get() const
+    {
+        static_assert(findColumn<Members...>() < k_columnsCount, "Member path doesn't match any column");
+        return std::get<findColumn<Members...>()>(m_set.m_columns)[m_index];
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    bool SparseSet<ElemType, IDType>::addElement(IDType entity, const ElemType& element)
+    {
+        if (isPresent(entity))
+        {
+            return false;
+        }
+
+        if (m_sparse.size() <= entity)
+        {
+            m_sparse.resize(entity + 1, -1);
+        }
+
+        m_sparse[entity] = m_denseEntities.size();
+        m_denseEntities.push_back(entity);
+        forSequence(std::make_index_sequence<k_columnsCount>{}, [&](auto column)
+            {
+                std::get<column>(m_columns).push_back(std::get<column>(Layout::k_columnPaths).resolve(element));
+            });
+
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    bool SparseSet<ElemType, IDType>::addElement(IDType entity, ElemType&& element)
+    {
+        // Leaves are copied column by column anyway, so there is nothing to move
+        return addElement(entity, static_cast<const ElemType&>(element));
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    typename SparseSet<ElemType, IDType>::Reference SparseSet<ElemType, IDType>::getElement(IDType entity)
+    {
+        return Reference(*this, m_sparse[entity]);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    ElemType SparseSet<ElemType, IDType>::getElement(IDType entity) const
+    {
+        return gather(m_sparse[entity]);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    bool SparseSet<ElemType, IDType>::removeElement(IDType entity)
+    {
+        if (!isPresent(entity))
+        {
+            return false;
+        }
+
+        size_t denseIndex = m_sparse[entity];
+
+        // Same swap-and-pop as the ids, applied to every column
+        forSequence(std::make_index_sequence<k_columnsCount>{}, [&](auto column)
+            {
+                auto& values = std::get<column>(m_columns);
+                values[denseIndex] = std::move(values.back());
+                values.pop_back();
+            });
+
+        return SparseSetBase<IDType>::removeElement(entity);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    void SparseSet<ElemType, IDType>::clear()
+    {
+        SparseSetBase<IDType>::clear();
+        forSequence(std::make_index_sequence<k_columnsCount>{}, [&](auto column)
+            {
+                std::get<column>(m_columns).clear();
+            });
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    void SparseSet<ElemType, IDType>::reorder(const std::vector<IDType>& order)
+    {
+        forSequence(std::make_index_sequence<k_columnsCount>{}, [&](auto column)
+            {
+                auto& values = std::get<column>(m_columns);
+                std::remove_reference_t<decltype(values)> reordered;
+                reordered.reserve(values.size());
+                for (IDType entity : order)
+                {
+                    reordered.emplace_back(std::move(values[m_sparse[entity]]));
+                }
+                values = std::move(reordered);
+            });
+
+        SparseSetBase<IDType>::reorder(order);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    ConcurrentInserter<ElemType, IDType> SparseSet<ElemType, IDType>::beginConcurrentInsertion(size_t count, IDType idsEnd,
+        const typename ConcurrentInserter<ElemType, IDType>::ParallelFor& parallelFor)
+    {
+        return ConcurrentInserter<ElemType, IDType>(*this, count, idsEnd, parallelFor);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    template <auto... Members>
+    auto SparseSet<ElemType, IDType>::getColumn()
+    {
+        static_assert(findColumn<Members...>() < k_columnsCount, "Member path doesn't match any column");
+        return getColumnAt<findColumn<Members...>()>();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    template <auto... Members>
+    auto SparseSet<ElemType, IDType>::getColumn() const
+    {
+        static_assert(findColumn<Members...>() < k_columnsCount, "Member path doesn't match any column");
+        return getColumnAt<findColumn<Members...>()>();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    template <size_t Column>
+    std::span<typename SparseSet<ElemType, IDType>::template ColumnType<Column>> SparseSet<ElemType, IDType>::getColumnAt()
+    {
+        return std::get<Column>(m_columns);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    template <size_t Column>
+    std::span<const typename SparseSet<ElemType, IDType>::template ColumnType<Column>> SparseSet<ElemType, IDType>::getColumnAt() const
+    {
+        return std::get<Column>(m_columns);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    constexpr size_t SparseSet<ElemType, IDType>::getColumnsCount()
+    {
+        return k_columnsCount;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    template <auto... Members>
+    constexpr size_t SparseSet<ElemType, IDType>::findColumn()
+    {
+        size_t result = k_columnsCount;
+        forSequence(std::make_index_sequence<k_columnsCount>{}, [&](auto column)
+            {
+                using Path = std::remove_cvref_t<decltype(std::get<column>(Layout::k_columnPaths))>;
+                if constexpr (std::is_same_v<Path, ColumnPath<typename Path::Type, decltype(Members)...>>)
+                {
+                    if (std::get<column>(Layout::k_columnPaths).members == std::make_tuple(Members...))
+                    {
+                        result = column;
+                    }
+                }
+            });
+        return result;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    ElemType SparseSet<ElemType, IDType>::gather(size_t index) const
+    {
+        ElemType element{};
+        forSequence(std::make_index_sequence<k_columnsCount>{}, [&](auto column)
+            {
+                auto& leaf = std::get<column>(Layout::k_columnPaths).resolve(element);
+                leaf = static_cast<std::remove_reference_t<decltype(leaf)>>(std::get<column>(m_columns)[index]);
+            });
+        return element;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    void SparseSet<ElemType, IDType>::scatter(size_t index, const ElemType& element)
+    {
+        forSequence(std::make_index_sequence<k_columnsCount>{}, [&](auto column)
+            {
+                std::get<column>(m_columns)[index] = std::get<column>(Layout::k_columnPaths).resolve(element);
+            });
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    size_t SparseSet<ElemType, IDType>::reserveSlots(size_t count, IDType idsEnd)
+    {
+        size_t first = SparseSetBase<IDType>::reserveSlotIds(count, idsEnd);
+        forSequence(std::make_index_sequence<k_columnsCount>{}, [&](auto column)
+            {
+                auto& values = std::get<column>(m_columns);
+                if (values.capacity() < first + count)
+                {
+                    values.reserve(std::max(first + count, values.capacity() * 2));
+                }
+            });
+        return first;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    void SparseSet<ElemType, IDType>::touchSlots(size_t begin, size_t end)
+    {
+        forSequence(std::make_index_sequence<k_columnsCount>{}, [&](auto column)
+            {
+                PageMemory::touch(std::get<column>(m_columns).data() + begin, (end - begin) * sizeof(ColumnType<column>), MemoryArena::Components);
+            });
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    void SparseSet<ElemType, IDType>::constructSlots(size_t end)
+    {
+        forSequence(std::make_index_sequence<k_columnsCount>{}, [&](auto column)
+            {
+                std::get<column>(m_columns).resize(end);
+            });
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    void SparseSet<ElemType, IDType>::storeElement(size_t index, IDType entity, const ElemType& element)
+    {
+        scatter(index, element);
+        SparseSetBase<IDType>::setSlotId(index, entity);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+        requires UseSoAStorage<ElemType>::value
+    void SparseSet<ElemType, IDType>::publishSlots(size_t first)
+    {
+        size_t count = SparseSetBase<IDType>::publishSlotIds(first, [this](size_t from, size_t to)
+            {
+                forSequence(std::make_index_sequence<k_columnsCount>{}, [&](auto column)
+                    {
+                        auto& values = std::get<column>(m_columns);
+                        values[to] = std::move(values[from]);
+                    });
+            });
+
+        forSequence(std::make_index_sequence<k_columnsCount>{}, [&](auto column)
+            {
+                std::get<column>(m_columns).resize(count);
+            });
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+}
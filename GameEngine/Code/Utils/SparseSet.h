@@ -1,9 +1,14 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <concepts>
+#include <functional>
 #include <vector>
 #include <iterator>
 
+#include "PageMemory.h"
+
 namespace Engine::Utils
 {
     template <typename IDType>
@@ -12,15 +17,80 @@ namespace Engine::Utils
     public:
         const std::vector<IDType>& getIds() const;
         bool isPresent(IDType entity) const;
+        size_t getIndex(IDType entity) const; // Dense index of a present entity, for column access
         size_t size() const;
         virtual bool removeElement(IDType id);
         virtual void clear();
+        virtual void reorder(const std::vector<IDType>& order); // order must be a permutation of getIds()
+
+    protected:
+        // Id bookkeeping of the concurrent insertions, the sets add their own dense arrays around it
+        size_t reserveSlotIds(size_t count, IDType idsEnd); // Returns the dense index of the first slot
+        void setSlotId(size_t index, IDType entity);
+
+        template <typename MoveElement>
+        size_t publishSlotIds(size_t first, MoveElement moveElement); // Returns the new size
 
     protected:
+        static constexpr IDType k_emptySlot = static_cast<IDType>(-1);
+
         std::vector<int> m_sparse; // Maps entity ID to index in dense array
         std::vector<IDType> m_denseEntities; // Maps dense index back to entity ID
     };
 
+    template <typename ElemType, typename IDType>
+    class SparseSet;
+
+    /**
+     * @brief      Adds elements to a set from several jobs at once, made by SparseSet::beginConcurrentInsertion.
+     *
+     *             The dense storage of count elements and the sparse entries up to idsEnd
+     *             are reserved up front. Given a parallelFor, the pages of the new slots
+     *             are first written by the jobs before the elements are constructed, so
+     *             Local page memory lands on their NUMA nodes rather than on the node of
+     *             the calling thread. Jobs then claim slots with an atomic cursor. A
+     *             slot and the sparse entry of its entity are only written by the job
+     *             owning them, so no lock is taken. Entities have to be distinct and
+     *             nothing else may use the set until publish(), called once the jobs are
+     *             done, drops the slots left empty and makes the set usable again.
+     */
+    template <typename ElemType, typename IDType>
+    class ConcurrentInserter
+    {
+    public:
+        // Runs job(begin, end) over batches of [0, count) on the worker threads, e.g. with JobsManager::parallelFor
+        using ParallelFor = std::function<void(size_t count, const std::function<void(size_t, size_t)>& job)>;
+
+    public:
+        ConcurrentInserter(SparseSet<ElemType, IDType>& set, size_t count, IDType idsEnd, const ParallelFor& parallelFor = {});
+        ~ConcurrentInserter(); // Publishes if it wasn't done yet
+
+        size_t claim(size_t count); // First of count consecutive slots, for jobs filling them in a known order, those past the reserved ones are refused by insert
+        bool insert(size_t slot, IDType entity, const ElemType& element); // False when the entity already has one
+        bool insert(size_t slot, IDType entity, ElemType&& element);
+
+        // Claims a slot of its own, elements end up in the order the jobs got to them
+        bool addElement(IDType entity, const ElemType& element);
+        bool addElement(IDType entity, ElemType&& element);
+
+        void publish();
+
+    private:
+        bool canInsert(size_t slot, IDType entity) const;
+
+    private:
+        SparseSet<ElemType, IDType>& m_set;
+        size_t m_first = 0; // Dense index of the first reserved slot
+        size_t m_count = 0;
+        IDType m_idsEnd = 0;
+        std::atomic<size_t> m_claimed = 0;
+        bool m_published = false;
+    };
+
+    // Dense component storage, large pools get pages of their own
+    template <typename ElemType>
+    using DenseArray = PageVector<ElemType, MemoryArena::Components>;
+
     template <typename ElemType, typename IDType>
     class SparseSet: public SparseSetBase<IDType> 
     {
@@ -33,21 +103,38 @@ namespace Engine::Utils
 
         bool removeElement(IDType entity) override;
         void clear() override;
+        void reserve(size_t count); // Capacity of the dense arrays, for bulk insertion
+        void reorder(const std::vector<IDType>& order) override;
 
-        const std::vector<ElemType>& getElements() const;
-        std::vector<ElemType>& getElements();
+        // Room for count elements of entities below idsEnd, filled by jobs through the inserter
+        ConcurrentInserter<ElemType, IDType> beginConcurrentInsertion(size_t count, IDType idsEnd,
+            const typename ConcurrentInserter<ElemType, IDType>::ParallelFor& parallelFor = {});
+
+        const DenseArray<ElemType>& getElements() const;
+        DenseArray<ElemType>& getElements();
 
         using SparseSetBase<IDType>::isPresent;
+        using SparseSetBase<IDType>::getIndex;
         using SparseSetBase<IDType>::getIds;
         using SparseSetBase<IDType>::size;
 
     private:
+        friend class ConcurrentInserter<ElemType, IDType>;
+
+        size_t reserveSlots(size_t count, IDType idsEnd); // Capacity only, the new slots are not constructed
+        void touchSlots(size_t begin, size_t end);
+        void constructSlots(size_t end);
+        void storeElement(size_t index, IDType entity, const ElemType& element);
+        void storeElement(size_t index, IDType entity, ElemType&& element);
+        void publishSlots(size_t first);
 
+    private:
         using SparseSetBase<IDType>::m_sparse;
         using SparseSetBase<IDType>::m_denseEntities;
 
-        std::vector<ElemType> m_dense; // Stores the actual components
+        DenseArray<ElemType> m_dense; // Stores the actual components
     };
 }
 
-#include "SparseSet.inl"
\ No newline at end of file
+#include "SparseSet.inl"
+#include "SoASparseSet.h"
\ No newline at end of file
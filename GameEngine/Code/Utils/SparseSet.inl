@@ -110,8 +110,101 @@ namespace Engine::Utils
 
     //////////////////////////////////////////////////////////////////////////
 
+    template<typename ElemType, typename IDType>
+    void SparseSet<ElemType, IDType>::reserve(size_t count)
+    {
+        m_dense.reserve(count);
+        m_denseEntities.reserve(count);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template<typename ElemType, typename IDType>
+    void SparseSet<ElemType, IDType>::reorder(const std::vector<IDType>& order)
+    {
+        DenseArray<ElemType> dense;
+        dense.reserve(m_dense.size());
+        for (IDType entity : order)
+        {
+            dense.emplace_back(std::move(m_dense[m_sparse[entity]]));
+        }
+        m_dense = std::move(dense);
+
+        SparseSetBase<IDType>::reorder(order);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template<typename ElemType, typename IDType>
+    ConcurrentInserter<ElemType, IDType> SparseSet<ElemType, IDType>::beginConcurrentInsertion(size_t count, IDType idsEnd,
+        const typename ConcurrentInserter<ElemType, IDType>::ParallelFor& parallelFor)
+    {
+        return ConcurrentInserter<ElemType, IDType>(*this, count, idsEnd, parallelFor);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template<typename ElemType, typename IDType>
+    size_t SparseSet<ElemType, IDType>::reserveSlots(size_t count, IDType idsEnd)
+    {
+        size_t first = SparseSetBase<IDType>::reserveSlotIds(count, idsEnd);
+        if (m_dense.capacity() < first + count)
+        {
+            m_dense.reserve(std::max(first + count, m_dense.capacity() * 2));
+        }
+        return first;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template<typename ElemType, typename IDType>
+    void SparseSet<ElemType, IDType>::touchSlots(size_t begin, size_t end)
+    {
+        PageMemory::touch(m_dense.data() + begin, (end - begin) * sizeof(ElemType), MemoryArena::Components);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template<typename ElemType, typename IDType>
+    void SparseSet<ElemType, IDType>::constructSlots(size_t end)
+    {
+        m_dense.resize(end);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template<typename ElemType, typename IDType>
+    void SparseSet<ElemType, IDType>::storeElement(size_t index, IDType entity, const ElemType& element)
+    {
+        m_dense[index] = element;
+        SparseSetBase<IDType>::setSlotId(index, entity);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template<typename ElemType, typename IDType>
+    void SparseSet<ElemType, IDType>::storeElement(size_t index, IDType entity, ElemType&& element)
+    {
+        m_dense[index] = std::move(element);
+        SparseSetBase<IDType>::setSlotId(index, entity);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template<typename ElemType, typename IDType>
+    void SparseSet<ElemType, IDType>::publishSlots(size_t first)
+    {
+        size_t count = SparseSetBase<IDType>::publishSlotIds(first, [this](size_t from, size_t to)
+            {
+                m_dense[to] = std::move(m_dense[from]);
+            });
+        m_dense.resize(count);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
     template <typename ElemType, typename IDType>
-    const std::vector<ElemType>& SparseSet<ElemType, IDType>::getElements() const
+    const DenseArray<ElemType>& SparseSet<ElemType, IDType>::getElements() const
     {
         return m_dense;
     }
@@ -119,7 +212,7 @@ namespace Engine::Utils
     //////////////////////////////////////////////////////////////////////////
 
     template <typename ElemType, typename IDType>
-    std::vector<ElemType>& SparseSet<ElemType, IDType>::getElements()
+    DenseArray<ElemType>& SparseSet<ElemType, IDType>::getElements()
     {
         return m_dense;
     }
@@ -134,6 +227,14 @@ namespace Engine::Utils
 
     //////////////////////////////////////////////////////////////////////////
 
+    template <typename IDType>
+    size_t SparseSetBase<IDType>::getIndex(IDType entity) const
+    {
+        return m_sparse[entity];
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
     template <typename IDType>
     size_t SparseSetBase<IDType>::size() const
     {
@@ -177,6 +278,193 @@ namespace Engine::Utils
 
     //////////////////////////////////////////////////////////////////////////
 
+    template<typename IDType>
+    void SparseSetBase<IDType>::reorder(const std::vector<IDType>& order)
+    {
+        m_denseEntities = order;
+        for (size_t i = 0; i < m_denseEntities.size(); i++)
+        {
+            m_sparse[m_denseEntities[i]] = i;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template<typename IDType>
+    size_t SparseSetBase<IDType>::reserveSlotIds(size_t count, IDType idsEnd)
+    {
+        // Sized once here, the jobs only write entries of their own entities afterwards
+        if (m_sparse.size() < static_cast<size_t>(idsEnd))
+        {
+            m_sparse.resize(idsEnd, -1);
+        }
+
+        size_t first = m_denseEntities.size();
+        m_denseEntities.resize(first + count, k_emptySlot);
+        return first;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template<typename IDType>
+    void SparseSetBase<IDType>::setSlotId(size_t index, IDType entity)
+    {
+        m_sparse[entity] = index;
+        m_denseEntities[index] = entity;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template<typename IDType>
+    template<typename MoveElement>
+    size_t SparseSetBase<IDType>::publishSlotIds(size_t first, MoveElement moveElement)
+    {
+        // Slots never filled are closed up, the others keep their order
+        size_t count = first;
+        for (size_t index = first; index < m_denseEntities.size(); index++)
+        {
+            IDType entity = m_denseEntities[index];
+            if (entity == k_emptySlot)
+            {
+                continue;
+            }
+
+            if (index != count)
+            {
+                moveElement(index, count);
+                setSlotId(count, entity);
+            }
+            count++;
+        }
+        m_denseEntities.resize(count);
+
+        while (!m_sparse.empty() && m_sparse[m_sparse.size() - 1] == -1)
+        {
+            m_sparse.pop_back();
+        }
+
+        return count;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+    ConcurrentInserter<ElemType, IDType>::ConcurrentInserter(SparseSet<ElemType, IDType>& set, size_t count, IDType idsEnd, const ParallelFor& parallelFor):
+        m_set(set), m_count(count), m_idsEnd(idsEnd)
+    {
+        m_first = m_set.reserveSlots(count, idsEnd);
+        if (parallelFor)
+        {
+            // Constructing the slots below writes them, the jobs have to get to the new pages first
+            parallelFor(count, [this](size_t begin, size_t end)
+                {
+                    m_set.touchSlots(m_first + begin, m_first + end);
+                });
+        }
+        m_set.constructSlots(m_first + count);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+    ConcurrentInserter<ElemType, IDType>::~ConcurrentInserter()
+    {
+        publish();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+    size_t ConcurrentInserter<ElemType, IDType>::claim(size_t count)
+    {
+        // Jobs only need their own slots to be theirs, what the others wrote is read at publish, after they are done
+        return m_claimed.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+    bool ConcurrentInserter<ElemType, IDType>::insert(size_t slot, IDType entity, const ElemType& element)
+    {
+        if (!canInsert(slot, entity))
+        {
+            return false;
+        }
+
+        m_set.storeElement(m_first + slot, entity, element);
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+    bool ConcurrentInserter<ElemType, IDType>::insert(size_t slot, IDType entity, ElemType&& element)
+    {
+        if (!canInsert(slot, entity))
+        {
+            return false;
+        }
+
+        m_set.storeElement(m_first + slot, entity, std::move(element));
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+    bool ConcurrentInserter<ElemType, IDType>::addElement(IDType entity, const ElemType& element)
+    {
+        // Checked before claiming, so a rejected element doesn't leave a slot to close up
+        if (!canInsert(0, entity))
+        {
+            return false;
+        }
+        return insert(claim(1), entity, element);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+    bool ConcurrentInserter<ElemType, IDType>::addElement(IDType entity, ElemType&& element)
+    {
+        if (!canInsert(0, entity))
+        {
+            return false;
+        }
+        return insert(claim(1), entity, std::move(element));
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+    void ConcurrentInserter<ElemType, IDType>::publish()
+    {
+        if (m_published)
+        {
+            return;
+        }
+
+        m_set.publishSlots(m_first);
+        m_published = true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
+    template <typename ElemType, typename IDType>
+    bool ConcurrentInserter<ElemType, IDType>::canInsert(size_t slot, IDType entity) const
+    {
+        // Past the reserved storage, claims beyond count are refused here
+        if (m_published || slot >= m_count || entity >= m_idsEnd)
+        {
+            return false;
+        }
+
+        // Only the job inserting this entity writes its entry
+        return !m_set.isPresent(entity);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
     template <typename IDType>
     const std::vector<IDType>& SparseSetBase<IDType>::getIds() const
     {
@@ -0,0 +1,129 @@
+#include "Task.h"
+
+#include <exception>
+#include <utility>
+
+namespace Engine::Utils
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	Task Task::promise_type::get_return_object()
+	{
+		return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::suspend_never Task::promise_type::initial_suspend() noexcept
+	{
+		return {};
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Task::FinalAwaiter Task::promise_type::final_suspend() noexcept
+	{
+		return {};
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Task::promise_type::return_void()
+	{
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Task::promise_type::unhandled_exception()
+	{
+		std::terminate();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool Task::FinalAwaiter::await_ready() const noexcept
+	{
+		return false;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::coroutine_handle<> Task::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+	{
+		// The frame stays alive until the owning Task is destroyed, the caller (if any) continues right away
+		std::coroutine_handle<> continuation = handle.promise().continuation;
+		return continuation ? continuation : std::noop_coroutine();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Task::FinalAwaiter::await_resume() const noexcept
+	{
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Task::Task(std::coroutine_handle<promise_type> handle): m_handle(handle)
+	{
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Task::Task(Task&& other) noexcept: m_handle(std::exchange(other.m_handle, nullptr))
+	{
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Task& Task::operator=(Task&& other) noexcept
+	{
+		if (this != &other)
+		{
+			if (m_handle)
+			{
+				m_handle.destroy();
+			}
+			m_handle = std::exchange(other.m_handle, nullptr);
+		}
+		return *this;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Task::~Task()
+	{
+		if (m_handle)
+		{
+			m_handle.destroy();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool Task::isDone() const
+	{
+		return !m_handle || m_handle.done();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool Task::await_ready() const
+	{
+		return isDone();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Task::await_suspend(std::coroutine_handle<> caller)
+	{
+		m_handle.promise().continuation = caller;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Task::await_resume() const
+	{
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <coroutine>
+
+namespace Engine::Utils
+{
+	/**
+	 * @brief      Coroutine type for multi-frame logic.
+	 *
+	 *             The body starts running immediately and continues until the first
+	 *             suspension. Tasks are handed to CoroutinesManager, which resumes
+	 *             them from the frame loop. Awaiting a task from another task resumes
+	 *             the caller once the awaited one finishes.
+	 */
+	class Task
+	{
+	public:
+		struct FinalAwaiter;
+
+		struct promise_type
+		{
+			Task get_return_object();
+			std::suspend_never initial_suspend() noexcept;
+			FinalAwaiter final_suspend() noexcept;
+			void return_void();
+			void unhandled_exception();
+
+			std::coroutine_handle<> continuation;
+		};
+
+		struct FinalAwaiter
+		{
+			bool await_ready() const noexcept;
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+			void await_resume() const noexcept;
+		};
+
+		Task(Task&& other) noexcept;
+		Task& operator=(Task&& other) noexcept;
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+		~Task();
+
+		bool isDone() const;
+
+		bool await_ready() const;
+		void await_suspend(std::coroutine_handle<> caller);
+		void await_resume() const;
+
+	private:
+		explicit Task(std::coroutine_handle<promise_type> handle);
+
+	private:
+		std::coroutine_handle<promise_type> m_handle;
+	};
+}
@@ -0,0 +1,140 @@
+#include "Animation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Engine::Visual
+{
+	namespace
+	{
+		//////////////////////////////////////////////////////////////////////////
+
+		Utils::Vector3 lerp(const Utils::Vector3& from, const Utils::Vector3& to, float weight)
+		{
+			return from + (to - from) * weight;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Close enough to slerp for keys sampled at animation rate and much cheaper
+		Utils::Quaternion nlerp(const Utils::Quaternion& from, const Utils::Quaternion& to, float weight)
+		{
+			float dot = from.real * to.real + from.i * to.i + from.j * to.j + from.k * to.k;
+			float toWeight = dot < 0.0f ? -weight : weight;
+			float fromWeight = 1.0f - weight;
+
+			Utils::Quaternion result(
+				from.real * fromWeight + to.real * toWeight,
+				from.i * fromWeight + to.i * toWeight,
+				from.j * fromWeight + to.j * toWeight,
+				from.k * fromWeight + to.k * toWeight);
+
+			float length = std::sqrt(result.real * result.real + result.i * result.i + result.j * result.j + result.k * result.k);
+			if (length > 0.0f)
+			{
+				result.real /= length;
+				result.i /= length;
+				result.j /= length;
+				result.k /= length;
+			}
+			return result;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		Utils::Vector3 getVector(const float* values)
+		{
+			return Utils::Vector3(values[0], values[1], values[2]);
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		Utils::Quaternion getQuaternion(const float* values)
+		{
+			return Utils::Quaternion(values[3], values[0], values[1], values[2]);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void blendPoses(const Pose& from, const Pose& to, float weight, Pose& result)
+	{
+		size_t count = std::min(from.size(), to.size());
+		result.resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			result[i].translation = lerp(from[i].translation, to[i].translation, weight);
+			result[i].rotation = nlerp(from[i].rotation, to[i].rotation, weight);
+			result[i].scale = lerp(from[i].scale, to[i].scale, weight);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t Skeleton::getJointCount() const
+	{
+		return joints.size();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void Skeleton::computeSkinningMatrices(const Pose& pose, std::vector<Utils::Matrix4>& globals, std::vector<Utils::Matrix4>& palette) const
+	{
+		globals.resize(joints.size());
+		palette.resize(joints.size());
+		for (size_t i = 0; i < joints.size(); i++)
+		{
+			const Joint& joint = joints[i];
+			const JointPose& local = i < pose.size() ? pose[i] : bindPose[i];
+
+			Utils::Matrix4 localMatrix = Utils::Matrix4::fromTRS(local.translation, local.rotation, local.scale);
+			if (joint.hasOffset)
+			{
+				localMatrix = joint.offsetTransform * localMatrix;
+			}
+
+			globals[i] = joint.parent >= 0 ? globals[joint.parent] * localMatrix : localMatrix;
+			palette[i] = globals[i] * joint.inverseBindMatrix;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void AnimationClip::sample(float time, Pose& pose) const
+	{
+		for (const Track& track : tracks)
+		{
+			if (track.joint >= pose.size() || track.times.empty())
+			{
+				continue;
+			}
+
+			// Times before the first key or after the last one clamp to it
+			size_t nextKey = std::upper_bound(track.times.begin(), track.times.end(), time) - track.times.begin();
+			size_t key = nextKey > 0 ? nextKey - 1 : 0;
+			nextKey = std::min(nextKey, track.times.size() - 1);
+
+			float weight = 0.0f;
+			if (!track.step && nextKey > key)
+			{
+				weight = (time - track.times[key]) / (track.times[nextKey] - track.times[key]);
+			}
+
+			JointPose& jointPose = pose[track.joint];
+			switch (track.path)
+			{
+			case TrackPath::Translation:
+				jointPose.translation = lerp(getVector(&track.values[key * 3]), getVector(&track.values[nextKey * 3]), weight);
+				break;
+			case TrackPath::Rotation:
+				jointPose.rotation = nlerp(getQuaternion(&track.values[key * 4]), getQuaternion(&track.values[nextKey * 4]), weight);
+				break;
+			case TrackPath::Scale:
+				jointPose.scale = lerp(getVector(&track.values[key * 3]), getVector(&track.values[nextKey * 3]), weight);
+				break;
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
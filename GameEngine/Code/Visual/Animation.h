@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Utils/Matrix.h"
+#include "Utils/Quaternion.h"
+
+namespace Engine::Visual
+{
+    // Local transform of one joint, relative to its parent
+    struct JointPose
+    {
+        Utils::Vector3 translation;
+        Utils::Quaternion rotation;
+        Utils::Vector3 scale = Utils::Vector3(1.0f);
+    };
+
+    using Pose = std::vector<JointPose>;
+
+    // Lerp of translations and scales, normalized lerp of rotations along the shortest arc
+    void blendPoses(const Pose& from, const Pose& to, float weight, Pose& result);
+
+    class Skeleton
+    {
+    public:
+        struct Joint
+        {
+            std::string name;
+            int parent = -1; // Always lower than the joint index, so one forward pass resolves the hierarchy
+            Utils::Matrix4 inverseBindMatrix;
+            Utils::Matrix4 offsetTransform; // Non joint nodes between the joint and its parent joint (or the scene root)
+            bool hasOffset = false;
+        };
+
+        std::vector<Joint> joints;
+        Pose bindPose;
+
+        size_t getJointCount() const;
+
+        // Skinning matrices (global * inverse bind) of a local pose, globals is scratch space of the caller
+        void computeSkinningMatrices(const Pose& pose, std::vector<Utils::Matrix4>& globals, std::vector<Utils::Matrix4>& palette) const;
+    };
+
+    class AnimationClip
+    {
+    public:
+        enum class TrackPath
+        {
+            Translation,
+            Rotation,
+            Scale
+        };
+
+        struct Track
+        {
+            size_t joint = 0;
+            TrackPath path = TrackPath::Translation;
+            bool step = false;
+            std::vector<float> times;
+            std::vector<float> values; // 3 floats per key, 4 for rotations (x, y, z, w)
+        };
+
+        std::string name;
+        float duration = 0.0f;
+        std::vector<Track> tracks;
+
+        // Overwrites the animated parts of the pose, the others keep their values
+        void sample(float time, Pose& pose) const;
+    };
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "Utils/Matrix.h"
+
+namespace Engine::Visual
+{
+    // Utils::Matrix4 is stored row by row and glm column by column, both for column vectors
+    inline glm::mat4 toGlmMatrix(const Utils::Matrix4& matrix)
+    {
+        glm::mat4 result;
+        for (int row = 0; row < 4; row++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                result[column][row] = matrix.m[row][column];
+            }
+        }
+        return result;
+    }
+
+    // Camera matrices are left-handed. The OpenGL and Vulkan shaders work in the right-handed view space
+    // glm::lookAt gives, which is the left-handed one with x and z negated.
+    inline glm::mat4 toRightHandedView(const Utils::Matrix4& view)
+    {
+        Utils::Matrix4 result = view;
+        for (int column = 0; column < 4; column++)
+        {
+            result.m[0][column] = -result.m[0][column];
+            result.m[2][column] = -result.m[2][column];
+        }
+        return toGlmMatrix(result);
+    }
+
+    /**
+     * @brief      Converts a camera projection to be applied after toRightHandedView.
+     *
+     *             Gives the same clip space as glm::perspective, x included, so
+     *             the image matches what these backends always showed.
+     *
+     * @param[in]  projection             The left-handed projection, depth in [0, 1].
+     * @param[in]  negativeOneToOneDepth  Remaps the depth to [-1, 1] for OpenGL.
+     */
+    inline glm::mat4 toRightHandedProjection(const Utils::Matrix4& projection, bool negativeOneToOneDepth)
+    {
+        Utils::Matrix4 result = projection;
+        for (int row = 0; row < 4; row++)
+        {
+            result.m[row][0] = -result.m[row][0];
+            result.m[row][2] = -result.m[row][2];
+        }
+
+        for (int column = 0; column < 4; column++)
+        {
+            result.m[0][column] = -result.m[0][column];
+            if (negativeOneToOneDepth)
+            {
+                result.m[2][column] = 2.0f * result.m[2][column] - result.m[3][column];
+            }
+        }
+        return toGlmMatrix(result);
+    }
+}
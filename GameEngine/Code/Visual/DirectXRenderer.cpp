@@ -4,20 +4,47 @@
 #include <d3dcompiler.h>
 #include <fstream>
 #include <sstream>
-#include <filesystem>
+#include <algorithm>
+#include <cstring>
 
-#include "tiny_obj_loader.h"
+#include "stb_image.h"
 #include "Utils/DebugMacros.h"
 
 namespace Engine::Visual
 {
 	////////////////////////////////////////////////////////////////////////
 
+	void DirectXRenderer::setFramePacing(const FramePacing& framePacing)
+	{
+		m_framePacing = framePacing;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void DirectXRenderer::setDepthPrePass(bool enabled)
+	{
+		m_depthPrePass = enabled;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void DirectXRenderer::setTextureStreaming(const TextureStreaming& settings, JobsManager& jobsManager)
+	{
+		m_textureStreamer.init(settings, &jobsManager, STBI_rgb_alpha);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
 	void DirectXRenderer::init(const Window& window)
 	{
 		createDeviceAndSwapChain(window.getHandle());
 		createRenderTarget(window.getHandle());
 		createShaders();
+		if (m_depthPrePass)
+		{
+			createDepthPrePassShaders();
+		}
+		createParticleResources();
 		createViewport(window.getHandle());
 		createDefaultMaterial();
 	}
@@ -26,6 +53,11 @@ namespace Engine::Visual
 
 	void DirectXRenderer::clearBackground(float r, float g, float b, float a)
 	{
+		if (m_textureStreamer.isEnabled())
+		{
+			updateStreamedTextures();
+		}
+
 		// Clear the render target with a solid color
 		float clearColor[] = {r, g, b, a }; // RGBA
 		m_deviceContext->ClearRenderTargetView(m_renderTargetView.Get(), clearColor);
@@ -43,10 +75,50 @@ namespace Engine::Visual
 			return;
 		}
 
-		ModelData& modelData = modelItr->second;
-
+		const ModelData& modelData = modelItr->second;
 		XMMATRIX worldMatrix = getWorldMatrix(position, rotation, scale);
+		ID3D11Buffer* instanceVertexBuffer = getInstanceVertexBuffer(model);
+		m_textureStreamer.onDraw(model.GetId(), position, scale);
+
+		if (m_depthPrePass)
+		{
+			m_drawCommands.push_back({ &modelData, instanceVertexBuffer, worldMatrix });
+			return;
+		}
 
+		drawModel(modelData, instanceVertexBuffer, worldMatrix);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void DirectXRenderer::drawParticles(const ParticleInstance* particles, size_t count)
+	{
+		m_particles.insert(m_particles.end(), particles, particles + count);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void DirectXRenderer::render()
+	{
+		if (!m_drawCommands.empty())
+		{
+			renderDrawCommands();
+		}
+
+		if (!m_particles.empty())
+		{
+			renderParticles();
+		}
+
+		// Present the frame, flip model swapchains without tearing behave like mailbox with sync interval 0
+		UINT syncInterval = m_framePacing.getPresentMode() == PresentMode::VSync ? 1 : 0;
+		m_swapChain->Present(syncInterval, 0);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void DirectXRenderer::updateConstantBuffer(const XMMATRIX& worldMatrix)
+	{
 		ConstantBuffer cb{};
 		cb.worldMatrix = XMMatrixTranspose(worldMatrix);
 		cb.viewMatrix = XMMatrixTranspose(m_viewMatrix);
@@ -55,8 +127,15 @@ namespace Engine::Visual
 
 		m_deviceContext->VSSetConstantBuffers(0, 1, m_constantBuffer.GetAddressOf());
 		m_deviceContext->PSSetConstantBuffers(0, 1, m_constantBuffer.GetAddressOf());
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void DirectXRenderer::drawModel(const ModelData& modelData, ID3D11Buffer* instanceVertexBuffer, const XMMATRIX& worldMatrix)
+	{
+		updateConstantBuffer(worldMatrix);
 
-		for (Material& material : modelData.materials)
+		for (const Material& material : modelData.materials)
 		{
 			MaterialBuffer mb{};
 			mb.ambientColor = material.ambientColor;
@@ -68,7 +147,8 @@ namespace Engine::Visual
 
 		UINT stride = sizeof(Vertex);
 		UINT offset = 0;
-		m_deviceContext->IASetVertexBuffers(0, 1, modelData.vertexBuffer.GetAddressOf(), &stride, &offset);
+		ID3D11Buffer* vertexBuffer = instanceVertexBuffer ? instanceVertexBuffer : modelData.vertexBuffer.Get();
+		m_deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
 		m_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 		m_deviceContext->PSSetSamplers(0, 1, m_samplerState.GetAddressOf());
@@ -87,8 +167,8 @@ namespace Engine::Visual
 			for (size_t meshIndex : meshIndices)
 			{
 				const SubMesh& mesh = modelData.meshes[meshIndex];
-				m_deviceContext->IASetIndexBuffer(mesh.indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
-				m_deviceContext->DrawIndexed(mesh.indices.size(), 0, 0);
+				m_deviceContext->IASetIndexBuffer(mesh.indexBuffer.Get(), mesh.indexFormat, 0);
+				m_deviceContext->DrawIndexed(mesh.indexCount, 0, mesh.baseVertex);
 			}
 		}
 
@@ -96,10 +176,129 @@ namespace Engine::Visual
 
 	////////////////////////////////////////////////////////////////////////
 
-	void DirectXRenderer::render()
+	void DirectXRenderer::drawModelDepth(const ModelData& modelData, ID3D11Buffer* instanceVertexBuffer, const XMMATRIX& worldMatrix)
 	{
-		// Present the frame
-		m_swapChain->Present(0, 0);
+		updateConstantBuffer(worldMatrix);
+
+		// Positions come first in Vertex, so the depth layout reads instance streams with the full stride
+		UINT stride = instanceVertexBuffer ? sizeof(Vertex) : sizeof(XMFLOAT3);
+		UINT offset = 0;
+		ID3D11Buffer* vertexBuffer = instanceVertexBuffer ? instanceVertexBuffer : modelData.positionBuffer.Get();
+		m_deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+
+		for (const SubMesh& mesh : modelData.meshes)
+		{
+			m_deviceContext->IASetIndexBuffer(mesh.indexBuffer.Get(), mesh.indexFormat, 0);
+			m_deviceContext->DrawIndexed(mesh.indexCount, 0, mesh.baseVertex);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void DirectXRenderer::renderDrawCommands()
+	{
+		m_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+		// Depth only pass, without a pixel shader nothing but depth is written
+		m_deviceContext->IASetInputLayout(m_depthInputLayout.Get());
+		m_deviceContext->VSSetShader(m_depthVertexShader.Get(), nullptr, 0);
+		m_deviceContext->PSSetShader(nullptr, nullptr, 0);
+		m_deviceContext->OMSetDepthStencilState(m_depthStencilState.Get(), 1);
+		for (const DrawCommand& command : m_drawCommands)
+		{
+			drawModelDepth(*command.model, command.instanceVertexBuffer, command.worldMatrix);
+		}
+
+		// Shading pass, only the nearest fragment of each pixel passes the equal test
+		m_deviceContext->IASetInputLayout(m_inputLayout.Get());
+		m_deviceContext->VSSetShader(m_vertexShader.Get(), nullptr, 0);
+		m_deviceContext->PSSetShader(m_pixelShader.Get(), nullptr, 0);
+		m_deviceContext->OMSetDepthStencilState(m_depthEqualState.Get(), 1);
+		for (const DrawCommand& command : m_drawCommands)
+		{
+			drawModel(*command.model, command.instanceVertexBuffer, command.worldMatrix);
+		}
+
+		m_drawCommands.clear();
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void DirectXRenderer::renderParticles()
+	{
+		auto renderStart = std::chrono::high_resolution_clock::now();
+
+		if (m_particles.size() > m_particleBufferCapacity)
+		{
+			D3D11_BUFFER_DESC bufferDesc = {};
+			bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+			bufferDesc.ByteWidth = (UINT)(m_particles.size() * sizeof(ParticleInstance));
+			bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+			bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+			m_particleBuffer.Reset();
+			HRESULT hr = m_device->CreateBuffer(&bufferDesc, nullptr, m_particleBuffer.GetAddressOf());
+			ASSERT(!FAILED(hr), "Can't create particle buffer, error code: {}", hr);
+			if (FAILED(hr))
+			{
+				m_particleBufferCapacity = 0;
+				m_particles.clear();
+				return;
+			}
+			m_particleBufferCapacity = m_particles.size();
+		}
+
+		// Discarding hands out fresh memory, the draws of the previous frame keep reading the old one
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		HRESULT hr = m_deviceContext->Map(m_particleBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+		ASSERT(!FAILED(hr), "Can't map particle buffer, error code: {}", hr);
+		if (FAILED(hr))
+		{
+			m_particles.clear();
+			return;
+		}
+		std::memcpy(mapped.pData, m_particles.data(), m_particles.size() * sizeof(ParticleInstance));
+		m_deviceContext->Unmap(m_particleBuffer.Get(), 0);
+
+		ComPtr<ID3D11RasterizerState> rasterizerState;
+		m_deviceContext->RSGetState(rasterizerState.GetAddressOf());
+
+		// Transparent and unsorted, particles are tested against the scene depth but don't write it
+		updateConstantBuffer(XMMatrixIdentity());
+		UINT stride = sizeof(ParticleInstance);
+		UINT offset = 0;
+		m_deviceContext->IASetVertexBuffers(0, 1, m_particleBuffer.GetAddressOf(), &stride, &offset);
+		m_deviceContext->IASetInputLayout(m_particleInputLayout.Get());
+		m_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+		m_deviceContext->VSSetShader(m_particleVertexShader.Get(), nullptr, 0);
+		m_deviceContext->PSSetShader(m_particlePixelShader.Get(), nullptr, 0);
+		m_deviceContext->OMSetBlendState(m_particleBlendState.Get(), nullptr, 0xffffffff);
+		m_deviceContext->OMSetDepthStencilState(m_particleDepthState.Get(), 1);
+		m_deviceContext->RSSetState(m_particleRasterizerState.Get());
+
+		m_deviceContext->DrawInstanced(4, (UINT)m_particles.size(), 0, 0);
+
+		m_deviceContext->RSSetState(rasterizerState.Get());
+		m_deviceContext->OMSetDepthStencilState(m_depthStencilState.Get(), 1);
+		m_deviceContext->OMSetBlendState(nullptr, nullptr, 0xffffffff);
+		m_deviceContext->IASetInputLayout(m_inputLayout.Get());
+		m_deviceContext->VSSetShader(m_vertexShader.Get(), nullptr, 0);
+		m_deviceContext->PSSetShader(m_pixelShader.Get(), nullptr, 0);
+
+		m_particleStats.renderedFrames++;
+		m_particleStats.renderedParticles += m_particles.size();
+		m_particleStats.renderTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - renderStart).count();
+		m_particles.clear();
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void DirectXRenderer::waitForNextFrame()
+	{
+		if (m_frameLatencyWaitableObject)
+		{
+			WaitForSingleObjectEx(m_frameLatencyWaitableObject, 1000, TRUE);
+		}
 	}
 
 	////////////////////////////////////////////////////////////////////////
@@ -107,13 +306,24 @@ namespace Engine::Visual
 	// Create the Direct3D device, swap chain, and device context
 	void DirectXRenderer::createDeviceAndSwapChain(HWND hwnd)
 	{
+		// Mailbox and waitable swapchains need the flip model, which doesn't allow sRGB back buffers, so the view is sRGB instead
+		bool useFlipModel = m_framePacing.waitableSwapchain || m_framePacing.getPresentMode() == PresentMode::Mailbox;
+
 		DXGI_SWAP_CHAIN_DESC swapChainDesc = {};
-		swapChainDesc.BufferCount = 1;
-		swapChainDesc.BufferDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+		swapChainDesc.BufferCount = useFlipModel ? std::max(m_framePacing.framesInFlight, 2) : 1;
+		swapChainDesc.BufferDesc.Format = useFlipModel ? DXGI_FORMAT_B8G8R8A8_UNORM : DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
 		swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
 		swapChainDesc.OutputWindow = hwnd;
 		swapChainDesc.SampleDesc.Count = 1;
 		swapChainDesc.Windowed = TRUE;
+		if (useFlipModel)
+		{
+			swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+		}
+		if (m_framePacing.waitableSwapchain)
+		{
+			swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+		}
 
 		D3D_FEATURE_LEVEL featureLevels[] = { D3D_FEATURE_LEVEL_11_0 };
 		HRESULT hr = D3D11CreateDeviceAndSwapChain(
@@ -132,6 +342,31 @@ namespace Engine::Visual
 		);
 
 		ASSERT(!FAILED(hr), "Can't create device and swapchain, error code: {}", hr);
+		if (FAILED(hr))
+		{
+			return;
+		}
+
+		if (m_framePacing.waitableSwapchain)
+		{
+			ComPtr<IDXGISwapChain2> swapChain2;
+			hr = m_swapChain.As(&swapChain2);
+			ASSERT(!FAILED(hr), "Waitable swapchain requires IDXGISwapChain2, error code: {}", hr);
+			if (!FAILED(hr))
+			{
+				swapChain2->SetMaximumFrameLatency(m_framePacing.framesInFlight);
+				m_frameLatencyWaitableObject = swapChain2->GetFrameLatencyWaitableObject();
+				return;
+			}
+		}
+
+		ComPtr<IDXGIDevice1> dxgiDevice;
+		hr = m_device.As(&dxgiDevice);
+		ASSERT(!FAILED(hr), "Can't get DXGI device, error code: {}", hr);
+		if (!FAILED(hr))
+		{
+			dxgiDevice->SetMaximumFrameLatency(m_framePacing.framesInFlight);
+		}
 	}
 
 	////////////////////////////////////////////////////////////////////////
@@ -140,7 +375,10 @@ namespace Engine::Visual
 	{
 		ComPtr<ID3D11Texture2D> backBuffer;
 		m_swapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer));
-		m_device->CreateRenderTargetView(backBuffer.Get(), nullptr, m_renderTargetView.GetAddressOf());
+		D3D11_RENDER_TARGET_VIEW_DESC renderTargetViewDesc = {};
+		renderTargetViewDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+		renderTargetViewDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+		m_device->CreateRenderTargetView(backBuffer.Get(), &renderTargetViewDesc, m_renderTargetView.GetAddressOf());
 
 		RECT rect;
 		GetClientRect(hwnd, &rect);
@@ -225,12 +463,87 @@ namespace Engine::Visual
 		depthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
 		depthStencilDesc.DepthFunc = D3D11_COMPARISON_LESS;
 
-		ComPtr<ID3D11DepthStencilState> depthStencilState;
-		hr = m_device->CreateDepthStencilState(&depthStencilDesc, depthStencilState.GetAddressOf());
+		hr = m_device->CreateDepthStencilState(&depthStencilDesc, m_depthStencilState.GetAddressOf());
 		ASSERT(!FAILED(hr), "Can't create depth stencil state, error code: {}", hr);
 
 		// Set the depth stencil state
-		m_deviceContext->OMSetDepthStencilState(depthStencilState.Get(), 1);
+		m_deviceContext->OMSetDepthStencilState(m_depthStencilState.Get(), 1);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void DirectXRenderer::createDepthPrePassShaders()
+	{
+		auto vsBytecode = Utils::loadBytesFromFile("DepthVertexShader.cso");
+
+		HRESULT hr = m_device->CreateVertexShader(vsBytecode.data(), vsBytecode.size(), nullptr, m_depthVertexShader.GetAddressOf());
+		ASSERT(!FAILED(hr), "Can't create depth vertex shader, error code: {}", hr);
+
+		D3D11_INPUT_ELEMENT_DESC layout[] = {
+			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+		};
+		hr = m_device->CreateInputLayout(layout, ARRAYSIZE(layout), vsBytecode.data(), vsBytecode.size(), m_depthInputLayout.GetAddressOf());
+		ASSERT(!FAILED(hr), "Can't create depth input layout, error code: {}", hr);
+
+		// The shading pass reuses the pre-pass depth, so it neither writes nor accepts anything but an exact match
+		D3D11_DEPTH_STENCIL_DESC depthStencilDesc;
+		ZeroMemory(&depthStencilDesc, sizeof(D3D11_DEPTH_STENCIL_DESC));
+		depthStencilDesc.DepthEnable = TRUE;
+		depthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+		depthStencilDesc.DepthFunc = D3D11_COMPARISON_EQUAL;
+
+		hr = m_device->CreateDepthStencilState(&depthStencilDesc, m_depthEqualState.GetAddressOf());
+		ASSERT(!FAILED(hr), "Can't create depth equal state, error code: {}", hr);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void DirectXRenderer::createParticleResources()
+	{
+		auto vsBytecode = Utils::loadBytesFromFile("ParticleVertexShader.cso");
+		auto psBytecode = Utils::loadBytesFromFile("ParticlePixelShader.cso");
+
+		HRESULT hr = m_device->CreateVertexShader(vsBytecode.data(), vsBytecode.size(), nullptr, m_particleVertexShader.GetAddressOf());
+		ASSERT(!FAILED(hr), "Can't create particle vertex shader, error code: {}", hr);
+
+		hr = m_device->CreatePixelShader(psBytecode.data(), psBytecode.size(), nullptr, m_particlePixelShader.GetAddressOf());
+		ASSERT(!FAILED(hr), "Can't create particle pixel shader, error code: {}", hr);
+
+		// Both elements advance once per instance, the quad corners come from SV_VertexID
+		D3D11_INPUT_ELEMENT_DESC layout[] = {
+			{ "POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, offsetof(ParticleInstance, position), D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+			{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, offsetof(ParticleInstance, color), D3D11_INPUT_PER_INSTANCE_DATA, 1 }
+		};
+		hr = m_device->CreateInputLayout(layout, ARRAYSIZE(layout), vsBytecode.data(), vsBytecode.size(), m_particleInputLayout.GetAddressOf());
+		ASSERT(!FAILED(hr), "Can't create particle input layout, error code: {}", hr);
+
+		D3D11_BLEND_DESC blendDesc = {};
+		blendDesc.RenderTarget[0].BlendEnable = TRUE;
+		blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+		blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+		blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+		blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+		blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+		blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+		blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+		hr = m_device->CreateBlendState(&blendDesc, m_particleBlendState.GetAddressOf());
+		ASSERT(!FAILED(hr), "Can't create particle blend state, error code: {}", hr);
+
+		D3D11_DEPTH_STENCIL_DESC depthStencilDesc;
+		ZeroMemory(&depthStencilDesc, sizeof(D3D11_DEPTH_STENCIL_DESC));
+		depthStencilDesc.DepthEnable = TRUE;
+		depthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+		depthStencilDesc.DepthFunc = D3D11_COMPARISON_LESS;
+		hr = m_device->CreateDepthStencilState(&depthStencilDesc, m_particleDepthState.GetAddressOf());
+		ASSERT(!FAILED(hr), "Can't create particle depth stencil state, error code: {}", hr);
+
+		D3D11_RASTERIZER_DESC rasterizerDesc;
+		ZeroMemory(&rasterizerDesc, sizeof(D3D11_RASTERIZER_DESC));
+		rasterizerDesc.CullMode = D3D11_CULL_NONE;
+		rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+		rasterizerDesc.DepthClipEnable = TRUE;
+		hr = m_device->CreateRasterizerState(&rasterizerDesc, m_particleRasterizerState.GetAddressOf());
+		ASSERT(!FAILED(hr), "Can't create particle rasterizer state, error code: {}", hr);
 	}
 
 	////////////////////////////////////////////////////////////////////////
@@ -252,19 +565,39 @@ namespace Engine::Visual
 			return false;
 		}
 
-		for (Material& material : model.materials)
+		if (m_depthPrePass)
 		{
-			D3D11_BUFFER_DESC cbDesc = {};
-			cbDesc.Usage = D3D11_USAGE_DEFAULT;
-			cbDesc.ByteWidth = sizeof(MaterialBuffer);
-			cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-			cbDesc.CPUAccessFlags = 0;
-			HRESULT hr = m_device->CreateBuffer(&cbDesc, nullptr, material.materialBuffer.GetAddressOf());
-			ASSERT(!FAILED(hr), "Can't create constant buffer, error code: {}", hr);
+			std::vector<XMFLOAT3> positions;
+			positions.reserve(model.vertices.size());
+			for (const Vertex& vertex : model.vertices)
+			{
+				positions.push_back(vertex.position);
+			}
+
+			D3D11_BUFFER_DESC positionBufferDesc = {};
+			positionBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+			positionBufferDesc.ByteWidth = sizeof(XMFLOAT3) * positions.size();
+			positionBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+			D3D11_SUBRESOURCE_DATA positionData = {};
+			positionData.pSysMem = positions.data();
+			hr = m_device->CreateBuffer(&positionBufferDesc, &positionData, model.positionBuffer.GetAddressOf());
+			ASSERT(!FAILED(hr), "Can't create position buffer, error code: {}", hr);
+			if (FAILED(hr))
+			{
+				return false;
+			}
+		}
+
+		if (!createMaterialBuffers(model))
+		{
+			return false;
 		}
 
 		for (SubMesh& subMesh: model.meshes)
 		{
+			subMesh.indexCount = static_cast<UINT>(subMesh.indices.size());
+
 			// Create the index buffer for this sub-mesh
 			D3D11_BUFFER_DESC indexBufferDesc = {};
 			indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
@@ -288,6 +621,68 @@ namespace Engine::Visual
 
 	////////////////////////////////////////////////////////////////////////
 
+	bool DirectXRenderer::createMaterialBuffers(ModelData& model)
+	{
+		for (Material& material : model.materials)
+		{
+			D3D11_BUFFER_DESC cbDesc = {};
+			cbDesc.Usage = D3D11_USAGE_DEFAULT;
+			cbDesc.ByteWidth = sizeof(MaterialBuffer);
+			cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+			cbDesc.CPUAccessFlags = 0;
+			HRESULT hr = m_device->CreateBuffer(&cbDesc, nullptr, material.materialBuffer.GetAddressOf());
+			ASSERT(!FAILED(hr), "Can't create constant buffer, error code: {}", hr);
+			if (FAILED(hr))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool DirectXRenderer::createBufferFromRanges(UINT bindFlags, const std::vector<GltfModel::BufferRange>& ranges, ComPtr<ID3D11Buffer>& buffer)
+	{
+		size_t totalSize = 0;
+		for (const GltfModel::BufferRange& range : ranges)
+		{
+			totalSize += range.size;
+		}
+
+		D3D11_BUFFER_DESC bufferDesc = {};
+		bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+		bufferDesc.ByteWidth = static_cast<UINT>(totalSize);
+		bufferDesc.BindFlags = bindFlags;
+
+		// A single range is passed as the initial data, several are copied one after another
+		D3D11_SUBRESOURCE_DATA initialData = {};
+		initialData.pSysMem = ranges.size() == 1 ? ranges[0].data : nullptr;
+
+		HRESULT hr = m_device->CreateBuffer(&bufferDesc, initialData.pSysMem ? &initialData : nullptr, buffer.GetAddressOf());
+		ASSERT(!FAILED(hr), "Can't create buffer, error code: {}", hr);
+		if (FAILED(hr))
+		{
+			return false;
+		}
+
+		if (ranges.size() > 1)
+		{
+			UINT offset = 0;
+			for (const GltfModel::BufferRange& range : ranges)
+			{
+				D3D11_BOX box = { offset, 0, 0, offset + static_cast<UINT>(range.size), 1, 1 };
+				m_deviceContext->UpdateSubresource(buffer.Get(), 0, &box, range.data, 0, 0);
+				offset += static_cast<UINT>(range.size);
+			}
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
 	const ComPtr<ID3D11ShaderResourceView>& DirectXRenderer::getTexture(const std::string& textureId) const
 	{
 		const auto& textureItr = m_textures.find(textureId);
@@ -310,6 +705,24 @@ namespace Engine::Visual
 
 	////////////////////////////////////////////////////////////////////////
 
+	ID3D11Buffer* DirectXRenderer::getInstanceVertexBuffer(const IModelInstance& modelInstance) const
+	{
+		const auto& bufferItr = m_instanceVertexBuffers.find(&modelInstance);
+		return bufferItr != m_instanceVertexBuffers.end() ? bufferItr->second.Get() : nullptr;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	ModelSource::Options DirectXRenderer::getModelSourceOptions() const
+	{
+		ModelSource::Options options;
+		options.positionStream = m_depthPrePass;
+		options.flipTexCoordV = true;
+		return options;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
 	bool DirectXRenderer::loadModel(const std::string& filename)
 	{
 		if (m_models.contains(filename))
@@ -317,15 +730,38 @@ namespace Engine::Visual
 			return true;
 		}
 
-		ModelData modelData;
-		if (!loadModelFromFile(modelData, filename))
+		ModelSource source;
+		return source.load(filename, getModelSourceOptions()) && loadModel(filename, source);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool DirectXRenderer::loadModel(const std::string& filename, const ModelSource& source)
+	{
+		if (m_models.contains(filename))
 		{
-			return false;
+			return true;
 		}
 
-		if (!createBuffersForModel(modelData))
+		ModelData modelData;
+		if (source.isGltf())
 		{
-			return false;
+			if (!loadModelFromGltf(modelData, source.getGltf(), filename))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			if (!loadModelFromFile(modelData, source.getObj(), filename))
+			{
+				return false;
+			}
+
+			if (!createBuffersForModel(modelData))
+			{
+				return false;
+			}
 		}
 
 		m_models.emplace(filename, std::move(modelData));
@@ -341,6 +777,17 @@ namespace Engine::Visual
 			return true;
 		}
 
+		auto loadStart = std::chrono::high_resolution_clock::now();
+
+		// Streamed textures start at a reduced level, their source is decoded again when finer ones are needed
+		if (m_textureStreamer.isEnabled() && filename != DEFAULT_TEXTURE)
+		{
+			TextureStreamer::Upload upload;
+			bool added = m_textureStreamer.addTexture(filename, filename, upload);
+			ASSERT(added, "Can't load texture: {}", filename);
+			return added && createTexture(filename, upload.pixels.data(), upload.width, upload.height, loadStart);
+		}
+
 		ComPtr<ID3D11ShaderResourceView> texture;
 		HRESULT hr = DirectX::CreateWICTextureFromFile(m_device.Get(), m_deviceContext.Get(), Utils::stringToWString(filename).c_str(), nullptr, texture.GetAddressOf());
 		ASSERT(!FAILED(hr), "Can't load texture: {}", filename);
@@ -349,114 +796,252 @@ namespace Engine::Visual
 			return false;
 		}
 
-		m_textures.emplace(filename, std::move(texture));
+		addTexture(filename, std::move(texture), loadStart);
 		return true;
 	}
 
 	////////////////////////////////////////////////////////////////////////
 
-	bool DirectXRenderer::loadModelFromFile(ModelData& model, const std::string& filename)
+	bool DirectXRenderer::loadModelFromFile(ModelData& model, const ObjModel& obj, const std::string& filename)
 	{
-		tinyobj::attrib_t attrib;
-		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
-		std::string warn, err;
+		static_assert(sizeof(Vertex) == sizeof(GltfModel::Vertex), "Vertex layout must match the model loaders");
 
-		std::filesystem::path fullPath(filename);
-		std::filesystem::path matDir = fullPath.parent_path();
-		bool res = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename.c_str(), matDir.string().c_str());
-		ASSERT(res, "Can't load model: {}", filename);
-		if (!res) 
+		for (const ObjModel::Material& objMaterial : obj.getMaterials())
 		{
-			return false;
+			Material matX;
+			matX.ambientColor = XMFLOAT3(objMaterial.ambientColor);
+			matX.diffuseColor = XMFLOAT3(objMaterial.diffuseColor);
+			matX.shininess = objMaterial.shininess;
+			matX.specularColor = XMFLOAT3(objMaterial.specularColor);
+			matX.diffuseTextureId = !objMaterial.diffuseTexture.empty() && loadTexture(objMaterial.diffuseTexture) ?
+				objMaterial.diffuseTexture : m_defaultMaterial.diffuseTextureId;
+			model.materials.emplace_back(matX);
 		}
 
-		for (const tinyobj::material_t& mat : materials)
+		const std::vector<GltfModel::Vertex>& vertices = obj.getVertices();
+		model.vertices.resize(vertices.size());
+		std::memcpy(model.vertices.data(), vertices.data(), vertices.size() * sizeof(Vertex));
+
+		for (const ObjModel::Shape& shape : obj.getShapes())
 		{
-			Material matX;
-			matX.ambientColor = XMFLOAT3(mat.ambient);
-			matX.diffuseColor = XMFLOAT3(mat.diffuse);
-			matX.shininess = mat.shininess;
-			matX.specularColor = XMFLOAT3(mat.specular);
-			if (!mat.diffuse_texname.empty())
+			SubMesh mesh;
+			mesh.indices.assign(shape.indices.begin(), shape.indices.end());
+			mesh.materialId = shape.materialId;
+			model.meshes.emplace_back(std::move(mesh));
+		}
+
+		if (m_textureStreamer.isEnabled())
+		{
+			TextureStreamer::ModelCoverage coverage;
+			const auto* vertices = reinterpret_cast<const GltfModel::Vertex*>(model.vertices.data());
+			for (const SubMesh& mesh : model.meshes)
 			{
-				std::string path = (matDir / mat.diffuse_texname).string();
-				if (loadTexture(path))
-				{
-					matX.diffuseTextureId = path;
-				}
-				else
+				if (mesh.materialId >= 0 && mesh.materialId < static_cast<int>(model.materials.size()))
 				{
-					matX.diffuseTextureId = m_defaultMaterial.diffuseTextureId;
+					coverage.addTriangles(model.materials[mesh.materialId].diffuseTextureId, vertices, model.vertices.size(), mesh.indices.data(), sizeof(mesh.indices[0]), mesh.indices.size());
 				}
 			}
-			else
+			m_textureStreamer.addModel(filename, coverage);
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool DirectXRenderer::loadModelFromGltf(ModelData& model, const GltfModel& gltf, const std::string& filename)
+	{
+		for (const GltfModel::Material& gltfMaterial : gltf.getMaterials())
+		{
+			Material material;
+			gltfMaterial.getPhongParameters(&material.ambientColor.x, &material.diffuseColor.x, &material.specularColor.x, material.shininess);
+			material.diffuseTextureId = loadGltfTexture(gltf, gltfMaterial.baseColorTexture);
+			model.materials.push_back(material);
+		}
+
+		if (m_textureStreamer.isEnabled())
+		{
+			TextureStreamer::ModelCoverage coverage;
+			for (const GltfModel::Primitive& primitive : gltf.getPrimitives())
 			{
-				matX.diffuseTextureId = m_defaultMaterial.diffuseTextureId;
+				if (primitive.materialId >= 0 && primitive.materialId < static_cast<int>(model.materials.size()))
+				{
+					coverage.addTriangles(model.materials[primitive.materialId].diffuseTextureId, static_cast<const GltfModel::Vertex*>(primitive.vertices.data),
+						primitive.vertexCount, primitive.indices.data, primitive.indexSize, primitive.indexCount);
+				}
 			}
-			model.materials.emplace_back(matX);
+			m_textureStreamer.addModel(filename, coverage);
 		}
 
-		for (const auto& shape : shapes)
+		std::vector<GltfModel::BufferRange> vertexRanges;
+		std::vector<GltfModel::BufferRange> positionRanges;
+		for (const GltfModel::Primitive& primitive : gltf.getPrimitives())
 		{
+			vertexRanges.push_back(primitive.vertices);
+			positionRanges.push_back(primitive.positions);
+
 			SubMesh mesh;
-			for (const auto& index : shape.mesh.indices)
+			mesh.materialId = primitive.materialId;
+			mesh.indexCount = static_cast<UINT>(primitive.indexCount);
+			mesh.baseVertex = static_cast<INT>(primitive.baseVertex);
+			mesh.indexFormat = primitive.indexSize == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+			if (!createBufferFromRanges(D3D11_BIND_INDEX_BUFFER, { primitive.indices }, mesh.indexBuffer))
 			{
-				Vertex vertex{};
-
-				vertex.position = {
-					attrib.vertices[3 * index.vertex_index + 0],
-					attrib.vertices[3 * index.vertex_index + 1],
-					attrib.vertices[3 * index.vertex_index + 2]
-				};
-
-				if (index.normal_index >= 0) {
-					vertex.normal = {
-						attrib.normals[3 * index.normal_index + 0],
-						attrib.normals[3 * index.normal_index + 1],
-						attrib.normals[3 * index.normal_index + 2]
-					};
-				}
+				return false;
+			}
+			model.meshes.push_back(std::move(mesh));
+		}
 
-				if (index.texcoord_index >= 0)
-				{
-					vertex.texCoord = {
-						attrib.texcoords[2 * index.texcoord_index + 0],
-						1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-					};
-				}
+		if (!createBufferFromRanges(D3D11_BIND_VERTEX_BUFFER, vertexRanges, model.vertexBuffer))
+		{
+			return false;
+		}
 
-				model.vertices.emplace_back(vertex);
-				mesh.indices.push_back(model.vertices.size() - 1);
-			}
+		if (m_depthPrePass && !createBufferFromRanges(D3D11_BIND_VERTEX_BUFFER, positionRanges, model.positionBuffer))
+		{
+			return false;
+		}
 
-			mesh.materialId = shape.mesh.material_ids.empty() ? -1 : shape.mesh.material_ids[0];
-			model.meshes.emplace_back(std::move(mesh));
+		return createMaterialBuffers(model);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	std::string DirectXRenderer::loadGltfTexture(const GltfModel& gltf, int imageId)
+	{
+		if (imageId < 0)
+		{
+			return m_defaultMaterial.diffuseTextureId;
 		}
 
+		const GltfModel::Image& image = gltf.getImages()[imageId];
+		bool loaded = image.data.data ? loadTextureFromMemory(image.id, image.data) : !image.path.empty() && loadTexture(image.path);
+		return loaded ? image.id : m_defaultMaterial.diffuseTextureId;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool DirectXRenderer::loadTextureFromMemory(const std::string& textureId, const GltfModel::BufferRange& data)
+	{
+		if (m_textures.contains(textureId))
+		{
+			return true;
+		}
+
+		auto loadStart = std::chrono::high_resolution_clock::now();
+
+		if (m_textureStreamer.isEnabled())
+		{
+			TextureStreamer::Upload upload;
+			bool added = m_textureStreamer.addTexture(textureId, data.data, data.size, upload);
+			ASSERT(added, "Can't load texture: {}", textureId);
+			return added && createTexture(textureId, upload.pixels.data(), upload.width, upload.height, loadStart);
+		}
+
+		ComPtr<ID3D11ShaderResourceView> texture;
+		HRESULT hr = DirectX::CreateWICTextureFromMemory(m_device.Get(), m_deviceContext.Get(), static_cast<const uint8_t*>(data.data), data.size, nullptr, texture.GetAddressOf());
+		ASSERT(!FAILED(hr), "Can't load texture: {}", textureId);
+		if (FAILED(hr))
+		{
+			return false;
+		}
+
+		addTexture(textureId, std::move(texture), loadStart);
 		return true;
 	}
 
 	////////////////////////////////////////////////////////////////////////
 
-	void DirectXRenderer::setCameraProperties(const Utils::Vector3& position, const Utils::Vector3& rotation)
+	void DirectXRenderer::addTexture(const std::string& textureId, ComPtr<ID3D11ShaderResourceView>&& texture, std::chrono::high_resolution_clock::time_point loadStart)
+	{
+		std::chrono::duration<double> loadTime = std::chrono::high_resolution_clock::now() - loadStart;
+
+		// WIC images are converted to 32 bit formats, mips are generated when the format allows it
+		size_t textureSize = 0;
+		ComPtr<ID3D11Resource> resource;
+		texture->GetResource(resource.GetAddressOf());
+		ComPtr<ID3D11Texture2D> texture2D;
+		if (SUCCEEDED(resource.As(&texture2D)))
+		{
+			D3D11_TEXTURE2D_DESC desc;
+			texture2D->GetDesc(&desc);
+			textureSize = desc.MipLevels > 1 ? TextureStats::getMipChainSize(desc.Width, desc.Height, 4) : (size_t)desc.Width * desc.Height * 4;
+		}
+
+		m_textureStats.onTextureCreated(textureId, textureSize, loadTime.count());
+		m_textures.emplace(textureId, std::move(texture));
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool DirectXRenderer::createTexture(const std::string& textureId, const unsigned char* pixels, int width, int height, std::chrono::high_resolution_clock::time_point loadStart)
 	{
-		XMVECTOR rotationQuaternion = XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
-    
-		// Define the forward and up vectors
-		XMVECTOR forward = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
-		XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-    
-		// Rotate forward and up vectors by the camera's rotation
-		forward = XMVector3Rotate(forward, rotationQuaternion);
-		up = XMVector3Rotate(up, rotationQuaternion);
-    
-		XMFLOAT3 positionX(position.x, position.y, position.z);
-		// Calculate the target position based on forward direction
-		XMVECTOR target = XMVectorAdd(XMLoadFloat3(&positionX), forward);
-    
-		// Create the view matrix using LookAt
-		m_viewMatrix = XMMatrixLookAtLH(XMLoadFloat3(&positionX), target, up);
+		// Same format and full mip chain as the WIC loader gives to 8 bit images
+		D3D11_TEXTURE2D_DESC desc = {};
+		desc.Width = static_cast<UINT>(width);
+		desc.Height = static_cast<UINT>(height);
+		desc.MipLevels = 0;
+		desc.ArraySize = 1;
+		desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.SampleDesc.Count = 1;
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+		desc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+		ComPtr<ID3D11Texture2D> texture2D;
+		HRESULT hr = m_device->CreateTexture2D(&desc, nullptr, texture2D.GetAddressOf());
+		ASSERT(!FAILED(hr), "Can't create texture: {}, error code: {}", textureId, hr);
+		if (FAILED(hr))
+		{
+			return false;
+		}
+
+		ComPtr<ID3D11ShaderResourceView> texture;
+		hr = m_device->CreateShaderResourceView(texture2D.Get(), nullptr, texture.GetAddressOf());
+		ASSERT(!FAILED(hr), "Can't create shader resource view for texture: {}, error code: {}", textureId, hr);
+		if (FAILED(hr))
+		{
+			return false;
+		}
+
+		m_deviceContext->UpdateSubresource(texture2D.Get(), 0, nullptr, pixels, static_cast<UINT>(width) * 4, 0);
+		m_deviceContext->GenerateMips(texture.Get());
+
+		addTexture(textureId, std::move(texture), loadStart);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void DirectXRenderer::updateStreamedTextures()
+	{
+		m_textureUploads.clear();
+		m_textureStreamer.update(m_textureStats, m_textureUploads);
+
+		// The runtime keeps the replaced textures alive while queued draws reference them
+		for (const TextureStreamer::Upload& upload : m_textureUploads)
+		{
+			auto loadStart = std::chrono::high_resolution_clock::now();
+			const auto& itr = m_textures.find(upload.textureId);
+			if (itr == m_textures.end())
+			{
+				continue;
+			}
+
+			m_textures.erase(itr);
+			m_textureStats.onTextureDestroyed(upload.textureId);
+			createTexture(upload.textureId, upload.pixels.data(), upload.width, upload.height, loadStart);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void DirectXRenderer::setCamera(const Utils::Matrix4& view, const Utils::Matrix4& projection)
+	{
+		// XMMATRIX is made for row vectors, the transpose of the engine matrices
+		m_viewMatrix = XMMatrixTranspose(XMMATRIX(&view.m[0][0]));
+		m_projectionMatrix = XMMatrixTranspose(XMMATRIX(&projection.m[0][0]));
+		m_textureStreamer.setCamera(view, projection, m_viewportHeight);
 	}
 
 	////////////////////////////////////////////////////////////////////////
@@ -470,6 +1055,52 @@ namespace Engine::Visual
 
 	bool DirectXRenderer::destroyModelInstance(IModelInstance& modelInstance)
 	{
+		m_instanceVertexBuffers.erase(&modelInstance);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool DirectXRenderer::updateInstanceVertices(IModelInstance& modelInstance, const void* vertices, size_t vertexCount)
+	{
+		UINT size = static_cast<UINT>(vertexCount * sizeof(Vertex));
+		ComPtr<ID3D11Buffer>& buffer = m_instanceVertexBuffers[&modelInstance];
+
+		D3D11_BUFFER_DESC bufferDesc = {};
+		if (buffer)
+		{
+			buffer->GetDesc(&bufferDesc);
+		}
+
+		if (!buffer || bufferDesc.ByteWidth != size)
+		{
+			bufferDesc = {};
+			bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+			bufferDesc.ByteWidth = size;
+			bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+			bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+			buffer.Reset();
+			HRESULT hr = m_device->CreateBuffer(&bufferDesc, nullptr, buffer.GetAddressOf());
+			ASSERT(!FAILED(hr), "Can't create instance vertex buffer, error code: {}", hr);
+			if (FAILED(hr))
+			{
+				m_instanceVertexBuffers.erase(&modelInstance);
+				return false;
+			}
+		}
+
+		// Discarding gives a fresh buffer while the previous frames may still read the old one
+		D3D11_MAPPED_SUBRESOURCE mapped = {};
+		HRESULT hr = m_deviceContext->Map(buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+		ASSERT(!FAILED(hr), "Can't map instance vertex buffer, error code: {}", hr);
+		if (FAILED(hr))
+		{
+			return false;
+		}
+
+		memcpy(mapped.pData, vertices, size);
+		m_deviceContext->Unmap(buffer.Get(), 0);
 		return true;
 	}
 
@@ -487,11 +1118,27 @@ namespace Engine::Visual
 		texture.Reset();
 
 		m_textures.erase(itr);
+		m_textureStats.onTextureDestroyed(filename);
+		m_textureStreamer.removeTexture(filename);
 		return true;
 	}
 
 	////////////////////////////////////////////////////////////////////////
 
+	const TextureStats& DirectXRenderer::getTextureStats() const
+	{
+		return m_textureStats;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	const ParticleStats& DirectXRenderer::getParticleStats() const
+	{
+		return m_particleStats;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
 	bool DirectXRenderer::unloadModel(const std::string& filename)
 	{
 		const auto& itr = m_models.find(filename);
@@ -507,8 +1154,10 @@ namespace Engine::Visual
 		}
 
 		modelData.vertexBuffer.Reset();
+		modelData.positionBuffer.Reset();
 
 		m_models.erase(itr);
+		m_textureStreamer.removeModel(filename);
 
 		return true;
 		
@@ -518,6 +1167,9 @@ namespace Engine::Visual
 
 	void DirectXRenderer::cleanUp()
 	{
+		m_textureStreamer.clear();
+		m_instanceVertexBuffers.clear();
+
 		for (const std::string& modelId : Utils::getKeys(m_models))
 		{
 			unloadModel(modelId);
@@ -533,8 +1185,26 @@ namespace Engine::Visual
 		destroyComPtrSafe(m_vertexShader);
 		destroyComPtrSafe(m_pixelShader);
 		destroyComPtrSafe(m_inputLayout);
+		destroyComPtrSafe(m_depthVertexShader);
+		destroyComPtrSafe(m_depthInputLayout);
+		destroyComPtrSafe(m_depthEqualState);
+		destroyComPtrSafe(m_particleVertexShader);
+		destroyComPtrSafe(m_particlePixelShader);
+		destroyComPtrSafe(m_particleInputLayout);
+		destroyComPtrSafe(m_particleBuffer);
+		destroyComPtrSafe(m_particleBlendState);
+		destroyComPtrSafe(m_particleDepthState);
+		destroyComPtrSafe(m_particleRasterizerState);
+		m_particleBufferCapacity = 0;
+		m_particles.clear();
+		destroyComPtrSafe(m_depthStencilState);
 		destroyComPtrSafe(m_depthStencilView);
 		destroyComPtrSafe(m_renderTargetView);
+		if (m_frameLatencyWaitableObject)
+		{
+			CloseHandle(m_frameLatencyWaitableObject);
+			m_frameLatencyWaitableObject = nullptr;
+		}
 		destroyComPtrSafe(m_swapChain);
 		destroyComPtrSafe(m_deviceContext);
 		destroyComPtrSafe(m_device);
@@ -573,10 +1243,11 @@ namespace Engine::Visual
 		viewport.MinDepth = 0.0f;
 		viewport.MaxDepth = 1.0f;
 		m_deviceContext->RSSetViewports(1, &viewport);
+		m_viewportHeight = static_cast<int>(height);
 
-		// Set up camera view and projection matrices
-		m_viewMatrix = XMMatrixLookAtLH(XMVectorSet(0.0f, 2.0f, -5.0f, 0.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
-		m_projectionMatrix = XMMatrixPerspectiveFovLH(XM_PIDIV4, width / height, 0.1f, 500.0f);
+		// The camera matrices come from setCamera, identity until the first frame
+		m_viewMatrix = XMMatrixIdentity();
+		m_projectionMatrix = XMMatrixIdentity();
 	}
 
 	////////////////////////////////////////////////////////////////////////
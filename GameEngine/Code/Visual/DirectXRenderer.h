@@ -1,16 +1,20 @@
 #pragma once
 
 #include <d3d11.h>
+#include <dxgi1_3.h>
 #include <DirectXMath.h>
 #include <Windows.h>
 #include <wrl/client.h>
 #include <WICTextureLoader.h>
 #include <string>
+#include <chrono>
 
 #include "GL/glew.h"
 #include "GL/wglext.h"
 
 #include "IRenderer.h"
+#include "GltfModel.h"
+#include "TextureStreamer.h"
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -21,6 +25,9 @@ namespace Engine::Visual
     class DirectXRenderer: public IRenderer
     {
     public:
+        void setFramePacing(const FramePacing& framePacing) override;
+        void setDepthPrePass(bool enabled) override;
+        void setTextureStreaming(const TextureStreaming& settings, JobsManager& jobsManager) override;
         void init(const Window& window) override;
         void clearBackground(float r, float g, float b, float a) override;
 
@@ -29,16 +36,23 @@ namespace Engine::Visual
             const Utils::Vector3& position,
             const Utils::Vector3& rotation,
             const Utils::Vector3& scale) override;
+        void drawParticles(const ParticleInstance* particles, size_t count) override;
         void render() override;
+        void waitForNextFrame() override;
 
+        ModelSource::Options getModelSourceOptions() const override;
         bool loadModel(const std::string& filename) override;
+        bool loadModel(const std::string& filename, const ModelSource& source) override;
         bool loadTexture(const std::string& filename) override;
 
-        void setCameraProperties(const Utils::Vector3& position, const Utils::Vector3& rotation) override;
+        void setCamera(const Utils::Matrix4& view, const Utils::Matrix4& projection) override;
         std::unique_ptr<IModelInstance> createModelInstance(const std::string& filename) override;
 
         bool destroyModelInstance(IModelInstance& modelInstance) override;
+        bool updateInstanceVertices(IModelInstance& modelInstance, const void* vertices, size_t vertexCount) override;
         bool unloadTexture(const std::string& filename) override;
+        const TextureStats& getTextureStats() const override;
+        const ParticleStats& getParticleStats() const override;
         bool unloadModel(const std::string& filename) override;
         void cleanUp() override;
 
@@ -54,9 +68,12 @@ namespace Engine::Visual
 
         struct SubMesh
         {
-            std::vector<unsigned int> indices;
+            std::vector<unsigned int> indices; // Empty for glTF models, their buffers are filled straight from the file
             ComPtr<ID3D11Buffer> indexBuffer;
             int materialId;
+            UINT indexCount = 0;
+            INT baseVertex = 0;
+            DXGI_FORMAT indexFormat = DXGI_FORMAT_R32_UINT;
         };
 
         struct Material
@@ -73,10 +90,18 @@ namespace Engine::Visual
         {
             std::vector<SubMesh> meshes;
             ComPtr<ID3D11Buffer> vertexBuffer;
+            ComPtr<ID3D11Buffer> positionBuffer; // Only created for the depth pre-pass
             std::vector<Vertex> vertices;
             std::vector<Material> materials;
         };
 
+        struct DrawCommand
+        {
+            const ModelData* model;
+            ID3D11Buffer* instanceVertexBuffer;
+            XMMATRIX worldMatrix;
+        };
+
         struct ConstantBuffer
         {
             XMMATRIX worldMatrix;
@@ -106,12 +131,29 @@ namespace Engine::Visual
         void createDeviceAndSwapChain(HWND hwnd);
         void createRenderTarget(HWND hwnd);
         void createShaders();
+        void createDepthPrePassShaders();
+        void createParticleResources();
         void createViewport(HWND hwnd);
         void createDefaultMaterial();
         bool createBuffersForModel(ModelData& model);
-        bool loadModelFromFile(ModelData& model, const std::string& filename);
+        bool createMaterialBuffers(ModelData& model);
+        bool createBufferFromRanges(UINT bindFlags, const std::vector<GltfModel::BufferRange>& ranges, ComPtr<ID3D11Buffer>& buffer);
+        bool loadModelFromFile(ModelData& model, const ObjModel& obj, const std::string& filename);
+        bool loadModelFromGltf(ModelData& model, const GltfModel& gltf, const std::string& filename);
+        std::string loadGltfTexture(const GltfModel& gltf, int imageId);
+        bool loadTextureFromMemory(const std::string& textureId, const GltfModel::BufferRange& data);
+        void addTexture(const std::string& textureId, ComPtr<ID3D11ShaderResourceView>&& texture, std::chrono::high_resolution_clock::time_point loadStart);
+        bool createTexture(const std::string& textureId, const unsigned char* pixels, int width, int height, std::chrono::high_resolution_clock::time_point loadStart); // 4 channels
+        void updateStreamedTextures();
+
+        void updateConstantBuffer(const XMMATRIX& worldMatrix);
+        void drawModel(const ModelData& model, ID3D11Buffer* instanceVertexBuffer, const XMMATRIX& worldMatrix);
+        void drawModelDepth(const ModelData& model, ID3D11Buffer* instanceVertexBuffer, const XMMATRIX& worldMatrix);
+        void renderDrawCommands();
+        void renderParticles();
 
         const ComPtr<ID3D11ShaderResourceView>& getTexture(const std::string& textureId) const;
+        ID3D11Buffer* getInstanceVertexBuffer(const IModelInstance& modelInstance) const;
 
     private:
 
@@ -126,15 +168,43 @@ namespace Engine::Visual
         ComPtr<ID3D11InputLayout> m_inputLayout;
         ComPtr<ID3D11Buffer> m_constantBuffer;
         ComPtr<ID3D11SamplerState> m_samplerState;
+        ComPtr<ID3D11DepthStencilState> m_depthStencilState;
+
+        // Depth pre-pass
+        bool m_depthPrePass = false;
+        ComPtr<ID3D11VertexShader> m_depthVertexShader;
+        ComPtr<ID3D11InputLayout> m_depthInputLayout;
+        ComPtr<ID3D11DepthStencilState> m_depthEqualState;
+        std::vector<DrawCommand> m_drawCommands;
+
+        // Particles, drawn as instanced quads after the models
+        ComPtr<ID3D11VertexShader> m_particleVertexShader;
+        ComPtr<ID3D11PixelShader> m_particlePixelShader;
+        ComPtr<ID3D11InputLayout> m_particleInputLayout;
+        ComPtr<ID3D11Buffer> m_particleBuffer;
+        size_t m_particleBufferCapacity = 0; // In particles
+        ComPtr<ID3D11BlendState> m_particleBlendState;
+        ComPtr<ID3D11DepthStencilState> m_particleDepthState;
+        ComPtr<ID3D11RasterizerState> m_particleRasterizerState;
+        std::vector<ParticleInstance> m_particles;
+        ParticleStats m_particleStats;
+
+        FramePacing m_framePacing;
+        HANDLE m_frameLatencyWaitableObject = nullptr;
 
         // Camera matrices
         XMMATRIX m_viewMatrix;
         XMMATRIX m_projectionMatrix;
+        int m_viewportHeight = 0;
 
         Material m_defaultMaterial;
 
         std::unordered_map<std::string, ModelData> m_models;
+        std::unordered_map<const IModelInstance*, ComPtr<ID3D11Buffer>> m_instanceVertexBuffers; // Dynamic, replace the model vertex buffer
         std::unordered_map<std::string, ComPtr<ID3D11ShaderResourceView>> m_textures;
+        TextureStats m_textureStats;
+        TextureStreamer m_textureStreamer;
+        std::vector<TextureStreamer::Upload> m_textureUploads;
         
     };
 
@@ -0,0 +1,26 @@
+#include "FramePacing.h"
+
+#include "Utils/DebugMacros.h"
+
+namespace Engine::Visual
+{
+	////////////////////////////////////////////////////////////////////////
+
+	PresentMode FramePacing::getPresentMode() const
+	{
+		if (presentMode == "VSync")
+		{
+			return PresentMode::VSync;
+		}
+
+		if (presentMode == "Mailbox")
+		{
+			return PresentMode::Mailbox;
+		}
+
+		ASSERT(presentMode == "Immediate", "Unknown present mode: {}", presentMode);
+		return PresentMode::Immediate;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+#include "Utils/Parser.h"
+
+namespace Engine::Visual
+{
+    enum class PresentMode
+    {
+        Immediate, // Present as soon as possible, tearing allowed
+        Mailbox, // Present without tearing, newer frames replace queued ones
+        VSync // Present without tearing, wait for vertical blank
+    };
+
+    class FramePacing
+    {
+    public:
+        int framesInFlight = 3;
+        std::string presentMode = "Immediate";
+        bool waitableSwapchain = false; // Block at the end of a frame until the next one can be queued
+        float maxFps = 0.0f; // 0 means no cap
+
+        PresentMode getPresentMode() const;
+
+        SERIALIZABLE(
+            PROPERTY(FramePacing, framesInFlight),
+            PROPERTY(FramePacing, presentMode),
+            PROPERTY(FramePacing, waitableSwapchain),
+            PROPERTY(FramePacing, maxFps)
+        )
+    };
+}
@@ -0,0 +1,1114 @@
+#include "GltfModel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+#include "Utils/BasicUtils.h"
+#include "Utils/DebugMacros.h"
+
+namespace Engine::Visual
+{
+	namespace
+	{
+		constexpr size_t k_headerSize = 12;
+		constexpr size_t k_chunkHeaderSize = 8;
+		constexpr float k_ambientFactor = 0.5f;
+		constexpr float k_dielectricSpecular = 0.04f;
+		constexpr float k_maxShininess = 1024.0f;
+
+		//////////////////////////////////////////////////////////////////////////
+
+		uint32_t readUint32(const uint8_t* data)
+		{
+			uint32_t value;
+			std::memcpy(&value, data, sizeof(value));
+			return value;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		bool isIdentity(const Utils::Matrix4& matrix)
+		{
+			return std::memcmp(matrix.m, Utils::Matrix4::identity().m, sizeof(matrix.m)) == 0;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Cofactors of the upper 3x3, keeps normals perpendicular under non-uniform scale
+		Utils::Matrix4 getNormalMatrix(const Utils::Matrix4& matrix)
+		{
+			const auto& m = matrix.m;
+			Utils::Matrix4 result;
+			result.m[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+			result.m[0][1] = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+			result.m[0][2] = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+			result.m[1][0] = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+			result.m[1][1] = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+			result.m[1][2] = m[0][1] * m[2][0] - m[0][0] * m[2][1];
+			result.m[2][0] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+			result.m[2][1] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+			result.m[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+
+			float determinant = m[0][0] * result.m[0][0] + m[0][1] * result.m[0][1] + m[0][2] * result.m[0][2];
+			if (determinant < 0.0f)
+			{
+				for (int row = 0; row < 3; row++)
+				{
+					for (int column = 0; column < 3; column++)
+					{
+						result.m[row][column] = -result.m[row][column];
+					}
+				}
+			}
+			return result;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		Utils::Matrix4 getNodeTransform(const nlohmann::json& node)
+		{
+			if (node.contains("matrix"))
+			{
+				// Column major in the file
+				const nlohmann::json& values = node["matrix"];
+				Utils::Matrix4 result;
+				for (int column = 0; column < 4; column++)
+				{
+					for (int row = 0; row < 4; row++)
+					{
+						result.m[row][column] = values[column * 4 + row].get<float>();
+					}
+				}
+				return result;
+			}
+
+			Utils::Matrix4 result;
+			if (node.contains("translation"))
+			{
+				const nlohmann::json& t = node["translation"];
+				result = result * Utils::Matrix4::translation(Utils::Vector3(t[0].get<float>(), t[1].get<float>(), t[2].get<float>()));
+			}
+			if (node.contains("rotation"))
+			{
+				// Stored as x, y, z, w
+				const nlohmann::json& r = node["rotation"];
+				result = result * Utils::Matrix4::rotation(Utils::Quaternion(r[3].get<float>(), r[0].get<float>(), r[1].get<float>(), r[2].get<float>()));
+			}
+			if (node.contains("scale"))
+			{
+				const nlohmann::json& s = node["scale"];
+				result = result * Utils::Matrix4::scaling(Utils::Vector3(s[0].get<float>(), s[1].get<float>(), s[2].get<float>()));
+			}
+			return result;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Inverse of Matrix4::fromTRS, shear can't be represented and is dropped
+		void decomposeTransform(const Utils::Matrix4& matrix, Utils::Vector3& translation, Utils::Quaternion& rotation, Utils::Vector3& scale)
+		{
+			const auto& m = matrix.m;
+			translation = Utils::Vector3(m[0][3], m[1][3], m[2][3]);
+			scale = Utils::Vector3(
+				Utils::Vector3(m[0][0], m[1][0], m[2][0]).length(),
+				Utils::Vector3(m[0][1], m[1][1], m[2][1]).length(),
+				Utils::Vector3(m[0][2], m[1][2], m[2][2]).length());
+
+			float determinant =
+				m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+				m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+				m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+			if (determinant < 0.0f)
+			{
+				scale.x = -scale.x;
+			}
+
+			float axisScale[3] = { scale.x, scale.y, scale.z };
+			float r[3][3];
+			for (int row = 0; row < 3; row++)
+			{
+				for (int column = 0; column < 3; column++)
+				{
+					r[row][column] = axisScale[column] != 0.0f ? m[row][column] / axisScale[column] : 0.0f;
+				}
+			}
+
+			// Shepperd's method, the largest diagonal term keeps the division stable
+			float trace = r[0][0] + r[1][1] + r[2][2];
+			if (trace > 0.0f)
+			{
+				float s = std::sqrt(trace + 1.0f) * 2.0f;
+				rotation = Utils::Quaternion(0.25f * s, (r[2][1] - r[1][2]) / s, (r[0][2] - r[2][0]) / s, (r[1][0] - r[0][1]) / s);
+			}
+			else if (r[0][0] > r[1][1] && r[0][0] > r[2][2])
+			{
+				float s = std::sqrt(1.0f + r[0][0] - r[1][1] - r[2][2]) * 2.0f;
+				rotation = Utils::Quaternion((r[2][1] - r[1][2]) / s, 0.25f * s, (r[0][1] + r[1][0]) / s, (r[0][2] + r[2][0]) / s);
+			}
+			else if (r[1][1] > r[2][2])
+			{
+				float s = std::sqrt(1.0f + r[1][1] - r[0][0] - r[2][2]) * 2.0f;
+				rotation = Utils::Quaternion((r[0][2] - r[2][0]) / s, (r[0][1] + r[1][0]) / s, 0.25f * s, (r[1][2] + r[2][1]) / s);
+			}
+			else
+			{
+				float s = std::sqrt(1.0f + r[2][2] - r[0][0] - r[1][1]) * 2.0f;
+				rotation = Utils::Quaternion((r[1][0] - r[0][1]) / s, (r[0][2] + r[2][0]) / s, (r[1][2] + r[2][1]) / s, 0.25f * s);
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void GltfModel::Material::getPhongParameters(float ambientColor[3], float diffuseColor[3], float specularColor[3], float& shininess) const
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			float baseColor = baseColorFactor[i];
+			diffuseColor[i] = baseColor * (1.0f - metallicFactor);
+			ambientColor[i] = baseColor * k_ambientFactor + emissiveFactor[i];
+			specularColor[i] = k_dielectricSpecular + (baseColor - k_dielectricSpecular) * metallicFactor;
+		}
+
+		// Blinn-Phong exponent matching the GGX lobe width, alpha = roughness^2
+		float alpha = std::max(roughnessFactor * roughnessFactor, 0.01f);
+		shininess = std::min(2.0f / (alpha * alpha) - 2.0f, k_maxShininess);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	GltfModel::~GltfModel()
+	{
+		unmapFile();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool GltfModel::isGltfFile(const std::string& filename)
+	{
+		std::string extension = std::filesystem::path(filename).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".glb";
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool GltfModel::load(const std::string& filename, bool positionStream)
+	{
+		m_positionStream = positionStream;
+
+		if (!mapFile(filename))
+		{
+			return false;
+		}
+
+		bool validHeader = m_fileSize >= k_headerSize + k_chunkHeaderSize &&
+			readUint32(m_fileData) == k_magic &&
+			readUint32(m_fileData + 4) == 2 &&
+			readUint32(m_fileData + 8) <= m_fileSize;
+		ASSERT(validHeader, "Not a glTF 2.0 binary file: {}", filename);
+		if (!validHeader)
+		{
+			return false;
+		}
+
+		size_t fileLength = readUint32(m_fileData + 8);
+		size_t offset = k_headerSize;
+		while (offset + k_chunkHeaderSize <= fileLength)
+		{
+			size_t chunkLength = readUint32(m_fileData + offset);
+			uint32_t chunkType = readUint32(m_fileData + offset + 4);
+			const uint8_t* chunkData = m_fileData + offset + k_chunkHeaderSize;
+			if (offset + k_chunkHeaderSize + chunkLength > fileLength)
+			{
+				break;
+			}
+
+			if (chunkType == k_jsonChunk && m_json.is_null())
+			{
+				m_json = nlohmann::json::parse(chunkData, chunkData + chunkLength, nullptr, false);
+			}
+			else if (chunkType == k_binaryChunk && !m_binaryData)
+			{
+				m_binaryData = chunkData;
+				m_binarySize = chunkLength;
+			}
+
+			offset += k_chunkHeaderSize + chunkLength;
+		}
+
+		bool validJson = m_json.is_object() && !m_json.is_discarded();
+		ASSERT(validJson, "Can't parse glTF json chunk: {}", filename);
+		if (!validJson)
+		{
+			return false;
+		}
+
+		loadImages(filename);
+		loadMaterials();
+		loadNodes();
+		loadSkins();
+		loadAnimations();
+
+		size_t sceneId = m_json.value("scene", size_t(0));
+		if (m_json.contains("scenes") && sceneId < m_json["scenes"].size())
+		{
+			for (size_t nodeId : m_json["scenes"][sceneId].value("nodes", std::vector<size_t>()))
+			{
+				loadNode(nodeId, Utils::Matrix4::identity());
+			}
+		}
+		else if (m_json.contains("meshes"))
+		{
+			for (size_t meshId = 0; meshId < m_json["meshes"].size(); meshId++)
+			{
+				loadMesh(meshId, Utils::Matrix4::identity(), -1);
+			}
+		}
+
+		for (Primitive& primitive : m_primitives)
+		{
+			primitive.baseVertex = m_vertexCount;
+			m_vertexCount += primitive.vertexCount;
+		}
+
+		ASSERT(!m_primitives.empty(), "No triangle primitives in: {}", filename);
+		return !m_primitives.empty();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::vector<GltfModel::Primitive>& GltfModel::getPrimitives() const
+	{
+		return m_primitives;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::vector<GltfModel::Material>& GltfModel::getMaterials() const
+	{
+		return m_materials;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::vector<GltfModel::Image>& GltfModel::getImages() const
+	{
+		return m_images;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::vector<GltfModel::Node>& GltfModel::getNodes() const
+	{
+		return m_nodes;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::vector<GltfModel::Skin>& GltfModel::getSkins() const
+	{
+		return m_skins;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::vector<GltfModel::Animation>& GltfModel::getAnimations() const
+	{
+		return m_animations;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const GltfModel::LoadStats& GltfModel::getLoadStats() const
+	{
+		return m_stats;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t GltfModel::getVertexCount() const
+	{
+		return m_vertexCount;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t GltfModel::getComponentSize(int componentType)
+	{
+		switch (componentType)
+		{
+		case Byte:
+		case UnsignedByte:
+			return 1;
+		case Short:
+		case UnsignedShort:
+			return 2;
+		case UnsignedInt:
+		case Float:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int GltfModel::getComponentsCount(const std::string& type)
+	{
+		if (type == "SCALAR")
+		{
+			return 1;
+		}
+		if (type == "VEC2")
+		{
+			return 2;
+		}
+		if (type == "VEC3")
+		{
+			return 3;
+		}
+		if (type == "VEC4")
+		{
+			return 4;
+		}
+		if (type == "MAT4")
+		{
+			return 16;
+		}
+		return 0;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool GltfModel::mapFile(const std::string& filename)
+	{
+		m_file = CreateFileW(Utils::stringToWString(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		ASSERT(m_file != INVALID_HANDLE_VALUE, "Can't open model: {}", filename);
+		if (m_file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			return false;
+		}
+		m_fileSize = static_cast<size_t>(fileSize.QuadPart);
+
+		m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		ASSERT(m_mapping, "Can't create file mapping for model: {}", filename);
+		if (!m_mapping)
+		{
+			return false;
+		}
+
+		m_fileData = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+		ASSERT(m_fileData, "Can't map model: {}", filename);
+		return m_fileData != nullptr;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void GltfModel::unmapFile()
+	{
+		if (m_fileData)
+		{
+			UnmapViewOfFile(m_fileData);
+			m_fileData = nullptr;
+		}
+
+		if (m_mapping)
+		{
+			CloseHandle(m_mapping);
+			m_mapping = nullptr;
+		}
+
+		if (m_file != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(m_file);
+			m_file = INVALID_HANDLE_VALUE;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool GltfModel::readAccessor(size_t accessorId, Accessor& accessor) const
+	{
+		if (!m_json.contains("accessors") || accessorId >= m_json["accessors"].size())
+		{
+			return false;
+		}
+
+		const nlohmann::json& accessorJson = m_json["accessors"][accessorId];
+		ASSERT(!accessorJson.contains("sparse"), "Sparse glTF accessors are not supported");
+		if (!accessorJson.contains("bufferView") || accessorJson.contains("sparse"))
+		{
+			return false;
+		}
+
+		accessor.bufferViewId = accessorJson["bufferView"].get<size_t>();
+		accessor.byteOffset = accessorJson.value("byteOffset", size_t(0));
+		accessor.count = accessorJson.value("count", size_t(0));
+		accessor.componentType = accessorJson.value("componentType", 0);
+		accessor.components = getComponentsCount(accessorJson.value("type", ""));
+		accessor.normalized = accessorJson.value("normalized", false);
+
+		size_t elementSize = getComponentSize(accessor.componentType) * accessor.components;
+		if (elementSize == 0 || accessor.count == 0 || !m_json.contains("bufferViews") || accessor.bufferViewId >= m_json["bufferViews"].size())
+		{
+			return false;
+		}
+
+		// Only the binary chunk is supported as a buffer, external .bin files are not
+		const nlohmann::json& viewJson = m_json["bufferViews"][accessor.bufferViewId];
+		size_t viewOffset = viewJson.value("byteOffset", size_t(0));
+		size_t viewLength = viewJson.value("byteLength", size_t(0));
+		bool validView = viewJson.value("buffer", 0) == 0 && m_binaryData && viewOffset + viewLength <= m_binarySize;
+		ASSERT(validView, "Buffer view {} is outside of the binary chunk", accessor.bufferViewId);
+		if (!validView)
+		{
+			return false;
+		}
+
+		accessor.stride = viewJson.value("byteStride", elementSize);
+		if (accessor.byteOffset + accessor.stride * (accessor.count - 1) + elementSize > viewLength)
+		{
+			return false;
+		}
+
+		accessor.data = m_binaryData + viewOffset + accessor.byteOffset;
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	float GltfModel::readComponent(const Accessor& accessor, size_t index, int component) const
+	{
+		const uint8_t* data = accessor.data + index * accessor.stride + component * getComponentSize(accessor.componentType);
+		switch (accessor.componentType)
+		{
+		case Float:
+		{
+			float value;
+			std::memcpy(&value, data, sizeof(value));
+			return value;
+		}
+		case UnsignedByte:
+		{
+			float value = static_cast<float>(*data);
+			return accessor.normalized ? value / 255.0f : value;
+		}
+		case Byte:
+		{
+			float value = static_cast<float>(static_cast<int8_t>(*data));
+			return accessor.normalized ? std::max(value / 127.0f, -1.0f) : value;
+		}
+		case UnsignedShort:
+		{
+			uint16_t value;
+			std::memcpy(&value, data, sizeof(value));
+			return accessor.normalized ? value / 65535.0f : static_cast<float>(value);
+		}
+		case Short:
+		{
+			int16_t value;
+			std::memcpy(&value, data, sizeof(value));
+			return accessor.normalized ? std::max(value / 32767.0f, -1.0f) : static_cast<float>(value);
+		}
+		case UnsignedInt:
+		{
+			uint32_t value;
+			std::memcpy(&value, data, sizeof(value));
+			return static_cast<float>(value);
+		}
+		default:
+			return 0.0f;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	uint32_t GltfModel::readIndex(const Accessor& accessor, size_t index) const
+	{
+		// Not read through floats, they can't hold every 32 bit index
+		const uint8_t* data = accessor.data + index * accessor.stride;
+		switch (accessor.componentType)
+		{
+		case UnsignedByte:
+			return *data;
+		case UnsignedShort:
+		{
+			uint16_t value;
+			std::memcpy(&value, data, sizeof(value));
+			return value;
+		}
+		case UnsignedInt:
+			return readUint32(data);
+		default:
+			return 0;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void GltfModel::loadImages(const std::string& filename)
+	{
+		if (!m_json.contains("images"))
+		{
+			return;
+		}
+
+		std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+		const nlohmann::json& images = m_json["images"];
+		for (size_t i = 0; i < images.size(); i++)
+		{
+			const nlohmann::json& imageJson = images[i];
+			Image image;
+
+			if (imageJson.contains("bufferView"))
+			{
+				size_t viewId = imageJson["bufferView"].get<size_t>();
+				const nlohmann::json& viewJson = m_json["bufferViews"][viewId];
+				size_t viewOffset = viewJson.value("byteOffset", size_t(0));
+				size_t viewLength = viewJson.value("byteLength", size_t(0));
+				if (m_binaryData && viewOffset + viewLength <= m_binarySize)
+				{
+					image.id = filename + "#image" + std::to_string(i);
+					image.data = BufferRange{ m_binaryData + viewOffset, viewLength };
+				}
+			}
+			else if (imageJson.contains("uri"))
+			{
+				std::string uri = imageJson["uri"].get<std::string>();
+				ASSERT(!uri.starts_with("data:"), "Data uri images are not supported: {}", filename);
+				if (!uri.starts_with("data:"))
+				{
+					image.path = (directory / uri).string();
+					image.id = image.path;
+				}
+			}
+
+			m_images.push_back(std::move(image));
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void GltfModel::loadMaterials()
+	{
+		if (!m_json.contains("materials"))
+		{
+			return;
+		}
+
+		for (const nlohmann::json& materialJson : m_json["materials"])
+		{
+			Material material;
+			material.name = materialJson.value("name", "");
+
+			if (materialJson.contains("pbrMetallicRoughness"))
+			{
+				const nlohmann::json& pbr = materialJson["pbrMetallicRoughness"];
+				if (pbr.contains("baseColorFactor"))
+				{
+					for (int i = 0; i < 4; i++)
+					{
+						material.baseColorFactor[i] = pbr["baseColorFactor"][i].get<float>();
+					}
+				}
+				material.metallicFactor = pbr.value("metallicFactor", 1.0f);
+				material.roughnessFactor = pbr.value("roughnessFactor", 1.0f);
+				material.baseColorTexture = getTextureImage(pbr.value("baseColorTexture", nlohmann::json()));
+				material.metallicRoughnessTexture = getTextureImage(pbr.value("metallicRoughnessTexture", nlohmann::json()));
+			}
+
+			if (materialJson.contains("emissiveFactor"))
+			{
+				for (int i = 0; i < 3; i++)
+				{
+					material.emissiveFactor[i] = materialJson["emissiveFactor"][i].get<float>();
+				}
+			}
+			material.normalTexture = getTextureImage(materialJson.value("normalTexture", nlohmann::json()));
+			material.occlusionTexture = getTextureImage(materialJson.value("occlusionTexture", nlohmann::json()));
+			material.emissiveTexture = getTextureImage(materialJson.value("emissiveTexture", nlohmann::json()));
+
+			m_materials.push_back(std::move(material));
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void GltfModel::loadNodes()
+	{
+		if (!m_json.contains("nodes"))
+		{
+			return;
+		}
+
+		const nlohmann::json& nodes = m_json["nodes"];
+		m_nodes.resize(nodes.size());
+		for (size_t nodeId = 0; nodeId < nodes.size(); nodeId++)
+		{
+			const nlohmann::json& nodeJson = nodes[nodeId];
+			Node& node = m_nodes[nodeId];
+			node.name = nodeJson.value("name", std::string());
+
+			if (nodeJson.contains("matrix"))
+			{
+				decomposeTransform(getNodeTransform(nodeJson), node.translation, node.rotation, node.scale);
+			}
+			else
+			{
+				if (nodeJson.contains("translation"))
+				{
+					const nlohmann::json& t = nodeJson["translation"];
+					node.translation = Utils::Vector3(t[0].get<float>(), t[1].get<float>(), t[2].get<float>());
+				}
+				if (nodeJson.contains("rotation"))
+				{
+					const nlohmann::json& r = nodeJson["rotation"];
+					node.rotation = Utils::Quaternion(r[3].get<float>(), r[0].get<float>(), r[1].get<float>(), r[2].get<float>());
+				}
+				if (nodeJson.contains("scale"))
+				{
+					const nlohmann::json& s = nodeJson["scale"];
+					node.scale = Utils::Vector3(s[0].get<float>(), s[1].get<float>(), s[2].get<float>());
+				}
+			}
+		}
+
+		for (size_t nodeId = 0; nodeId < nodes.size(); nodeId++)
+		{
+			for (size_t childId : nodes[nodeId].value("children", std::vector<size_t>()))
+			{
+				if (childId >= m_nodes.size())
+				{
+					continue;
+				}
+
+				// The links only ever form a forest, a child that already has a parent or is an ancestor would close a cycle
+				bool ancestor = false;
+				for (int parent = static_cast<int>(nodeId); parent >= 0 && !ancestor; parent = m_nodes[parent].parent)
+				{
+					ancestor = parent == static_cast<int>(childId);
+				}
+
+				bool validChild = m_nodes[childId].parent < 0 && !ancestor;
+				ASSERT(validChild, "glTF node {} has several parents or is its own ancestor", childId);
+				if (validChild)
+				{
+					m_nodes[childId].parent = static_cast<int>(nodeId);
+				}
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void GltfModel::loadSkins()
+	{
+		if (!m_json.contains("skins"))
+		{
+			return;
+		}
+
+		for (const nlohmann::json& skinJson : m_json["skins"])
+		{
+			Skin skin;
+			skin.joints = skinJson.value("joints", std::vector<size_t>());
+
+			bool validJoints = std::all_of(skin.joints.begin(), skin.joints.end(), [this](size_t nodeId) { return nodeId < m_nodes.size(); });
+			ASSERT(validJoints, "glTF skin {} references missing nodes", m_skins.size());
+			if (!validJoints)
+			{
+				skin.joints.clear();
+			}
+
+			// Missing inverse bind matrices mean identity
+			skin.inverseBindMatrices.resize(skin.joints.size());
+			Accessor matrices;
+			if (skinJson.contains("inverseBindMatrices") &&
+				readAccessor(skinJson["inverseBindMatrices"].get<size_t>(), matrices) &&
+				matrices.components == 16 && matrices.count >= skin.joints.size())
+			{
+				for (size_t joint = 0; joint < skin.joints.size(); joint++)
+				{
+					// Column major in the file
+					for (int column = 0; column < 4; column++)
+					{
+						for (int row = 0; row < 4; row++)
+						{
+							skin.inverseBindMatrices[joint].m[row][column] = readComponent(matrices, joint, column * 4 + row);
+						}
+					}
+				}
+			}
+
+			m_skins.push_back(std::move(skin));
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void GltfModel::loadAnimations()
+	{
+		if (!m_json.contains("animations"))
+		{
+			return;
+		}
+
+		for (const nlohmann::json& animationJson : m_json["animations"])
+		{
+			Animation animation;
+			animation.name = animationJson.value("name", "animation" + std::to_string(m_animations.size()));
+
+			nlohmann::json samplers = animationJson.value("samplers", nlohmann::json::array());
+			for (const nlohmann::json& channelJson : animationJson.value("channels", nlohmann::json::array()))
+			{
+				AnimationChannel channel;
+				if (loadAnimationChannel(channelJson, samplers, channel))
+				{
+					animation.duration = std::max(animation.duration, channel.times.back());
+					animation.channels.push_back(std::move(channel));
+				}
+			}
+
+			m_animations.push_back(std::move(animation));
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool GltfModel::loadAnimationChannel(const nlohmann::json& channelJson, const nlohmann::json& samplers, AnimationChannel& channel) const
+	{
+		if (!channelJson.contains("target") || !channelJson.contains("sampler"))
+		{
+			return false;
+		}
+
+		// Morph target weights aren't supported
+		const nlohmann::json& target = channelJson["target"];
+		std::string path = target.value("path", std::string());
+		if (path == "translation")
+		{
+			channel.path = AnimationChannel::Path::Translation;
+		}
+		else if (path == "rotation")
+		{
+			channel.path = AnimationChannel::Path::Rotation;
+		}
+		else if (path == "scale")
+		{
+			channel.path = AnimationChannel::Path::Scale;
+		}
+		else
+		{
+			return false;
+		}
+
+		int nodeId = target.value("node", -1);
+		size_t samplerId = channelJson["sampler"].get<size_t>();
+		if (nodeId < 0 || nodeId >= static_cast<int>(m_nodes.size()) || samplerId >= samplers.size())
+		{
+			return false;
+		}
+		channel.nodeId = static_cast<size_t>(nodeId);
+
+		const nlohmann::json& sampler = samplers[samplerId];
+		Accessor input, output;
+		if (!sampler.contains("input") || !sampler.contains("output") ||
+			!readAccessor(sampler["input"].get<size_t>(), input) || !readAccessor(sampler["output"].get<size_t>(), output) ||
+			input.components != 1)
+		{
+			return false;
+		}
+
+		// Cubic splines store in-tangent, value and out-tangent for every key, only the values are kept and interpolated linearly
+		std::string interpolation = sampler.value("interpolation", std::string("LINEAR"));
+		size_t valuesPerKey = interpolation == "CUBICSPLINE" ? 3 : 1;
+		int components = channel.path == AnimationChannel::Path::Rotation ? 4 : 3;
+		if (output.components != components || output.count < input.count * valuesPerKey)
+		{
+			return false;
+		}
+
+		channel.step = interpolation == "STEP";
+		channel.times.resize(input.count);
+		channel.values.resize(input.count * components);
+		for (size_t key = 0; key < input.count; key++)
+		{
+			channel.times[key] = readComponent(input, key, 0);
+
+			size_t element = key * valuesPerKey + valuesPerKey / 2;
+			for (int component = 0; component < components; component++)
+			{
+				channel.values[key * components + component] = readComponent(output, element, component);
+			}
+		}
+
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void GltfModel::loadNode(size_t nodeId, const Utils::Matrix4& parentTransform)
+	{
+		if (!m_json.contains("nodes") || nodeId >= m_json["nodes"].size())
+		{
+			return;
+		}
+
+		const nlohmann::json& node = m_json["nodes"][nodeId];
+		Utils::Matrix4 transform = parentTransform * getNodeTransform(node);
+
+		if (node.contains("mesh"))
+		{
+			// Skinned vertices stay in bind space, the joints carry the whole transform
+			int skinId = node.value("skin", -1);
+			if (skinId >= static_cast<int>(m_skins.size()) || (skinId >= 0 && m_skins[skinId].joints.empty()))
+			{
+				skinId = -1;
+			}
+			loadMesh(node["mesh"].get<size_t>(), skinId >= 0 ? Utils::Matrix4::identity() : transform, skinId);
+		}
+
+		// Only the links accepted by loadNodes are followed, so cyclic hierarchies can't recurse forever
+		for (size_t childId : node.value("children", std::vector<size_t>()))
+		{
+			if (childId < m_nodes.size() && m_nodes[childId].parent == static_cast<int>(nodeId))
+			{
+				loadNode(childId, transform);
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void GltfModel::loadMesh(size_t meshId, const Utils::Matrix4& transform, int skinId)
+	{
+		if (!m_json.contains("meshes") || meshId >= m_json["meshes"].size())
+		{
+			return;
+		}
+
+		for (const nlohmann::json& primitiveJson : m_json["meshes"][meshId].value("primitives", nlohmann::json::array()))
+		{
+			loadPrimitive(primitiveJson, transform, skinId);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool GltfModel::loadPrimitive(const nlohmann::json& primitiveJson, const Utils::Matrix4& transform, int skinId)
+	{
+		bool triangles = primitiveJson.value("mode", k_trianglesMode) == k_trianglesMode;
+		ASSERT(triangles, "Only triangle list glTF primitives are supported");
+		if (!triangles || !primitiveJson.contains("attributes"))
+		{
+			return false;
+		}
+
+		const nlohmann::json& attributes = primitiveJson["attributes"];
+		Accessor positions, normals, texCoords;
+		if (!attributes.contains("POSITION") || !readAccessor(attributes["POSITION"].get<size_t>(), positions) || positions.components != 3)
+		{
+			return false;
+		}
+
+		bool hasNormals = attributes.contains("NORMAL") &&
+			readAccessor(attributes["NORMAL"].get<size_t>(), normals) && normals.count == positions.count && normals.components == 3;
+		bool hasTexCoords = attributes.contains("TEXCOORD_0") &&
+			readAccessor(attributes["TEXCOORD_0"].get<size_t>(), texCoords) && texCoords.count == positions.count && texCoords.components == 2;
+
+		Primitive primitive;
+		primitive.vertexCount = positions.count;
+		primitive.materialId = primitiveJson.value("material", -1);
+		if (primitive.materialId >= static_cast<int>(m_materials.size()))
+		{
+			primitive.materialId = -1;
+		}
+
+		bool identity = isIdentity(transform);
+
+		// The attributes can be uploaded as they are when they are already interleaved like Vertex
+		bool interleaved = identity && hasNormals && hasTexCoords &&
+			positions.componentType == Float && normals.componentType == Float && texCoords.componentType == Float &&
+			positions.bufferViewId == normals.bufferViewId && positions.bufferViewId == texCoords.bufferViewId &&
+			positions.stride == sizeof(Vertex) &&
+			normals.byteOffset == positions.byteOffset + offsetof(Vertex, normal) &&
+			texCoords.byteOffset == positions.byteOffset + offsetof(Vertex, texCoord);
+
+		if (interleaved)
+		{
+			primitive.vertices = BufferRange{ positions.data, positions.count * sizeof(Vertex) };
+			m_stats.zeroCopyVertices += positions.count;
+		}
+		else
+		{
+			Utils::Matrix4 normalMatrix = getNormalMatrix(transform);
+
+			std::vector<uint8_t> data(positions.count * sizeof(Vertex));
+			Vertex* vertices = reinterpret_cast<Vertex*>(data.data());
+			for (size_t i = 0; i < positions.count; i++)
+			{
+				Vertex& vertex = vertices[i];
+
+				Utils::Vector3 position = transform.transformPoint(Utils::Vector3(
+					readComponent(positions, i, 0), readComponent(positions, i, 1), readComponent(positions, i, 2)));
+				vertex.position[0] = position.x;
+				vertex.position[1] = position.y;
+				vertex.position[2] = position.z;
+
+				Utils::Vector3 normal;
+				if (hasNormals)
+				{
+					normal = normalMatrix.transformDirection(Utils::Vector3(
+						readComponent(normals, i, 0), readComponent(normals, i, 1), readComponent(normals, i, 2)));
+					if (normal.lengthSqr() > 0.0f)
+					{
+						normal.normalize();
+					}
+				}
+				vertex.normal[0] = normal.x;
+				vertex.normal[1] = normal.y;
+				vertex.normal[2] = normal.z;
+
+				vertex.texCoord[0] = hasTexCoords ? readComponent(texCoords, i, 0) : 0.0f;
+				vertex.texCoord[1] = hasTexCoords ? readComponent(texCoords, i, 1) : 0.0f;
+			}
+
+			primitive.vertices = storeConverted(std::move(data));
+			m_stats.convertedVertices += positions.count;
+		}
+
+		if (m_positionStream)
+		{
+			if (identity && positions.componentType == Float && positions.stride == sizeof(Vertex::position))
+			{
+				primitive.positions = BufferRange{ positions.data, positions.count * sizeof(Vertex::position) };
+			}
+			else
+			{
+				// Taken from the vertices so the transform is applied only once
+				const Vertex* vertices = static_cast<const Vertex*>(primitive.vertices.data);
+				std::vector<uint8_t> data(positions.count * sizeof(Vertex::position));
+				for (size_t i = 0; i < positions.count; i++)
+				{
+					std::memcpy(data.data() + i * sizeof(Vertex::position), vertices[i].position, sizeof(Vertex::position));
+				}
+				primitive.positions = storeConverted(std::move(data));
+			}
+		}
+
+		Accessor indices;
+		bool hasIndices = primitiveJson.contains("indices") && readAccessor(primitiveJson["indices"].get<size_t>(), indices) && indices.components == 1;
+		if (hasIndices &&
+			(indices.componentType == UnsignedShort || indices.componentType == UnsignedInt) &&
+			indices.stride == getComponentSize(indices.componentType))
+		{
+			primitive.indexSize = indices.stride;
+			primitive.indexCount = indices.count;
+			primitive.indices = BufferRange{ indices.data, indices.count * indices.stride };
+			m_stats.zeroCopyIndices += indices.count;
+		}
+		else
+		{
+			// Byte indices aren't supported by every API, non indexed primitives get a trivial index list
+			size_t count = hasIndices ? indices.count : positions.count;
+			std::vector<uint8_t> data(count * sizeof(uint32_t));
+			uint32_t* values = reinterpret_cast<uint32_t*>(data.data());
+			for (size_t i = 0; i < count; i++)
+			{
+				values[i] = hasIndices ? readIndex(indices, i) : static_cast<uint32_t>(i);
+			}
+
+			primitive.indexSize = sizeof(uint32_t);
+			primitive.indexCount = count;
+			primitive.indices = storeConverted(std::move(data));
+			m_stats.convertedIndices += count;
+		}
+
+		if (skinId >= 0)
+		{
+			primitive.skinWeights = loadSkinWeights(attributes, positions.count);
+			primitive.skinId = primitive.skinWeights.data ? skinId : -1;
+		}
+
+		m_primitives.push_back(primitive);
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	GltfModel::BufferRange GltfModel::loadSkinWeights(const nlohmann::json& attributes, size_t vertexCount)
+	{
+		Accessor joints, weights;
+		bool validAttributes = attributes.contains("JOINTS_0") && attributes.contains("WEIGHTS_0") &&
+			readAccessor(attributes["JOINTS_0"].get<size_t>(), joints) && readAccessor(attributes["WEIGHTS_0"].get<size_t>(), weights) &&
+			joints.components == 4 && weights.components == 4 && joints.count == vertexCount && weights.count == vertexCount;
+		ASSERT(validAttributes, "Skinned glTF primitive without valid JOINTS_0 and WEIGHTS_0");
+		if (!validAttributes)
+		{
+			return BufferRange();
+		}
+
+		// Converted every time, joint indices come as bytes or shorts and weights can be normalized integers
+		std::vector<uint8_t> data(vertexCount * sizeof(SkinWeights));
+		SkinWeights* values = reinterpret_cast<SkinWeights*>(data.data());
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			SkinWeights& value = values[i];
+			float weightsSum = 0.0f;
+			for (int influence = 0; influence < 4; influence++)
+			{
+				value.joints[influence] = static_cast<uint16_t>(readComponent(joints, i, influence));
+				value.weights[influence] = readComponent(weights, i, influence);
+				weightsSum += value.weights[influence];
+			}
+
+			// Exporters don't always normalize, the skinning relies on it
+			for (int influence = 0; influence < 4; influence++)
+			{
+				value.weights[influence] = weightsSum > 0.0f ? value.weights[influence] / weightsSum : (influence == 0 ? 1.0f : 0.0f);
+			}
+		}
+
+		return storeConverted(std::move(data));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	GltfModel::BufferRange GltfModel::storeConverted(std::vector<uint8_t>&& data)
+	{
+		// Moving the vector keeps its storage, so the range stays valid
+		BufferRange range{ data.data(), data.size() };
+		m_convertedData.push_back(std::move(data));
+		return range;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	int GltfModel::getTextureImage(const nlohmann::json& textureInfo) const
+	{
+		if (!textureInfo.is_object() || !textureInfo.contains("index") || !m_json.contains("textures"))
+		{
+			return -1;
+		}
+
+		size_t textureId = textureInfo["index"].get<size_t>();
+		if (textureId >= m_json["textures"].size())
+		{
+			return -1;
+		}
+
+		int imageId = m_json["textures"][textureId].value("source", -1);
+		return imageId < static_cast<int>(m_images.size()) ? imageId : -1;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <Windows.h>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "Utils/Matrix.h"
+#include "Utils/Quaternion.h"
+
+namespace Engine::Visual
+{
+    // Binary glTF 2.0 (.glb) reader. The file is memory mapped and vertex/index data is handed out
+    // as ranges of the mapping whenever its layout already matches what the renderers upload,
+    // everything else is converted once into buffers owned by the model.
+    // The ranges stay valid until the model is destroyed, so it only has to live while buffers are created.
+    class GltfModel
+    {
+    public:
+        // Interleaved layout used by the vertex buffers of every renderer
+        struct Vertex
+        {
+            float position[3];
+            float normal[3];
+            float texCoord[2];
+        };
+
+        // Four strongest joint influences of a vertex, the weights sum to 1
+        struct SkinWeights
+        {
+            uint16_t joints[4];
+            float weights[4];
+        };
+
+        struct BufferRange
+        {
+            const void* data = nullptr;
+            size_t size = 0;
+        };
+
+        struct Primitive
+        {
+            BufferRange vertices; // Vertex layout
+            BufferRange positions; // Tightly packed positions, only filled when requested on load
+            BufferRange indices;
+            size_t vertexCount = 0;
+            size_t baseVertex = 0; // Index of the first vertex when the primitives share one vertex buffer
+            size_t indexCount = 0;
+            size_t indexSize = sizeof(uint32_t); // 2 or 4 bytes
+            int materialId = -1;
+            int skinId = -1; // Vertices of skinned primitives are in bind pose, node transforms aren't baked
+            BufferRange skinWeights; // SkinWeights layout, only filled for skinned primitives
+        };
+
+        // Embedded images have data, external ones a path relative to the working directory
+        struct Image
+        {
+            std::string id;
+            std::string path;
+            BufferRange data;
+        };
+
+        // Metallic-roughness PBR parameters, textures are indices into the images
+        struct Material
+        {
+            std::string name;
+            float baseColorFactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+            float metallicFactor = 1.0f;
+            float roughnessFactor = 1.0f;
+            float emissiveFactor[3] = { 0.0f, 0.0f, 0.0f };
+            int baseColorTexture = -1;
+            int metallicRoughnessTexture = -1;
+            int normalTexture = -1;
+            int occlusionTexture = -1;
+            int emissiveTexture = -1;
+
+            // Approximation for the Blinn-Phong shading of the renderers
+            void getPhongParameters(float ambientColor[3], float diffuseColor[3], float specularColor[3], float& shininess) const;
+        };
+
+        // Local transform of a node, matrices are decomposed so animations can replace any part
+        struct Node
+        {
+            std::string name;
+            int parent = -1;
+            Utils::Vector3 translation;
+            Utils::Quaternion rotation;
+            Utils::Vector3 scale = Utils::Vector3(1.0f);
+        };
+
+        struct Skin
+        {
+            std::vector<size_t> joints; // Node ids
+            std::vector<Utils::Matrix4> inverseBindMatrices; // One per joint
+        };
+
+        struct AnimationChannel
+        {
+            enum class Path
+            {
+                Translation,
+                Rotation,
+                Scale
+            };
+
+            size_t nodeId = 0;
+            Path path = Path::Translation;
+            bool step = false; // STEP interpolation, LINEAR otherwise
+            std::vector<float> times;
+            std::vector<float> values; // 3 floats per key, 4 for rotations (x, y, z, w)
+        };
+
+        struct Animation
+        {
+            std::string name;
+            float duration = 0.0f;
+            std::vector<AnimationChannel> channels;
+        };
+
+        struct LoadStats
+        {
+            size_t zeroCopyVertices = 0;
+            size_t convertedVertices = 0;
+            size_t zeroCopyIndices = 0;
+            size_t convertedIndices = 0;
+        };
+
+    public:
+        GltfModel() = default;
+        ~GltfModel();
+
+        GltfModel(const GltfModel&) = delete;
+        GltfModel& operator=(const GltfModel&) = delete;
+
+        static bool isGltfFile(const std::string& filename);
+
+        bool load(const std::string& filename, bool positionStream);
+
+        const std::vector<Primitive>& getPrimitives() const;
+        const std::vector<Material>& getMaterials() const;
+        const std::vector<Image>& getImages() const;
+        const std::vector<Node>& getNodes() const;
+        const std::vector<Skin>& getSkins() const;
+        const std::vector<Animation>& getAnimations() const;
+        const LoadStats& getLoadStats() const;
+        size_t getVertexCount() const;
+
+    private:
+        enum ComponentType
+        {
+            Byte = 5120,
+            UnsignedByte = 5121,
+            Short = 5122,
+            UnsignedShort = 5123,
+            UnsignedInt = 5125,
+            Float = 5126
+        };
+
+        struct Accessor
+        {
+            const uint8_t* data = nullptr; // First element
+            size_t count = 0;
+            size_t stride = 0;
+            size_t bufferViewId = 0;
+            size_t byteOffset = 0; // Offset inside the buffer view
+            int componentType = Float;
+            int components = 1;
+            bool normalized = false;
+        };
+
+    private:
+        static size_t getComponentSize(int componentType);
+        static int getComponentsCount(const std::string& type);
+
+        bool mapFile(const std::string& filename);
+        void unmapFile();
+
+        bool readAccessor(size_t accessorId, Accessor& accessor) const;
+        float readComponent(const Accessor& accessor, size_t index, int component) const;
+        uint32_t readIndex(const Accessor& accessor, size_t index) const;
+
+        void loadImages(const std::string& filename);
+        void loadMaterials();
+        void loadNodes();
+        void loadSkins();
+        void loadAnimations();
+        bool loadAnimationChannel(const nlohmann::json& channelJson, const nlohmann::json& samplers, AnimationChannel& channel) const;
+        void loadNode(size_t nodeId, const Utils::Matrix4& parentTransform);
+        void loadMesh(size_t meshId, const Utils::Matrix4& transform, int skinId);
+        bool loadPrimitive(const nlohmann::json& primitiveJson, const Utils::Matrix4& transform, int skinId);
+        BufferRange loadSkinWeights(const nlohmann::json& attributes, size_t vertexCount);
+
+        BufferRange storeConverted(std::vector<uint8_t>&& data);
+        int getTextureImage(const nlohmann::json& textureInfo) const;
+
+    private:
+        static constexpr uint32_t k_magic = 0x46546C67; // "glTF"
+        static constexpr uint32_t k_jsonChunk = 0x4E4F534A; // "JSON"
+        static constexpr uint32_t k_binaryChunk = 0x004E4942; // "BIN"
+        static constexpr int k_trianglesMode = 4;
+
+        HANDLE m_file = INVALID_HANDLE_VALUE;
+        HANDLE m_mapping = nullptr;
+        const uint8_t* m_fileData = nullptr;
+        size_t m_fileSize = 0;
+
+        nlohmann::json m_json;
+        const uint8_t* m_binaryData = nullptr;
+        size_t m_binarySize = 0;
+        bool m_positionStream = false;
+
+        std::vector<Primitive> m_primitives;
+        std::vector<Material> m_materials;
+        std::vector<Image> m_images;
+        std::vector<Node> m_nodes;
+        std::vector<Skin> m_skins;
+        std::vector<Animation> m_animations;
+        std::vector<std::vector<uint8_t>> m_convertedData;
+        LoadStats m_stats;
+        size_t m_vertexCount = 0;
+    };
+}
@@ -4,7 +4,18 @@
 
 #include "Window.h"
 #include "Utils/Vector.h"
+#include "Utils/Matrix.h"
 #include "ModelInstanceBase.h"
+#include "ModelSource.h"
+#include "FramePacing.h"
+#include "TextureStats.h"
+#include "TextureStreaming.h"
+#include "ParticleInstance.h"
+
+namespace Engine
+{
+    class JobsManager;
+}
 
 namespace Engine::Visual
 {
@@ -12,6 +23,9 @@ namespace Engine::Visual
     {
     public:
 
+        virtual void setFramePacing(const FramePacing& framePacing) = 0; // Must be called before init
+        virtual void setDepthPrePass(bool enabled) = 0; // Must be called before init, draws are deferred to render when enabled
+        virtual void setTextureStreaming(const TextureStreaming& settings, JobsManager& jobsManager) = 0; // Must be called before init, level changes are decoded on the jobs
         virtual void init(const Window& window) = 0;
         virtual void clearBackground(float r, float g, float b, float a) = 0;
         virtual void draw(
@@ -19,17 +33,30 @@ namespace Engine::Visual
             const Utils::Vector3& position,
             const Utils::Vector3& rotation,
             const Utils::Vector3& scale) = 0;
-        virtual void setCameraProperties(const Utils::Vector3& position, const Utils::Vector3& rotation) = 0;
+        // Particles are copied and drawn after the models of the frame, with blending and without depth writes
+        virtual void drawParticles(const ParticleInstance* particles, size_t count) = 0;
+        // Left-handed with depth in [0, 1] as CameraSystem builds them, each backend converts to its own conventions
+        virtual void setCamera(const Utils::Matrix4& view, const Utils::Matrix4& projection) = 0;
         virtual void render() = 0;
+        virtual void waitForNextFrame() = 0;
 
         
+        // Models are parsed with these options on any thread, then handed to loadModel on the frame loop thread
+        virtual ModelSource::Options getModelSourceOptions() const = 0;
         virtual bool loadModel(const std::string& filename) = 0;
+        virtual bool loadModel(const std::string& filename, const ModelSource& source) = 0; // Only creates the device resources
         virtual bool loadTexture(const std::string& filename) = 0;
 
         virtual std::unique_ptr<IModelInstance> createModelInstance(const std::string& filename) = 0;
 
         virtual bool destroyModelInstance(IModelInstance& modelInstance) = 0;
+
+        // Replaces the vertices the instance is drawn with until it is destroyed, used by CPU skinning.
+        // The vertices follow the layout and order of the model vertex buffer (position, normal, texCoord).
+        virtual bool updateInstanceVertices(IModelInstance& modelInstance, const void* vertices, size_t vertexCount) = 0;
         virtual bool unloadTexture(const std::string& filename) = 0;
+        virtual const TextureStats& getTextureStats() const = 0;
+        virtual const ParticleStats& getParticleStats() const = 0;
         virtual bool unloadModel(const std::string& filename) = 0;
 
         virtual void cleanUp() = 0;
@@ -0,0 +1,276 @@
+#include "MeshGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <numbers>
+
+#include "nlohmann/json.hpp"
+#include "Utils/DebugMacros.h"
+
+namespace Engine::Visual
+{
+	namespace
+	{
+		//////////////////////////////////////////////////////////////////////////
+
+		GltfModel::Vertex makeVertex(float x, float y, float z, float nx, float ny, float nz, float u, float v)
+		{
+			return GltfModel::Vertex{ { x, y, z }, { nx, ny, nz }, { u, v } };
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		void writeUint32(std::ofstream& file, uint32_t value)
+		{
+			file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		size_t alignTo4(size_t size)
+		{
+			return (size + 3) & ~size_t(3);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t MeshGenerator::Mesh::getTriangleCount() const
+	{
+		return indices.size() / 3;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool MeshGenerator::parseShape(const std::string& name, Shape& shape)
+	{
+		for (Shape candidate : { Shape::Sphere, Shape::Torus, Shape::Grid })
+		{
+			if (name == getShapeName(candidate))
+			{
+				shape = candidate;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::string MeshGenerator::getShapeName(Shape shape)
+	{
+		switch (shape)
+		{
+		case Shape::Sphere:
+			return "Sphere";
+		case Shape::Torus:
+			return "Torus";
+		case Shape::Grid:
+			return "Grid";
+		}
+		return "";
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	MeshGenerator::Mesh MeshGenerator::generate(Shape shape, size_t triangleCount)
+	{
+		switch (shape)
+		{
+		case Shape::Sphere:
+			return generateSphere(triangleCount);
+		case Shape::Torus:
+			return generateTorus(triangleCount);
+		case Shape::Grid:
+			return generateGrid(triangleCount);
+		}
+		return Mesh();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool MeshGenerator::writeGlb(const Mesh& mesh, const std::string& filename, const std::string& textureUri)
+	{
+		// Interleaved vertices and 32 bit indices, the layout the renderers upload without converting
+		size_t verticesSize = mesh.vertices.size() * sizeof(GltfModel::Vertex);
+		size_t indicesSize = mesh.indices.size() * sizeof(uint32_t);
+		size_t binarySize = alignTo4(verticesSize + indicesSize);
+
+		float minPosition[3] = { 0.0f, 0.0f, 0.0f };
+		float maxPosition[3] = { 0.0f, 0.0f, 0.0f };
+		for (size_t i = 0; i < mesh.vertices.size(); i++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float value = mesh.vertices[i].position[axis];
+				minPosition[axis] = i == 0 ? value : std::min(minPosition[axis], value);
+				maxPosition[axis] = i == 0 ? value : std::max(maxPosition[axis], value);
+			}
+		}
+
+		nlohmann::json json = {
+			{ "asset", { { "version", "2.0" }, { "generator", "GameEngine MeshGenerator" } } },
+			{ "buffers", { { { "byteLength", binarySize } } } },
+			{ "bufferViews", {
+				{ { "buffer", 0 }, { "byteOffset", 0 }, { "byteLength", verticesSize }, { "byteStride", sizeof(GltfModel::Vertex) }, { "target", 34962 } },
+				{ { "buffer", 0 }, { "byteOffset", verticesSize }, { "byteLength", indicesSize }, { "target", 34963 } } } },
+			{ "accessors", {
+				{ { "bufferView", 0 }, { "byteOffset", offsetof(GltfModel::Vertex, position) }, { "componentType", 5126 }, { "count", mesh.vertices.size() }, { "type", "VEC3" },
+					{ "min", minPosition }, { "max", maxPosition } },
+				{ { "bufferView", 0 }, { "byteOffset", offsetof(GltfModel::Vertex, normal) }, { "componentType", 5126 }, { "count", mesh.vertices.size() }, { "type", "VEC3" } },
+				{ { "bufferView", 0 }, { "byteOffset", offsetof(GltfModel::Vertex, texCoord) }, { "componentType", 5126 }, { "count", mesh.vertices.size() }, { "type", "VEC2" } },
+				{ { "bufferView", 1 }, { "componentType", 5125 }, { "count", mesh.indices.size() }, { "type", "SCALAR" } } } },
+			{ "meshes", { { { "primitives", { { { "attributes", { { "POSITION", 0 }, { "NORMAL", 1 }, { "TEXCOORD_0", 2 } } }, { "indices", 3 } } } } } } },
+			{ "nodes", { { { "mesh", 0 } } } },
+			{ "scenes", { { { "nodes", { 0 } } } } },
+			{ "scene", 0 }
+		};
+
+		if (!textureUri.empty())
+		{
+			json["images"] = { { { "uri", textureUri } } };
+			json["textures"] = { { { "source", 0 } } };
+			nlohmann::json pbr = { { "baseColorTexture", { { "index", 0 } } }, { "metallicFactor", 0.0f } };
+			json["materials"] = { { { "pbrMetallicRoughness", pbr } } };
+			json["meshes"][0]["primitives"][0]["material"] = 0;
+		}
+
+		// The json chunk is padded with spaces and the binary one with zeros
+		std::string jsonText = json.dump();
+		jsonText.resize(alignTo4(jsonText.size()), ' ');
+
+		std::ofstream file(filename, std::ios::binary);
+		ASSERT(file.is_open(), "Failed to create file: {}", filename);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		writeUint32(file, k_glbMagic);
+		writeUint32(file, 2);
+		writeUint32(file, static_cast<uint32_t>(12 + 8 + jsonText.size() + 8 + binarySize));
+
+		writeUint32(file, static_cast<uint32_t>(jsonText.size()));
+		writeUint32(file, k_glbJsonChunk);
+		file.write(jsonText.data(), jsonText.size());
+
+		writeUint32(file, static_cast<uint32_t>(binarySize));
+		writeUint32(file, k_glbBinaryChunk);
+		file.write(reinterpret_cast<const char*>(mesh.vertices.data()), verticesSize);
+		file.write(reinterpret_cast<const char*>(mesh.indices.data()), indicesSize);
+		std::fill_n(std::ostreambuf_iterator<char>(file), binarySize - verticesSize - indicesSize, '\0');
+
+		return file.good();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	MeshGenerator::Mesh MeshGenerator::generateSphere(size_t triangleCount)
+	{
+		// UV sphere with twice as many segments as rings: 2 * segments * rings triangles, the pole quads are degenerate
+		size_t rings = std::max<size_t>(2, (size_t)std::lround(std::sqrt(triangleCount / 4.0)));
+		size_t segments = rings * 2;
+		float pi = std::numbers::pi_v<float>;
+
+		Mesh mesh;
+		mesh.vertices.reserve((segments + 1) * (rings + 1));
+		for (size_t ring = 0; ring <= rings; ring++)
+		{
+			float v = (float)ring / rings;
+			float polar = v * pi;
+			for (size_t segment = 0; segment <= segments; segment++)
+			{
+				float u = (float)segment / segments;
+				float azimuth = u * 2.0f * pi;
+				float x = std::sin(polar) * std::cos(azimuth);
+				float y = std::cos(polar);
+				float z = -std::sin(polar) * std::sin(azimuth);
+				mesh.vertices.push_back(makeVertex(0.5f * x, 0.5f * y, 0.5f * z, x, y, z, u, v));
+			}
+		}
+
+		addQuadIndices(mesh, segments, rings);
+		return mesh;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	MeshGenerator::Mesh MeshGenerator::generateTorus(size_t triangleCount)
+	{
+		// Ring in the XY plane, twice as many segments around it as around the tube: 2 * segments * sides triangles
+		size_t sides = std::max<size_t>(3, (size_t)std::lround(std::sqrt(triangleCount / 4.0)));
+		size_t segments = sides * 2;
+		float pi = std::numbers::pi_v<float>;
+		float ringRadius = 0.35f;
+		float tubeRadius = 0.15f;
+
+		Mesh mesh;
+		mesh.vertices.reserve((segments + 1) * (sides + 1));
+		for (size_t side = 0; side <= sides; side++)
+		{
+			float v = (float)side / sides;
+			float tubeAngle = v * 2.0f * pi;
+			for (size_t segment = 0; segment <= segments; segment++)
+			{
+				float u = (float)segment / segments;
+				float ringAngle = u * 2.0f * pi;
+				float nx = std::cos(tubeAngle) * std::cos(ringAngle);
+				float ny = std::cos(tubeAngle) * std::sin(ringAngle);
+				float nz = -std::sin(tubeAngle);
+				float x = ringRadius * std::cos(ringAngle) + tubeRadius * nx;
+				float y = ringRadius * std::sin(ringAngle) + tubeRadius * ny;
+				mesh.vertices.push_back(makeVertex(x, y, tubeRadius * nz, nx, ny, nz, u, v));
+			}
+		}
+
+		addQuadIndices(mesh, segments, sides);
+		return mesh;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	MeshGenerator::Mesh MeshGenerator::generateGrid(size_t triangleCount)
+	{
+		// Unit square facing the camera, 2 * cells * cells triangles
+		size_t cells = std::max<size_t>(1, (size_t)std::lround(std::sqrt(triangleCount / 2.0)));
+
+		Mesh mesh;
+		mesh.vertices.reserve((cells + 1) * (cells + 1));
+		for (size_t row = 0; row <= cells; row++)
+		{
+			float v = (float)row / cells;
+			for (size_t column = 0; column <= cells; column++)
+			{
+				float u = (float)column / cells;
+				mesh.vertices.push_back(makeVertex(0.5f - u, 0.5f - v, 0.0f, 0.0f, 0.0f, -1.0f, u, v));
+			}
+		}
+
+		addQuadIndices(mesh, cells, cells);
+		return mesh;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void MeshGenerator::addQuadIndices(Mesh& mesh, size_t columns, size_t rows)
+	{
+		// Vertices are laid out row by row with columns + 1 vertices per row
+		mesh.indices.reserve(mesh.indices.size() + columns * rows * 6);
+		for (size_t row = 0; row < rows; row++)
+		{
+			for (size_t column = 0; column < columns; column++)
+			{
+				uint32_t topLeft = static_cast<uint32_t>(row * (columns + 1) + column);
+				uint32_t topRight = topLeft + 1;
+				uint32_t bottomLeft = topLeft + static_cast<uint32_t>(columns + 1);
+				uint32_t bottomRight = bottomLeft + 1;
+
+				mesh.indices.insert(mesh.indices.end(), { topLeft, bottomLeft, topRight, topRight, bottomLeft, bottomRight });
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
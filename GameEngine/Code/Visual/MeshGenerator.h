@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "GltfModel.h"
+
+namespace Engine::Visual
+{
+    // Procedural meshes with a chosen triangle count, so mesh complexity can be varied without changing
+    // topology or materials. They are written as .glb files and loaded like any other model.
+    class MeshGenerator
+    {
+    public:
+        enum class Shape
+        {
+            Sphere,
+            Torus,
+            Grid
+        };
+
+        struct Mesh
+        {
+            std::vector<GltfModel::Vertex> vertices;
+            std::vector<uint32_t> indices;
+
+            size_t getTriangleCount() const;
+        };
+
+        static bool parseShape(const std::string& name, Shape& shape);
+        static std::string getShapeName(Shape shape);
+
+        // The triangle count is rounded to the closest one the shape can be tessellated with
+        static Mesh generate(Shape shape, size_t triangleCount);
+        // A texture uri adds a material sampling it, relative to the directory of the file
+        static bool writeGlb(const Mesh& mesh, const std::string& filename, const std::string& textureUri = "");
+
+    private:
+        static Mesh generateSphere(size_t triangleCount);
+        static Mesh generateTorus(size_t triangleCount);
+        static Mesh generateGrid(size_t triangleCount);
+        static void addQuadIndices(Mesh& mesh, size_t columns, size_t rows);
+
+    private:
+        static constexpr uint32_t k_glbMagic = 0x46546C67; // "glTF"
+        static constexpr uint32_t k_glbJsonChunk = 0x4E4F534A; // "JSON"
+        static constexpr uint32_t k_glbBinaryChunk = 0x004E4942; // "BIN"
+    };
+}
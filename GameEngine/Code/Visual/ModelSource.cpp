@@ -0,0 +1,33 @@
+#include "ModelSource.h"
+
+namespace Engine::Visual
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	bool ModelSource::load(const std::string& filename, const Options& options)
+	{
+		m_isGltf = GltfModel::isGltfFile(filename);
+		return m_isGltf ? m_gltf.load(filename, options.positionStream) : m_obj.load(filename, options.flipTexCoordV);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool ModelSource::isGltf() const
+	{
+		return m_isGltf;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const GltfModel& ModelSource::getGltf() const
+	{
+		return m_gltf;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const ObjModel& ModelSource::getObj() const
+	{
+		return m_obj;
+	}
+}
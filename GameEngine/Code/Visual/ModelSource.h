@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+
+#include "GltfModel.h"
+#include "ObjModel.h"
+
+namespace Engine::Visual
+{
+    // CPU side of a model file, parsed without touching the device so it can be built on a worker thread.
+    // The renderer that asked for it only creates its buffers and textures from it.
+    class ModelSource
+    {
+    public:
+        // Filled by each renderer to match the buffers it creates
+        struct Options
+        {
+            bool positionStream = false; // Tightly packed positions for the depth pre-pass
+            bool flipTexCoordV = false;
+        };
+
+    public:
+        bool load(const std::string& filename, const Options& options);
+
+        bool isGltf() const;
+        const GltfModel& getGltf() const;
+        const ObjModel& getObj() const;
+
+    private:
+        GltfModel m_gltf;
+        ObjModel m_obj;
+        bool m_isGltf = false;
+    };
+}
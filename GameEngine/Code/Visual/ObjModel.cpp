@@ -0,0 +1,103 @@
+#include "ObjModel.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#include "tiny_obj_loader.h"
+#include "Utils/DebugMacros.h"
+
+namespace Engine::Visual
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	bool ObjModel::load(const std::string& filename, bool flipTexCoordV)
+	{
+		std::filesystem::path fullPath(filename);
+		std::filesystem::path matDir = fullPath.parent_path();
+
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warn, err;
+
+		bool success = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename.c_str(), matDir.string().c_str());
+		ASSERT(success, "Can't load model: {}", filename);
+		if (!success)
+		{
+			return false;
+		}
+
+		for (const tinyobj::material_t& mat : materials)
+		{
+			Material material;
+			std::copy(mat.ambient, mat.ambient + 3, material.ambientColor);
+			std::copy(mat.diffuse, mat.diffuse + 3, material.diffuseColor);
+			std::copy(mat.specular, mat.specular + 3, material.specularColor);
+			material.shininess = mat.shininess;
+			if (!mat.diffuse_texname.empty())
+			{
+				material.diffuseTexture = (matDir / mat.diffuse_texname).string();
+			}
+			m_materials.push_back(std::move(material));
+		}
+
+		size_t indexCount = 0;
+		for (const tinyobj::shape_t& shape : shapes)
+		{
+			indexCount += shape.mesh.indices.size();
+		}
+		m_vertices.reserve(indexCount);
+
+		for (const tinyobj::shape_t& shape : shapes)
+		{
+			Shape objShape;
+			objShape.indices.reserve(shape.mesh.indices.size());
+			for (const tinyobj::index_t& index : shape.mesh.indices)
+			{
+				GltfModel::Vertex vertex = {};
+				std::copy_n(&attrib.vertices[3 * index.vertex_index], 3, vertex.position);
+
+				if (index.normal_index >= 0)
+				{
+					std::copy_n(&attrib.normals[3 * index.normal_index], 3, vertex.normal);
+				}
+
+				if (index.texcoord_index >= 0)
+				{
+					float v = attrib.texcoords[2 * index.texcoord_index + 1];
+					vertex.texCoord[0] = attrib.texcoords[2 * index.texcoord_index + 0];
+					vertex.texCoord[1] = flipTexCoordV ? 1.0f - v : v;
+				}
+
+				m_vertices.push_back(vertex);
+				objShape.indices.push_back(static_cast<uint32_t>(m_vertices.size() - 1));
+			}
+
+			objShape.materialId = shape.mesh.material_ids.empty() ? -1 : shape.mesh.material_ids[0];
+			m_shapes.push_back(std::move(objShape));
+		}
+
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::vector<GltfModel::Vertex>& ObjModel::getVertices() const
+	{
+		return m_vertices;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::vector<ObjModel::Shape>& ObjModel::getShapes() const
+	{
+		return m_shapes;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::vector<ObjModel::Material>& ObjModel::getMaterials() const
+	{
+		return m_materials;
+	}
+}
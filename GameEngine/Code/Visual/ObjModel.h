@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "GltfModel.h"
+
+namespace Engine::Visual
+{
+    // Wavefront .obj reader. Faces are expanded into one vertex per index in the layout of GltfModel::Vertex,
+    // so the renderers only copy the buffers. Needs no device, models can be parsed on any thread.
+    class ObjModel
+    {
+    public:
+        struct Shape
+        {
+            std::vector<uint32_t> indices;
+            int materialId = -1;
+        };
+
+        // Blinn-Phong parameters as written in the .mtl file
+        struct Material
+        {
+            float ambientColor[3] = { 0.0f, 0.0f, 0.0f };
+            float diffuseColor[3] = { 0.0f, 0.0f, 0.0f };
+            float specularColor[3] = { 0.0f, 0.0f, 0.0f };
+            float shininess = 0.0f;
+            std::string diffuseTexture; // Relative to the working directory, empty without a texture
+        };
+
+    public:
+        // DirectX samples textures with v pointing down and flips it on load
+        bool load(const std::string& filename, bool flipTexCoordV);
+
+        const std::vector<GltfModel::Vertex>& getVertices() const;
+        const std::vector<Shape>& getShapes() const;
+        const std::vector<Material>& getMaterials() const;
+
+    private:
+        std::vector<GltfModel::Vertex> m_vertices;
+        std::vector<Shape> m_shapes;
+        std::vector<Material> m_materials;
+    };
+}
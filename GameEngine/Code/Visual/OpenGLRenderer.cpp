@@ -2,14 +2,16 @@
 #define WGL_WGLEXT_PROTOTYPES
 
 #include "OpenGLRenderer.h"
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 #include <iostream>
 #include <GL/wglext.h>
 #include <GL/glew.h>
 
 #include "stb_image.h"
-#include "tiny_obj_loader.h"
 
+#include "CameraMatrices.h"
 #include "Utils/DebugMacros.h"
 
 
@@ -18,16 +20,45 @@ namespace Engine::Visual
 
     ////////////////////////////////////////////////////////////////////////
 
+    void OpenGLRenderer::setFramePacing(const FramePacing& framePacing)
+    {
+        m_framePacing = framePacing;
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    void OpenGLRenderer::setDepthPrePass(bool enabled)
+    {
+        m_depthPrePass = enabled;
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    void OpenGLRenderer::setTextureStreaming(const TextureStreaming& settings, JobsManager& jobsManager)
+    {
+        m_textureStreamer.init(settings, &jobsManager, STBI_rgb);
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
     void OpenGLRenderer::init(const Window& window)
     {
         m_hwnd = window.getHandle();
         m_hdc = GetDC(m_hwnd);
+        m_frameFences.assign(m_framePacing.framesInFlight, nullptr);
+        m_frameIndex = 0;
     
         setPixelFormat();
         createWglContext();
         setInitialOpenGLState();
         createShaderProgram("VertexShader.glsl", "FragmentShader.glsl");
         createShaderFields();
+        if (m_depthPrePass)
+        {
+            createDepthShaderProgram("DepthVertexShader.glsl");
+        }
+        createParticleShaderProgram("ParticleVertexShader.glsl", "ParticleFragmentShader.glsl");
+        createParticleBuffers();
         createFrameBuffer();
         createViewport();
         createDefaultMaterial();   
@@ -37,6 +68,12 @@ namespace Engine::Visual
 
     void OpenGLRenderer::clearBackground(float r, float g, float b, float a)
     {
+        waitForFrameFence();
+        if (m_textureStreamer.isEnabled())
+        {
+            updateStreamedTextures();
+        }
+
         glClearColor(r, g, b, a);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -58,8 +95,23 @@ namespace Engine::Visual
         }
         const ModelData& modelData = modelItr->second;
         glm::mat4 worldMatrix = getWorldMatrix(position, rotation, scale);
+        m_textureStreamer.onDraw(model.GetId(), position, scale);
+
+        if (m_depthPrePass)
+        {
+            m_drawCommands.push_back({ &model, &modelData, worldMatrix });
+            return;
+        }
 
-        glBindVertexArray(modelData.vao);
+        drawModel(model, modelData, worldMatrix);
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    void OpenGLRenderer::drawModel(const IModelInstance& model, const ModelData& modelData, const glm::mat4& worldMatrix)
+    {
+        const auto& instanceItr = m_instanceVertices.find(&model);
+        glBindVertexArray(instanceItr != m_instanceVertices.end() ? instanceItr->second.vao : modelData.vao);
         ASSERT_OPENGL("Unable to bind vertex buffer for model: {}", model.GetId());
 
         glUniformMatrix4fv(m_viewMatrixLoc, 1, GL_FALSE, glm::value_ptr(m_viewMatrix));
@@ -93,7 +145,7 @@ namespace Engine::Visual
                 glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
                 ASSERT_OPENGL("Unable to bind index buffer for mesh of model: {}", model.GetId());
 
-				glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, 0);
+				glDrawElementsBaseVertex(GL_TRIANGLES, mesh.indexCount, mesh.indexType, nullptr, mesh.baseVertex);
 				ASSERT_OPENGL("Unable to draw mesh of model: {}", model.GetId());
 			}
 		}
@@ -103,10 +155,145 @@ namespace Engine::Visual
 
     ////////////////////////////////////////////////////////////////////////
 
+    void OpenGLRenderer::drawModelDepth(const IModelInstance& model, const ModelData& modelData, const glm::mat4& worldMatrix)
+    {
+        // The depth shader only reads the position attribute, so instance streams need no position-only copy
+        const auto& instanceItr = m_instanceVertices.find(&model);
+        glBindVertexArray(instanceItr != m_instanceVertices.end() ? instanceItr->second.vao : modelData.depthVao);
+        ASSERT_OPENGL("Unable to bind position buffer for model: {}", model.GetId());
+
+        glUniformMatrix4fv(m_depthModelMatrixLoc, 1, GL_FALSE, glm::value_ptr(worldMatrix));
+
+        for (const SubMesh& mesh : modelData.meshes)
+        {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+            glDrawElementsBaseVertex(GL_TRIANGLES, mesh.indexCount, mesh.indexType, nullptr, mesh.baseVertex);
+            ASSERT_OPENGL("Unable to draw depth of mesh of model: {}", model.GetId());
+        }
+
+        glBindVertexArray(0);
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    void OpenGLRenderer::renderDrawCommands()
+    {
+        // Depth only pass, color writes are masked so the fragment stage has nothing to do
+        glUseProgram(m_depthShaderProgram);
+        glUniformMatrix4fv(m_depthViewMatrixLoc, 1, GL_FALSE, glm::value_ptr(m_viewMatrix));
+        glUniformMatrix4fv(m_depthProjectionMatrixLoc, 1, GL_FALSE, glm::value_ptr(m_projectionMatrix));
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        for (const DrawCommand& command : m_drawCommands)
+        {
+            drawModelDepth(*command.instance, *command.model, command.worldMatrix);
+        }
+
+        // Shading pass, only the nearest fragment of each pixel passes the equal test
+        glUseProgram(m_shaderProgram);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+        for (const DrawCommand& command : m_drawCommands)
+        {
+            drawModel(*command.instance, *command.model, command.worldMatrix);
+        }
+
+        // Depth writes must be back on for the next clear
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+
+        m_drawCommands.clear();
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    void OpenGLRenderer::drawParticles(const ParticleInstance* particles, size_t count)
+    {
+        m_particles.insert(m_particles.end(), particles, particles + count);
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    void OpenGLRenderer::renderParticles()
+    {
+        auto renderStart = std::chrono::high_resolution_clock::now();
+
+        // Orphaning the buffer lets the driver hand out new memory instead of waiting for the previous frame
+        GLsizeiptr size = (GLsizeiptr)(m_particles.size() * sizeof(ParticleInstance));
+        glBindBuffer(GL_ARRAY_BUFFER, m_particleBuffer);
+        m_particleBufferCapacity = std::max(m_particleBufferCapacity, m_particles.size());
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(m_particleBufferCapacity * sizeof(ParticleInstance)), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size, m_particles.data());
+        ASSERT_OPENGL("Unable to upload particles");
+
+        // Transparent and unsorted, particles are tested against the scene depth but don't write it
+        glUseProgram(m_particleShaderProgram);
+        glUniformMatrix4fv(m_particleViewMatrixLoc, 1, GL_FALSE, glm::value_ptr(m_viewMatrix));
+        glUniformMatrix4fv(m_particleProjectionMatrixLoc, 1, GL_FALSE, glm::value_ptr(m_projectionMatrix));
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+        glDisable(GL_CULL_FACE);
+
+        glBindVertexArray(m_particleVao);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)m_particles.size());
+        ASSERT_OPENGL("Unable to draw particles");
+        glBindVertexArray(0);
+
+        glEnable(GL_CULL_FACE);
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+        glUseProgram(m_shaderProgram);
+
+        m_particleStats.renderedFrames++;
+        m_particleStats.renderedParticles += m_particles.size();
+        m_particleStats.renderTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - renderStart).count();
+        m_particles.clear();
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
     void OpenGLRenderer::render()
     {
+        if (!m_drawCommands.empty())
+        {
+            renderDrawCommands();
+        }
+
+        if (!m_particles.empty())
+        {
+            renderParticles();
+        }
+
         SwapBuffers(m_hdc);
         ASSERT_OPENGL("Unable to swap buffers and render");
+
+        m_frameFences[m_frameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_frameIndex = (m_frameIndex + 1) % m_frameFences.size();
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    void OpenGLRenderer::waitForNextFrame()
+    {
+        waitForFrameFence();
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    void OpenGLRenderer::waitForFrameFence()
+    {
+        GLsync& fence = m_frameFences[m_frameIndex];
+        if (!fence)
+        {
+            return;
+        }
+
+        constexpr GLuint64 timeout = 1000000000; // 1 second in nanoseconds
+        GLenum waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        ASSERT(waitResult != GL_WAIT_FAILED, "Failed to wait for frame fence");
+        glDeleteSync(fence);
+        fence = nullptr;
     }
 
     ////////////////////////////////////////////////////////////////////////
@@ -138,7 +325,37 @@ namespace Engine::Visual
         glGenBuffers(1, &model.vertexBuffer);
         glBindBuffer(GL_ARRAY_BUFFER, model.vertexBuffer);
         glBufferData(GL_ARRAY_BUFFER, model.vertices.size() * sizeof(Vertex), model.vertices.data(), GL_STATIC_DRAW);
+        setVertexAttributes();
+
+        for (auto& subMesh : model.meshes)
+        {
+            subMesh.indexCount = static_cast<GLsizei>(subMesh.indices.size());
+            glGenBuffers(1, &subMesh.indexBuffer);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, subMesh.indexBuffer);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, subMesh.indices.size() * sizeof(unsigned int), subMesh.indices.data(), GL_STATIC_DRAW);
+        }
+
+        glBindVertexArray(0);
+
+        if (!m_depthPrePass)
+        {
+            return;
+        }
+
+        std::vector<glm::vec3> positions;
+        positions.reserve(model.vertices.size());
+        for (const Vertex& vertex : model.vertices)
+        {
+            positions.push_back(vertex.position);
+        }
 
+        createDepthVertexArray(model, { GltfModel::BufferRange{ positions.data(), positions.size() * sizeof(glm::vec3) } });
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    void OpenGLRenderer::setVertexAttributes()
+    {
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
         glEnableVertexAttribArray(0);
 
@@ -147,134 +364,188 @@ namespace Engine::Visual
 
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
         glEnableVertexAttribArray(2);
+    }
 
-        for (auto& subMesh : model.meshes)
-        {
-            glGenBuffers(1, &subMesh.indexBuffer);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, subMesh.indexBuffer);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, subMesh.indices.size() * sizeof(unsigned int), subMesh.indices.data(), GL_STATIC_DRAW);
-        }
+    ////////////////////////////////////////////////////////////////////////
+
+    void OpenGLRenderer::createDepthVertexArray(ModelData& model, const std::vector<GltfModel::BufferRange>& positionRanges)
+    {
+        glGenVertexArrays(1, &model.depthVao);
+        glBindVertexArray(model.depthVao);
+
+        glGenBuffers(1, &model.positionBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, model.positionBuffer);
+        uploadBufferRanges(GL_ARRAY_BUFFER, positionRanges);
+
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+        glEnableVertexAttribArray(0);
 
         glBindVertexArray(0);
     }
 
     ////////////////////////////////////////////////////////////////////////
 
-    bool OpenGLRenderer::loadModelFromFile(ModelData& model, const std::string& filename)
+    void OpenGLRenderer::uploadBufferRanges(GLenum target, const std::vector<GltfModel::BufferRange>& ranges)
     {
-        std::filesystem::path fullPath(filename);
-        std::filesystem::path matDir = fullPath.parent_path();
+        if (ranges.size() == 1)
+        {
+            glBufferData(target, ranges[0].size, ranges[0].data, GL_STATIC_DRAW);
+            return;
+        }
+
+        size_t totalSize = 0;
+        for (const GltfModel::BufferRange& range : ranges)
+        {
+            totalSize += range.size;
+        }
 
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-        std::string warn, err;
+        glBufferData(target, totalSize, nullptr, GL_STATIC_DRAW);
 
-        bool success = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename.c_str(), matDir.string().c_str());
-        if (!success) 
+        size_t offset = 0;
+        for (const GltfModel::BufferRange& range : ranges)
         {
-            return false;
+            glBufferSubData(target, offset, range.size, range.data);
+            offset += range.size;
         }
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    bool OpenGLRenderer::loadModelFromFile(ModelData& model, const ObjModel& obj, const std::string& filename)
+    {
+        static_assert(sizeof(Vertex) == sizeof(GltfModel::Vertex), "Vertex layout must match the model loaders");
 
-        // Load materials
-        for (const auto& mat : materials)
+        for (const ObjModel::Material& objMaterial : obj.getMaterials())
         {
             Material material;
-            material.ambientColor = glm::vec3(mat.ambient[0], mat.ambient[1], mat.ambient[2]);
-            material.diffuseColor = glm::vec3(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2]);
-            material.specularColor = glm::vec3(mat.specular[0], mat.specular[1], mat.specular[2]);
-            material.shininess = mat.shininess;
+            material.ambientColor = glm::make_vec3(objMaterial.ambientColor);
+            material.diffuseColor = glm::make_vec3(objMaterial.diffuseColor);
+            material.specularColor = glm::make_vec3(objMaterial.specularColor);
+            material.shininess = objMaterial.shininess;
+            material.diffuseTextureId = !objMaterial.diffuseTexture.empty() && loadTexture(objMaterial.diffuseTexture) ?
+                objMaterial.diffuseTexture : m_defaultMaterial.diffuseTextureId;
+            model.materials.push_back(material);
+        }
 
-            if (!mat.diffuse_texname.empty())
-            {
+        const std::vector<GltfModel::Vertex>& vertices = obj.getVertices();
+        model.vertices.resize(vertices.size());
+        std::memcpy(model.vertices.data(), vertices.data(), vertices.size() * sizeof(Vertex));
 
-                std::string texturePath = (matDir / mat.diffuse_texname).string();
-                if (loadTexture(texturePath))
-                {
-                    material.diffuseTextureId = texturePath;
-                }
-                else
+        for (const ObjModel::Shape& shape : obj.getShapes())
+        {
+            SubMesh subMesh;
+            subMesh.indices.assign(shape.indices.begin(), shape.indices.end());
+            subMesh.materialId = shape.materialId;
+            model.meshes.push_back(std::move(subMesh));
+        }
+
+        if (m_textureStreamer.isEnabled())
+        {
+            TextureStreamer::ModelCoverage coverage;
+            const auto* vertices = reinterpret_cast<const GltfModel::Vertex*>(model.vertices.data());
+            for (const SubMesh& subMesh : model.meshes)
+            {
+                if (subMesh.materialId >= 0 && subMesh.materialId < static_cast<int>(model.materials.size()))
                 {
-                    material.diffuseTextureId = m_defaultMaterial.diffuseTextureId;
+                    coverage.addTriangles(model.materials[subMesh.materialId].diffuseTextureId, vertices, model.vertices.size(), subMesh.indices.data(), sizeof(unsigned int), subMesh.indices.size());
                 }
             }
-            else
-            {
-                material.diffuseTextureId = m_defaultMaterial.diffuseTextureId;
-            }
+            m_textureStreamer.addModel(filename, coverage);
+        }
 
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    bool OpenGLRenderer::loadModelFromGltf(ModelData& model, const GltfModel& gltf, const std::string& filename)
+    {
+        for (const GltfModel::Material& gltfMaterial : gltf.getMaterials())
+        {
+            Material material;
+            gltfMaterial.getPhongParameters(
+                glm::value_ptr(material.ambientColor),
+                glm::value_ptr(material.diffuseColor),
+                glm::value_ptr(material.specularColor),
+                material.shininess);
+            material.diffuseTextureId = loadGltfTexture(gltf, gltfMaterial.baseColorTexture);
             model.materials.push_back(material);
         }
 
-        // Load shapes and vertices
-        for (const auto& shape : shapes)
+        if (m_textureStreamer.isEnabled())
         {
-            SubMesh subMesh;
-
-            for (const auto& index : shape.mesh.indices)
+            TextureStreamer::ModelCoverage coverage;
+            for (const GltfModel::Primitive& primitive : gltf.getPrimitives())
             {
-                Vertex vertex = {};
-                vertex.position = glm::vec3(
-                    attrib.vertices[3 * index.vertex_index + 0],
-                    attrib.vertices[3 * index.vertex_index + 1],
-                    attrib.vertices[3 * index.vertex_index + 2]
-                );
-
-                if (index.normal_index >= 0) {
-                    vertex.normal = glm::vec3(
-                        attrib.normals[3 * index.normal_index + 0],
-                        attrib.normals[3 * index.normal_index + 1],
-                        attrib.normals[3 * index.normal_index + 2]
-                    );
+                if (primitive.materialId >= 0 && primitive.materialId < static_cast<int>(model.materials.size()))
+                {
+                    coverage.addTriangles(model.materials[primitive.materialId].diffuseTextureId, static_cast<const GltfModel::Vertex*>(primitive.vertices.data),
+                        primitive.vertexCount, primitive.indices.data, primitive.indexSize, primitive.indexCount);
                 }
+            }
+            m_textureStreamer.addModel(filename, coverage);
+        }
 
-                if (index.texcoord_index >= 0) {
-                    vertex.texCoord = glm::vec2(
-                        attrib.texcoords[2 * index.texcoord_index + 0],
-                        attrib.texcoords[2 * index.texcoord_index + 1]
-                    );
-                }
+        glGenVertexArrays(1, &model.vao);
+        glBindVertexArray(model.vao);
 
-                model.vertices.push_back(vertex);
-                subMesh.indices.push_back(static_cast<unsigned int>(model.vertices.size() - 1));
-            }
+        std::vector<GltfModel::BufferRange> vertexRanges;
+        std::vector<GltfModel::BufferRange> positionRanges;
+        for (const GltfModel::Primitive& primitive : gltf.getPrimitives())
+        {
+            vertexRanges.push_back(primitive.vertices);
+            positionRanges.push_back(primitive.positions);
+
+            SubMesh subMesh;
+            subMesh.materialId = primitive.materialId;
+            subMesh.indexCount = static_cast<GLsizei>(primitive.indexCount);
+            subMesh.baseVertex = static_cast<GLint>(primitive.baseVertex);
+            subMesh.indexType = primitive.indexSize == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+            glGenBuffers(1, &subMesh.indexBuffer);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, subMesh.indexBuffer);
+            uploadBufferRanges(GL_ELEMENT_ARRAY_BUFFER, { primitive.indices });
 
-            subMesh.materialId = shape.mesh.material_ids.empty() ? 0 : shape.mesh.material_ids[0];
             model.meshes.push_back(std::move(subMesh));
         }
 
+        glGenBuffers(1, &model.vertexBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, model.vertexBuffer);
+        uploadBufferRanges(GL_ARRAY_BUFFER, vertexRanges);
+        setVertexAttributes();
+
+        glBindVertexArray(0);
+        ASSERT_OPENGL("Unable to create buffers for model: {}", filename);
+
+        if (m_depthPrePass)
+        {
+            createDepthVertexArray(model, positionRanges);
+        }
+
         return true;
     }
 
     ////////////////////////////////////////////////////////////////////////
 
-    void OpenGLRenderer::setCameraProperties(const Utils::Vector3& position, const Utils::Vector3& rotation)
+    std::string OpenGLRenderer::loadGltfTexture(const GltfModel& gltf, int imageId)
     {
-		glm::vec3 pos = glm::vec3(position.x, position.y, position.z);
-
-        float pitch = -rotation.x;
-        float yaw = rotation.y; 
-        float roll = rotation.z; 
-
-        glm::vec3 forward;
-        forward.x = cos(pitch) * sin(yaw);
-        forward.y = sin(pitch);
-        forward.z = cos(pitch) * cos(yaw);
-        forward = glm::normalize(forward);
-
-        glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+        if (imageId < 0)
+        {
+            return m_defaultMaterial.diffuseTextureId;
+        }
 
-        glm::vec3 right = glm::normalize(glm::cross(up, forward));
+        const GltfModel::Image& image = gltf.getImages()[imageId];
+        bool loaded = image.data.data ? loadTextureFromMemory(image.id, image.data) : !image.path.empty() && loadTexture(image.path);
+        return loaded ? image.id : m_defaultMaterial.diffuseTextureId;
+    }
 
-        glm::mat4 rollMatrix = glm::rotate(glm::mat4(1.0f), roll, forward);
-        right = glm::vec3(rollMatrix * glm::vec4(right, 0.0f));
-        up = glm::normalize(glm::cross(forward, right));
+    ////////////////////////////////////////////////////////////////////////
 
-        m_viewMatrix = glm::lookAt(
-            pos,
-            pos + forward,
-            up
-        );
+    void OpenGLRenderer::setCamera(const Utils::Matrix4& view, const Utils::Matrix4& projection)
+    {
+        m_viewMatrix = toRightHandedView(view);
+        m_projectionMatrix = toRightHandedProjection(projection, true);
+        m_textureStreamer.setCamera(view, projection, m_viewportHeight);
     }
 
     ////////////////////////////////////////////////////////////////////////
@@ -288,6 +559,40 @@ namespace Engine::Visual
 
     bool OpenGLRenderer::destroyModelInstance(IModelInstance& modelInstance)
     {
+        const auto& itr = m_instanceVertices.find(&modelInstance);
+        if (itr == m_instanceVertices.end())
+        {
+            return true;
+        }
+
+        glDeleteBuffers(1, &itr->second.vertexBuffer);
+        glDeleteVertexArrays(1, &itr->second.vao);
+        m_instanceVertices.erase(itr);
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    bool OpenGLRenderer::updateInstanceVertices(IModelInstance& modelInstance, const void* vertices, size_t vertexCount)
+    {
+        InstanceVertices& instanceVertices = m_instanceVertices[&modelInstance];
+        if (!instanceVertices.vao)
+        {
+            glGenVertexArrays(1, &instanceVertices.vao);
+            glBindVertexArray(instanceVertices.vao);
+
+            glGenBuffers(1, &instanceVertices.vertexBuffer);
+            glBindBuffer(GL_ARRAY_BUFFER, instanceVertices.vertexBuffer);
+            setVertexAttributes();
+
+            glBindVertexArray(0);
+        }
+
+        // Respecifying the whole store orphans the old one, so draws of the previous frames aren't waited for
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVertices.vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertices, GL_STREAM_DRAW);
+        ASSERT_OPENGL("Unable to update vertices of instance of model: {}", modelInstance.GetId());
+
         return true;
     }
 
@@ -308,11 +613,27 @@ namespace Engine::Visual
         }
 
         m_textures.erase(itr);
+        m_textureStats.onTextureDestroyed(filename);
+        m_textureStreamer.removeTexture(filename);
         return true;
     }
 
     ////////////////////////////////////////////////////////////////////////
 
+    const TextureStats& OpenGLRenderer::getTextureStats() const
+    {
+        return m_textureStats;
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    const ParticleStats& OpenGLRenderer::getParticleStats() const
+    {
+        return m_particleStats;
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
     bool OpenGLRenderer::unloadModel(const std::string& filename)
     {
         const auto& itr = m_models.find(filename);
@@ -339,7 +660,18 @@ namespace Engine::Visual
             glDeleteVertexArrays(1, &model.vao);
         }
 
+        if (model.positionBuffer)
+        {
+            glDeleteBuffers(1, &model.positionBuffer);
+        }
+
+        if (model.depthVao)
+        {
+            glDeleteVertexArrays(1, &model.depthVao);
+        }
+
         m_models.erase(itr);
+        m_textureStreamer.removeModel(filename);
         return true;
     }
 
@@ -347,6 +679,24 @@ namespace Engine::Visual
 
     void OpenGLRenderer::cleanUp()
     {
+        m_textureStreamer.clear();
+
+        for (GLsync& fence : m_frameFences)
+        {
+            if (fence)
+            {
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+
+        for (auto& [instance, instanceVertices] : m_instanceVertices)
+        {
+            glDeleteBuffers(1, &instanceVertices.vertexBuffer);
+            glDeleteVertexArrays(1, &instanceVertices.vao);
+        }
+        m_instanceVertices.clear();
+
         for (const std::string& modelId : Utils::getKeys(m_models))
         {
             unloadModel(modelId);
@@ -363,6 +713,32 @@ namespace Engine::Visual
             m_shaderProgram = 0;
         }
 
+        if (m_depthShaderProgram)
+        {
+            glDeleteProgram(m_depthShaderProgram);
+            m_depthShaderProgram = 0;
+        }
+
+        if (m_particleShaderProgram)
+        {
+            glDeleteProgram(m_particleShaderProgram);
+            m_particleShaderProgram = 0;
+        }
+
+        if (m_particleBuffer)
+        {
+            glDeleteBuffers(1, &m_particleBuffer);
+            m_particleBuffer = 0;
+            m_particleBufferCapacity = 0;
+        }
+
+        if (m_particleVao)
+        {
+            glDeleteVertexArrays(1, &m_particleVao);
+            m_particleVao = 0;
+        }
+        m_particles.clear();
+
         if (m_frameBufferTexture) 
         {
             glDeleteTextures(1, &m_frameBufferTexture);
@@ -406,6 +782,15 @@ namespace Engine::Visual
 
     ////////////////////////////////////////////////////////////////////////
 
+    ModelSource::Options OpenGLRenderer::getModelSourceOptions() const
+    {
+        ModelSource::Options options;
+        options.positionStream = m_depthPrePass;
+        return options;
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
     bool OpenGLRenderer::loadModel(const std::string& filename)
     {
         if (m_models.contains(filename))
@@ -413,12 +798,35 @@ namespace Engine::Visual
             return true;
         }
 
+        ModelSource source;
+        return source.load(filename, getModelSourceOptions()) && loadModel(filename, source);
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    bool OpenGLRenderer::loadModel(const std::string& filename, const ModelSource& source)
+    {
+        if (m_models.contains(filename))
+        {
+            return true;
+        }
+
         ModelData modelData;
-        if (!loadModelFromFile(modelData, filename))
+        if (source.isGltf())
         {
-            return false;
+            if (!loadModelFromGltf(modelData, source.getGltf(), filename))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            if (!loadModelFromFile(modelData, source.getObj(), filename))
+            {
+                return false;
+            }
+            createBuffersForModel(modelData);
         }
-        createBuffersForModel(modelData);
 
         m_models.emplace(filename, std::move(modelData));
         return true;
@@ -433,22 +841,109 @@ namespace Engine::Visual
             return true;
         }
 
+        auto loadStart = std::chrono::high_resolution_clock::now();
+
+        // Streamed textures start at a reduced level, their source is decoded again when finer ones are needed
+        if (m_textureStreamer.isEnabled() && filename != DEFAULT_TEXTURE)
+        {
+            TextureStreamer::Upload upload;
+            if (!m_textureStreamer.addTexture(filename, filename, upload))
+            {
+                return false;
+            }
+            createTexture(filename, upload.pixels.data(), upload.width, upload.height, loadStart);
+            return true;
+        }
+
+        // Converted to RGB like the embedded images, the textures are created as GL_RGB
         int width, height, channels;
-        unsigned char* data = stbi_load(filename.c_str(), &width, &height, &channels, 0);
+        unsigned char* data = stbi_load(filename.c_str(), &width, &height, &channels, STBI_rgb);
         if (!data) {
             return false;
         }
 
+        createTexture(filename, data, width, height, loadStart);
+        stbi_image_free(data);
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    bool OpenGLRenderer::loadTextureFromMemory(const std::string& textureId, const GltfModel::BufferRange& data)
+    {
+        if (m_textures.contains(textureId))
+        {
+            return true;
+        }
+
+        auto loadStart = std::chrono::high_resolution_clock::now();
+
+        if (m_textureStreamer.isEnabled())
+        {
+            TextureStreamer::Upload upload;
+            bool added = m_textureStreamer.addTexture(textureId, data.data, data.size, upload);
+            ASSERT(added, "Can't decode texture: {}", textureId);
+            if (!added)
+            {
+                return false;
+            }
+            createTexture(textureId, upload.pixels.data(), upload.width, upload.height, loadStart);
+            return true;
+        }
+
+        int width, height, channels;
+        unsigned char* pixels = stbi_load_from_memory(static_cast<const stbi_uc*>(data.data), static_cast<int>(data.size), &width, &height, &channels, STBI_rgb);
+        ASSERT(pixels, "Can't decode texture: {}", textureId);
+        if (!pixels)
+        {
+            return false;
+        }
+
+        createTexture(textureId, pixels, width, height, loadStart);
+        stbi_image_free(pixels);
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    void OpenGLRenderer::createTexture(const std::string& textureId, const unsigned char* pixels, int width, int height, std::chrono::high_resolution_clock::time_point loadStart)
+    {
         GLuint texture;
         glGenTextures(1, &texture);
         glBindTexture(GL_TEXTURE_2D, texture);
 
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels);
         glGenerateMipmap(GL_TEXTURE_2D);
-        stbi_image_free(data);
 
-        m_textures.emplace(filename, texture);
-        return true;
+        m_textures.emplace(textureId, texture);
+
+        // Drivers store RGB with 4 bytes per texel, the upload itself may still be in flight
+        std::chrono::duration<double> loadTime = std::chrono::high_resolution_clock::now() - loadStart;
+        m_textureStats.onTextureCreated(textureId, TextureStats::getMipChainSize(width, height, 4), loadTime.count());
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    void OpenGLRenderer::updateStreamedTextures()
+    {
+        m_textureUploads.clear();
+        m_textureStreamer.update(m_textureStats, m_textureUploads);
+
+        // The driver keeps deleted textures alive until the frames in flight sampling them are done
+        for (const TextureStreamer::Upload& upload : m_textureUploads)
+        {
+            auto loadStart = std::chrono::high_resolution_clock::now();
+            const auto& itr = m_textures.find(upload.textureId);
+            if (itr == m_textures.end())
+            {
+                continue;
+            }
+
+            glDeleteTextures(1, &itr->second);
+            m_textures.erase(itr);
+            m_textureStats.onTextureDestroyed(upload.textureId);
+            createTexture(upload.textureId, upload.pixels.data(), upload.width, upload.height, loadStart);
+        }
     }
 
     ////////////////////////////////////////////////////////////////////////
@@ -538,11 +1033,12 @@ namespace Engine::Visual
         // Store the HGLRC for later use
         m_hglrc = tempContext;
         
+        // WGL has no mailbox mode, it falls back to an unsynchronized swap like immediate
         auto wglSwapIntervalEXT = (PFNWGLSWAPINTERVALEXTPROC)wglGetProcAddress("wglSwapIntervalEXT");
-        ASSERT(wglSwapIntervalEXT, "Failed to get wglSwapIntervalEXT for disabling VSync");
+        ASSERT(wglSwapIntervalEXT, "Failed to get wglSwapIntervalEXT for setting the swap interval");
         if (wglSwapIntervalEXT)
         {
-            wglSwapIntervalEXT(0);
+            wglSwapIntervalEXT(m_framePacing.getPresentMode() == PresentMode::VSync ? 1 : 0);
         }
     }
 
@@ -554,6 +1050,9 @@ namespace Engine::Visual
         glEnable(GL_DEPTH_TEST);
         glEnable(GL_CULL_FACE);
         glFrontFace(GL_CW);
+
+        // RGB rows of odd widths aren't padded to 4 bytes, streamed levels have any width
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     }
 
     ////////////////////////////////////////////////////////////////////////
@@ -593,9 +1092,7 @@ namespace Engine::Visual
         int height = rect.bottom - rect.top;
 
         glViewport(0, 0, width, height);
-        float aspectRatio = (float)(width) / (float)(height);
-
-        m_projectionMatrix = glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, 1000.0f);
+        m_viewportHeight = height;
     }
 
     ////////////////////////////////////////////////////////////////////////
@@ -650,6 +1147,88 @@ namespace Engine::Visual
 
     ////////////////////////////////////////////////////////////////////////
 
+    void OpenGLRenderer::createDepthShaderProgram(const std::string& vsSource)
+    {
+        // Without a fragment shader only depth gets written, which is all the pre-pass needs
+        GLuint vertexShader = createShader(vsSource, GL_VERTEX_SHADER);
+
+        GLuint program = glCreateProgram();
+        glAttachShader(program, vertexShader);
+        glLinkProgram(program);
+
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            char infoLog[512];
+            glGetProgramInfoLog(program, 512, nullptr, infoLog);
+            ASSERT(success, "Depth shader program linking error: {}", infoLog);
+            throw std::runtime_error("Depth shader program linking failed.");
+        }
+
+        glDeleteShader(vertexShader);
+
+        m_depthShaderProgram = program;
+        m_depthViewMatrixLoc = glGetUniformLocation(m_depthShaderProgram, "viewMatrix");
+        m_depthProjectionMatrixLoc = glGetUniformLocation(m_depthShaderProgram, "projectionMatrix");
+        m_depthModelMatrixLoc = glGetUniformLocation(m_depthShaderProgram, "modelMatrix");
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    void OpenGLRenderer::createParticleShaderProgram(const std::string& vsSource, const std::string& fsSource)
+    {
+        GLuint vertexShader = createShader(vsSource, GL_VERTEX_SHADER);
+        GLuint fragmentShader = createShader(fsSource, GL_FRAGMENT_SHADER);
+
+        GLuint program = glCreateProgram();
+        glAttachShader(program, vertexShader);
+        glAttachShader(program, fragmentShader);
+        glLinkProgram(program);
+
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            char infoLog[512];
+            glGetProgramInfoLog(program, 512, nullptr, infoLog);
+            ASSERT(success, "Particle shader program linking error: {}", infoLog);
+            throw std::runtime_error("Particle shader program linking failed.");
+        }
+
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+
+        m_particleShaderProgram = program;
+        m_particleViewMatrixLoc = glGetUniformLocation(m_particleShaderProgram, "viewMatrix");
+        m_particleProjectionMatrixLoc = glGetUniformLocation(m_particleShaderProgram, "projectionMatrix");
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
+    void OpenGLRenderer::createParticleBuffers()
+    {
+        glGenVertexArrays(1, &m_particleVao);
+        glBindVertexArray(m_particleVao);
+
+        // Storage is allocated on the first frame with particles
+        glGenBuffers(1, &m_particleBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, m_particleBuffer);
+
+        // Both attributes advance once per instance, the quad has no vertex buffer
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)offsetof(ParticleInstance, position));
+        glEnableVertexAttribArray(0);
+        glVertexAttribDivisor(0, 1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)offsetof(ParticleInstance, color));
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+
+        glBindVertexArray(0);
+        ASSERT_OPENGL("Unable to create particle buffers");
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+
     void OpenGLRenderer::createShaderFields()
     {
         glUseProgram(m_shaderProgram);
@@ -7,8 +7,11 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "IRenderer.h"
+#include "GltfModel.h"
+#include "TextureStreamer.h"
 #include <string>
 #include <vector>
+#include <chrono>
 
 namespace Engine::Visual
 {
@@ -16,6 +19,9 @@ namespace Engine::Visual
     {
     public:
 
+        void setFramePacing(const FramePacing& framePacing) override;
+        void setDepthPrePass(bool enabled) override;
+        void setTextureStreaming(const TextureStreaming& settings, JobsManager& jobsManager) override;
         void init(const Window& window) override;
         void clearBackground(float r, float g, float b, float a) override;
 
@@ -24,16 +30,23 @@ namespace Engine::Visual
             const Utils::Vector3& position,
             const Utils::Vector3& rotation,
             const Utils::Vector3& scale) override;
+        void drawParticles(const ParticleInstance* particles, size_t count) override;
         void render() override;
+        void waitForNextFrame() override;
 
+        ModelSource::Options getModelSourceOptions() const override;
         bool loadModel(const std::string& filename) override;
+        bool loadModel(const std::string& filename, const ModelSource& source) override;
         bool loadTexture(const std::string& filename) override;
 
-        void setCameraProperties(const Utils::Vector3& position, const Utils::Vector3& rotation) override;
+        void setCamera(const Utils::Matrix4& view, const Utils::Matrix4& projection) override;
         std::unique_ptr<IModelInstance> createModelInstance(const std::string& filename) override;
 
         bool destroyModelInstance(IModelInstance& modelInstance) override;
+        bool updateInstanceVertices(IModelInstance& modelInstance, const void* vertices, size_t vertexCount) override;
         bool unloadTexture(const std::string& filename) override;
+        const TextureStats& getTextureStats() const override;
+        const ParticleStats& getParticleStats() const override;
         bool unloadModel(const std::string& filename) override;
         void cleanUp() override;
 
@@ -47,9 +60,12 @@ namespace Engine::Visual
 
         struct SubMesh
         {
-            std::vector<unsigned int> indices;
+            std::vector<unsigned int> indices; // Empty for glTF models, their buffers are filled straight from the file
             GLuint indexBuffer;
             int materialId;
+            GLsizei indexCount = 0;
+            GLint baseVertex = 0;
+            GLenum indexType = GL_UNSIGNED_INT;
         };
 
         struct Material
@@ -66,11 +82,27 @@ namespace Engine::Visual
             std::vector<SubMesh> meshes;
             GLuint vertexBuffer;
             GLuint vao;
+            GLuint positionBuffer = 0; // Position-only stream, only created for the depth pre-pass
+            GLuint depthVao = 0;
             std::vector<Vertex> vertices;
             std::vector<Material> materials;
             glm::mat4 worldMatrix;
         };
 
+        // Vertex stream of one instance, used instead of the model vertex buffer
+        struct InstanceVertices
+        {
+            GLuint vertexBuffer = 0;
+            GLuint vao = 0;
+        };
+
+        struct DrawCommand
+        {
+            const IModelInstance* instance;
+            const ModelData* model;
+            glm::mat4 worldMatrix;
+        };
+
     private:
         static glm::mat4 getWorldMatrix(const Utils::Vector3& position, const Utils::Vector3& rotation, const Utils::Vector3& scale);
 
@@ -79,21 +111,43 @@ namespace Engine::Visual
         void createWglContext();
         void setInitialOpenGLState();
         void createShaderProgram(const std::string& vsSource, const std::string& fsSource);
+        void createDepthShaderProgram(const std::string& vsSource);
+        void createParticleShaderProgram(const std::string& vsSource, const std::string& fsSource);
+        void createParticleBuffers();
         void createShaderFields();
         void createFrameBuffer();
         void createViewport();
         void createDefaultMaterial();
 
+        void waitForFrameFence();
+
+        void drawModel(const IModelInstance& model, const ModelData& modelData, const glm::mat4& worldMatrix);
+        void drawModelDepth(const IModelInstance& model, const ModelData& modelData, const glm::mat4& worldMatrix);
+        void renderDrawCommands();
+        void renderParticles();
+
         GLuint createShader(const std::string& source, GLenum shaderType);
         const GLuint& getTexture(const std::string& textureId) const;
         void createBuffersForModel(ModelData& model);
-        bool loadModelFromFile(ModelData& model, const std::string& filename);
+        void setVertexAttributes();
+        void createDepthVertexArray(ModelData& model, const std::vector<GltfModel::BufferRange>& positionRanges);
+        void uploadBufferRanges(GLenum target, const std::vector<GltfModel::BufferRange>& ranges);
+        bool loadModelFromFile(ModelData& model, const ObjModel& obj, const std::string& filename);
+        bool loadModelFromGltf(ModelData& model, const GltfModel& gltf, const std::string& filename);
+        std::string loadGltfTexture(const GltfModel& gltf, int imageId);
+        bool loadTextureFromMemory(const std::string& textureId, const GltfModel::BufferRange& data);
+        void createTexture(const std::string& textureId, const unsigned char* pixels, int width, int height, std::chrono::high_resolution_clock::time_point loadStart);
+        void updateStreamedTextures();
 
     private:
         HWND m_hwnd;
         HDC m_hdc;
         HGLRC m_hglrc;
 
+        FramePacing m_framePacing;
+        std::vector<GLsync> m_frameFences; // One fence per frame in flight, the driver queue depth isn't controllable otherwise
+        size_t m_frameIndex = 0;
+
         GLuint m_shaderProgram;
         GLuint m_viewMatrixLoc;
         GLuint m_projectionMatrixLoc;
@@ -101,12 +155,35 @@ namespace Engine::Visual
         GLuint m_frameBuffer;
         GLuint m_frameBufferTexture;
 
+        // Depth pre-pass
+        bool m_depthPrePass = false;
+        GLuint m_depthShaderProgram = 0;
+        GLuint m_depthViewMatrixLoc;
+        GLuint m_depthProjectionMatrixLoc;
+        GLuint m_depthModelMatrixLoc;
+        std::vector<DrawCommand> m_drawCommands;
+
+        // Particles, drawn as instanced quads after the models
+        GLuint m_particleShaderProgram = 0;
+        GLuint m_particleViewMatrixLoc;
+        GLuint m_particleProjectionMatrixLoc;
+        GLuint m_particleVao = 0;
+        GLuint m_particleBuffer = 0;
+        size_t m_particleBufferCapacity = 0; // In particles
+        std::vector<ParticleInstance> m_particles;
+        ParticleStats m_particleStats;
+
+        int m_viewportHeight = 0;
         Material m_defaultMaterial;
-        glm::mat4 m_viewMatrix;
-        glm::mat4 m_projectionMatrix;
+        glm::mat4 m_viewMatrix = glm::mat4(1.0f);
+        glm::mat4 m_projectionMatrix = glm::mat4(1.0f);
 
         std::unordered_map<std::string, GLuint> m_textures;
+        TextureStats m_textureStats;
+        TextureStreamer m_textureStreamer;
+        std::vector<TextureStreamer::Upload> m_textureUploads;
         std::unordered_map<std::string, ModelData> m_models;
+        std::unordered_map<const IModelInstance*, InstanceVertices> m_instanceVertices;
 
     };
 }
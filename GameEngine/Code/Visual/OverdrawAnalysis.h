@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+#include "Utils/Parser.h"
+
+namespace Engine::Visual
+{
+    // Per-pixel instrumentation of the software rasterizer, heatmaps and a summary are written to outputDirectory
+    class OverdrawAnalysis
+    {
+    public:
+        std::string outputDirectory; // Empty disables the analysis
+        int heatmapInterval = 0; // Frames between heatmap dumps, 0 writes only the ones of the last frame
+        int heatmapMaxCount = 8; // Count at which the heatmap color saturates
+
+        SERIALIZABLE(
+            PROPERTY(OverdrawAnalysis, outputDirectory),
+            PROPERTY(OverdrawAnalysis, heatmapInterval),
+            PROPERTY(OverdrawAnalysis, heatmapMaxCount)
+        )
+    };
+}
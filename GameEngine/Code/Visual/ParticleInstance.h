@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Engine::Visual
+{
+    // One camera facing quad, the layout is read directly by the particle shaders of every backend
+    struct ParticleInstance
+    {
+        float position[3];
+        float size; // Edge length in world units
+        float color[4]; // Straight alpha, blended over the scene
+    };
+
+    static_assert(sizeof(ParticleInstance) == 32, "Particle shaders expect 32 byte instances");
+
+    // Particle counters kept by every renderer, separate from the simulation cost measured by ParticleSystem
+    class ParticleStats
+    {
+    public:
+        size_t renderedFrames = 0; // Frames with at least one particle
+        size_t renderedParticles = 0;
+        double renderTime = 0.0; // Seconds of CPU time spent uploading the instances and recording the draws
+    };
+}
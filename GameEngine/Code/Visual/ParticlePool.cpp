@@ -0,0 +1,240 @@
+#include "ParticlePool.h"
+
+#include <algorithm>
+#include <immintrin.h>
+
+#include "Utils/Geometry.h"
+
+#ifdef _MSC_VER
+#define PARTICLES_TARGET_AVX
+#else
+#define PARTICLES_TARGET_AVX __attribute__((target("avx")))
+#endif
+
+namespace Engine::Visual
+{
+	namespace
+	{
+		struct ParticleStreams
+		{
+			float* position[3];
+			float* velocity[3];
+			float* age;
+		};
+
+		struct IntegrationStep
+		{
+			float dt;
+			float damping; // Velocity kept after one step of drag
+			float gravity[3]; // Velocity gained in one step
+		};
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Same operations in the same order as the SIMD kernels, so every level gives the same result
+		void integrateScalar(const IntegrationStep& step, const ParticleStreams& streams, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				for (int axis = 0; axis < 3; axis++)
+				{
+					float velocity = streams.velocity[axis][i] * step.damping + step.gravity[axis];
+					streams.velocity[axis][i] = velocity;
+					streams.position[axis][i] = streams.position[axis][i] + velocity * step.dt;
+				}
+				streams.age[i] = streams.age[i] + step.dt;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// SIMD kernels. Return the index of the first unprocessed particle
+		//////////////////////////////////////////////////////////////////////////
+
+		size_t integrateSSE(const IntegrationStep& step, const ParticleStreams& streams, size_t count)
+		{
+			__m128 dt = _mm_set1_ps(step.dt);
+			__m128 damping = _mm_set1_ps(step.damping);
+			__m128 gravity[3] = { _mm_set1_ps(step.gravity[0]), _mm_set1_ps(step.gravity[1]), _mm_set1_ps(step.gravity[2]) };
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				for (int axis = 0; axis < 3; axis++)
+				{
+					__m128 velocity = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(streams.velocity[axis] + i), damping), gravity[axis]);
+					_mm_storeu_ps(streams.velocity[axis] + i, velocity);
+					_mm_storeu_ps(streams.position[axis] + i, _mm_add_ps(_mm_loadu_ps(streams.position[axis] + i), _mm_mul_ps(velocity, dt)));
+				}
+				_mm_storeu_ps(streams.age + i, _mm_add_ps(_mm_loadu_ps(streams.age + i), dt));
+			}
+			return i;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		PARTICLES_TARGET_AVX
+		size_t integrateAVX(const IntegrationStep& step, const ParticleStreams& streams, size_t count)
+		{
+			__m256 dt = _mm256_set1_ps(step.dt);
+			__m256 damping = _mm256_set1_ps(step.damping);
+			__m256 gravity[3] = { _mm256_set1_ps(step.gravity[0]), _mm256_set1_ps(step.gravity[1]), _mm256_set1_ps(step.gravity[2]) };
+
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				for (int axis = 0; axis < 3; axis++)
+				{
+					__m256 velocity = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(streams.velocity[axis] + i), damping), gravity[axis]);
+					_mm256_storeu_ps(streams.velocity[axis] + i, velocity);
+					_mm256_storeu_ps(streams.position[axis] + i, _mm256_add_ps(_mm256_loadu_ps(streams.position[axis] + i), _mm256_mul_ps(velocity, dt)));
+				}
+				_mm256_storeu_ps(streams.age + i, _mm256_add_ps(_mm256_loadu_ps(streams.age + i), dt));
+			}
+			return i;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	ParticlePool::ParticlePool(size_t capacity, uint32_t seed):
+		m_capacity(capacity),
+		m_random(seed),
+		m_positionX(capacity),
+		m_positionY(capacity),
+		m_positionZ(capacity),
+		m_velocityX(capacity),
+		m_velocityY(capacity),
+		m_velocityZ(capacity),
+		m_age(capacity),
+		m_lifetime(capacity)
+	{
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t ParticlePool::getCapacity() const
+	{
+		return m_capacity;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t ParticlePool::size() const
+	{
+		return m_count;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t ParticlePool::emit(size_t count, const Utils::Vector3& origin, const Utils::Vector3& velocity, float velocitySpread, float lifetime, float lifetimeVariance)
+	{
+		size_t emitted = std::min(count, m_capacity - m_count);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+		for (size_t i = m_count; i < m_count + emitted; i++)
+		{
+			m_positionX[i] = origin.x;
+			m_positionY[i] = origin.y;
+			m_positionZ[i] = origin.z;
+
+			float velocityX = velocity.x + unit(m_random) * velocitySpread;
+			float velocityY = velocity.y + unit(m_random) * velocitySpread;
+			float velocityZ = velocity.z + unit(m_random) * velocitySpread;
+			m_velocityX[i] = velocityX;
+			m_velocityY[i] = velocityY;
+			m_velocityZ[i] = velocityZ;
+
+			m_age[i] = 0.0f;
+			m_lifetime[i] = std::max(lifetime + unit(m_random) * lifetimeVariance, 0.0f);
+		}
+
+		m_count += emitted;
+		return emitted;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void ParticlePool::update(float dt, const Utils::Vector3& gravity, float drag)
+	{
+		integrate(dt, gravity, drag);
+		compact();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void ParticlePool::writeInstances(ParticleInstance* instances, float particleSize, const Utils::Vector3& color, float alpha) const
+	{
+		for (size_t i = 0; i < m_count; i++)
+		{
+			float fade = m_lifetime[i] > 0.0f ? 1.0f - m_age[i] / m_lifetime[i] : 0.0f;
+
+			ParticleInstance& instance = instances[i];
+			instance.position[0] = m_positionX[i];
+			instance.position[1] = m_positionY[i];
+			instance.position[2] = m_positionZ[i];
+			instance.size = particleSize;
+			instance.color[0] = color.x;
+			instance.color[1] = color.y;
+			instance.color[2] = color.z;
+			instance.color[3] = alpha * fade;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void ParticlePool::integrate(float dt, const Utils::Vector3& gravity, float drag)
+	{
+		IntegrationStep step{ dt, std::max(1.0f - drag * dt, 0.0f), { gravity.x * dt, gravity.y * dt, gravity.z * dt } };
+		ParticleStreams streams{
+			{ m_positionX.data(), m_positionY.data(), m_positionZ.data() },
+			{ m_velocityX.data(), m_velocityY.data(), m_velocityZ.data() },
+			m_age.data()
+		};
+
+		size_t i = 0;
+		switch (Utils::getActiveSimdLevel())
+		{
+		case Utils::SimdLevel::AVX:
+			i = integrateAVX(step, streams, m_count);
+			break;
+		case Utils::SimdLevel::SSE:
+			i = integrateSSE(step, streams, m_count);
+			break;
+		default:
+			break;
+		}
+
+		integrateScalar(step, streams, i, m_count);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void ParticlePool::compact()
+	{
+		// Stable and in a single forward pass, live particles keep their order and the arrays are streamed
+		size_t write = 0;
+		for (size_t read = 0; read < m_count; read++)
+		{
+			if (m_age[read] >= m_lifetime[read])
+			{
+				continue;
+			}
+
+			if (write != read)
+			{
+				m_positionX[write] = m_positionX[read];
+				m_positionY[write] = m_positionY[read];
+				m_positionZ[write] = m_positionZ[read];
+				m_velocityX[write] = m_velocityX[read];
+				m_velocityY[write] = m_velocityY[read];
+				m_velocityZ[write] = m_velocityZ[read];
+				m_age[write] = m_age[read];
+				m_lifetime[write] = m_lifetime[read];
+			}
+			write++;
+		}
+		m_count = write;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
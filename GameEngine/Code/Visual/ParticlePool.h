@@ -0,0 +1,48 @@
+#pragma once
+
+#include <random>
+#include <vector>
+
+#include "ParticleInstance.h"
+#include "Utils/Vector.h"
+
+namespace Engine::Visual
+{
+    // Fixed capacity particle storage, one array per attribute so the update runs 4 or 8 particles per instruction.
+    // Live particles are always the first size() entries, dead ones are compacted away after each update.
+    class ParticlePool
+    {
+    public:
+        explicit ParticlePool(size_t capacity, uint32_t seed = 0);
+
+        size_t getCapacity() const;
+        size_t size() const;
+
+        // Starts up to count particles at origin, fewer when the pool is full. Returns how many were started.
+        size_t emit(size_t count, const Utils::Vector3& origin, const Utils::Vector3& velocity, float velocitySpread, float lifetime, float lifetimeVariance);
+
+        // Semi-implicit Euler step with linear drag, then removes the particles that reached their lifetime
+        void update(float dt, const Utils::Vector3& gravity, float drag);
+
+        // Alpha fades linearly to 0 over the lifetime of each particle
+        void writeInstances(ParticleInstance* instances, float particleSize, const Utils::Vector3& color, float alpha) const;
+
+    private:
+        void integrate(float dt, const Utils::Vector3& gravity, float drag);
+        void compact();
+
+    private:
+        size_t m_capacity;
+        size_t m_count = 0;
+        std::mt19937 m_random;
+
+        std::vector<float> m_positionX;
+        std::vector<float> m_positionY;
+        std::vector<float> m_positionZ;
+        std::vector<float> m_velocityX;
+        std::vector<float> m_velocityY;
+        std::vector<float> m_velocityZ;
+        std::vector<float> m_age;
+        std::vector<float> m_lifetime;
+    };
+}
@@ -0,0 +1,416 @@
+#include "SkinnedModel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <immintrin.h>
+
+#include "Utils/Geometry.h"
+#include "Utils/DebugMacros.h"
+
+#ifdef _MSC_VER
+#define SKINNING_TARGET_AVX
+#else
+#define SKINNING_TARGET_AVX __attribute__((target("avx")))
+#endif
+
+namespace Engine::Visual
+{
+	namespace
+	{
+		using Vertex = GltfModel::Vertex;
+		using SkinWeights = GltfModel::SkinWeights;
+
+		// The kernels store 4 floats at position and normal, the spill lands in the next member and is overwritten right after
+		static_assert(sizeof(Vertex) == 8 * sizeof(float) && offsetof(Vertex, normal) == 3 * sizeof(float) && offsetof(Vertex, texCoord) == 6 * sizeof(float));
+
+		// Palette matrix stored by columns, so every column is one register. The w of the axes is 0 and of the translation 1.
+		struct alignas(32) SkinningMatrix
+		{
+			float columns[4][4];
+		};
+
+		//////////////////////////////////////////////////////////////////////////
+
+		void normalize(float normal[3])
+		{
+			float lengthSqr = normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2];
+			if (lengthSqr > 0.0f)
+			{
+				float length = std::sqrt(lengthSqr);
+				normal[0] /= length;
+				normal[1] /= length;
+				normal[2] /= length;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		void skinScalar(const SkinningMatrix* palette, const Vertex* input, const SkinWeights* weights, size_t count, Vertex* output)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				float blended[4][4] = {};
+				for (int influence = 0; influence < 4; influence++)
+				{
+					const SkinningMatrix& matrix = palette[weights[i].joints[influence]];
+					float weight = weights[i].weights[influence];
+					for (int column = 0; column < 4; column++)
+					{
+						for (int row = 0; row < 4; row++)
+						{
+							blended[column][row] += weight * matrix.columns[column][row];
+						}
+					}
+				}
+
+				const Vertex& vertex = input[i];
+				Vertex& result = output[i];
+				for (int row = 0; row < 3; row++)
+				{
+					result.position[row] =
+						blended[0][row] * vertex.position[0] +
+						blended[1][row] * vertex.position[1] +
+						blended[2][row] * vertex.position[2] +
+						blended[3][row];
+					result.normal[row] =
+						blended[0][row] * vertex.normal[0] +
+						blended[1][row] * vertex.normal[1] +
+						blended[2][row] * vertex.normal[2];
+				}
+				normalize(result.normal);
+				result.texCoord[0] = vertex.texCoord[0];
+				result.texCoord[1] = vertex.texCoord[1];
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Normalizes and writes the results of one vertex, w of the normal is 0 so it doesn't disturb the length
+		void storeVertex(__m128 position, __m128 normal, const Vertex& vertex, Vertex& result)
+		{
+			__m128 squared = _mm_mul_ps(normal, normal);
+			__m128 shuffled = _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(2, 3, 0, 1));
+			__m128 sums = _mm_add_ps(squared, shuffled);
+			sums = _mm_add_ps(sums, _mm_movehl_ps(shuffled, sums));
+			__m128 lengthSqr = _mm_shuffle_ps(sums, sums, _MM_SHUFFLE(0, 0, 0, 0));
+			__m128 length = _mm_sqrt_ps(lengthSqr);
+			__m128 valid = _mm_cmpgt_ps(lengthSqr, _mm_setzero_ps());
+			normal = _mm_or_ps(_mm_and_ps(valid, _mm_div_ps(normal, length)), _mm_andnot_ps(valid, normal));
+
+			_mm_storeu_ps(result.position, position);
+			_mm_storeu_ps(result.normal, normal);
+			result.texCoord[0] = vertex.texCoord[0];
+			result.texCoord[1] = vertex.texCoord[1];
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		void skinSSE(const SkinningMatrix* palette, const Vertex* input, const SkinWeights* weights, size_t count, Vertex* output)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				const SkinWeights& skinWeights = weights[i];
+				__m128 column0 = _mm_setzero_ps();
+				__m128 column1 = _mm_setzero_ps();
+				__m128 column2 = _mm_setzero_ps();
+				__m128 column3 = _mm_setzero_ps();
+				for (int influence = 0; influence < 4; influence++)
+				{
+					const SkinningMatrix& matrix = palette[skinWeights.joints[influence]];
+					__m128 weight = _mm_set1_ps(skinWeights.weights[influence]);
+					column0 = _mm_add_ps(column0, _mm_mul_ps(weight, _mm_load_ps(matrix.columns[0])));
+					column1 = _mm_add_ps(column1, _mm_mul_ps(weight, _mm_load_ps(matrix.columns[1])));
+					column2 = _mm_add_ps(column2, _mm_mul_ps(weight, _mm_load_ps(matrix.columns[2])));
+					column3 = _mm_add_ps(column3, _mm_mul_ps(weight, _mm_load_ps(matrix.columns[3])));
+				}
+
+				const Vertex& vertex = input[i];
+				__m128 position = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(vertex.position[0])), _mm_mul_ps(column1, _mm_set1_ps(vertex.position[1]))),
+					_mm_add_ps(_mm_mul_ps(column2, _mm_set1_ps(vertex.position[2])), column3));
+				__m128 normal = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(vertex.normal[0])), _mm_mul_ps(column1, _mm_set1_ps(vertex.normal[1]))),
+					_mm_mul_ps(column2, _mm_set1_ps(vertex.normal[2])));
+
+				storeVertex(position, normal, vertex, output[i]);
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		// Two columns per register halves the blending work, the halves are summed once at the end
+		SKINNING_TARGET_AVX
+		void skinAVX(const SkinningMatrix* palette, const Vertex* input, const SkinWeights* weights, size_t count, Vertex* output)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				const SkinWeights& skinWeights = weights[i];
+				__m256 columns01 = _mm256_setzero_ps();
+				__m256 columns23 = _mm256_setzero_ps();
+				for (int influence = 0; influence < 4; influence++)
+				{
+					const SkinningMatrix& matrix = palette[skinWeights.joints[influence]];
+					__m256 weight = _mm256_set1_ps(skinWeights.weights[influence]);
+					columns01 = _mm256_add_ps(columns01, _mm256_mul_ps(weight, _mm256_load_ps(matrix.columns[0])));
+					columns23 = _mm256_add_ps(columns23, _mm256_mul_ps(weight, _mm256_load_ps(matrix.columns[2])));
+				}
+
+				const Vertex& vertex = input[i];
+				const float* p = vertex.position;
+				const float* n = vertex.normal;
+				__m256 position = _mm256_add_ps(
+					_mm256_mul_ps(columns01, _mm256_setr_ps(p[0], p[0], p[0], p[0], p[1], p[1], p[1], p[1])),
+					_mm256_mul_ps(columns23, _mm256_setr_ps(p[2], p[2], p[2], p[2], 1.0f, 1.0f, 1.0f, 1.0f)));
+				__m256 normal = _mm256_add_ps(
+					_mm256_mul_ps(columns01, _mm256_setr_ps(n[0], n[0], n[0], n[0], n[1], n[1], n[1], n[1])),
+					_mm256_mul_ps(columns23, _mm256_setr_ps(n[2], n[2], n[2], n[2], 0.0f, 0.0f, 0.0f, 0.0f)));
+
+				storeVertex(
+					_mm_add_ps(_mm256_castps256_ps128(position), _mm256_extractf128_ps(position, 1)),
+					_mm_add_ps(_mm256_castps256_ps128(normal), _mm256_extractf128_ps(normal, 1)),
+					vertex, output[i]);
+			}
+
+			// Avoids the SSE transition penalty in the code that runs next
+			_mm256_zeroupper();
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool SkinnedModel::load(const std::string& filename)
+	{
+		GltfModel gltf;
+		if (!gltf.load(filename, false))
+		{
+			return false;
+		}
+
+		const std::vector<GltfModel::Primitive>& primitives = gltf.getPrimitives();
+		auto skinnedPrimitive = std::find_if(primitives.begin(), primitives.end(), [](const GltfModel::Primitive& primitive) { return primitive.skinId >= 0; });
+		ASSERT(skinnedPrimitive != primitives.end(), "Model has no skinned primitives: {}", filename);
+		if (skinnedPrimitive == primitives.end())
+		{
+			return false;
+		}
+
+		int skinId = skinnedPrimitive->skinId;
+		const GltfModel::Skin& skin = gltf.getSkins()[skinId];
+
+		// The last index is taken by the identity matrix of the vertices that aren't skinned
+		bool validJointCount = skin.joints.size() < std::numeric_limits<uint16_t>::max();
+		ASSERT(validJointCount, "Too many joints in: {}", filename);
+		if (!validJointCount)
+		{
+			return false;
+		}
+
+		std::vector<int> nodeJoints;
+		std::vector<uint16_t> skinJoints;
+		loadSkeleton(gltf, skin, nodeJoints, skinJoints);
+		loadClips(gltf, nodeJoints);
+		loadVertices(gltf, skinId, skinJoints);
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const Skeleton& SkinnedModel::getSkeleton() const
+	{
+		return m_skeleton;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const std::vector<AnimationClip>& SkinnedModel::getClips() const
+	{
+		return m_clips;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	const AnimationClip* SkinnedModel::findClip(const std::string& name) const
+	{
+		if (name.empty())
+		{
+			return m_clips.empty() ? nullptr : &m_clips.front();
+		}
+
+		auto clipItr = std::find_if(m_clips.begin(), m_clips.end(), [&name](const AnimationClip& clip) { return clip.name == name; });
+		return clipItr != m_clips.end() ? &*clipItr : nullptr;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t SkinnedModel::getVertexCount() const
+	{
+		return m_bindVertices.size();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SkinnedModel::skin(const std::vector<Utils::Matrix4>& palette, GltfModel::Vertex* vertices) const
+	{
+		// Transposed on every call, the palette is tiny next to the vertices
+		thread_local std::vector<SkinningMatrix> matrices;
+		size_t jointCount = m_skeleton.getJointCount();
+		matrices.resize(jointCount + 1);
+		for (size_t joint = 0; joint <= jointCount; joint++)
+		{
+			const Utils::Matrix4 matrix = joint < jointCount && joint < palette.size() ? palette[joint] : Utils::Matrix4::identity();
+			for (int column = 0; column < 4; column++)
+			{
+				for (int row = 0; row < 4; row++)
+				{
+					matrices[joint].columns[column][row] = matrix.m[row][column];
+				}
+			}
+		}
+
+		switch (Utils::getActiveSimdLevel())
+		{
+		case Utils::SimdLevel::AVX:
+			skinAVX(matrices.data(), m_bindVertices.data(), m_weights.data(), m_bindVertices.size(), vertices);
+			break;
+		case Utils::SimdLevel::SSE:
+			skinSSE(matrices.data(), m_bindVertices.data(), m_weights.data(), m_bindVertices.size(), vertices);
+			break;
+		default:
+			skinScalar(matrices.data(), m_bindVertices.data(), m_weights.data(), m_bindVertices.size(), vertices);
+			break;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SkinnedModel::loadSkeleton(const GltfModel& gltf, const GltfModel::Skin& skin, std::vector<int>& nodeJoints, std::vector<uint16_t>& skinJoints)
+	{
+		const std::vector<GltfModel::Node>& nodes = gltf.getNodes();
+
+		// Joints are sorted by depth, so parents come before their children
+		std::vector<size_t> depths(skin.joints.size(), 0);
+		for (size_t joint = 0; joint < skin.joints.size(); joint++)
+		{
+			for (int parent = nodes[skin.joints[joint]].parent; parent >= 0; parent = nodes[parent].parent)
+			{
+				depths[joint]++;
+			}
+		}
+
+		std::vector<size_t> order(skin.joints.size());
+		std::iota(order.begin(), order.end(), size_t(0));
+		std::stable_sort(order.begin(), order.end(), [&depths](size_t left, size_t right) { return depths[left] < depths[right]; });
+
+		nodeJoints.assign(nodes.size(), -1);
+		skinJoints.resize(skin.joints.size());
+		for (size_t joint = 0; joint < order.size(); joint++)
+		{
+			nodeJoints[skin.joints[order[joint]]] = static_cast<int>(joint);
+			skinJoints[order[joint]] = static_cast<uint16_t>(joint);
+		}
+
+		m_skeleton.joints.resize(order.size());
+		m_skeleton.bindPose.resize(order.size());
+		for (size_t joint = 0; joint < order.size(); joint++)
+		{
+			const GltfModel::Node& node = nodes[skin.joints[order[joint]]];
+			Skeleton::Joint& skeletonJoint = m_skeleton.joints[joint];
+			skeletonJoint.name = node.name;
+			skeletonJoint.inverseBindMatrix = skin.inverseBindMatrices[order[joint]];
+			m_skeleton.bindPose[joint] = JointPose{ node.translation, node.rotation, node.scale };
+
+			// Nodes that aren't joints can't be animated by the clips, their transform is folded into a fixed offset
+			int parent = node.parent;
+			while (parent >= 0 && nodeJoints[parent] < 0)
+			{
+				const GltfModel::Node& parentNode = nodes[parent];
+				skeletonJoint.offsetTransform = Utils::Matrix4::fromTRS(parentNode.translation, parentNode.rotation, parentNode.scale) * skeletonJoint.offsetTransform;
+				skeletonJoint.hasOffset = true;
+				parent = parentNode.parent;
+			}
+			skeletonJoint.parent = parent >= 0 ? nodeJoints[parent] : -1;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SkinnedModel::loadClips(const GltfModel& gltf, const std::vector<int>& nodeJoints)
+	{
+		for (const GltfModel::Animation& animation : gltf.getAnimations())
+		{
+			AnimationClip clip;
+			clip.name = animation.name;
+			clip.duration = animation.duration;
+
+			for (const GltfModel::AnimationChannel& channel : animation.channels)
+			{
+				// Animated nodes outside of the skeleton are ignored
+				int joint = nodeJoints[channel.nodeId];
+				if (joint < 0)
+				{
+					continue;
+				}
+
+				AnimationClip::Track track;
+				track.joint = static_cast<size_t>(joint);
+				track.step = channel.step;
+				track.times = channel.times;
+				track.values = channel.values;
+				switch (channel.path)
+				{
+				case GltfModel::AnimationChannel::Path::Translation:
+					track.path = AnimationClip::TrackPath::Translation;
+					break;
+				case GltfModel::AnimationChannel::Path::Rotation:
+					track.path = AnimationClip::TrackPath::Rotation;
+					break;
+				case GltfModel::AnimationChannel::Path::Scale:
+					track.path = AnimationClip::TrackPath::Scale;
+					break;
+				}
+				clip.tracks.push_back(std::move(track));
+			}
+
+			m_clips.push_back(std::move(clip));
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void SkinnedModel::loadVertices(const GltfModel& gltf, int skinId, const std::vector<uint16_t>& skinJoints)
+	{
+		uint16_t identityJoint = static_cast<uint16_t>(m_skeleton.getJointCount());
+		const SkinWeights staticWeights{ { identityJoint, identityJoint, identityJoint, identityJoint }, { 1.0f, 0.0f, 0.0f, 0.0f } };
+
+		m_bindVertices.reserve(gltf.getVertexCount());
+		m_weights.reserve(gltf.getVertexCount());
+		for (const GltfModel::Primitive& primitive : gltf.getPrimitives())
+		{
+			const Vertex* vertices = static_cast<const Vertex*>(primitive.vertices.data);
+			m_bindVertices.insert(m_bindVertices.end(), vertices, vertices + primitive.vertexCount);
+
+			const SkinWeights* weights = primitive.skinId == skinId ? static_cast<const SkinWeights*>(primitive.skinWeights.data) : nullptr;
+			for (size_t i = 0; i < primitive.vertexCount; i++)
+			{
+				if (!weights)
+				{
+					m_weights.push_back(staticWeights);
+					continue;
+				}
+
+				// Indices outside of the skin would read past the palette
+				SkinWeights value = weights[i];
+				for (uint16_t& joint : value.joints)
+				{
+					joint = joint < skinJoints.size() ? skinJoints[joint] : identityJoint;
+				}
+				m_weights.push_back(value);
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Animation.h"
+#include "GltfModel.h"
+#include "Utils/PageMemory.h"
+
+namespace Engine::Visual
+{
+    // Skeleton, clips and bind pose vertices of a skinned glTF model, shared by every character using the file.
+    // Only the first skin is animated, vertices of other primitives keep their bind pose.
+    class SkinnedModel
+    {
+    public:
+        bool load(const std::string& filename);
+
+        const Skeleton& getSkeleton() const;
+        const std::vector<AnimationClip>& getClips() const;
+        const AnimationClip* findClip(const std::string& name) const; // An empty name gives the first clip
+        size_t getVertexCount() const;
+
+        // Linear blend skinning of every vertex with one palette matrix per joint. The output has getVertexCount()
+        // vertices in the order of the vertex buffer the renderers create for the same file.
+        void skin(const std::vector<Utils::Matrix4>& palette, GltfModel::Vertex* vertices) const;
+
+    private:
+        void loadSkeleton(const GltfModel& gltf, const GltfModel::Skin& skin, std::vector<int>& nodeJoints, std::vector<uint16_t>& skinJoints);
+        void loadClips(const GltfModel& gltf, const std::vector<int>& nodeJoints);
+        void loadVertices(const GltfModel& gltf, int skinId, const std::vector<uint16_t>& skinJoints);
+
+    private:
+        // Read by every worker skinning a character, placed with the geometry arena policy
+        Utils::PageVector<GltfModel::Vertex, Utils::MemoryArena::Geometry> m_bindVertices;
+        Utils::PageVector<GltfModel::SkinWeights, Utils::MemoryArena::Geometry> m_weights;
+        Skeleton m_skeleton;
+        std::vector<AnimationClip> m_clips;
+    };
+}
@@ -0,0 +1,778 @@
+#include "SoftwareRenderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/ext/matrix_clip_space.hpp>
+
+#include "CameraMatrices.h"
+#include "Utils/DebugMacros.h"
+
+namespace Engine::Visual
+{
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::setFramePacing(const FramePacing& framePacing)
+	{
+		// GDI presents immediately, only the FPS cap of the main loop applies
+		m_framePacing = framePacing;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::setDepthPrePass(bool enabled)
+	{
+		m_depthPrePass = enabled;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::setTextureStreaming(const TextureStreaming& settings, JobsManager& jobsManager)
+	{
+		// Models are drawn with their material colors, there are no textures to stream
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::setOverdrawAnalysis(const OverdrawAnalysis& analysis)
+	{
+		m_analysis = analysis;
+		m_analysisEnabled = !analysis.outputDirectory.empty();
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::init(const Window& window)
+	{
+		m_hwnd = window.getHandle();
+		m_hdc = GetDC(m_hwnd);
+
+		RECT rect;
+		GetClientRect(m_hwnd, &rect);
+		m_width = std::max<int>(rect.right - rect.left, 1);
+		m_height = std::max<int>(rect.bottom - rect.top, 1);
+
+		size_t pixelsCount = static_cast<size_t>(m_width) * m_height;
+		m_colorBuffer.assign(pixelsCount, 0);
+		m_depthBuffer.assign(pixelsCount, 1.0f);
+		if (m_analysisEnabled)
+		{
+			m_depthPasses.assign(pixelsCount, 0);
+			m_depthFailures.assign(pixelsCount, 0);
+			m_shadedFragments.assign(pixelsCount, 0);
+		}
+
+		// Top-down 32 bit DIB, so the color buffer can be blitted as is
+		m_bitmapInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+		m_bitmapInfo.bmiHeader.biWidth = m_width;
+		m_bitmapInfo.bmiHeader.biHeight = -m_height;
+		m_bitmapInfo.bmiHeader.biPlanes = 1;
+		m_bitmapInfo.bmiHeader.biBitCount = 32;
+		m_bitmapInfo.bmiHeader.biCompression = BI_RGB;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::clearBackground(float r, float g, float b, float a)
+	{
+		std::fill(m_colorBuffer.begin(), m_colorBuffer.end(), packColor(glm::vec3(r, g, b)));
+		std::fill(m_depthBuffer.begin(), m_depthBuffer.end(), 1.0f);
+
+		if (m_analysisEnabled)
+		{
+			std::fill(m_depthPasses.begin(), m_depthPasses.end(), 0);
+			std::fill(m_depthFailures.begin(), m_depthFailures.end(), 0);
+			std::fill(m_shadedFragments.begin(), m_shadedFragments.end(), 0);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::draw(const IModelInstance& model, const Utils::Vector3& position, const Utils::Vector3& rotation, const Utils::Vector3& scale)
+	{
+		const auto& modelItr = m_models.find(model.GetId());
+		ASSERT(modelItr != m_models.end(), "Can't find model with id: {}", model.GetId());
+		if (modelItr == m_models.end())
+		{
+			return;
+		}
+
+		const ModelData& modelData = modelItr->second;
+		glm::mat4 worldMatrix = getWorldMatrix(position, rotation, scale);
+
+		const auto& instancePositionsItr = m_instancePositions.find(&model);
+		const std::vector<glm::vec3>& positions = instancePositionsItr != m_instancePositions.end() ? instancePositionsItr->second : modelData.positions;
+
+		if (m_depthPrePass)
+		{
+			m_drawCommands.push_back({ &modelData, &positions, worldMatrix });
+			return;
+		}
+
+		drawModel(modelData, positions, worldMatrix, RasterPass::Shade);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::drawParticles(const ParticleInstance* particles, size_t count)
+	{
+		m_particles.insert(m_particles.end(), particles, particles + count);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::render()
+	{
+		if (!m_drawCommands.empty())
+		{
+			for (const DrawCommand& command : m_drawCommands)
+			{
+				drawModel(*command.model, *command.positions, command.worldMatrix, RasterPass::DepthOnly);
+			}
+			for (const DrawCommand& command : m_drawCommands)
+			{
+				drawModel(*command.model, *command.positions, command.worldMatrix, RasterPass::ShadeEqual);
+			}
+			m_drawCommands.clear();
+		}
+
+		if (!m_particles.empty())
+		{
+			auto renderStart = std::chrono::high_resolution_clock::now();
+			for (const ParticleInstance& particle : m_particles)
+			{
+				splatParticle(particle);
+			}
+
+			m_particleStats.renderedFrames++;
+			m_particleStats.renderedParticles += m_particles.size();
+			m_particleStats.renderTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - renderStart).count();
+			m_particles.clear();
+		}
+
+		if (m_analysisEnabled)
+		{
+			collectFrameCounters();
+			if (m_analysis.heatmapInterval > 0 && m_framesCount % m_analysis.heatmapInterval == 0)
+			{
+				writeHeatmaps("_frame" + std::to_string(m_framesCount));
+			}
+		}
+
+		SetDIBitsToDevice(m_hdc, 0, 0, m_width, m_height, 0, 0, 0, m_height, m_colorBuffer.data(), &m_bitmapInfo, DIB_RGB_COLORS);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::waitForNextFrame()
+	{
+		// Frames are finished by the time render returns
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::drawModel(const ModelData& model, const std::vector<glm::vec3>& positions, const glm::mat4& worldMatrix, RasterPass pass)
+	{
+		// Both passes of the pre-pass go through the same transform, so their depth values match exactly
+		glm::mat4 viewProjectionMatrix = m_projectionMatrix * m_viewMatrix;
+
+		m_worldPositions.resize(positions.size());
+		m_clipPositions.resize(positions.size());
+		for (size_t i = 0; i < positions.size(); i++)
+		{
+			glm::vec4 worldPosition = worldMatrix * glm::vec4(positions[i], 1.0f);
+			m_worldPositions[i] = glm::vec3(worldPosition);
+			m_clipPositions[i] = viewProjectionMatrix * worldPosition;
+		}
+
+		for (const SubMesh& mesh : model.meshes)
+		{
+			bool hasMaterial = mesh.materialId >= 0 && mesh.materialId < (int)model.diffuseColors.size();
+			const glm::vec3& diffuseColor = hasMaterial ? model.diffuseColors[mesh.materialId] : k_defaultDiffuseColor;
+
+			for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+			{
+				uint32_t i0 = mesh.indices[i];
+				uint32_t i1 = mesh.indices[i + 1];
+				uint32_t i2 = mesh.indices[i + 2];
+
+				// Flat two sided lighting is enough to tell the surfaces apart
+				uint32_t color = 0;
+				if (pass != RasterPass::DepthOnly)
+				{
+					glm::vec3 normal = glm::cross(m_worldPositions[i1] - m_worldPositions[i0], m_worldPositions[i2] - m_worldPositions[i0]);
+					float normalLength = glm::length(normal);
+					float diffuse = normalLength > 0.0f ? std::abs(glm::dot(normal / normalLength, k_lightDirection)) : 0.0f;
+					color = packColor(diffuseColor * (k_ambient + (1.0f - k_ambient) * diffuse));
+				}
+
+				drawTriangle(m_clipPositions[i0], m_clipPositions[i1], m_clipPositions[i2], color, pass);
+			}
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::drawTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, uint32_t color, RasterPass pass)
+	{
+		// Trivially reject triangles fully outside of one of the frustum planes
+		if ((a.x > a.w && b.x > b.w && c.x > c.w) || (a.x < -a.w && b.x < -b.w && c.x < -c.w) ||
+			(a.y > a.w && b.y > b.w && c.y > c.w) || (a.y < -a.w && b.y < -b.w && c.y < -c.w) ||
+			(a.z > a.w && b.z > b.w && c.z > c.w) || (a.z < 0.0f && b.z < 0.0f && c.z < 0.0f))
+		{
+			return;
+		}
+
+		auto project = [](const glm::vec4& v) { return glm::vec3(v) / v.w; };
+
+		if (a.z >= 0.0f && b.z >= 0.0f && c.z >= 0.0f)
+		{
+			rasterizeTriangle(project(a), project(b), project(c), color, pass);
+			return;
+		}
+
+		// Clip against the near plane, the other planes are handled by the screen bounds and the depth range
+		const glm::vec4 input[3] = { a, b, c };
+		glm::vec4 clipped[4];
+		size_t clippedCount = 0;
+		for (size_t i = 0; i < 3; i++)
+		{
+			const glm::vec4& current = input[i];
+			const glm::vec4& next = input[(i + 1) % 3];
+			if (current.z >= 0.0f)
+			{
+				clipped[clippedCount++] = current;
+			}
+			if ((current.z >= 0.0f) != (next.z >= 0.0f))
+			{
+				float t = current.z / (current.z - next.z);
+				clipped[clippedCount++] = current + (next - current) * t;
+			}
+		}
+
+		for (size_t i = 1; i + 1 < clippedCount; i++)
+		{
+			rasterizeTriangle(project(clipped[0]), project(clipped[i]), project(clipped[i + 1]), color, pass);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::rasterizeTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, uint32_t color, RasterPass pass)
+	{
+		auto toScreen = [this](const glm::vec3& ndc)
+			{
+				return glm::vec3((ndc.x * 0.5f + 0.5f) * m_width, (0.5f - ndc.y * 0.5f) * m_height, ndc.z);
+			};
+		glm::vec3 s0 = toScreen(a);
+		glm::vec3 s1 = toScreen(b);
+		glm::vec3 s2 = toScreen(c);
+
+		auto edge = [](const glm::vec3& from, const glm::vec3& to, float x, float y)
+			{
+				return (to.x - from.x) * (y - from.y) - (to.y - from.y) * (x - from.x);
+			};
+
+		// Clockwise front faces like the other backends, the y flip makes their screen area positive
+		float area = edge(s0, s1, s2.x, s2.y);
+		if (area <= 0.0f)
+		{
+			return;
+		}
+
+		int minX = std::max(0, (int)std::floor(std::min({ s0.x, s1.x, s2.x })));
+		int maxX = std::min(m_width - 1, (int)std::ceil(std::max({ s0.x, s1.x, s2.x })));
+		int minY = std::max(0, (int)std::floor(std::min({ s0.y, s1.y, s2.y })));
+		int maxY = std::min(m_height - 1, (int)std::ceil(std::max({ s0.y, s1.y, s2.y })));
+
+		float inverseArea = 1.0f / area;
+		for (int y = minY; y <= maxY; y++)
+		{
+			float pixelY = y + 0.5f;
+			for (int x = minX; x <= maxX; x++)
+			{
+				float pixelX = x + 0.5f;
+				float w0 = edge(s1, s2, pixelX, pixelY);
+				float w1 = edge(s2, s0, pixelX, pixelY);
+				float w2 = edge(s0, s1, pixelX, pixelY);
+				if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+				{
+					continue;
+				}
+
+				float depth = (w0 * s0.z + w1 * s1.z + w2 * s2.z) * inverseArea;
+				if (depth < 0.0f || depth > 1.0f)
+				{
+					continue;
+				}
+
+				size_t pixel = static_cast<size_t>(y) * m_width + x;
+				float& storedDepth = m_depthBuffer[pixel];
+				bool passed = pass == RasterPass::ShadeEqual ? depth == storedDepth : depth < storedDepth;
+
+				if (m_analysisEnabled)
+				{
+					(passed ? m_depthPasses : m_depthFailures)[pixel]++;
+				}
+
+				if (!passed)
+				{
+					continue;
+				}
+
+				if (pass != RasterPass::ShadeEqual)
+				{
+					storedDepth = depth;
+				}
+
+				if (pass != RasterPass::DepthOnly)
+				{
+					m_colorBuffer[pixel] = color;
+					if (m_analysisEnabled)
+					{
+						m_shadedFragments[pixel]++;
+					}
+				}
+			}
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::splatParticle(const ParticleInstance& particle)
+	{
+		glm::vec4 clipPosition = m_projectionMatrix * m_viewMatrix * glm::vec4(particle.position[0], particle.position[1], particle.position[2], 1.0f);
+		if (clipPosition.w <= 0.0f)
+		{
+			return;
+		}
+
+		glm::vec3 ndc = glm::vec3(clipPosition) / clipPosition.w;
+		if (ndc.z < 0.0f || ndc.z > 1.0f)
+		{
+			return;
+		}
+
+		// Same round quad as the GPU backends, its size projected at the depth of the center
+		float centerX = (ndc.x * 0.5f + 0.5f) * m_width;
+		float centerY = (0.5f - ndc.y * 0.5f) * m_height;
+		float radius = 0.5f * particle.size * m_projectionMatrix[1][1] / clipPosition.w * m_height * 0.5f;
+		if (radius <= 0.0f)
+		{
+			return;
+		}
+
+		int minX = std::max(0, (int)std::floor(centerX - radius));
+		int maxX = std::min(m_width - 1, (int)std::ceil(centerX + radius));
+		int minY = std::max(0, (int)std::floor(centerY - radius));
+		int maxY = std::min(m_height - 1, (int)std::ceil(centerY + radius));
+
+		glm::vec3 color(particle.color[0], particle.color[1], particle.color[2]);
+		float inverseRadiusSqr = 1.0f / (radius * radius);
+		for (int y = minY; y <= maxY; y++)
+		{
+			float offsetY = y + 0.5f - centerY;
+			for (int x = minX; x <= maxX; x++)
+			{
+				float offsetX = x + 0.5f - centerX;
+				float distanceSqr = (offsetX * offsetX + offsetY * offsetY) * inverseRadiusSqr;
+				if (distanceSqr > 1.0f)
+				{
+					continue;
+				}
+
+				size_t pixel = static_cast<size_t>(y) * m_width + x;
+				bool passed = ndc.z < m_depthBuffer[pixel];
+				if (m_analysisEnabled)
+				{
+					(passed ? m_depthPasses : m_depthFailures)[pixel]++;
+				}
+
+				if (!passed)
+				{
+					continue;
+				}
+
+				uint32_t stored = m_colorBuffer[pixel];
+				glm::vec3 destination(((stored >> 16) & 0xff) / 255.0f, ((stored >> 8) & 0xff) / 255.0f, (stored & 0xff) / 255.0f);
+				float alpha = particle.color[3] * (1.0f - distanceSqr);
+				m_colorBuffer[pixel] = packColor(glm::mix(destination, color, alpha));
+				if (m_analysisEnabled)
+				{
+					m_shadedFragments[pixel]++;
+				}
+			}
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::collectFrameCounters()
+	{
+		for (size_t pixel = 0; pixel < m_shadedFragments.size(); pixel++)
+		{
+			m_totalCounters.depthPasses += m_depthPasses[pixel];
+			m_totalCounters.depthFailures += m_depthFailures[pixel];
+			m_totalCounters.shadedFragments += m_shadedFragments[pixel];
+			if (m_shadedFragments[pixel] > 0)
+			{
+				m_totalCounters.shadedPixels++;
+			}
+			m_maxShadedFragments = std::max<uint64_t>(m_maxShadedFragments, m_shadedFragments[pixel]);
+		}
+		m_framesCount++;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::writeHeatmaps(const std::string& suffix) const
+	{
+		std::filesystem::path directory(m_analysis.outputDirectory);
+		std::filesystem::create_directories(directory);
+
+		uint32_t maxCount = std::max(m_analysis.heatmapMaxCount, 1);
+		std::vector<uint32_t> pixels(m_shadedFragments.size());
+
+		for (size_t pixel = 0; pixel < pixels.size(); pixel++)
+		{
+			pixels[pixel] = heatmapColor(m_shadedFragments[pixel], maxCount);
+		}
+		bool writeResult = writeBmp((directory / ("shaded_fragments" + suffix + ".bmp")).string(), m_width, m_height, pixels);
+		ASSERT(writeResult, "Failed to write shaded fragments heatmap to: {}", directory.string());
+
+		for (size_t pixel = 0; pixel < pixels.size(); pixel++)
+		{
+			pixels[pixel] = heatmapColor(m_depthPasses[pixel] + m_depthFailures[pixel], maxCount);
+		}
+		writeResult = writeBmp((directory / ("depth_tests" + suffix + ".bmp")).string(), m_width, m_height, pixels);
+		ASSERT(writeResult, "Failed to write depth tests heatmap to: {}", directory.string());
+
+		for (size_t pixel = 0; pixel < pixels.size(); pixel++)
+		{
+			pixels[pixel] = heatmapColor(m_depthFailures[pixel], maxCount);
+		}
+		writeResult = writeBmp((directory / ("depth_failures" + suffix + ".bmp")).string(), m_width, m_height, pixels);
+		ASSERT(writeResult, "Failed to write depth failures heatmap to: {}", directory.string());
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::writeSummary() const
+	{
+		std::filesystem::path directory(m_analysis.outputDirectory);
+		std::filesystem::create_directories(directory);
+
+		std::ofstream outFile(directory / "overdraw_summary.txt");
+		ASSERT(outFile.is_open(), "Failed to write overdraw summary to: {}", directory.string());
+		if (!outFile.is_open())
+		{
+			return;
+		}
+
+		double frames = static_cast<double>(std::max<size_t>(m_framesCount, 1));
+		double pixelsCount = static_cast<double>(m_width) * m_height;
+		uint64_t depthTests = m_totalCounters.depthPasses + m_totalCounters.depthFailures;
+
+		outFile << "Resolution: " << m_width << "x" << m_height << std::endl;
+		outFile << "Frames: " << m_framesCount << std::endl;
+		outFile << "Depth pre-pass: " << m_depthPrePass << std::endl;
+		outFile << "Average shaded fragments per frame: " << m_totalCounters.shadedFragments / frames << std::endl;
+		outFile << "Average depth tests per frame: " << depthTests / frames << std::endl;
+		outFile << "Average depth test passes per frame: " << m_totalCounters.depthPasses / frames << std::endl;
+		outFile << "Average depth test failures per frame: " << m_totalCounters.depthFailures / frames << std::endl;
+		outFile << "Depth test failure rate: " << (depthTests > 0 ? (double)m_totalCounters.depthFailures / depthTests : 0.0) << std::endl;
+		outFile << "Average shaded fragments per screen pixel: " << m_totalCounters.shadedFragments / (frames * pixelsCount) << std::endl;
+		outFile << "Average overdraw (shaded fragments per covered pixel): "
+			<< (m_totalCounters.shadedPixels > 0 ? (double)m_totalCounters.shadedFragments / m_totalCounters.shadedPixels : 0.0) << std::endl;
+		outFile << "Average covered pixels per frame: " << m_totalCounters.shadedPixels / frames << std::endl;
+		outFile << "Max shaded fragments on a pixel: " << m_maxShadedFragments << std::endl;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	ModelSource::Options SoftwareRenderer::getModelSourceOptions() const
+	{
+		// The rasterizer only reads positions
+		ModelSource::Options options;
+		options.positionStream = true;
+		return options;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool SoftwareRenderer::loadModel(const std::string& filename)
+	{
+		if (m_models.contains(filename))
+		{
+			return true;
+		}
+
+		ModelSource source;
+		return source.load(filename, getModelSourceOptions()) && loadModel(filename, source);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool SoftwareRenderer::loadModel(const std::string& filename, const ModelSource& source)
+	{
+		if (m_models.contains(filename))
+		{
+			return true;
+		}
+
+		ModelData model;
+		bool loaded = source.isGltf() ? loadModelFromGltf(model, source.getGltf(), filename) : loadModelFromFile(model, source.getObj(), filename);
+		if (!loaded)
+		{
+			return false;
+		}
+
+		m_models.emplace(filename, std::move(model));
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool SoftwareRenderer::loadModelFromFile(ModelData& model, const ObjModel& obj, const std::string& filename)
+	{
+		for (const ObjModel::Material& material : obj.getMaterials())
+		{
+			model.diffuseColors.emplace_back(material.diffuseColor[0], material.diffuseColor[1], material.diffuseColor[2]);
+		}
+
+		model.positions.reserve(obj.getVertices().size());
+		for (const GltfModel::Vertex& vertex : obj.getVertices())
+		{
+			model.positions.emplace_back(vertex.position[0], vertex.position[1], vertex.position[2]);
+		}
+
+		for (const ObjModel::Shape& shape : obj.getShapes())
+		{
+			SubMesh mesh;
+			mesh.indices = shape.indices;
+			mesh.materialId = shape.materialId;
+			model.meshes.emplace_back(std::move(mesh));
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool SoftwareRenderer::loadModelFromGltf(ModelData& model, const GltfModel& gltf, const std::string& filename)
+	{
+		for (const GltfModel::Material& material : gltf.getMaterials())
+		{
+			model.diffuseColors.emplace_back(material.baseColorFactor[0], material.baseColorFactor[1], material.baseColorFactor[2]);
+		}
+
+		// Indices are made absolute here, the rasterizer reads them directly
+		model.positions.resize(gltf.getVertexCount());
+		for (const GltfModel::Primitive& primitive : gltf.getPrimitives())
+		{
+			std::memcpy(model.positions.data() + primitive.baseVertex, primitive.positions.data, primitive.positions.size);
+
+			SubMesh mesh;
+			mesh.materialId = primitive.materialId;
+			mesh.indices.resize(primitive.indexCount);
+			for (size_t i = 0; i < primitive.indexCount; i++)
+			{
+				uint32_t index = primitive.indexSize == sizeof(uint16_t) ?
+					static_cast<const uint16_t*>(primitive.indices.data)[i] :
+					static_cast<const uint32_t*>(primitive.indices.data)[i];
+				ASSERT(index < primitive.vertexCount, "Index out of range in model: {}", filename);
+				if (index >= primitive.vertexCount)
+				{
+					return false;
+				}
+				mesh.indices[i] = index + static_cast<uint32_t>(primitive.baseVertex);
+			}
+			model.meshes.emplace_back(std::move(mesh));
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool SoftwareRenderer::loadTexture(const std::string& filename)
+	{
+		// Textures don't change coverage, materials are shaded with their diffuse color only
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::setCamera(const Utils::Matrix4& view, const Utils::Matrix4& projection)
+	{
+		m_viewMatrix = toGlmMatrix(view);
+		m_projectionMatrix = toGlmMatrix(projection);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	std::unique_ptr<IModelInstance> SoftwareRenderer::createModelInstance(const std::string& filename)
+	{
+		return std::make_unique<ModelInstanceBase>(filename);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool SoftwareRenderer::destroyModelInstance(IModelInstance& modelInstance)
+	{
+		m_instancePositions.erase(&modelInstance);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool SoftwareRenderer::updateInstanceVertices(IModelInstance& modelInstance, const void* vertices, size_t vertexCount)
+	{
+		// Only positions are rasterized, normals are recomputed per triangle
+		const GltfModel::Vertex* sourceVertices = static_cast<const GltfModel::Vertex*>(vertices);
+		std::vector<glm::vec3>& positions = m_instancePositions[&modelInstance];
+		positions.resize(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			positions[i] = glm::vec3(sourceVertices[i].position[0], sourceVertices[i].position[1], sourceVertices[i].position[2]);
+		}
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool SoftwareRenderer::unloadTexture(const std::string& filename)
+	{
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	const TextureStats& SoftwareRenderer::getTextureStats() const
+	{
+		return m_textureStats;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	const ParticleStats& SoftwareRenderer::getParticleStats() const
+	{
+		return m_particleStats;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool SoftwareRenderer::unloadModel(const std::string& filename)
+	{
+		m_models.erase(filename);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void SoftwareRenderer::cleanUp()
+	{
+		if (m_analysisEnabled && m_framesCount > 0)
+		{
+			writeHeatmaps("");
+			writeSummary();
+		}
+
+		m_models.clear();
+		m_instancePositions.clear();
+		m_drawCommands.clear();
+		m_particles.clear();
+
+		if (m_hdc)
+		{
+			ReleaseDC(m_hwnd, m_hdc);
+			m_hdc = nullptr;
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	glm::mat4 SoftwareRenderer::getWorldMatrix(const Utils::Vector3& position, const Utils::Vector3& rotation, const Utils::Vector3& scale)
+	{
+		glm::mat4 translation = glm::translate(glm::mat4(1.0f), glm::vec3(position.x, position.y, position.z));
+		glm::mat4 rotationX = glm::rotate(glm::mat4(1.0f), rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
+		glm::mat4 rotationY = glm::rotate(glm::mat4(1.0f), rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 rotationZ = glm::rotate(glm::mat4(1.0f), rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
+		glm::mat4 scaling = glm::scale(glm::mat4(1.0f), glm::vec3(scale.x, scale.y, scale.z));
+
+		return translation * rotationX * rotationY * rotationZ * scaling;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	uint32_t SoftwareRenderer::packColor(const glm::vec3& color)
+	{
+		glm::vec3 clamped = glm::clamp(color, 0.0f, 1.0f) * 255.0f;
+		return (static_cast<uint32_t>(clamped.r) << 16) | (static_cast<uint32_t>(clamped.g) << 8) | static_cast<uint32_t>(clamped.b);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	uint32_t SoftwareRenderer::heatmapColor(uint32_t count, uint32_t maxCount)
+	{
+		if (count == 0)
+		{
+			return 0;
+		}
+
+		// Blue, cyan, green, yellow, red from a single fragment up to maxCount and beyond
+		static const glm::vec3 k_gradient[] = {
+			glm::vec3(0.0f, 0.0f, 1.0f),
+			glm::vec3(0.0f, 1.0f, 1.0f),
+			glm::vec3(0.0f, 1.0f, 0.0f),
+			glm::vec3(1.0f, 1.0f, 0.0f),
+			glm::vec3(1.0f, 0.0f, 0.0f)
+		};
+		constexpr size_t segmentsCount = std::size(k_gradient) - 1;
+
+		float t = maxCount > 1 ? std::min((float)(count - 1) / (float)(maxCount - 1), 1.0f) : 1.0f;
+		float scaled = t * segmentsCount;
+		size_t segment = std::min(static_cast<size_t>(scaled), segmentsCount - 1);
+		return packColor(glm::mix(k_gradient[segment], k_gradient[segment + 1], scaled - segment));
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool SoftwareRenderer::writeBmp(const std::string& filename, int width, int height, const std::vector<uint32_t>& pixels)
+	{
+		std::ofstream file(filename, std::ios::binary);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		BITMAPINFOHEADER infoHeader{};
+		infoHeader.biSize = sizeof(BITMAPINFOHEADER);
+		infoHeader.biWidth = width;
+		infoHeader.biHeight = height; // Bottom-up, rows are written in reverse
+		infoHeader.biPlanes = 1;
+		infoHeader.biBitCount = 32;
+		infoHeader.biCompression = BI_RGB;
+		infoHeader.biSizeImage = static_cast<DWORD>(pixels.size() * sizeof(uint32_t));
+
+		BITMAPFILEHEADER fileHeader{};
+		fileHeader.bfType = 0x4D42; // "BM"
+		fileHeader.bfOffBits = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER);
+		fileHeader.bfSize = fileHeader.bfOffBits + infoHeader.biSizeImage;
+
+		file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+		file.write(reinterpret_cast<const char*>(&infoHeader), sizeof(infoHeader));
+		for (int y = height - 1; y >= 0; y--)
+		{
+			file.write(reinterpret_cast<const char*>(pixels.data() + static_cast<size_t>(y) * width), width * sizeof(uint32_t));
+		}
+
+		return file.good();
+	}
+
+	////////////////////////////////////////////////////////////////////////
+}
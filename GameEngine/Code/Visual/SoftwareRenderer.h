@@ -0,0 +1,145 @@
+#pragma once
+
+#include <Windows.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "IRenderer.h"
+#include "OverdrawAnalysis.h"
+#include "GltfModel.h"
+
+namespace Engine::Visual
+{
+    // CPU rasterizer, slow but every fragment can be counted
+    class SoftwareRenderer : public IRenderer
+    {
+    public:
+        void setFramePacing(const FramePacing& framePacing) override;
+        void setDepthPrePass(bool enabled) override;
+        void setTextureStreaming(const TextureStreaming& settings, JobsManager& jobsManager) override;
+        void setOverdrawAnalysis(const OverdrawAnalysis& analysis); // Must be called before init
+
+        void init(const Window& window) override;
+        void clearBackground(float r, float g, float b, float a) override;
+
+        void draw(
+            const IModelInstance& model,
+            const Utils::Vector3& position,
+            const Utils::Vector3& rotation,
+            const Utils::Vector3& scale) override;
+        void drawParticles(const ParticleInstance* particles, size_t count) override;
+        void render() override;
+        void waitForNextFrame() override;
+
+        ModelSource::Options getModelSourceOptions() const override;
+        bool loadModel(const std::string& filename) override;
+        bool loadModel(const std::string& filename, const ModelSource& source) override;
+        bool loadTexture(const std::string& filename) override;
+
+        void setCamera(const Utils::Matrix4& view, const Utils::Matrix4& projection) override;
+        std::unique_ptr<IModelInstance> createModelInstance(const std::string& filename) override;
+
+        bool destroyModelInstance(IModelInstance& modelInstance) override;
+        bool updateInstanceVertices(IModelInstance& modelInstance, const void* vertices, size_t vertexCount) override;
+        bool unloadTexture(const std::string& filename) override;
+        const TextureStats& getTextureStats() const override;
+        const ParticleStats& getParticleStats() const override;
+        bool unloadModel(const std::string& filename) override;
+        void cleanUp() override;
+
+    private:
+        struct SubMesh
+        {
+            std::vector<uint32_t> indices;
+            int materialId;
+        };
+
+        struct ModelData
+        {
+            std::vector<SubMesh> meshes;
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec3> diffuseColors; // Per material
+        };
+
+        struct DrawCommand
+        {
+            const ModelData* model;
+            const std::vector<glm::vec3>* positions;
+            glm::mat4 worldMatrix;
+        };
+
+        enum class RasterPass
+        {
+            Shade, // Depth test LESS with depth writes
+            DepthOnly, // Depth pre-pass, nothing is shaded
+            ShadeEqual // Shading after the pre-pass, depth test EQUAL without writes
+        };
+
+        struct FrameCounters
+        {
+            uint64_t depthPasses = 0;
+            uint64_t depthFailures = 0;
+            uint64_t shadedFragments = 0;
+            uint64_t shadedPixels = 0; // Pixels shaded at least once
+        };
+
+    private:
+        static glm::mat4 getWorldMatrix(const Utils::Vector3& position, const Utils::Vector3& rotation, const Utils::Vector3& scale);
+        static uint32_t packColor(const glm::vec3& color);
+        static uint32_t heatmapColor(uint32_t count, uint32_t maxCount);
+        static bool writeBmp(const std::string& filename, int width, int height, const std::vector<uint32_t>& pixels);
+
+        bool loadModelFromFile(ModelData& model, const ObjModel& obj, const std::string& filename);
+        bool loadModelFromGltf(ModelData& model, const GltfModel& gltf, const std::string& filename);
+
+        void drawModel(const ModelData& model, const std::vector<glm::vec3>& positions, const glm::mat4& worldMatrix, RasterPass pass);
+        void drawTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, uint32_t color, RasterPass pass);
+        void rasterizeTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, uint32_t color, RasterPass pass);
+        void splatParticle(const ParticleInstance& particle);
+
+        void collectFrameCounters();
+        void writeHeatmaps(const std::string& suffix) const;
+        void writeSummary() const;
+
+    private:
+        static constexpr float k_ambient = 0.3f;
+        static inline const glm::vec3 k_lightDirection = glm::normalize(glm::vec3(0.0f, -0.6f, 0.8f));
+        static inline const glm::vec3 k_defaultDiffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
+
+        HWND m_hwnd = nullptr;
+        HDC m_hdc = nullptr;
+        BITMAPINFO m_bitmapInfo{};
+        int m_width = 0;
+        int m_height = 0;
+
+        FramePacing m_framePacing;
+        bool m_depthPrePass = false;
+        std::vector<DrawCommand> m_drawCommands;
+        std::vector<ParticleInstance> m_particles; // Splatted after the models, depth tested without writes
+        ParticleStats m_particleStats;
+
+        std::vector<uint32_t> m_colorBuffer;
+        std::vector<float> m_depthBuffer;
+        std::vector<glm::vec3> m_worldPositions; // Scratch buffers reused by every draw
+        std::vector<glm::vec4> m_clipPositions;
+
+        glm::mat4 m_viewMatrix = glm::mat4(1.0f);
+        glm::mat4 m_projectionMatrix = glm::mat4(1.0f);
+
+        // Overdraw analysis, counted per pixel for the current frame
+        OverdrawAnalysis m_analysis;
+        bool m_analysisEnabled = false;
+        std::vector<uint32_t> m_depthPasses;
+        std::vector<uint32_t> m_depthFailures;
+        std::vector<uint32_t> m_shadedFragments;
+        FrameCounters m_totalCounters;
+        uint64_t m_maxShadedFragments = 0;
+        size_t m_framesCount = 0;
+
+        std::unordered_map<std::string, ModelData> m_models;
+        TextureStats m_textureStats; // Stays empty, textures are never loaded
+        std::unordered_map<const IModelInstance*, std::vector<glm::vec3>> m_instancePositions; // Replace the model positions
+    };
+}
@@ -0,0 +1,105 @@
+#include "TextureGenerator.h"
+
+#include <Windows.h>
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+namespace Engine::Visual
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	bool TextureGenerator::parseFormat(const std::string& name, Format& format)
+	{
+		for (Format candidate : { Format::RGB, Format::RGBA })
+		{
+			if (name == getFormatName(candidate))
+			{
+				format = candidate;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	std::string TextureGenerator::getFormatName(Format format)
+	{
+		switch (format)
+		{
+		case Format::RGB:
+			return "RGB";
+		case Format::RGBA:
+			return "RGBA";
+		}
+		return "";
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool TextureGenerator::writeBmp(const std::string& filename, int size, Format format, uint32_t seed)
+	{
+		std::ofstream file(filename, std::ios::binary);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		size_t bytesPerPixel = format == Format::RGBA ? 4 : 3;
+		size_t rowSize = (size * bytesPerPixel + 3) & ~size_t(3);
+
+		BITMAPINFOHEADER infoHeader{};
+		infoHeader.biSize = sizeof(BITMAPINFOHEADER);
+		infoHeader.biWidth = size;
+		infoHeader.biHeight = size;
+		infoHeader.biPlanes = 1;
+		infoHeader.biBitCount = static_cast<WORD>(bytesPerPixel * 8);
+		infoHeader.biCompression = BI_RGB;
+		infoHeader.biSizeImage = static_cast<DWORD>(rowSize * size);
+
+		BITMAPFILEHEADER fileHeader{};
+		fileHeader.bfType = 0x4D42; // "BM"
+		fileHeader.bfOffBits = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER);
+		fileHeader.bfSize = fileHeader.bfOffBits + infoHeader.biSizeImage;
+
+		file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+		file.write(reinterpret_cast<const char*>(&infoHeader), sizeof(infoHeader));
+
+		// Two colors picked from the seed, checker cells of 1/8 of the texture
+		uint32_t state = seed * 747796405u + 2891336453u;
+		auto nextRandom = [&state]()
+			{
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+				return state;
+			};
+		uint32_t colors[2] = { nextRandom(), nextRandom() };
+		int cellSize = std::max(1, size / 8);
+
+		std::vector<uint8_t> row(rowSize, 0);
+		for (int y = 0; y < size; y++)
+		{
+			for (int x = 0; x < size; x++)
+			{
+				uint32_t color = colors[((x / cellSize) + (y / cellSize)) % 2];
+				uint32_t noise = nextRandom() & 0x1F;
+				uint8_t* pixel = row.data() + x * bytesPerPixel;
+				for (size_t channel = 0; channel < 3; channel++)
+				{
+					pixel[channel] = static_cast<uint8_t>(std::min<uint32_t>(255, ((color >> (channel * 8)) & 0xE0) + noise));
+				}
+				if (bytesPerPixel == 4)
+				{
+					pixel[3] = 255;
+				}
+			}
+			file.write(reinterpret_cast<const char*>(row.data()), rowSize);
+		}
+
+		return file.good();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
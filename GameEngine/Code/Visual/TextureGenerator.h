@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Engine::Visual
+{
+    // Writes procedural textures as uncompressed BMP files, every renderer can load them (WIC and stb_image)
+    class TextureGenerator
+    {
+    public:
+        enum class Format
+        {
+            RGB, // 24 bits per pixel
+            RGBA // 32 bits per pixel
+        };
+
+        static bool parseFormat(const std::string& name, Format& format);
+        static std::string getFormatName(Format format);
+
+        // Colored checkerboard with per pixel noise, the seed makes every texture unique
+        static bool writeBmp(const std::string& filename, int size, Format format, uint32_t seed);
+    };
+}
@@ -0,0 +1,52 @@
+#include "TextureStats.h"
+
+#include <algorithm>
+
+namespace Engine::Visual
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	void TextureStats::onTextureCreated(const std::string& textureId, size_t bytes, double seconds)
+	{
+		m_textureSizes[textureId] = bytes;
+		residentTextures = m_textureSizes.size();
+		residentBytes += bytes;
+		uploadedTextures++;
+		uploadedBytes += bytes;
+		uploadTime += seconds;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void TextureStats::onTextureDestroyed(const std::string& textureId)
+	{
+		const auto& itr = m_textureSizes.find(textureId);
+		if (itr == m_textureSizes.end())
+		{
+			return;
+		}
+
+		residentBytes -= itr->second;
+		m_textureSizes.erase(itr);
+		residentTextures = m_textureSizes.size();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t TextureStats::getMipChainSize(size_t width, size_t height, size_t bytesPerPixel)
+	{
+		size_t size = 0;
+		while (true)
+		{
+			size += width * height * bytesPerPixel;
+			if (width == 1 && height == 1)
+			{
+				return size;
+			}
+			width = std::max<size_t>(1, width / 2);
+			height = std::max<size_t>(1, height / 2);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+namespace Engine::Visual
+{
+    // Texture counters kept by every renderer, sizes are estimates from the dimensions and the format used
+    class TextureStats
+    {
+    public:
+        size_t residentTextures = 0;
+        size_t residentBytes = 0;
+        size_t uploadedTextures = 0; // Every texture created since init, including unloaded ones
+        size_t uploadedBytes = 0;
+        double uploadTime = 0.0; // Seconds of CPU time spent decoding and submitting the uploads
+
+        // Only filled while streaming, requested is what the screen coverage of the drawn textures asks for, regardless of the budget
+        size_t requestedBytes = 0;
+        size_t streamingBudget = 0;
+        size_t streamedInBytes = 0; // Finer levels loaded since init
+        size_t droppedBytes = 0; // Finer levels released since init
+        size_t streamedUploads = 0; // Textures replaced by a level change
+        size_t pendingLoads = 0;
+
+        void onTextureCreated(const std::string& textureId, size_t bytes, double seconds);
+        void onTextureDestroyed(const std::string& textureId);
+
+        static size_t getMipChainSize(size_t width, size_t height, size_t bytesPerPixel);
+
+    private:
+        std::unordered_map<std::string, size_t> m_textureSizes;
+    };
+}
@@ -0,0 +1,526 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+#include "stb_image.h"
+
+namespace Engine::Visual
+{
+	//////////////////////////////////////////////////////////////////////////
+
+	void TextureStreamer::ModelCoverage::addTriangles(const std::string& textureId, const GltfModel::Vertex* vertices, size_t vertexCount, const void* indices, size_t indexSize, size_t indexCount)
+	{
+		Areas& areas = m_textureAreas[textureId];
+		for (size_t i = 0; i + 2 < indexCount; i += 3)
+		{
+			const GltfModel::Vertex* corners[3];
+			bool valid = true;
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				size_t index = indexSize == sizeof(uint16_t) ? static_cast<const uint16_t*>(indices)[i + corner] : static_cast<const uint32_t*>(indices)[i + corner];
+				valid &= index < vertexCount;
+				corners[corner] = valid ? &vertices[index] : nullptr;
+			}
+			if (!valid)
+			{
+				continue;
+			}
+
+			Utils::Vector3 positions[3];
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				positions[corner] = Utils::Vector3(corners[corner]->position[0], corners[corner]->position[1], corners[corner]->position[2]);
+				m_radius = std::max(m_radius, positions[corner].length());
+			}
+
+			Utils::Vector3 cross = Utils::Vector3::crossProduct(positions[1] - positions[0], positions[2] - positions[0]);
+			areas.model += 0.5 * cross.length();
+
+			const float* uv0 = corners[0]->texCoord;
+			const float* uv1 = corners[1]->texCoord;
+			const float* uv2 = corners[2]->texCoord;
+			areas.texture += 0.5 * std::abs((uv1[0] - uv0[0]) * (uv2[1] - uv0[1]) - (uv2[0] - uv0[0]) * (uv1[1] - uv0[1]));
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void TextureStreamer::init(const TextureStreaming& settings, JobsManager* jobsManager, int channels)
+	{
+		clear();
+
+		m_settings = settings;
+		m_settings.updateInterval = std::max(m_settings.updateInterval, 1);
+		m_settings.residentSize = std::max(m_settings.residentSize, 1);
+		m_settings.maxPendingLoads = std::max(m_settings.maxPendingLoads, 1);
+		m_jobsManager = jobsManager;
+		m_channels = channels;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void TextureStreamer::clear()
+	{
+		// The jobs write into this object, it can't go away before they are done
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_loadsFinished.wait(lock, [this]() { return m_pendingLoads == 0; });
+			m_finishedLoads.clear();
+		}
+
+		m_textures.clear();
+		m_freeSlots.clear();
+		m_textureSlots.clear();
+		m_models.clear();
+		m_loadQueue.clear();
+		m_frame = 0;
+		m_sampling = false;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool TextureStreamer::isEnabled() const
+	{
+		return m_settings.enabled && m_jobsManager;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool TextureStreamer::addTexture(const std::string& textureId, const std::string& filename, Upload& upload)
+	{
+		auto source = std::make_shared<Source>();
+		source->filename = filename;
+		return addTexture(textureId, std::move(source), upload);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool TextureStreamer::addTexture(const std::string& textureId, const void* data, size_t size, Upload& upload)
+	{
+		// Kept encoded, the model the image came from is released once loaded
+		auto source = std::make_shared<Source>();
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		source->data.assign(bytes, bytes + size);
+		return addTexture(textureId, std::move(source), upload);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool TextureStreamer::addTexture(const std::string& textureId, std::shared_ptr<const Source>&& source, Upload& upload)
+	{
+		std::vector<unsigned char> pixels;
+		int width, height;
+		if (!decode(*source, pixels, width, height))
+		{
+			return false;
+		}
+
+		removeTexture(textureId);
+
+		Texture texture;
+		texture.id = textureId;
+		texture.source = std::move(source);
+		texture.width = width;
+		texture.height = height;
+		while ((std::max(width, height) >> texture.tailLevel) > m_settings.residentSize)
+		{
+			texture.tailLevel++;
+		}
+		texture.residentLevel = texture.tailLevel;
+		texture.requestedLevel = texture.tailLevel;
+		texture.targetLevel = texture.tailLevel;
+		texture.serial = ++m_nextSerial;
+
+		downsample(pixels, width, height, texture.tailLevel);
+		upload.textureId = textureId;
+		upload.pixels = std::move(pixels);
+		upload.width = width;
+		upload.height = height;
+		upload.level = texture.tailLevel;
+
+		size_t slot = m_textures.size();
+		if (!m_freeSlots.empty())
+		{
+			slot = m_freeSlots.back();
+			m_freeSlots.pop_back();
+			m_textures[slot] = std::move(texture);
+		}
+		else
+		{
+			m_textures.push_back(std::move(texture));
+		}
+		m_textureSlots[textureId] = slot;
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void TextureStreamer::removeTexture(const std::string& textureId)
+	{
+		const auto& itr = m_textureSlots.find(textureId);
+		if (itr == m_textureSlots.end())
+		{
+			return;
+		}
+
+		// A load still running for it is dropped when it finishes, the serial won't match anymore
+		m_textures[itr->second] = Texture();
+		m_freeSlots.push_back(itr->second);
+		m_textureSlots.erase(itr);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void TextureStreamer::addModel(const std::string& modelId, const ModelCoverage& coverage)
+	{
+		Model model;
+		model.radius = coverage.m_radius;
+		for (const auto& [textureId, areas] : coverage.m_textureAreas)
+		{
+			const auto& slot = m_textureSlots.find(textureId);
+			if (slot == m_textureSlots.end() || areas.model <= 0.0 || areas.texture <= 0.0)
+			{
+				continue;
+			}
+
+			float uvDensity = static_cast<float>(std::sqrt(areas.texture / areas.model));
+			model.textures.push_back({ slot->second, m_textures[slot->second].serial, uvDensity });
+		}
+
+		if (model.textures.empty())
+		{
+			m_models.erase(modelId);
+			return;
+		}
+		m_models[modelId] = std::move(model);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void TextureStreamer::removeModel(const std::string& modelId)
+	{
+		m_models.erase(modelId);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void TextureStreamer::setCamera(const Utils::Matrix4& view, const Utils::Matrix4& projection, int viewportHeight)
+	{
+		m_view = view;
+		m_pixelScale = projection.m[1][1] * static_cast<float>(viewportHeight) * 0.5f;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void TextureStreamer::onDraw(const std::string& modelId, const Utils::Vector3& position, const Utils::Vector3& scale)
+	{
+		if (!m_sampling)
+		{
+			return;
+		}
+
+		const auto& modelItr = m_models.find(modelId);
+		if (modelItr == m_models.end())
+		{
+			return;
+		}
+
+		const Model& model = modelItr->second;
+		float maxScale = std::max({ std::abs(scale.x), std::abs(scale.y), std::abs(scale.z) });
+		if (maxScale <= 0.0f)
+		{
+			return;
+		}
+
+		// View depth of the nearest point of the bounds, the projected size of the model scales with its inverse
+		float depth = m_view.m[2][0] * position.x + m_view.m[2][1] * position.y + m_view.m[2][2] * position.z + m_view.m[2][3] - model.radius * maxScale;
+		float pixelsPerUnit = m_pixelScale / std::max(depth, k_minimumDepth);
+
+		for (const ModelTexture& modelTexture : model.textures)
+		{
+			Texture* texture = findTexture(modelTexture.texture, modelTexture.serial);
+			if (!texture)
+			{
+				continue;
+			}
+
+			// Texels of the finest level under one pixel, each level halves them
+			float texelsPerPixel = std::max(texture->width, texture->height) * modelTexture.uvDensity / (maxScale * pixelsPerUnit);
+			int level = static_cast<int>(std::floor(std::log2(std::max(texelsPerPixel, 1e-6f)) + m_settings.mipBias));
+			level = std::clamp(level, 0, texture->tailLevel);
+			texture->requestedLevel = std::min(texture->requestedLevel, level);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void TextureStreamer::update(TextureStats& stats, std::vector<Upload>& uploads)
+	{
+		if (!isEnabled())
+		{
+			return;
+		}
+
+		std::vector<FinishedLoad> finishedLoads;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			finishedLoads.swap(m_finishedLoads);
+		}
+
+		for (FinishedLoad& finished : finishedLoads)
+		{
+			Texture* texture = findTexture(finished.slot, finished.serial);
+			if (!texture)
+			{
+				continue;
+			}
+
+			// A failed decode keeps the current level, the next estimation asks again
+			texture->pending = false;
+			if (!finished.success)
+			{
+				continue;
+			}
+
+			size_t residentBytes = getLevelBytes(*texture, texture->residentLevel);
+			size_t loadedBytes = getLevelBytes(*texture, finished.upload.level);
+			if (loadedBytes > residentBytes)
+			{
+				stats.streamedInBytes += loadedBytes - residentBytes;
+			}
+			else
+			{
+				stats.droppedBytes += residentBytes - loadedBytes;
+			}
+			texture->residentLevel = finished.upload.level;
+			uploads.push_back(std::move(finished.upload));
+		}
+
+		if (m_sampling)
+		{
+			estimateTargets(stats);
+		}
+		scheduleLoads();
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			stats.pendingLoads = m_pendingLoads;
+		}
+		stats.streamingBudget = static_cast<size_t>(std::max(m_settings.budget, 0)) * 1024 * 1024;
+		stats.streamedUploads += uploads.size();
+
+		m_frame++;
+		m_sampling = m_frame % m_settings.updateInterval == 0;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	TextureStreamer::Texture* TextureStreamer::findTexture(size_t slot, size_t serial)
+	{
+		if (slot >= m_textures.size() || m_textures[slot].id.empty() || m_textures[slot].serial != serial)
+		{
+			return nullptr;
+		}
+		return &m_textures[slot];
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	size_t TextureStreamer::getLevelBytes(const Texture& texture, int level) const
+	{
+		// 4 bytes per texel like TextureStats, whatever the channels of the upload
+		return TextureStats::getMipChainSize(std::max(texture.width >> level, 1), std::max(texture.height >> level, 1), 4);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void TextureStreamer::estimateTargets(TextureStats& stats)
+	{
+		size_t requestedBytes = 0;
+		size_t targetBytes = 0;
+		for (Texture& texture : m_textures)
+		{
+			if (texture.id.empty())
+			{
+				continue;
+			}
+			requestedBytes += getLevelBytes(texture, texture.requestedLevel);
+
+			// Textures out of view for a short while keep their levels, they often come back
+			if (texture.requestedLevel > texture.residentLevel && ++texture.coarserEstimations < m_settings.dropDelay)
+			{
+				texture.targetLevel = texture.residentLevel;
+			}
+			else
+			{
+				texture.targetLevel = texture.requestedLevel;
+				texture.coarserEstimations = 0;
+			}
+			targetBytes += getLevelBytes(texture, texture.targetLevel);
+
+			texture.requestedLevel = texture.tailLevel;
+		}
+		stats.requestedBytes = requestedBytes;
+
+		// Over budget, the largest textures lose their finest level first, which evens out the resolutions
+		size_t budget = static_cast<size_t>(std::max(m_settings.budget, 0)) * 1024 * 1024;
+		if (targetBytes > budget)
+		{
+			std::priority_queue<std::pair<size_t, size_t>> largest;
+			for (size_t slot = 0; slot < m_textures.size(); slot++)
+			{
+				const Texture& texture = m_textures[slot];
+				if (!texture.id.empty() && texture.targetLevel < texture.tailLevel)
+				{
+					largest.emplace(getLevelBytes(texture, texture.targetLevel), slot);
+				}
+			}
+
+			while (targetBytes > budget && !largest.empty())
+			{
+				size_t slot = largest.top().second;
+				Texture& texture = m_textures[slot];
+				largest.pop();
+
+				targetBytes -= getLevelBytes(texture, texture.targetLevel) - getLevelBytes(texture, texture.targetLevel + 1);
+				texture.targetLevel++;
+				if (texture.targetLevel < texture.tailLevel)
+				{
+					largest.emplace(getLevelBytes(texture, texture.targetLevel), slot);
+				}
+			}
+		}
+
+		// Drops first so their memory is free before new levels come in, then the textures missing the most levels
+		m_loadQueue.clear();
+		for (size_t slot = 0; slot < m_textures.size(); slot++)
+		{
+			const Texture& texture = m_textures[slot];
+			if (!texture.id.empty() && texture.targetLevel != texture.residentLevel)
+			{
+				m_loadQueue.push_back(slot);
+			}
+		}
+		std::sort(m_loadQueue.begin(), m_loadQueue.end(), [this](size_t left, size_t right)
+			{
+				int leftChange = m_textures[left].targetLevel - m_textures[left].residentLevel;
+				int rightChange = m_textures[right].targetLevel - m_textures[right].residentLevel;
+				if ((leftChange > 0) != (rightChange > 0))
+				{
+					return leftChange > 0;
+				}
+				return std::abs(leftChange) > std::abs(rightChange);
+			});
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void TextureStreamer::scheduleLoads()
+	{
+		size_t next = 0;
+		for (; next < m_loadQueue.size(); next++)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				if (m_pendingLoads >= static_cast<size_t>(m_settings.maxPendingLoads))
+				{
+					break;
+				}
+			}
+
+			const Texture& texture = m_textures[m_loadQueue[next]];
+			if (!texture.id.empty() && !texture.pending && texture.targetLevel != texture.residentLevel)
+			{
+				load(m_loadQueue[next]);
+			}
+		}
+		m_loadQueue.erase(m_loadQueue.begin(), m_loadQueue.begin() + next);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void TextureStreamer::load(size_t slot)
+	{
+		Texture& texture = m_textures[slot];
+		texture.pending = true;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_pendingLoads++;
+		}
+
+		FinishedLoad finished{ slot, texture.serial };
+		finished.upload.textureId = texture.id;
+		finished.upload.level = texture.targetLevel;
+		m_jobsManager->submit([this, source = texture.source, finished = std::move(finished)]() mutable
+			{
+				Upload& upload = finished.upload;
+				finished.success = decode(*source, upload.pixels, upload.width, upload.height);
+				if (finished.success)
+				{
+					downsample(upload.pixels, upload.width, upload.height, upload.level);
+				}
+
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_finishedLoads.push_back(std::move(finished));
+					m_pendingLoads--;
+				}
+				m_loadsFinished.notify_all();
+			});
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	bool TextureStreamer::decode(const Source& source, std::vector<unsigned char>& pixels, int& width, int& height) const
+	{
+		int channels;
+		unsigned char* decoded = source.data.empty() ?
+			stbi_load(source.filename.c_str(), &width, &height, &channels, m_channels) :
+			stbi_load_from_memory(source.data.data(), static_cast<int>(source.data.size()), &width, &height, &channels, m_channels);
+		if (!decoded)
+		{
+			return false;
+		}
+
+		pixels.assign(decoded, decoded + static_cast<size_t>(width) * height * m_channels);
+		stbi_image_free(decoded);
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void TextureStreamer::downsample(std::vector<unsigned char>& pixels, int& width, int& height, int levels) const
+	{
+		// Box filter, the last row or column of odd sizes is repeated
+		std::vector<unsigned char> reduced;
+		for (int level = 0; level < levels && (width > 1 || height > 1); level++)
+		{
+			int reducedWidth = std::max(width / 2, 1);
+			int reducedHeight = std::max(height / 2, 1);
+			reduced.resize(static_cast<size_t>(reducedWidth) * reducedHeight * m_channels);
+			for (int y = 0; y < reducedHeight; y++)
+			{
+				const unsigned char* row0 = &pixels[static_cast<size_t>(std::min(2 * y, height - 1)) * width * m_channels];
+				const unsigned char* row1 = &pixels[static_cast<size_t>(std::min(2 * y + 1, height - 1)) * width * m_channels];
+				unsigned char* output = &reduced[static_cast<size_t>(y) * reducedWidth * m_channels];
+				for (int x = 0; x < reducedWidth; x++)
+				{
+					size_t left = static_cast<size_t>(std::min(2 * x, width - 1)) * m_channels;
+					size_t right = static_cast<size_t>(std::min(2 * x + 1, width - 1)) * m_channels;
+					for (int channel = 0; channel < m_channels; channel++)
+					{
+						int sum = row0[left + channel] + row0[right + channel] + row1[left + channel] + row1[right + channel];
+						output[x * m_channels + channel] = static_cast<unsigned char>((sum + 2) / 4);
+					}
+				}
+			}
+			pixels.swap(reduced);
+			width = reducedWidth;
+			height = reducedHeight;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "GltfModel.h"
+#include "TextureStats.h"
+#include "TextureStreaming.h"
+#include "Managers/JobsManager.h"
+#include "Utils/Matrix.h"
+
+namespace Engine::Visual
+{
+    /**
+     * @brief      Chooses the mip levels each texture keeps resident, shared by the renderers.
+     *
+     *             The renderers register their textures and the texel density of the
+     *             models sampling them, then report the draws of a frame every
+     *             updateInterval frames. The finest level a texture needs follows from
+     *             the size its models take on screen. Levels are changed by decoding the
+     *             source again on the jobs and handing the renderer a downsampled image,
+     *             which replaces the texture: a texture at level L is simply the source
+     *             at 1 / 2^L of its resolution, with its own mip chain below it.
+     */
+    class TextureStreamer
+    {
+    public:
+        // Pixels replacing a texture, the source reduced to level
+        struct Upload
+        {
+            std::string textureId;
+            std::vector<unsigned char> pixels;
+            int width = 0;
+            int height = 0;
+            int level = 0;
+        };
+
+        // Faces of a model sampling each texture, built when the model is loaded
+        class ModelCoverage
+        {
+        public:
+            // Vertices in the layout all the renderers share, indices of 2 or 4 bytes
+            void addTriangles(const std::string& textureId, const GltfModel::Vertex* vertices, size_t vertexCount, const void* indices, size_t indexSize, size_t indexCount);
+
+        private:
+            friend class TextureStreamer;
+
+            struct Areas
+            {
+                double model = 0.0;
+                double texture = 0.0; // In UV units
+            };
+
+            std::unordered_map<std::string, Areas> m_textureAreas;
+            float m_radius = 0.0f;
+        };
+
+    public:
+        void init(const TextureStreaming& settings, JobsManager* jobsManager, int channels);
+        void clear(); // Waits for the levels still being decoded
+        bool isEnabled() const;
+
+        // Decodes the source once for its size, the texture starts with the levels up to residentSize
+        bool addTexture(const std::string& textureId, const std::string& filename, Upload& upload);
+        bool addTexture(const std::string& textureId, const void* data, size_t size, Upload& upload); // The encoded data is copied
+        void removeTexture(const std::string& textureId);
+
+        void addModel(const std::string& modelId, const ModelCoverage& coverage);
+        void removeModel(const std::string& modelId);
+
+        void setCamera(const Utils::Matrix4& view, const Utils::Matrix4& projection, int viewportHeight);
+        void onDraw(const std::string& modelId, const Utils::Vector3& position, const Utils::Vector3& scale);
+
+        // Called once per frame before drawing, returns the textures to replace and fills the streaming counters
+        void update(TextureStats& stats, std::vector<Upload>& uploads);
+
+    private:
+        struct Source
+        {
+            std::string filename;
+            std::vector<unsigned char> data; // Encoded, used instead of the file when not empty
+        };
+
+        struct Texture
+        {
+            std::string id;
+            std::shared_ptr<const Source> source;
+            int width = 0;
+            int height = 0;
+            int tailLevel = 0; // Coarsest level, at or below residentSize
+            int residentLevel = 0;
+            int requestedLevel = 0; // Finest level the draws sampled since the last estimation need
+            int targetLevel = 0;
+            int coarserEstimations = 0;
+            size_t serial = 0; // Tells the loads of a removed texture from those of a new one in the same slot
+            bool pending = false;
+        };
+
+        struct ModelTexture
+        {
+            size_t texture;
+            size_t serial;
+            float uvDensity; // UV units per model unit
+        };
+
+        struct Model
+        {
+            float radius = 0.0f;
+            std::vector<ModelTexture> textures;
+        };
+
+        struct FinishedLoad
+        {
+            size_t slot;
+            size_t serial;
+            bool success = false;
+            Upload upload;
+        };
+
+    private:
+        bool addTexture(const std::string& textureId, std::shared_ptr<const Source>&& source, Upload& upload);
+        Texture* findTexture(size_t slot, size_t serial);
+        size_t getLevelBytes(const Texture& texture, int level) const;
+
+        void estimateTargets(TextureStats& stats);
+        void scheduleLoads();
+        void load(size_t slot);
+
+        bool decode(const Source& source, std::vector<unsigned char>& pixels, int& width, int& height) const;
+        void downsample(std::vector<unsigned char>& pixels, int& width, int& height, int levels) const;
+
+    private:
+        static constexpr float k_minimumDepth = 0.01f;
+
+        TextureStreaming m_settings;
+        JobsManager* m_jobsManager = nullptr;
+        int m_channels = 4;
+
+        std::vector<Texture> m_textures;
+        std::vector<size_t> m_freeSlots;
+        std::unordered_map<std::string, size_t> m_textureSlots;
+        std::unordered_map<std::string, Model> m_models;
+        size_t m_nextSerial = 0;
+        std::vector<size_t> m_loadQueue; // Slots whose level changes, most urgent first
+
+        Utils::Matrix4 m_view;
+        float m_pixelScale = 1.0f; // Pixels covered by one unit at depth 1
+        size_t m_frame = 0;
+        bool m_sampling = false; // Whether the draws of the current frame are estimated
+
+        // Filled by the jobs
+        std::mutex m_mutex;
+        std::condition_variable m_loadsFinished;
+        std::vector<FinishedLoad> m_finishedLoads;
+        size_t m_pendingLoads = 0;
+    };
+}
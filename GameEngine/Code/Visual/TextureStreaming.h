@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Utils/Parser.h"
+
+namespace Engine::Visual
+{
+    // Mip residency streaming, textures only keep the levels their on-screen size needs
+    class TextureStreaming
+    {
+    public:
+        bool enabled = false;
+        int budget = 256; // MB of texture memory the streamed textures may take, mip chains included
+        int updateInterval = 4; // Frames between two estimations of the needed levels
+        int residentSize = 64; // Resolution below which levels are never dropped, loaded with the texture
+        int maxPendingLoads = 8; // Level changes decoded in the background at once
+        int dropDelay = 8; // Estimations a texture has to need coarser levels before its finer ones are dropped, unless over budget
+        float mipBias = 0.0f; // Added to the estimated levels, positive values keep coarser textures
+
+        SERIALIZABLE(
+            PROPERTY(TextureStreaming, enabled),
+            PROPERTY(TextureStreaming, budget),
+            PROPERTY(TextureStreaming, updateInterval),
+            PROPERTY(TextureStreaming, residentSize),
+            PROPERTY(TextureStreaming, maxPendingLoads),
+            PROPERTY(TextureStreaming, dropDelay),
+            PROPERTY(TextureStreaming, mipBias)
+        )
+    };
+}
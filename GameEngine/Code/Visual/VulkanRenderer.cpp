@@ -4,20 +4,43 @@
 #include <vector>
 #include <iostream>
 #include <set>
+#include <algorithm>
+#include <cstring>
 #include <vulkan/vulkan_win32.h>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/ext/matrix_clip_space.hpp>
 
 #include "stb_image.h"
-#include "tiny_obj_loader.h"
 
 #include "Window.h"
+#include "CameraMatrices.h"
 #include "Utils/DebugMacros.h"
 
 namespace Engine::Visual
 {
 	////////////////////////////////////////////////////////////////////////
 
+	void VulkanRenderer::setFramePacing(const FramePacing& framePacing)
+	{
+		m_framePacing = framePacing;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void VulkanRenderer::setDepthPrePass(bool enabled)
+	{
+		m_depthPrePass = enabled;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void VulkanRenderer::setTextureStreaming(const TextureStreaming& settings, JobsManager& jobsManager)
+	{
+		m_textureStreamer.init(settings, &jobsManager, STBI_rgb_alpha);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
 	void VulkanRenderer::init(const Window& window)
 	{
 		createInstance();
@@ -36,7 +59,6 @@ namespace Engine::Visual
 		createSyncObjects();
 		createCommandBuffers();
 		createTextureSampler();
-		createProjectionMatrix();
 		createDefaultMaterial();
 	}
 
@@ -58,6 +80,11 @@ namespace Engine::Visual
 		vkWaitForFences(m_device, 1, &m_inFlightFences[m_currentImageInFlight], VK_TRUE, UINT64_MAX);
 		vkResetFences(m_device, 1, &m_inFlightFences[m_currentImageInFlight]);
 
+		if (m_textureStreamer.isEnabled())
+		{
+			updateStreamedTextures();
+		}
+
 		const VkCommandBuffer& commandBuffer = m_commandBuffers[m_imageIndex];
 		VkResult resetResult = vkResetCommandBuffer(m_commandBuffers[m_imageIndex], 0);
 		if (!validateResult(resetResult, "Failed to reset command buffer"))
@@ -112,11 +139,25 @@ namespace Engine::Visual
 
 		glm::mat4 worldMatrix = getWorldMatrix(position, rotation, scale);
 		m_ubo.worldMatrix = worldMatrix;
+		m_textureStreamer.onDraw(model.GetId(), position, scale);
 
 		bool setUboMemoryResult = setBufferMemoryData(modelInstance.uniformBufferMemory, &m_ubo, sizeof(m_ubo));
 		ASSERT(setUboMemoryResult, "Failed to set memory data for uniform buffer");
 
-		VkBuffer vertexBuffers[] = { modelData.vertexBuffer };
+		if (m_depthPrePass)
+		{
+			m_drawCommands.push_back({ &modelData, &modelInstance });
+			return;
+		}
+
+		recordModelDraw(commandBuffer, modelData, modelInstance);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void VulkanRenderer::recordModelDraw(VkCommandBuffer commandBuffer, const ModelData& modelData, const VulkanModelInstance& modelInstance)
+	{
+		VkBuffer vertexBuffers[] = { modelInstance.vertexBuffer != VK_NULL_HANDLE ? modelInstance.vertexBuffer : modelData.vertexBuffer };
 		VkDeviceSize offsets[] = { 0 };
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
 
@@ -150,8 +191,8 @@ namespace Engine::Visual
 			for (size_t meshIndex : meshIndices)
 			{
 				const SubMesh& mesh = modelData.meshes[meshIndex];
-				vkCmdBindIndexBuffer(commandBuffer, mesh.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-				vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(mesh.indices.size()), 1, 0, 0, 0);
+				vkCmdBindIndexBuffer(commandBuffer, mesh.indexBuffer, 0, mesh.indexType);
+				vkCmdDrawIndexed(commandBuffer, mesh.indexCount, 1, 0, mesh.baseVertex, 0);
 			}
 
 		}
@@ -160,10 +201,155 @@ namespace Engine::Visual
 
 	////////////////////////////////////////////////////////////////////////
 
+	void VulkanRenderer::recordModelDepthDraw(VkCommandBuffer commandBuffer, const ModelData& modelData, const VulkanModelInstance& modelInstance)
+	{
+		VkBuffer vertexBuffers[] = { modelInstance.positionBuffer != VK_NULL_HANDLE ? modelInstance.positionBuffer : modelData.positionBuffer };
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &modelInstance.descriptorSet, 0, nullptr);
+
+		for (const SubMesh& mesh : modelData.meshes)
+		{
+			vkCmdBindIndexBuffer(commandBuffer, mesh.indexBuffer, 0, mesh.indexType);
+			vkCmdDrawIndexed(commandBuffer, mesh.indexCount, 1, 0, mesh.baseVertex, 0);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void VulkanRenderer::recordDrawCommands(VkCommandBuffer commandBuffer)
+	{
+		// Depth only pass, the pipeline has no fragment stage and writes no color
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_depthPrePassPipeline);
+		for (const DrawCommand& command : m_drawCommands)
+		{
+			recordModelDepthDraw(commandBuffer, *command.model, *command.instance);
+		}
+
+		// Shading pass, only the nearest fragment of each pixel passes the equal test
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_depthEqualPipeline);
+		for (const DrawCommand& command : m_drawCommands)
+		{
+			recordModelDraw(commandBuffer, *command.model, *command.instance);
+		}
+
+		m_drawCommands.clear();
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void VulkanRenderer::drawParticles(const ParticleInstance* particles, size_t count)
+	{
+		m_particles.insert(m_particles.end(), particles, particles + count);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void VulkanRenderer::recordParticles(VkCommandBuffer commandBuffer)
+	{
+		auto renderStart = std::chrono::high_resolution_clock::now();
+
+		// The fence of this frame was waited on in clearBackground, so its buffer is no longer read
+		m_particleBuffers.resize(m_framePacing.framesInFlight);
+		ParticleBuffer& particleBuffer = m_particleBuffers[m_currentImageInFlight];
+		if (!reserveParticleBuffer(particleBuffer, m_particles.size()))
+		{
+			m_particles.clear();
+			return;
+		}
+		memcpy(particleBuffer.mappedData, m_particles.data(), m_particles.size() * sizeof(ParticleInstance));
+
+		ParticlePushConstants pushConstants{ m_ubo.viewMatrix, m_ubo.projectionMatrix };
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_particlePipeline);
+		vkCmdPushConstants(commandBuffer, m_particlePipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pushConstants), &pushConstants);
+
+		VkDeviceSize offset = 0;
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &particleBuffer.buffer, &offset);
+		vkCmdDraw(commandBuffer, 4, static_cast<uint32_t>(m_particles.size()), 0, 0);
+
+		m_particleStats.renderedFrames++;
+		m_particleStats.renderedParticles += m_particles.size();
+		m_particleStats.renderTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - renderStart).count();
+		m_particles.clear();
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool VulkanRenderer::reserveParticleBuffer(ParticleBuffer& particleBuffer, size_t count)
+	{
+		if (count <= particleBuffer.capacity)
+		{
+			return true;
+		}
+
+		destroyParticleBuffer(particleBuffer);
+
+		bool createBufferResult = createBuffer(
+			count * sizeof(ParticleInstance),
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			particleBuffer.buffer,
+			particleBuffer.memory);
+		ASSERT(createBufferResult, "Failed to create particle buffer for {} particles", count);
+		if (!createBufferResult)
+		{
+			destroyParticleBuffer(particleBuffer);
+			return false;
+		}
+
+		VkResult mapMemoryResult = vkMapMemory(m_device, particleBuffer.memory, 0, VK_WHOLE_SIZE, 0, &particleBuffer.mappedData);
+		if (!validateResult(mapMemoryResult, "Failed to map particle buffer"))
+		{
+			destroyParticleBuffer(particleBuffer);
+			return false;
+		}
+
+		particleBuffer.capacity = count;
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void VulkanRenderer::destroyParticleBuffer(ParticleBuffer& particleBuffer)
+	{
+		if (particleBuffer.mappedData)
+		{
+			vkUnmapMemory(m_device, particleBuffer.memory);
+			particleBuffer.mappedData = nullptr;
+		}
+
+		if (particleBuffer.buffer != VK_NULL_HANDLE)
+		{
+			vkDestroyBuffer(m_device, particleBuffer.buffer, nullptr);
+			particleBuffer.buffer = VK_NULL_HANDLE;
+		}
+
+		if (particleBuffer.memory != VK_NULL_HANDLE)
+		{
+			vkFreeMemory(m_device, particleBuffer.memory, nullptr);
+			particleBuffer.memory = VK_NULL_HANDLE;
+		}
+
+		particleBuffer.capacity = 0;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
 	void VulkanRenderer::render()
 	{
 		VkCommandBuffer commandBuffer = m_commandBuffers[m_imageIndex];
 
+		if (!m_drawCommands.empty())
+		{
+			recordDrawCommands(commandBuffer);
+		}
+
+		if (!m_particles.empty())
+		{
+			recordParticles(commandBuffer);
+		}
+
 		vkCmdEndRenderPass(commandBuffer);
 		VkResult endCommandBufferResult = vkEndCommandBuffer(commandBuffer);
 		if (!validateResult(endCommandBufferResult, "Failed to record command buffer"))
@@ -210,8 +396,16 @@ namespace Engine::Visual
 			return;
 		}
 
-		m_currentImageInFlight = (m_currentImageInFlight + 1) % MAX_FRAMES_IN_FLIGHT;
+		m_currentImageInFlight = (m_currentImageInFlight + 1) % m_framePacing.framesInFlight;
+
+	}
 
+	////////////////////////////////////////////////////////////////////////
+
+	void VulkanRenderer::waitForNextFrame()
+	{
+		// The fence is only reset when the frame is recorded, so waiting here doesn't change clearBackground
+		vkWaitForFences(m_device, 1, &m_inFlightFences[m_currentImageInFlight], VK_TRUE, UINT64_MAX);
 	}
 
 	////////////////////////////////////////////////////////////////////////
@@ -228,6 +422,11 @@ namespace Engine::Visual
 			return false;
 		}
 
+		if (m_depthPrePass && !createPositionBuffer(model))
+		{
+			return false;
+		}
+
 		if (!createUniformBuffers(model))
 		{
 			return false;
@@ -285,90 +484,135 @@ namespace Engine::Visual
 
 	////////////////////////////////////////////////////////////////////////
 
-	bool VulkanRenderer::loadModelFromFile(ModelData& model, const std::string& filename)
+	bool VulkanRenderer::loadModelFromFile(ModelData& model, const ObjModel& obj, const std::string& filename)
 	{
-		std::filesystem::path fullPath(filename);
-		std::filesystem::path matDir = fullPath.parent_path();
+		static_assert(sizeof(Vertex) == sizeof(GltfModel::Vertex), "Vertex layout must match the model loaders");
 
-		tinyobj::attrib_t attrib;
-		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
-		std::string warn, err;
-
-		bool success = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename.c_str(), matDir.string().c_str());
-		if (!success) 
+		for (const ObjModel::Material& objMaterial : obj.getMaterials())
 		{
-			return false;
+			Material material;
+			material.ambientColor = glm::vec3(objMaterial.ambientColor[0], objMaterial.ambientColor[1], objMaterial.ambientColor[2]);
+			material.diffuseColor = glm::vec3(objMaterial.diffuseColor[0], objMaterial.diffuseColor[1], objMaterial.diffuseColor[2]);
+			material.specularColor = glm::vec3(objMaterial.specularColor[0], objMaterial.specularColor[1], objMaterial.specularColor[2]);
+			material.shininess = objMaterial.shininess;
+			material.diffuseTextureId = !objMaterial.diffuseTexture.empty() && loadTexture(objMaterial.diffuseTexture) ?
+				objMaterial.diffuseTexture : m_defaultMaterial.diffuseTextureId;
+			model.materials.push_back(material);
 		}
 
-		// Load materials
-		for (const auto& mat : materials)
+		const std::vector<GltfModel::Vertex>& vertices = obj.getVertices();
+		model.vertices.resize(vertices.size());
+		std::memcpy(model.vertices.data(), vertices.data(), vertices.size() * sizeof(Vertex));
+
+		for (const ObjModel::Shape& shape : obj.getShapes())
 		{
-			Material material;
-			material.ambientColor = glm::vec3(mat.ambient[0], mat.ambient[1], mat.ambient[2]);
-			material.diffuseColor = glm::vec3(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2]);
-			material.specularColor = glm::vec3(mat.specular[0], mat.specular[1], mat.specular[2]);
-			material.shininess = mat.shininess;
+			SubMesh subMesh;
+			subMesh.indices = shape.indices;
+			subMesh.materialId = shape.materialId;
+			model.meshes.push_back(std::move(subMesh));
+		}
 
-			if (!mat.diffuse_texname.empty())
+		if (m_textureStreamer.isEnabled())
+		{
+			TextureStreamer::ModelCoverage coverage;
+			const auto* vertices = reinterpret_cast<const GltfModel::Vertex*>(model.vertices.data());
+			for (const SubMesh& subMesh : model.meshes)
 			{
-				std::string texturePath = (matDir / mat.diffuse_texname).string();
-				if (loadTexture(texturePath))
+				if (subMesh.materialId >= 0 && subMesh.materialId < static_cast<int>(model.materials.size()))
 				{
-					material.diffuseTextureId = texturePath;
+					coverage.addTriangles(model.materials[subMesh.materialId].diffuseTextureId, vertices, model.vertices.size(), subMesh.indices.data(), sizeof(unsigned int), subMesh.indices.size());
 				}
-				else
+			}
+			m_textureStreamer.addModel(filename, coverage);
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool VulkanRenderer::loadModelFromGltf(ModelData& model, const GltfModel& gltf, const std::string& filename)
+	{
+		for (const GltfModel::Material& gltfMaterial : gltf.getMaterials())
+		{
+			Material material{};
+			gltfMaterial.getPhongParameters(&material.ambientColor.x, &material.diffuseColor.x, &material.specularColor.x, material.shininess);
+			material.diffuseTextureId = loadGltfTexture(gltf, gltfMaterial.baseColorTexture);
+			model.materials.push_back(material);
+		}
+
+		if (m_textureStreamer.isEnabled())
+		{
+			TextureStreamer::ModelCoverage coverage;
+			for (const GltfModel::Primitive& primitive : gltf.getPrimitives())
+			{
+				if (primitive.materialId >= 0 && primitive.materialId < static_cast<int>(model.materials.size()))
 				{
-					material.diffuseTextureId = m_defaultMaterial.diffuseTextureId;
+					coverage.addTriangles(model.materials[primitive.materialId].diffuseTextureId, static_cast<const GltfModel::Vertex*>(primitive.vertices.data),
+						primitive.vertexCount, primitive.indices.data, primitive.indexSize, primitive.indexCount);
 				}
 			}
-			else
+			m_textureStreamer.addModel(filename, coverage);
+		}
+
+		std::vector<GltfModel::BufferRange> vertexRanges;
+		std::vector<GltfModel::BufferRange> positionRanges;
+		for (const GltfModel::Primitive& primitive : gltf.getPrimitives())
+		{
+			vertexRanges.push_back(primitive.vertices);
+			positionRanges.push_back(primitive.positions);
+
+			SubMesh subMesh{};
+			subMesh.materialId = primitive.materialId;
+			subMesh.indexCount = static_cast<uint32_t>(primitive.indexCount);
+			subMesh.baseVertex = static_cast<int32_t>(primitive.baseVertex);
+			subMesh.indexType = primitive.indexSize == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+			if (!createDeviceLocalBuffer({ primitive.indices }, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, subMesh.indexBuffer, subMesh.indexBufferMemory))
 			{
-				material.diffuseTextureId = m_defaultMaterial.diffuseTextureId;
-				
+				return false;
 			}
+			model.meshes.push_back(std::move(subMesh));
+		}
 
-			model.materials.push_back(material);
+		if (!createDeviceLocalBuffer(vertexRanges, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, model.vertexBuffer, model.vertexBufferMemory))
+		{
+			return false;
 		}
 
-		// Load shapes and vertices
-		for (const auto& shape : shapes)
+		if (m_depthPrePass && !createDeviceLocalBuffer(positionRanges, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, model.positionBuffer, model.positionBufferMemory))
 		{
-			SubMesh subMesh;
+			return false;
+		}
 
-			for (const auto& index : shape.mesh.indices)
-			{
-				Vertex vertex = {};
-				vertex.position = glm::vec3(
-					attrib.vertices[3 * index.vertex_index + 0],
-					attrib.vertices[3 * index.vertex_index + 1],
-					attrib.vertices[3 * index.vertex_index + 2]
-				);
-
-				if (index.normal_index >= 0) {
-					vertex.normal = glm::vec3(
-						attrib.normals[3 * index.normal_index + 0],
-						attrib.normals[3 * index.normal_index + 1],
-						attrib.normals[3 * index.normal_index + 2]
-					);
-				}
+		if (!createUniformBuffers(model))
+		{
+			return false;
+		}
 
-				if (index.texcoord_index >= 0) {
-					vertex.texCoord = glm::vec2(
-						attrib.texcoords[2 * index.texcoord_index + 0],
-						attrib.texcoords[2 * index.texcoord_index + 1]
-					);
-				}
+		return createDescriptorSets(model);
+	}
 
-				model.vertices.push_back(vertex);
-				subMesh.indices.push_back(static_cast<unsigned int>(model.vertices.size() - 1));
-			}
+	////////////////////////////////////////////////////////////////////////
 
-			subMesh.materialId = shape.mesh.material_ids.empty() ? 0 : shape.mesh.material_ids[0];
-			model.meshes.push_back(std::move(subMesh));
+	std::string VulkanRenderer::loadGltfTexture(const GltfModel& gltf, int imageId)
+	{
+		if (imageId < 0)
+		{
+			return m_defaultMaterial.diffuseTextureId;
 		}
 
-		return true;
+		const GltfModel::Image& image = gltf.getImages()[imageId];
+		bool loaded = image.data.data ? loadTextureFromMemory(image.id, image.data) : !image.path.empty() && loadTexture(image.path);
+		return loaded ? image.id : m_defaultMaterial.diffuseTextureId;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	ModelSource::Options VulkanRenderer::getModelSourceOptions() const
+	{
+		ModelSource::Options options;
+		options.positionStream = m_depthPrePass;
+		return options;
 	}
 
 	////////////////////////////////////////////////////////////////////////
@@ -380,15 +624,38 @@ namespace Engine::Visual
 			return true;
 		}
 
-		ModelData modelData;
-		if (!loadModelFromFile(modelData, filename))
+		ModelSource source;
+		return source.load(filename, getModelSourceOptions()) && loadModel(filename, source);
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool VulkanRenderer::loadModel(const std::string& filename, const ModelSource& source)
+	{
+		if (m_models.contains(filename))
 		{
-			return false;
+			return true;
 		}
 
-		if (!createBuffersForModel(modelData))
+		ModelData modelData;
+		if (source.isGltf())
 		{
-			return false;
+			if (!loadModelFromGltf(modelData, source.getGltf(), filename))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			if (!loadModelFromFile(modelData, source.getObj(), filename))
+			{
+				return false;
+			}
+
+			if (!createBuffersForModel(modelData))
+			{
+				return false;
+			}
 		}
 
 		m_models.emplace(filename, std::move(modelData));
@@ -405,9 +672,74 @@ namespace Engine::Visual
 			return true;
 		}
 
+		auto loadStart = std::chrono::high_resolution_clock::now();
+
+		// Streamed textures start at a reduced level, their source is decoded again when finer ones are needed
+		if (m_textureStreamer.isEnabled() && filename != DEFAULT_TEXTURE)
+		{
+			TextureStreamer::Upload upload;
+			if (!m_textureStreamer.addTexture(filename, filename, upload))
+			{
+				return false;
+			}
+			return createTexture(filename, upload.pixels.data(), upload.width, upload.height, loadStart);
+		}
+
+		int texWidth, texHeight, texChannels;
+		stbi_uc* pixels = stbi_load(filename.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+		if (!pixels)
+		{
+			return false;
+		}
+
+		bool result = createTexture(filename, pixels, texWidth, texHeight, loadStart);
+		stbi_image_free(pixels);
+		return result;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool VulkanRenderer::loadTextureFromMemory(const std::string& textureId, const GltfModel::BufferRange& data)
+	{
+		if (m_textures.contains(textureId))
+		{
+			return true;
+		}
+
+		auto loadStart = std::chrono::high_resolution_clock::now();
+
+		if (m_textureStreamer.isEnabled())
+		{
+			TextureStreamer::Upload upload;
+			bool added = m_textureStreamer.addTexture(textureId, data.data, data.size, upload);
+			ASSERT(added, "Can't decode texture: {}", textureId);
+			if (!added)
+			{
+				return false;
+			}
+			return createTexture(textureId, upload.pixels.data(), upload.width, upload.height, loadStart);
+		}
+
+		int texWidth, texHeight, texChannels;
+		stbi_uc* pixels = stbi_load_from_memory(static_cast<const stbi_uc*>(data.data), static_cast<int>(data.size), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+		ASSERT(pixels, "Can't decode texture: {}", textureId);
+		if (!pixels)
+		{
+			return false;
+		}
+
+		bool result = createTexture(textureId, pixels, texWidth, texHeight, loadStart);
+		stbi_image_free(pixels);
+		return result;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool VulkanRenderer::createTexture(const std::string& textureId, const unsigned char* pixels, int width, int height, std::chrono::high_resolution_clock::time_point loadStart)
+	{
 		TextureData textureData;
 
-		bool createTextureImageResult = createTextureImage(filename, textureData);
+		bool createTextureImageResult = createTextureImage(pixels, width, height, textureData);
 		if (!createTextureImageResult)
 		{
 			return false;
@@ -443,12 +775,45 @@ namespace Engine::Visual
 
 		vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 
-		m_textures.emplace(filename, std::move(textureData));
+		m_textures.emplace(textureId, std::move(textureData));
+
+		// The copy is waited for by createTextureImage, so this includes the transfer. There are no mips.
+		std::chrono::duration<double> loadTime = std::chrono::high_resolution_clock::now() - loadStart;
+		m_textureStats.onTextureCreated(textureId, (size_t)width * height * 4, loadTime.count());
 		return true;
 	}
 
 	////////////////////////////////////////////////////////////////////////
 
+	void VulkanRenderer::updateStreamedTextures()
+	{
+		m_textureUploads.clear();
+		m_textureStreamer.update(m_textureStats, m_textureUploads);
+		if (m_textureUploads.empty())
+		{
+			return;
+		}
+
+		// The other frames in flight may still sample the replaced textures, only the current one was waited for
+		vkQueueWaitIdle(m_graphicsQueue);
+		for (const TextureStreamer::Upload& upload : m_textureUploads)
+		{
+			auto loadStart = std::chrono::high_resolution_clock::now();
+			const auto& itr = m_textures.find(upload.textureId);
+			if (itr == m_textures.end())
+			{
+				continue;
+			}
+
+			destroyTexture(itr->second);
+			m_textures.erase(itr);
+			m_textureStats.onTextureDestroyed(upload.textureId);
+			createTexture(upload.textureId, upload.pixels.data(), upload.width, upload.height, loadStart);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
 	void VulkanRenderer::createDepthResources()
 	{
 		VkFormat depthFormat = findDepthFormat();
@@ -470,9 +835,9 @@ namespace Engine::Visual
 
 	void VulkanRenderer::createSyncObjects()
 	{
-		m_imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		m_renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		m_inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+		m_imageAvailableSemaphores.resize(m_framePacing.framesInFlight);
+		m_renderFinishedSemaphores.resize(m_framePacing.framesInFlight);
+		m_inFlightFences.resize(m_framePacing.framesInFlight);
 
 		VkSemaphoreCreateInfo semaphoreInfo{};
 		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -481,7 +846,7 @@ namespace Engine::Visual
 		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+		for (size_t i = 0; i < m_inFlightFences.size(); ++i)
 		{
 			VkResult createImageSemaphoreResult = vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_imageAvailableSemaphores[i]);
 			if (!validateResult(createImageSemaphoreResult, "Failed to create image available semaphore"))
@@ -551,15 +916,6 @@ namespace Engine::Visual
 
 	////////////////////////////////////////////////////////////////////////
 
-	void VulkanRenderer::createProjectionMatrix()
-	{
-		float aspectRatio = (float)m_swapChainExtent.width / (float)m_swapChainExtent.height;
-		m_ubo.projectionMatrix = glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, 1000.0f);
-		m_ubo.projectionMatrix[1][1] *= -1;
-	}
-
-	////////////////////////////////////////////////////////////////////////
-
 	void VulkanRenderer::createTextureSampler()
 	{
 		VkPhysicalDeviceProperties properties{};
@@ -744,35 +1100,23 @@ namespace Engine::Visual
 	{
 		ASSERT(!model.vertices.empty(), "Model is empty");
 
-		VkDeviceSize bufferSize = sizeof(model.vertices[0]) * model.vertices.size();
-
-		VkBuffer stagingBuffer{};
-		VkDeviceMemory stagingBufferMemory{};
-
-		if (!createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			stagingBuffer, stagingBufferMemory))
-		{
-			return false;
-		}
+		GltfModel::BufferRange vertices{ model.vertices.data(), sizeof(model.vertices[0]) * model.vertices.size() };
+		return createDeviceLocalBuffer({ vertices }, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, model.vertexBuffer, model.vertexBufferMemory);
+	}
 
-		if (!setBufferMemoryData(stagingBufferMemory, model.vertices.data(), bufferSize))
-		{
-			return false;
-		}
+	////////////////////////////////////////////////////////////////////////
 
-		if (!createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, model.vertexBuffer, model.vertexBufferMemory))
+	bool VulkanRenderer::createPositionBuffer(ModelData& model)
+	{
+		std::vector<glm::vec3> positions;
+		positions.reserve(model.vertices.size());
+		for (const Vertex& vertex : model.vertices)
 		{
-			return false;
+			positions.push_back(vertex.position);
 		}
 
-		copyBuffer(stagingBuffer, model.vertexBuffer, bufferSize);
-
-		vkDestroyBuffer(m_device, stagingBuffer, nullptr);
-		vkFreeMemory(m_device, stagingBufferMemory, nullptr);
-
-		return true;
+		GltfModel::BufferRange positionsRange{ positions.data(), sizeof(positions[0]) * positions.size() };
+		return createDeviceLocalBuffer({ positionsRange }, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, model.positionBuffer, model.positionBufferMemory);
 	}
 
 	////////////////////////////////////////////////////////////////////////
@@ -781,35 +1125,65 @@ namespace Engine::Visual
 	{
 		for (auto& mesh : model.meshes)
 		{
-			VkDeviceSize bufferSize = sizeof(mesh.indices[0]) * mesh.indices.size();
-
-			VkBuffer stagingBuffer{};
-			VkDeviceMemory stagingBufferMemory{};
+			mesh.indexCount = static_cast<uint32_t>(mesh.indices.size());
 
-			if (!createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-				stagingBuffer, stagingBufferMemory))
+			GltfModel::BufferRange indices{ mesh.indices.data(), sizeof(mesh.indices[0]) * mesh.indices.size() };
+			if (!createDeviceLocalBuffer({ indices }, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, mesh.indexBuffer, mesh.indexBufferMemory))
 			{
 				return false;
 			}
+		}
 
-			if (!setBufferMemoryData(stagingBufferMemory, mesh.indices.data(), bufferSize))
-			{
-				return false;
-			}
+		return true;
+	}
 
-			if (!createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mesh.indexBuffer, mesh.indexBufferMemory))
-			{
-				return false;
-			}
+	////////////////////////////////////////////////////////////////////////
+
+	bool VulkanRenderer::createDeviceLocalBuffer(const std::vector<GltfModel::BufferRange>& ranges, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+	{
+		VkDeviceSize bufferSize = 0;
+		for (const GltfModel::BufferRange& range : ranges)
+		{
+			bufferSize += range.size;
+		}
+
+		VkBuffer stagingBuffer{};
+		VkDeviceMemory stagingBufferMemory{};
+
+		if (!createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			stagingBuffer, stagingBufferMemory))
+		{
+			return false;
+		}
+
+		// Ranges are written one after another, glTF ranges point straight into the mapped file
+		void* mappedData;
+		VkResult mapMemoryResult = vkMapMemory(m_device, stagingBufferMemory, 0, bufferSize, 0, &mappedData);
+		if (!validateResult(mapMemoryResult, "Failed to map memory"))
+		{
+			return false;
+		}
 
-			copyBuffer(stagingBuffer, mesh.indexBuffer, bufferSize);
+		uint8_t* destination = static_cast<uint8_t*>(mappedData);
+		for (const GltfModel::BufferRange& range : ranges)
+		{
+			memcpy(destination, range.data, range.size);
+			destination += range.size;
+		}
+		vkUnmapMemory(m_device, stagingBufferMemory);
 
-			vkDestroyBuffer(m_device, stagingBuffer, nullptr);
-			vkFreeMemory(m_device, stagingBufferMemory, nullptr);
+		if (!createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, bufferMemory))
+		{
+			return false;
 		}
 
+		copyBuffer(stagingBuffer, buffer, bufferSize);
+
+		vkDestroyBuffer(m_device, stagingBuffer, nullptr);
+		vkFreeMemory(m_device, stagingBufferMemory, nullptr);
+
 		return true;
 	}
 
@@ -828,17 +1202,10 @@ namespace Engine::Visual
 
 	////////////////////////////////////////////////////////////////////////
 
-	bool VulkanRenderer::createTextureImage(const std::string& filename, TextureData& texture)
+	bool VulkanRenderer::createTextureImage(const unsigned char* pixels, int texWidth, int texHeight, TextureData& texture)
 	{
-		int texWidth, texHeight, texChannels;
-		stbi_uc* pixels = stbi_load(filename.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
 		VkDeviceSize imageSize = texWidth * texHeight * 4;
 
-		if (!pixels) 
-		{
-			return false;
-		}
-
 		VkBuffer stagingBuffer;
 		VkDeviceMemory stagingBufferMemory;
 
@@ -854,8 +1221,6 @@ namespace Engine::Visual
 			return false;
 		}
 
-		stbi_image_free(pixels);
-
 		if (!createImage(texWidth, texHeight, VK_FORMAT_B8G8R8A8_UNORM,
 			VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, texture.textureImage, texture.textureImageMemory))
@@ -1164,11 +1529,24 @@ namespace Engine::Visual
 
 	VkPresentModeKHR VulkanRenderer::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes)
 	{
-		for (const auto& availablePresentMode : availablePresentModes) 
+		std::vector<VkPresentModeKHR> preferredModes;
+		switch (m_framePacing.getPresentMode())
+		{
+		case PresentMode::Immediate:
+			preferredModes = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR };
+			break;
+		case PresentMode::Mailbox:
+			preferredModes = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+			break;
+		case PresentMode::VSync:
+			break;
+		}
+
+		for (VkPresentModeKHR preferredMode : preferredModes)
 		{
-			if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR || availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
+			if (std::find(availablePresentModes.begin(), availablePresentModes.end(), preferredMode) != availablePresentModes.end())
 			{
-				return availablePresentMode;
+				return preferredMode;
 			}
 		}
 		return VK_PRESENT_MODE_FIFO_KHR; // Only this mode is guaranteed
@@ -1215,30 +1593,12 @@ namespace Engine::Visual
 
 	////////////////////////////////////////////////////////////////////////
 
-	void VulkanRenderer::setCameraProperties(const Utils::Vector3& position, const Utils::Vector3& rotation)
+	void VulkanRenderer::setCamera(const Utils::Matrix4& view, const Utils::Matrix4& projection)
 	{
-		glm::vec3 pos = glm::vec3(position.x, position.y, position.z);
-
-		float pitch = -rotation.x;
-		float yaw = rotation.y;
-		float roll = rotation.z;
-
-		glm::vec3 forward;
-		forward.x = cos(pitch) * sin(yaw);
-		forward.y = sin(pitch);
-		forward.z = cos(pitch) * cos(yaw);
-		forward = glm::normalize(forward);
-
-		glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
-
-		glm::vec3 right = glm::normalize(glm::cross(up, forward));
-
-		glm::mat4 rollMatrix = glm::rotate(glm::mat4(1.0f), roll, forward);
-		right = glm::vec3(rollMatrix * glm::vec4(right, 0.0f));
-		up = glm::normalize(glm::cross(forward, right));
-
-		m_ubo.viewMatrix = glm::lookAt(pos, pos + forward, up);
-
+		m_ubo.viewMatrix = toRightHandedView(view);
+		m_ubo.projectionMatrix = toRightHandedProjection(projection, false);
+		m_ubo.projectionMatrix[1][1] *= -1;
+		m_textureStreamer.setCamera(view, projection, static_cast<int>(m_swapChainExtent.height));
 	}
 	////////////////////////////////////////////////////////////////////////
 
@@ -1337,11 +1697,100 @@ namespace Engine::Visual
 			vkModelInstance.uniformBuffer = VK_NULL_HANDLE;
 		}
 
+		destroyInstanceVertexBuffers(vkModelInstance);
+
 		return true;
 	}
 
 	////////////////////////////////////////////////////////////////////////
 
+	bool VulkanRenderer::updateInstanceVertices(IModelInstance& modelInstance, const void* vertices, size_t vertexCount)
+	{
+		VulkanModelInstance& vkModelInstance = (VulkanModelInstance&)modelInstance;
+
+		if (vkModelInstance.vertexCount != vertexCount)
+		{
+			destroyInstanceVertexBuffers(vkModelInstance);
+
+			bool createBufferResult = createBuffer(
+				vertexCount * sizeof(Vertex),
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				vkModelInstance.vertexBuffer,
+				vkModelInstance.vertexBufferMemory);
+			ASSERT(createBufferResult, "Failed to create vertex buffer for instance of model: {}", modelInstance.GetId());
+
+			if (createBufferResult && m_depthPrePass)
+			{
+				createBufferResult = createBuffer(
+					vertexCount * sizeof(glm::vec3),
+					VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+					vkModelInstance.positionBuffer,
+					vkModelInstance.positionBufferMemory);
+				ASSERT(createBufferResult, "Failed to create position buffer for instance of model: {}", modelInstance.GetId());
+			}
+
+			if (!createBufferResult)
+			{
+				destroyInstanceVertexBuffers(vkModelInstance);
+				return false;
+			}
+			vkModelInstance.vertexCount = vertexCount;
+		}
+
+		// Written in place like the uniform buffers, frames in flight can see the update of a later frame
+		bool setMemoryResult = setBufferMemoryData(vkModelInstance.vertexBufferMemory, vertices, vertexCount * sizeof(Vertex));
+		ASSERT(setMemoryResult, "Failed to set vertices of instance of model: {}", modelInstance.GetId());
+
+		if (setMemoryResult && vkModelInstance.positionBuffer != VK_NULL_HANDLE)
+		{
+			const Vertex* sourceVertices = static_cast<const Vertex*>(vertices);
+			m_instancePositions.resize(vertexCount);
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				m_instancePositions[i] = sourceVertices[i].position;
+			}
+			setMemoryResult = setBufferMemoryData(vkModelInstance.positionBufferMemory, m_instancePositions.data(), vertexCount * sizeof(glm::vec3));
+			ASSERT(setMemoryResult, "Failed to set positions of instance of model: {}", modelInstance.GetId());
+		}
+
+		return setMemoryResult;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	void VulkanRenderer::destroyInstanceVertexBuffers(VulkanModelInstance& modelInstance)
+	{
+		if (modelInstance.vertexBuffer != VK_NULL_HANDLE)
+		{
+			vkDestroyBuffer(m_device, modelInstance.vertexBuffer, nullptr);
+			modelInstance.vertexBuffer = VK_NULL_HANDLE;
+		}
+
+		if (modelInstance.vertexBufferMemory != VK_NULL_HANDLE)
+		{
+			vkFreeMemory(m_device, modelInstance.vertexBufferMemory, nullptr);
+			modelInstance.vertexBufferMemory = VK_NULL_HANDLE;
+		}
+
+		if (modelInstance.positionBuffer != VK_NULL_HANDLE)
+		{
+			vkDestroyBuffer(m_device, modelInstance.positionBuffer, nullptr);
+			modelInstance.positionBuffer = VK_NULL_HANDLE;
+		}
+
+		if (modelInstance.positionBufferMemory != VK_NULL_HANDLE)
+		{
+			vkFreeMemory(m_device, modelInstance.positionBufferMemory, nullptr);
+			modelInstance.positionBufferMemory = VK_NULL_HANDLE;
+		}
+
+		modelInstance.vertexCount = 0;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
 	bool VulkanRenderer::unloadTexture(const std::string& filename)
 	{
 		const auto& itr = m_textures.find(filename);
@@ -1350,7 +1799,22 @@ namespace Engine::Visual
 			return true;
 		}
 		
-		TextureData& texture = itr->second;
+		if (!destroyTexture(itr->second))
+		{
+			return false;
+		}
+
+		m_textures.erase(itr);
+		m_textureStats.onTextureDestroyed(filename);
+		m_textureStreamer.removeTexture(filename);
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	bool VulkanRenderer::destroyTexture(TextureData& texture)
+	{
 		if (texture.descriptorSet != VK_NULL_HANDLE)
 		{
 			VkResult freeDescriptorSetResult = vkFreeDescriptorSets(m_device, m_texturesDescriptorPool, 1, &texture.descriptorSet);
@@ -1379,13 +1843,25 @@ namespace Engine::Visual
 			texture.textureImageMemory = VK_NULL_HANDLE;
 		}
 
-		m_textures.erase(itr);
-
 		return true;
 	}
 
 	////////////////////////////////////////////////////////////////////////
 
+	const TextureStats& VulkanRenderer::getTextureStats() const
+	{
+		return m_textureStats;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	const ParticleStats& VulkanRenderer::getParticleStats() const
+	{
+		return m_particleStats;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
 	bool VulkanRenderer::unloadModel(const std::string& filename)
 	{
 		const auto& itr = m_models.find(filename);
@@ -1407,6 +1883,17 @@ namespace Engine::Visual
 			modelData.vertexBufferMemory = VK_NULL_HANDLE;
 		}
 
+		if (modelData.positionBuffer != VK_NULL_HANDLE)
+		{
+			vkDestroyBuffer(m_device, modelData.positionBuffer, nullptr);
+			modelData.positionBuffer = VK_NULL_HANDLE;
+		}
+		if (modelData.positionBufferMemory != VK_NULL_HANDLE)
+		{
+			vkFreeMemory(m_device, modelData.positionBufferMemory, nullptr);
+			modelData.positionBufferMemory = VK_NULL_HANDLE;
+		}
+
 		for (SubMesh& subMesh : modelData.meshes)
 		{
 			if (subMesh.indexBuffer != VK_NULL_HANDLE) 
@@ -1427,6 +1914,7 @@ namespace Engine::Visual
 		}
 
 		m_models.erase(itr);
+		m_textureStreamer.removeModel(filename);
 
 		return true;
 	}
@@ -1435,6 +1923,8 @@ namespace Engine::Visual
 
 	void VulkanRenderer::cleanUp()
 	{
+		m_textureStreamer.clear();
+
 		for (const std::string& modelId : Utils::getKeys(m_models))
 		{
 			unloadModel(modelId);
@@ -1448,6 +1938,13 @@ namespace Engine::Visual
 		unloadMaterial(m_defaultMaterial);
 
 		vkDeviceWaitIdle(m_device);
+		for (ParticleBuffer& particleBuffer : m_particleBuffers)
+		{
+			destroyParticleBuffer(particleBuffer);
+		}
+		m_particleBuffers.clear();
+		m_particles.clear();
+
 		for (auto& semaphore : m_imageAvailableSemaphores)
 		{
 			vkDestroySemaphore(m_device, semaphore, nullptr);
@@ -1497,6 +1994,10 @@ namespace Engine::Visual
 		vkDestroySwapchainKHR(m_device, m_swapChain, nullptr);
 
 		vkDestroyPipeline(m_device, m_graphicsPipeline, nullptr);
+		if (m_depthPrePassPipeline) vkDestroyPipeline(m_device, m_depthPrePassPipeline, nullptr);
+		if (m_depthEqualPipeline) vkDestroyPipeline(m_device, m_depthEqualPipeline, nullptr);
+		if (m_particlePipeline) vkDestroyPipeline(m_device, m_particlePipeline, nullptr);
+		if (m_particlePipelineLayout) vkDestroyPipelineLayout(m_device, m_particlePipelineLayout, nullptr);
 		vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
 		vkDestroyRenderPass(m_device, m_renderPass, nullptr);
 
@@ -2005,6 +2506,122 @@ namespace Engine::Visual
 			return;
 		}
 
+		if (m_depthPrePass)
+		{
+			// Same shading pipeline, but the depth already comes from the pre-pass
+			depthStencil.depthWriteEnable = VK_FALSE;
+			depthStencil.depthCompareOp = VK_COMPARE_OP_EQUAL;
+
+			VkResult createDepthEqualPipelineResult = vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_depthEqualPipeline);
+			if (!validateResult(createDepthEqualPipelineResult, "Failed to create depth equal pipeline"))
+			{
+				return;
+			}
+
+			// Depth only pipeline: vertex stage only, position-only stream and no color writes
+			auto depthShaderCode = Utils::loadBytesFromFile("depth.spv");
+			VkShaderModule depthShaderModule = createShaderModule(depthShaderCode);
+
+			VkPipelineShaderStageCreateInfo depthShaderStageInfo = vertShaderStageInfo;
+			depthShaderStageInfo.module = depthShaderModule;
+
+			VkVertexInputBindingDescription positionBindingDescription{};
+			positionBindingDescription.binding = 0;
+			positionBindingDescription.stride = sizeof(glm::vec3);
+			positionBindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			VkVertexInputAttributeDescription positionAttributeDescription{};
+			positionAttributeDescription.binding = 0;
+			positionAttributeDescription.location = 0;
+			positionAttributeDescription.format = VK_FORMAT_R32G32B32_SFLOAT;
+			positionAttributeDescription.offset = 0;
+
+			vertexInputInfo.vertexBindingDescriptionCount = 1;
+			vertexInputInfo.pVertexBindingDescriptions = &positionBindingDescription;
+			vertexInputInfo.vertexAttributeDescriptionCount = 1;
+			vertexInputInfo.pVertexAttributeDescriptions = &positionAttributeDescription;
+
+			depthStencil.depthWriteEnable = VK_TRUE;
+			depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+			colorBlendAttachment.colorWriteMask = 0;
+
+			pipelineInfo.stageCount = 1;
+			pipelineInfo.pStages = &depthShaderStageInfo;
+
+			VkResult createDepthPrePassPipelineResult = vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_depthPrePassPipeline);
+			vkDestroyShaderModule(m_device, depthShaderModule, nullptr);
+			if (!validateResult(createDepthPrePassPipelineResult, "Failed to create depth pre-pass pipeline"))
+			{
+				return;
+			}
+		}
+
+		// Particle pipeline: one instance per particle, camera matrices pushed per frame, blended without depth writes
+		auto particleVertShaderCode = Utils::loadBytesFromFile("particleVert.spv");
+		auto particleFragShaderCode = Utils::loadBytesFromFile("particleFrag.spv");
+		VkShaderModule particleVertShaderModule = createShaderModule(particleVertShaderCode);
+		VkShaderModule particleFragShaderModule = createShaderModule(particleFragShaderCode);
+
+		VkPipelineShaderStageCreateInfo particleShaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
+		particleShaderStages[0].module = particleVertShaderModule;
+		particleShaderStages[1].module = particleFragShaderModule;
+
+		VkVertexInputBindingDescription particleBindingDescription{};
+		particleBindingDescription.binding = 0;
+		particleBindingDescription.stride = sizeof(ParticleInstance);
+		particleBindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+		std::array<VkVertexInputAttributeDescription, 2> particleAttributeDescriptions{};
+		particleAttributeDescriptions[0].binding = 0;
+		particleAttributeDescriptions[0].location = 0;
+		particleAttributeDescriptions[0].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+		particleAttributeDescriptions[0].offset = offsetof(ParticleInstance, position);
+		particleAttributeDescriptions[1].binding = 0;
+		particleAttributeDescriptions[1].location = 1;
+		particleAttributeDescriptions[1].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+		particleAttributeDescriptions[1].offset = offsetof(ParticleInstance, color);
+
+		vertexInputInfo.vertexBindingDescriptionCount = 1;
+		vertexInputInfo.pVertexBindingDescriptions = &particleBindingDescription;
+		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(particleAttributeDescriptions.size());
+		vertexInputInfo.pVertexAttributeDescriptions = particleAttributeDescriptions.data();
+
+		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+		rasterizerState.cullMode = VK_CULL_MODE_NONE;
+		depthStencil.depthWriteEnable = VK_FALSE;
+		depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		colorBlendAttachment.blendEnable = VK_TRUE;
+		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+		VkPushConstantRange particlePushConstantRange{};
+		particlePushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		particlePushConstantRange.offset = 0;
+		particlePushConstantRange.size = sizeof(ParticlePushConstants);
+
+		VkPipelineLayoutCreateInfo particlePipelineLayoutInfo{};
+		particlePipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		particlePipelineLayoutInfo.setLayoutCount = 0;
+		particlePipelineLayoutInfo.pushConstantRangeCount = 1;
+		particlePipelineLayoutInfo.pPushConstantRanges = &particlePushConstantRange;
+
+		VkResult createParticlePipelineLayoutResult = vkCreatePipelineLayout(m_device, &particlePipelineLayoutInfo, nullptr, &m_particlePipelineLayout);
+		if (validateResult(createParticlePipelineLayoutResult, "Failed to create particle pipeline layout"))
+		{
+			pipelineInfo.stageCount = 2;
+			pipelineInfo.pStages = particleShaderStages;
+			pipelineInfo.layout = m_particlePipelineLayout;
+
+			VkResult createParticlePipelineResult = vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_particlePipeline);
+			validateResult(createParticlePipelineResult, "Failed to create particle pipeline");
+		}
+
+		vkDestroyShaderModule(m_device, particleVertShaderModule, nullptr);
+		vkDestroyShaderModule(m_device, particleFragShaderModule, nullptr);
 		vkDestroyShaderModule(m_device, vertShaderModule, nullptr);
 		vkDestroyShaderModule(m_device, fragShaderModule, nullptr);
 	}
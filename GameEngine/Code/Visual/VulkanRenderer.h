@@ -4,8 +4,11 @@
 #include <glm/glm.hpp>
 #include <memory>
 #include <string>
+#include <chrono>
 
 #include "IRenderer.h"
+#include "GltfModel.h"
+#include "TextureStreamer.h"
 #include "Utils/SparseSet.h"
 #include "Managers/EntitiesManager.h"
 
@@ -16,6 +19,9 @@ namespace Engine::Visual
     {
     public:
 
+        void setFramePacing(const FramePacing& framePacing) override;
+        void setDepthPrePass(bool enabled) override;
+        void setTextureStreaming(const TextureStreaming& settings, JobsManager& jobsManager) override;
         void init(const Window& window) override;
         void clearBackground(float r, float g, float b, float a) override;
 
@@ -24,16 +30,23 @@ namespace Engine::Visual
             const Utils::Vector3& position,
             const Utils::Vector3& rotation,
             const Utils::Vector3& scale) override;
+        void drawParticles(const ParticleInstance* particles, size_t count) override;
         void render() override;
+        void waitForNextFrame() override;
 
+        ModelSource::Options getModelSourceOptions() const override;
         bool loadModel(const std::string& filename) override;
+        bool loadModel(const std::string& filename, const ModelSource& source) override;
         bool loadTexture(const std::string& filename) override;
 
-        void setCameraProperties(const Utils::Vector3& position, const Utils::Vector3& rotation) override;
+        void setCamera(const Utils::Matrix4& view, const Utils::Matrix4& projection) override;
         std::unique_ptr<IModelInstance> createModelInstance(const std::string& filename) override;
 
         bool destroyModelInstance(IModelInstance& modelInstance) override;
+        bool updateInstanceVertices(IModelInstance& modelInstance, const void* vertices, size_t vertexCount) override;
         bool unloadTexture(const std::string& filename) override;
+        const TextureStats& getTextureStats() const override;
+        const ParticleStats& getParticleStats() const override;
         bool unloadModel(const std::string& filename) override;
 
         void cleanUp() override;
@@ -52,8 +65,11 @@ namespace Engine::Visual
 
         struct SubMesh
         {
-            std::vector<uint32_t> indices;
+            std::vector<uint32_t> indices; // Empty for glTF models, their buffers are filled straight from the file
             int materialId;
+            uint32_t indexCount = 0;
+            int32_t baseVertex = 0;
+            VkIndexType indexType = VK_INDEX_TYPE_UINT32;
 
             VkBuffer indexBuffer;
             VkDeviceMemory indexBufferMemory;
@@ -90,6 +106,10 @@ namespace Engine::Visual
 
             VkBuffer vertexBuffer;
             VkDeviceMemory vertexBufferMemory;
+
+            // Position-only stream, only created for the depth pre-pass
+            VkBuffer positionBuffer = VK_NULL_HANDLE;
+            VkDeviceMemory positionBufferMemory = VK_NULL_HANDLE;
         };
 
         struct UniformBufferObject
@@ -120,6 +140,34 @@ namespace Engine::Visual
             VkDeviceMemory uniformBufferMemory;
             VkDescriptorSet descriptorSet;
 			EntityID descriptorPoolID;
+
+            // Host visible streams replacing the model buffers, only created by updateInstanceVertices
+            VkBuffer vertexBuffer = VK_NULL_HANDLE;
+            VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
+            VkBuffer positionBuffer = VK_NULL_HANDLE; // The depth pre-pass pipeline reads tightly packed positions
+            VkDeviceMemory positionBufferMemory = VK_NULL_HANDLE;
+            size_t vertexCount = 0;
+        };
+
+        struct DrawCommand
+        {
+            const ModelData* model;
+            const VulkanModelInstance* instance;
+        };
+
+        struct ParticlePushConstants
+        {
+            glm::mat4 viewMatrix;
+            glm::mat4 projectionMatrix;
+        };
+
+        // Persistently mapped instance stream, one per frame in flight so a frame never overwrites one still being read
+        struct ParticleBuffer
+        {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            void* mappedData = nullptr;
+            size_t capacity = 0; // In particles
         };
 
         struct QueueFamilyIndices
@@ -166,31 +214,47 @@ namespace Engine::Visual
         void createSyncObjects();
         void createCommandBuffers();
         void createTextureSampler();
-        void createProjectionMatrix();
         void createDefaultMaterial();
 
 		// Model loading methods
         const TextureData& getTexture(const std::string& textureId) const;
-        bool loadModelFromFile(ModelData& model, const std::string& filename);
+        bool loadModelFromFile(ModelData& model, const ObjModel& obj, const std::string& filename);
+        bool loadModelFromGltf(ModelData& model, const GltfModel& gltf, const std::string& filename);
+        std::string loadGltfTexture(const GltfModel& gltf, int imageId);
+        bool loadTextureFromMemory(const std::string& textureId, const GltfModel::BufferRange& data);
+        bool createTexture(const std::string& textureId, const unsigned char* pixels, int width, int height, std::chrono::high_resolution_clock::time_point loadStart);
+        bool destroyTexture(TextureData& texture);
+        void updateStreamedTextures();
         bool createBuffersForModel(ModelData& model);
         void unloadMaterial(Material& material);
 
         bool createUniformBuffers(ModelData& model);
         bool createDescriptorSets(ModelData& model);
         bool createVertexBuffer(ModelData& model);
+        bool createPositionBuffer(ModelData& model);
         bool createIndexBuffer(ModelData& model);
         bool createDescriptorSet(Material& material);
 
+        // Draw recording
+        void recordModelDraw(VkCommandBuffer commandBuffer, const ModelData& modelData, const VulkanModelInstance& modelInstance);
+        void recordModelDepthDraw(VkCommandBuffer commandBuffer, const ModelData& modelData, const VulkanModelInstance& modelInstance);
+        void recordDrawCommands(VkCommandBuffer commandBuffer);
+        void recordParticles(VkCommandBuffer commandBuffer);
+        bool reserveParticleBuffer(ParticleBuffer& particleBuffer, size_t count);
+        void destroyParticleBuffer(ParticleBuffer& particleBuffer);
+
 
         // Memory utils
         bool createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
         bool setBufferMemoryData(VkDeviceMemory memory, const void* data, VkDeviceSize size);
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+        void destroyInstanceVertexBuffers(VulkanModelInstance& modelInstance);
+        bool createDeviceLocalBuffer(const std::vector<GltfModel::BufferRange>& ranges, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
 
         bool createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
                         VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& img,
                         VkDeviceMemory& imageMemory);
-        bool createTextureImage(const std::string& filename, TextureData& texture);
+        bool createTextureImage(const unsigned char* pixels, int width, int height, TextureData& texture);
         void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
         void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
         VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
@@ -217,12 +281,13 @@ namespace Engine::Visual
     private:
 
         static const int MAX_MODEL_INSTANCES = 50;
-        static const int MAX_MATERIALS = 80;
-        static const int MAX_TEXTURES = 80;
+        static const int MAX_MATERIALS = 1024; // Enough for the texture stress experiment
+        static const int MAX_TEXTURES = 1024;
 
-        static const int MAX_FRAMES_IN_FLIGHT = 3;
         static inline const std::vector<const char*> DEVICE_EXTENSIONS = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 
+        FramePacing m_framePacing;
+
         VkInstance m_instance{};
         VkSurfaceKHR m_surface{};
 
@@ -248,6 +313,20 @@ namespace Engine::Visual
         VkPipelineLayout m_pipelineLayout{};
         VkPipeline m_graphicsPipeline{};
 
+        // Depth pre-pass
+        bool m_depthPrePass = false;
+        VkPipeline m_depthPrePassPipeline{};
+        VkPipeline m_depthEqualPipeline{};
+        std::vector<DrawCommand> m_drawCommands;
+        std::vector<glm::vec3> m_instancePositions; // Scratch space of updateInstanceVertices
+
+        // Particles, drawn as instanced quads after the models
+        VkPipelineLayout m_particlePipelineLayout{};
+        VkPipeline m_particlePipeline{};
+        std::vector<ParticleBuffer> m_particleBuffers;
+        std::vector<ParticleInstance> m_particles;
+        ParticleStats m_particleStats;
+
         VkCommandPool m_commandPool{};
 
         VkImage m_depthImage{};
@@ -279,6 +358,9 @@ namespace Engine::Visual
 
         std::unordered_map<std::string, ModelData> m_models;
         std::unordered_map <std::string, TextureData> m_textures;
+        TextureStats m_textureStats;
+        TextureStreamer m_textureStreamer;
+        std::vector<TextureStreamer::Upload> m_textureUploads;
 
     };
 }
\ No newline at end of file
@@ -125,6 +125,23 @@ namespace Engine::Visual
 
     //////////////////////////////////////////////////////////////////////////
 
+    float Window::getAspectRatio() const
+    {
+        RECT rect;
+        GetClientRect(m_window, &rect);
+
+        int width = rect.right - rect.left;
+        int height = rect.bottom - rect.top;
+        if (width <= 0 || height <= 0)
+        {
+            return 1.0f;
+        }
+
+        return (float)width / (float)height;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+
     LRESULT CALLBACK Window::windowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     {
         Window* pThis;
@@ -0,0 +1,15 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+
+uniform mat4 modelMatrix;
+uniform mat4 viewMatrix;
+uniform mat4 projectionMatrix;
+
+invariant gl_Position;
+
+void main()
+{
+    vec3 fragPos = vec3(modelMatrix * vec4(aPos, 1.0));
+    gl_Position = projectionMatrix * viewMatrix * vec4(fragPos, 1.0);
+}
@@ -0,0 +1,14 @@
+cbuffer ConstantBuffer : register(b0)
+{
+    matrix worldMatrix;
+    matrix viewMatrix;
+    matrix projectionMatrix;
+};
+
+float4 main(float3 position : POSITION) : SV_POSITION
+{
+    precise float4 worldPos = mul(float4(position, 1.0f), worldMatrix);
+    precise float4 viewPos = mul(worldPos, viewMatrix);
+    precise float4 clipPos = mul(viewPos, projectionMatrix);
+    return clipPos;
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#version 450 core
+
+in vec2 Corner;
+in vec4 Color;
+
+out vec4 FragColor;
+
+void main()
+{
+    // Round particles with a soft edge
+    float distanceSqr = dot(Corner, Corner) * 4.0;
+    if (distanceSqr > 1.0)
+    {
+        discard;
+    }
+    FragColor = vec4(Color.rgb, Color.a * (1.0 - distanceSqr));
+}
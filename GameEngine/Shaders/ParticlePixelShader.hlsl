@@ -0,0 +1,14 @@
+struct PSInput
+{
+    float4 position : SV_POSITION;
+    float2 corner : TEXCOORD;
+    float4 color : COLOR;
+};
+
+float4 main(PSInput input) : SV_TARGET
+{
+    // Round particles with a soft edge
+    float distanceSqr = dot(input.corner, input.corner) * 4.0f;
+    clip(1.0f - distanceSqr);
+    return float4(input.color.rgb, input.color.a * (1.0f - distanceSqr));
+}
@@ -0,0 +1,22 @@
+#version 450 core
+
+// One instance per particle, the 4 corners of the quad come from gl_VertexID
+layout(location = 0) in vec4 aPositionSize;
+layout(location = 1) in vec4 aColor;
+
+out vec2 Corner;
+out vec4 Color;
+
+uniform mat4 viewMatrix;
+uniform mat4 projectionMatrix;
+
+void main()
+{
+    Corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) - 0.5;
+    Color = aColor;
+
+    // Offsetting in view space keeps the quad facing the camera
+    vec4 viewPos = viewMatrix * vec4(aPositionSize.xyz, 1.0);
+    viewPos.xy += Corner * aPositionSize.w;
+    gl_Position = projectionMatrix * viewPos;
+}
@@ -0,0 +1,34 @@
+cbuffer ConstantBuffer : register(b0)
+{
+    matrix worldMatrix;
+    matrix viewMatrix;
+    matrix projectionMatrix;
+};
+
+// One instance per particle, the 4 corners of the quad come from SV_VertexID
+struct VSInput
+{
+    float4 positionSize : POSITION;
+    float4 color : COLOR;
+    uint vertexId : SV_VertexID;
+};
+
+struct VSOutput
+{
+    float4 position : SV_POSITION;
+    float2 corner : TEXCOORD;
+    float4 color : COLOR;
+};
+
+VSOutput main(VSInput input)
+{
+    VSOutput output;
+    output.corner = float2(input.vertexId & 1, input.vertexId >> 1) - 0.5f;
+    output.color = input.color;
+
+    // Offsetting in view space keeps the quad facing the camera
+    float4 viewPos = mul(float4(input.positionSize.xyz, 1.0f), viewMatrix);
+    viewPos.xy += output.corner * input.positionSize.w;
+    output.position = mul(viewPos, projectionMatrix);
+    return output;
+}
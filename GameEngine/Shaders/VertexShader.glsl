@@ -12,6 +12,9 @@ uniform mat4 modelMatrix;
 uniform mat4 viewMatrix;
 uniform mat4 projectionMatrix;
 
+// Must match DepthVertexShader exactly for the depth pre-pass equal test
+invariant gl_Position;
+
 void main()
 {
     // Transform vertex position to world space using model matrix
@@ -22,9 +22,11 @@ struct VSOutput
 VSOutput main(VSInput input)
 {
     VSOutput output;
-    float4 worldPos = mul(float4(input.position, 1.0f), worldMatrix);
-    float4 viewPos = mul(worldPos, viewMatrix);
-    output.position = mul(viewPos, projectionMatrix);
+    // Computed the same way as in DepthVertexShader, the depth pre-pass relies on matching depth values
+    precise float4 worldPos = mul(float4(input.position, 1.0f), worldMatrix);
+    precise float4 viewPos = mul(worldPos, viewMatrix);
+    precise float4 clipPos = mul(viewPos, projectionMatrix);
+    output.position = clipPos;
     output.normal = mul(input.normal, (float3x3) worldMatrix);
     output.texCoord = input.texCoord;
     return output;
@@ -0,0 +1,17 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 worldMatrix;
+    mat4 viewMatrix;
+    mat4 projectionMatrix;
+} ubo;
+
+layout(location = 0) in vec3 inPosition;
+
+invariant gl_Position;
+
+void main() {
+    vec4 worldPosition = ubo.worldMatrix * vec4(inPosition, 1.0);
+    gl_Position = ubo.projectionMatrix * ubo.viewMatrix * worldPosition;
+}
@@ -0,0 +1,16 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec2 Corner;
+layout(location = 1) in vec4 Color;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // Round particles with a soft edge
+    float distanceSqr = dot(Corner, Corner) * 4.0;
+    if (distanceSqr > 1.0) {
+        discard;
+    }
+    outColor = vec4(Color.rgb, Color.a * (1.0 - distanceSqr));
+}
@@ -0,0 +1,24 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(push_constant) uniform PushConstants {
+    mat4 viewMatrix;
+    mat4 projectionMatrix;
+} pc;
+
+// One instance per particle, the 4 corners of the quad come from gl_VertexIndex
+layout(location = 0) in vec4 inPositionSize;
+layout(location = 1) in vec4 inColor;
+
+layout(location = 0) out vec2 Corner;
+layout(location = 1) out vec4 Color;
+
+void main() {
+    Corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1) - 0.5;
+    Color = inColor;
+
+    // Offsetting in view space keeps the quad facing the camera
+    vec4 viewPosition = pc.viewMatrix * vec4(inPositionSize.xyz, 1.0);
+    viewPosition.xy += Corner * inPositionSize.w;
+    gl_Position = pc.projectionMatrix * viewPosition;
+}
@@ -15,6 +15,9 @@ layout(location = 0) out vec3 FragPos;   // Output fragment position in world sp
 layout(location = 1) out vec3 Normal;    // Output normal in world space
 layout(location = 2) out vec2 TexCoord;  // Output texture coordinates
 
+// Must match depth.vert exactly for the depth pre-pass equal test
+invariant gl_Position;
+
 void main() {
     // Calculate the world-space position of the fragment
     vec4 worldPosition = ubo.worldMatrix * vec4(inPosition, 1.0);